@@ -0,0 +1,31 @@
+/*
+//	be/alloc_counter
+//	Counts heap allocations, to check that a steady-state frame makes none.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace be
+{
+	namespace alloc_counter
+	{
+		/*
+		//	Building be with BE_COUNT_ALLOCATIONS defined replaces the global operator new and delete
+		//	with versions that count every allocation, from any thread. It is a debugging aid:
+		//	it adds an atomic increment to every allocation in the program.
+		*/
+#ifdef BE_COUNT_ALLOCATIONS
+		inline constexpr bool isEnabled = true;
+#else
+		inline constexpr bool isEnabled = false;
+#endif
+
+		// Allocations since startup. Always 0 unless isEnabled.
+		std::uint64_t getAllocationCount() noexcept;
+	}
+}
@@ -8,8 +8,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <stdexcept>
+#include <string_view>
 
 #include "be/logger.hpp"
 #include "be/game.hpp"
@@ -51,6 +53,25 @@ namespace be
 		GlewInitException(std::string const& what);
 	};
 
+	class HeadlessInitException : public RunException
+	{
+	public:
+		HeadlessInitException(char const* what = "[be] headless init exception");
+		HeadlessInitException(std::string const& what);
+	};
+
+	// Frame timing statistics gathered by a headless run.
+	struct RunStats
+	{
+		std::uint64_t frames{};
+		std::uint64_t updates{};
+		double totalSeconds{};
+		double meanFrameMs{};
+		double p95FrameMs{};
+		double minFrameMs{};
+		double maxFrameMs{};
+	};
+
 	struct ApplicationRunInfo
 	{
 		// REQUIRED
@@ -63,6 +84,35 @@ namespace be
 		int windowWidth = 1920 / 2; // require > 0
 		int windowHeight = 1080 / 2; // require > 0
 		char const* windowTitle = "be app"; // require != nullptr
+		bool enableProfiler = false; // see be/profile.hpp
+		int jobWorkerCount = -1; // see be/jobs.hpp. -1 means one fewer than the hardware threads. require >= -1
+
+		double fixedTimestep = 1.0 / 60.0; // seconds per Game::Update. require > 0
+		int maxUpdatesPerFrame = 5; // require > 0
+		double maxFrameRate = 0.0; // frames per second. 0 means uncapped. require >= 0
+		bool vsync = true;
+
+		/*
+		//	Headless mode renders offscreen (see be/headless.hpp) with no window and no input.
+		//	The game is stepped once per frame by |fixedTimestep|, so the simulation is the same
+		//	however slow the renderer is. |maxFrameRate| and |vsync| are ignored.
+		//	The run ends after whichever limit is reached first, then timing statistics are printed.
+		*/
+		bool headless = false;
+		int headlessFrameCount = 0; // 0 means no limit. require >= 0
+		double headlessSeconds = 0.0; // 0 means no limit. require >= 0, and at least one limit when headless
+		RunStats* runStats{}; // if provided, receives the statistics of a headless run
+
+		/*
+		//	Input recording (see be/input_record.hpp). Each input event is stamped with the index of
+		//	the Game::Update it comes before. A replay delivers the recorded events before the same
+		//	updates, steps by the recorded timestep and ignores live input, so a windowed session can be
+		//	reproduced exactly, headless or not. Recorded window resizes are replayed too, so give a
+		//	headless replay the recorded window size.
+		*/
+		char const* recordInputPath{}; // written when the run ends
+		char const* replayInputPath{}; // require not both paths
+		bool exitWhenReplayEnds = true; // after the recorded number of updates. counts as a headless limit
 	};
 
 	namespace Application
@@ -72,5 +122,12 @@ namespace be
 		Game* getGame() noexcept;
 		Logger* getLogger() noexcept;
 		void logException() noexcept;
+		void log(LogLevel level, std::string_view message) noexcept; // does nothing without a logger
+		void logf(LogLevel level, char const* format, ...) noexcept; // see Logger::logf
+
+		bool isHeadless() noexcept;
+		bool isReplayingInput() noexcept; // live input is being ignored, see ApplicationRunInfo::replayInputPath
+		int getWindowWidth() noexcept;
+		int getWindowHeight() noexcept;
 	};
 }
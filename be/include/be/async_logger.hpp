@@ -0,0 +1,145 @@
+/*
+//	be/async_logger
+//	A Logger that never blocks the caller on I/O: messages go through a lock-free ring
+//	to a background thread, which writes them to sinks and collapses repeats.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "be/logger.hpp"
+
+namespace be
+{
+	class LoggerException final : public std::runtime_error
+	{
+	public:
+		explicit LoggerException(std::string const& msg)
+			: std::runtime_error("[be] logger exception: " + msg)
+		{}
+	};
+
+
+
+	// Interface. Only called from the AsyncLogger thread.
+	class LogSink
+	{
+	public:
+		virtual ~LogSink() noexcept = default;
+	protected:
+		LogSink() = default;
+		LogSink(LogSink const&) = delete;
+		LogSink& operator=(LogSink const&) = delete;
+
+	private:
+		// INTERFACE METHODS
+		virtual void Write(LogLevel level, std::string_view line) = 0; // |line| has no newline
+		virtual void Flush() {} // after each batch of writes
+
+	public:
+		void write(LogLevel level, std::string_view line) { Write(level, line); }
+		void flush() { Flush(); }
+	};
+
+	// Debug and info to stdout, warnings and errors to stderr.
+	class ConsoleLogSink final : public LogSink
+	{
+	private:
+		void Write(LogLevel level, std::string_view line) final;
+		void Flush() final;
+	};
+
+	class FileLogSink final : public LogSink
+	{
+	private:
+		std::ofstream m_file;
+
+	public:
+		explicit FileLogSink(std::string const& path); // truncates. throws LoggerException
+
+	private:
+		void Write(LogLevel level, std::string_view line) final;
+		void Flush() final;
+	};
+
+
+
+	/*
+	//	Log and LogException copy the message into a fixed-size slot of a bounded multi-producer
+	//	single-consumer ring and return, so any thread may log, including from inside the frame loop.
+	//	A message longer than maxMessageLength is truncated. When the ring is full the message is
+	//	dropped and counted rather than waiting, and the count is reported once there is room.
+	//
+	//	Each line shows when its message was logged, not when it was written.
+	//	A message identical to one written in the last |repeatWindow| is not written again;
+	//	instead one "repeated N more times" line follows when the window closes. So an exception thrown
+	//	every frame costs one line per window, not one per frame.
+	*/
+	class AsyncLogger final : public Logger
+	{
+	public:
+		static constexpr std::size_t maxMessageLength = 240;
+
+		struct CreateInfo
+		{
+			std::vector<std::shared_ptr<LogSink>> sinks; // if empty, a ConsoleLogSink
+			LogLevel minLevel = LogLevel::Info; // lower levels are discarded by the caller
+			std::size_t capacity = 1024; // messages in flight. require a power of two
+			std::chrono::milliseconds repeatWindow{ 1000 }; // 0 writes every message
+		};
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Slot
+		{
+			std::atomic<std::size_t> sequence{};
+			Clock::time_point time;
+			LogLevel level{};
+			std::uint8_t length{};
+			char text[maxMessageLength];
+		};
+
+		struct Consumer; // state owned by the background thread
+
+		std::unique_ptr<Slot[]> m_slots;
+		std::size_t m_mask{};
+		LogLevel m_minLevel{};
+		alignas(64) std::atomic<std::size_t> m_enqueuePosition{ 0 };
+		alignas(64) std::atomic<std::uint32_t> m_signal{ 0 }; // bumped after each enqueue
+		std::atomic<std::uint64_t> m_dropped{ 0 };
+		std::atomic<bool> m_stopping{ false };
+		std::unique_ptr<Consumer> m_consumer;
+		std::thread m_thread;
+
+	public:
+		explicit AsyncLogger(CreateInfo const& info);
+		~AsyncLogger() noexcept final; // writes everything still queued
+		AsyncLogger(AsyncLogger const&) = delete;
+		AsyncLogger& operator=(AsyncLogger const&) = delete;
+
+		LogLevel minLevel() const noexcept { return m_minLevel; }
+		std::uint64_t droppedCount() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+
+	private:
+		void LogException() noexcept final;
+		void Log(LogLevel level, std::string_view message) noexcept final;
+		bool IsEnabled(LogLevel level) const noexcept final { return level >= m_minLevel; }
+
+		bool tryEnqueue(LogLevel level, std::string_view message) noexcept;
+		void run() noexcept;
+		bool drain();
+	};
+}
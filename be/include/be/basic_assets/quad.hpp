@@ -2,7 +2,9 @@
 #pragma once
 
 #include "be/gl.hpp"
+#include "be/mesh_pool.hpp"
 #include "be/pink/trs.hpp"
+#include "be/pink/culling.hpp"
 
 namespace be
 {
@@ -11,6 +13,10 @@ namespace be
 		namespace meshes
 		{
 			be::gl::BasicMesh makeQuadMesh();
+			be::gl::MeshRange addQuadMesh(be::gl::MeshPool& pool);
+
+			// model space bounds of the quad mesh
+			inline be::pink::Aabb const quadMeshBounds{ glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec3(0.5f, 0.5f, 0.0f) };
 		}
 	}
 
@@ -18,18 +18,40 @@
 #include "be/mem/soil.hpp"
 #include "be/mem/ft.hpp"
 #include "be/mem/fmod.hpp"
+#include "be/mem/frame_arena.hpp"
 
 // LOCAL LEAF INCLUDES
 #include "be/need.hpp"
+#include "be/function_ref.hpp"
+#include "be/slot_map.hpp"
+#include "be/alloc_counter.hpp"
 #include "be/gl.hpp"
+#include "be/gl_stats.hpp"
+#include "be/error_stats.hpp"
+#include "be/gpu_memory.hpp"
+#include "be/stream_buffer.hpp"
+#include "be/mesh_pool.hpp"
+#include "be/multi_draw.hpp"
+#include "be/shadow_atlas.hpp"
+#include "be/light_clusters.hpp"
+#include "be/gl_resources.hpp"
 #include "be/application.hpp"
+#include "be/async_logger.hpp"
 #include "be/soil.hpp"
 #include "be/ft.hpp"
 #include "be/uniform.hpp"
 #include "be/input.hpp"
+#include "be/input_record.hpp"
+#include "be/profile.hpp"
+#include "be/headless.hpp"
+#include "be/frame_pacing.hpp"
+#include "be/jobs.hpp"
+#include "be/texture_stream.hpp"
 
 // PINK
 #include "be/pink/trs.hpp"
+#include "be/pink/culling.hpp"
+#include "be/pink/occlusion.hpp"
 #include "be/pink/camera.hpp"
 #include "be/pink/unlit.hpp"
 #include "be/pink/text_label.hpp"
@@ -0,0 +1,72 @@
+/*
+//	be/error_stats
+//	Counts recoverable errors on per-frame paths instead of throwing them.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace be
+{
+	namespace error_stats
+	{
+		struct ErrorStats
+		{
+			char const* name{};
+			std::uint64_t frame{}; // since the last beginFrame
+			std::uint64_t total{};
+		};
+
+		/*
+		//	One kind of error that can recur every frame, e.g. a label naming a character its font lacks.
+		//	Update and render code returns a status for these and reports it here, keeping exceptions
+		//	for load-time failures. The first report is logged with its detail; later ones are only
+		//	counted, so a repeating error costs two atomic increments, not a throw and a log line.
+		//
+		//	Sites register themselves on construction and must outlive every report and query,
+		//	so declare them with BE_ERROR_SITE. |name| must be a string literal.
+		*/
+		class ErrorSite
+		{
+		private:
+			char const* m_name;
+			std::atomic<std::uint64_t> m_frame{ 0 };
+			std::atomic<std::uint64_t> m_total{ 0 };
+			ErrorSite* m_next{};
+
+			friend void beginFrame() noexcept;
+			friend std::vector<ErrorStats> getAllErrorStats();
+			friend std::uint64_t getFrameErrorCount() noexcept;
+
+		public:
+			explicit ErrorSite(char const* name) noexcept;
+			ErrorSite(ErrorSite const&) = delete;
+			ErrorSite& operator=(ErrorSite const&) = delete;
+
+			// Thread safe.
+			void report(std::string_view detail = {}) noexcept;
+
+			char const* name() const noexcept { return m_name; }
+			std::uint64_t frameCount() const noexcept { return m_frame.load(std::memory_order_relaxed); }
+			std::uint64_t totalCount() const noexcept { return m_total.load(std::memory_order_relaxed); }
+		};
+
+		// Zeroes the frame counts. Application calls this at the start of each frame.
+		void beginFrame() noexcept;
+
+		// Every site that has reported at least once, most recently registered first.
+		std::vector<ErrorStats> getAllErrorStats();
+
+		std::uint64_t getFrameErrorCount() noexcept;
+	}
+}
+
+#define BE_ERROR_SITE(variable, name)\
+	static ::be::error_stats::ErrorSite variable{ name }
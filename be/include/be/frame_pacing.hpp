@@ -0,0 +1,86 @@
+/*
+//	be/frame_pacing
+//	Fixed simulation timestep and precise frame rate limiting.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <chrono>
+
+namespace be
+{
+	namespace frame_pacing
+	{
+		using Clock = std::chrono::steady_clock;
+		using Seconds = std::chrono::duration<double>;
+
+		/*
+		//	Accumulates real elapsed time and hands it out in fixed simulation steps.
+		//	The remainder is exposed as an interpolation factor for rendering between
+		//	the previous and the current simulation state.
+		*/
+		class FixedTimestep
+		{
+		private:
+			double m_step;
+			int m_maxStepsPerFrame;
+			double m_accumulator = 0.0;
+
+		public:
+			FixedTimestep(double stepSeconds, int maxStepsPerFrame) noexcept
+				: m_step(stepSeconds)
+				, m_maxStepsPerFrame(maxStepsPerFrame)
+			{}
+
+			/*
+			//	Adds the real time elapsed since the previous frame.
+			//	Returns the number of steps to simulate this frame.
+			//	Time beyond |maxStepsPerFrame| steps is dropped, so a long stall
+			//	slows the simulation down rather than snowballing.
+			*/
+			int advance(double elapsedSeconds) noexcept
+			{
+				m_accumulator += elapsedSeconds;
+				int steps = static_cast<int>(m_accumulator / m_step);
+				if (steps > m_maxStepsPerFrame)
+				{
+					steps = m_maxStepsPerFrame;
+					m_accumulator = 0.0;
+				}
+				else
+				{
+					m_accumulator -= steps * m_step;
+				}
+				return steps;
+			}
+
+			double step() const noexcept { return m_step; }
+
+			// Fraction of a step that has elapsed since the last simulated step, in [0, 1).
+			double interpolation() const noexcept { return m_accumulator / m_step; }
+		};
+
+		/*
+		//	Blocks until the deadline.
+		//	Sleeps coarsely until |spinThreshold| before the deadline, then spins,
+		//	because the OS scheduler can oversleep by more than a millisecond.
+		*/
+		void sleepUntil(
+			Clock::time_point deadline,
+			Seconds spinThreshold = std::chrono::milliseconds(2)
+		) noexcept;
+
+		// Requests a finer OS timer resolution for the lifetime of the object (Win32 only).
+		class TimerResolutionScope
+		{
+		public:
+			TimerResolutionScope() noexcept;
+			~TimerResolutionScope() noexcept;
+			TimerResolutionScope(TimerResolutionScope const&) = delete;
+			TimerResolutionScope& operator=(TimerResolutionScope const&) = delete;
+		};
+	}
+}
@@ -14,13 +14,19 @@ namespace be
 	{
 		struct FontGlyph
 		{
-			be::mem::gl::Texture texture = {};
+			glm::vec2 atlasMin = {}; // its top left in the font's atlas, in texture coordinates
+			glm::vec2 atlasMax = {}; // its bottom right
 			glm::ivec2 size = {};
 			glm::ivec2 bearing = {};
 			int advance = {};
 		};
 
-		using Font = std::map<GLchar, FontGlyph>;
+		// Every glyph is packed into one GL_RED texture, so a whole label draws from a single binding.
+		struct Font
+		{
+			be::mem::gl::Texture atlas = {};
+			std::map<GLchar, FontGlyph> glyphs;
+		};
 
 
 
@@ -0,0 +1,71 @@
+/*
+//	be/function_ref
+//	A non-owning reference to a callable, for callbacks that do not outlive the call.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+namespace be
+{
+	template<class Signature>
+	class FunctionRef;
+
+	/*
+	//	Unlike std::function it never allocates or copies the callable: it holds a pointer to it
+	//	and a pointer to a function that calls it. So the callable must outlive the FunctionRef.
+	//	Take it by value as a parameter and pass a lambda; do not store one made from a temporary.
+	*/
+	template<class R, class... Args>
+	class FunctionRef<R(Args...)>
+	{
+	private:
+		// a function pointer cannot be held as a void*, so it is kept beside the callable's address.
+		union Target
+		{
+			void* callable;
+			void(*function)();
+		};
+		Target m_target;
+		R(*m_invoke)(Target, Args...);
+
+		template<class F>
+		static constexpr bool isFunction = std::is_function_v<std::remove_pointer_t<std::remove_cvref_t<F>>>;
+
+	public:
+		template<class F>
+			requires (!std::is_same_v<std::remove_cvref_t<F>, FunctionRef>
+				&& !isFunction<F>
+				&& std::is_invocable_r_v<R, F&, Args...>)
+		FunctionRef(F&& callable) noexcept
+			: m_target{ .callable = const_cast<void*>(static_cast<void const*>(std::addressof(callable))) }
+			, m_invoke([](Target const t, Args... args) -> R
+				{
+					return std::invoke(*static_cast<std::remove_reference_t<F>*>(t.callable), std::forward<Args>(args)...);
+				})
+		{}
+
+		// A plain function or function pointer is held by value, so it may be a temporary.
+		template<class F>
+			requires (std::is_function_v<F>
+				&& std::is_invocable_r_v<R, F*, Args...>)
+		FunctionRef(F* const function) noexcept
+			: m_target{ .function = reinterpret_cast<void(*)()>(function) }
+			, m_invoke([](Target const t, Args... args) -> R
+				{
+					return std::invoke(reinterpret_cast<F*>(t.function), std::forward<Args>(args)...);
+				})
+		{}
+
+		R operator()(Args... args) const
+		{
+			return m_invoke(m_target, std::forward<Args>(args)...);
+		}
+	};
+}
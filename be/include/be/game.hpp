@@ -17,8 +17,8 @@ namespace be
 
 	private:
 		// INTERFACE METHODS
-		virtual void Update() {}
-		virtual void Render() {}
+		virtual void Update(float deltaTime) {} // called once per fixed simulation step
+		virtual void Render(float interpolation) {} // fraction of a step since the last Update, in [0, 1)
 		virtual void OnWindowSizeChanged(int width, int height) {}
 		virtual void OnWindowPositionChanged(int x, int y) {}
 		virtual void OnMousePositionInWindowChanged(int x, int y) {}
@@ -36,8 +36,8 @@ namespace be
 		virtual void OnMouseLeftWindow() {}
 
 	public:
-		void update() { Update(); }
-		void render() { Render(); }
+		void update(float deltaTime) { Update(deltaTime); }
+		void render(float interpolation) { Render(interpolation); }
 		void onWindowSizeChanged(int width, int height) { OnWindowSizeChanged(width, height); }
 		void onWindowPositionChanged(int x, int y) { OnWindowPositionChanged(x, y); }
 		void onMousePositionInWindowChanged(int x, int y) { OnMousePositionInWindowChanged(x, y); }
@@ -0,0 +1,72 @@
+/*
+//	be/gl_resources
+//	A registry of GL resources addressed by generational handles.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include "be/gl.hpp"
+#include "be/slot_map.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		using MeshHandle = Handle<BasicMesh>;
+		using TextureHandle = Handle<mem::gl::Texture>;
+		using ProgramHandle = Handle<mem::gl::Program>;
+		using FrameBufferHandle = Handle<mem::gl::FrameBuffer>;
+
+		/*
+		//	Owns meshes, textures, programs and framebuffers in one dense array per type.
+		//	Draw code holds 32 bit handles and resolves them here each frame, so an asset can be
+		//	replaced (e.g. reloaded from disk) without touching anything that refers to it.
+		//	Resolving a stale handle throws be::SlotMapException; find* returns nullptr or 0 instead.
+		//	Destroy it while the GL context is alive. Main thread (GL context) only.
+		*/
+		class ResourceRegistry
+		{
+		private:
+			SlotMap<BasicMesh> m_meshes;
+			SlotMap<mem::gl::Texture> m_textures;
+			SlotMap<mem::gl::Program> m_programs;
+			SlotMap<mem::gl::FrameBuffer> m_frameBuffers;
+
+		public:
+			MeshHandle add(BasicMesh&& mesh);
+			TextureHandle add(mem::gl::Texture&& texture);
+			ProgramHandle add(mem::gl::Program&& program);
+			FrameBufferHandle add(mem::gl::FrameBuffer&& frameBuffer);
+
+			// The old resource is deleted; the handle now resolves to the new one.
+			void replace(MeshHandle handle, BasicMesh&& mesh);
+			void replace(TextureHandle handle, mem::gl::Texture&& texture);
+			void replace(ProgramHandle handle, mem::gl::Program&& program);
+			void replace(FrameBufferHandle handle, mem::gl::FrameBuffer&& frameBuffer);
+
+			// Stale handles are ignored.
+			void remove(MeshHandle handle) noexcept;
+			void remove(TextureHandle handle) noexcept;
+			void remove(ProgramHandle handle) noexcept;
+			void remove(FrameBufferHandle handle) noexcept;
+
+			BasicMesh const& mesh(MeshHandle handle) const;
+			GLuint texture(TextureHandle handle) const;
+			GLuint program(ProgramHandle handle) const;
+			GLuint frameBuffer(FrameBufferHandle handle) const;
+
+			BasicMesh const* findMesh(MeshHandle handle) const noexcept;
+			GLuint findTexture(TextureHandle handle) const noexcept;
+			GLuint findProgram(ProgramHandle handle) const noexcept;
+			GLuint findFrameBuffer(FrameBufferHandle handle) const noexcept;
+
+			SlotMap<BasicMesh> const& meshes() const noexcept { return m_meshes; }
+			SlotMap<mem::gl::Texture> const& textures() const noexcept { return m_textures; }
+			SlotMap<mem::gl::Program> const& programs() const noexcept { return m_programs; }
+			SlotMap<mem::gl::FrameBuffer> const& frameBuffers() const noexcept { return m_frameBuffers; }
+		};
+	}
+}
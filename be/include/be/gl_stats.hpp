@@ -0,0 +1,165 @@
+/*
+//	be/gl_stats
+//	Counts the OpenGL calls, primitives and upload bytes of each frame, and times them on the GPU, bucketed by pass.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <glew/glew.h>
+#include <cress/moo/defer.hpp>
+
+namespace be
+{
+	namespace gl
+	{
+		struct FrameStats
+		{
+			std::uint64_t drawCalls{};
+			std::uint64_t primitives{};
+			std::uint64_t programBinds{};
+			std::uint64_t vertexArrayBinds{};
+			std::uint64_t textureBinds{};
+			std::uint64_t frameBufferBinds{};
+			std::uint64_t uniformCalls{};
+			std::uint64_t bufferUploadBytes{}; // glBufferData and glBufferSubData
+			std::uint64_t textureUploadBytes{}; // be::gl::texImage2D with pixel data
+			std::uint64_t gpuNanoseconds{}; // see setGpuTimingEnabled
+
+			std::uint64_t stateChanges() const noexcept
+			{
+				return programBinds + vertexArrayBinds + textureBinds + frameBufferBinds;
+			}
+
+			FrameStats& operator+=(FrameStats const& other) noexcept
+			{
+				drawCalls += other.drawCalls;
+				primitives += other.primitives;
+				programBinds += other.programBinds;
+				vertexArrayBinds += other.vertexArrayBinds;
+				textureBinds += other.textureBinds;
+				frameBufferBinds += other.frameBufferBinds;
+				uniformCalls += other.uniformCalls;
+				bufferUploadBytes += other.bufferUploadBytes;
+				textureUploadBytes += other.textureUploadBytes;
+				gpuNanoseconds += other.gpuNanoseconds;
+				return *this;
+			}
+		};
+
+		struct PassStats
+		{
+			char const* name{};
+			FrameStats stats{};
+		};
+
+		namespace detail
+		{
+			// only touched by the thread that owns the GL context.
+			inline bool s_statsEnabled = false;
+			inline FrameStats s_frameStats{};
+			inline std::vector<PassStats> s_passStats;
+			inline std::ptrdiff_t s_currentPass = -1;
+
+			inline void count(std::uint64_t FrameStats::* counter, std::uint64_t n = 1) noexcept
+			{
+				s_frameStats.*counter += n;
+				if (s_currentPass >= 0) { s_passStats[s_currentPass].stats.*counter += n; }
+			}
+
+			void countDraw(GLenum mode, GLsizei count, GLsizei instances = 1) noexcept;
+			void countTextureUpload(GLsizei width, GLsizei height, GLenum format, GLenum type, void const* pixels) noexcept;
+		}
+
+		/*
+		//	Installs counting wrappers over the GLEW function pointers, or restores the originals.
+		//	Requires glewInit to have succeeded.
+		*/
+		void setStatsEnabled(bool enabled) noexcept;
+		inline bool isStatsEnabled() noexcept { return detail::s_statsEnabled; }
+
+		/*
+		//	Times each pass on the GPU with a pair of timestamp queries while stats are enabled.
+		//	Results are read back without stalling, a few frames late: resetFrameStats adds the ones
+		//	that are ready to the new frame's gpuNanoseconds, so averages over many frames are right
+		//	but a single frame shows older work. A pass's time includes the passes nested in it;
+		//	the frame total counts outermost passes only, so time outside any pass is not included.
+		//	Returns false and stays disabled if the context lacks timer queries (GL 3.3 or ARB_timer_query).
+		*/
+		bool setGpuTimingEnabled(bool enabled) noexcept;
+		bool isGpuTimingEnabled() noexcept;
+
+		// Everything counted since the last reset.
+		inline FrameStats const& getFrameStats() noexcept { return detail::s_frameStats; }
+
+		// One entry per pass ever entered while enabled, in first-entered order. Reset zeroes them.
+		inline std::vector<PassStats> const& getAllPassStats() noexcept { return detail::s_passStats; }
+
+		// Zero if the pass was not entered since the last reset.
+		FrameStats getPassStats(std::string_view name) noexcept;
+
+		// Call between frames, outside any pass.
+		void resetFrameStats() noexcept;
+
+		/*
+		//	Attributes the calls made during its lifetime to the named pass.
+		//	Passes nest; calls count towards the innermost pass only, and always towards the frame total.
+		//	|name| is kept while stats are enabled, so pass a string literal.
+		*/
+		class PassScope
+		{
+		private:
+			std::ptrdiff_t m_previous = -1;
+			bool m_active = false;
+			GLuint m_beginQuery = 0; // when timing on the GPU
+
+		public:
+			explicit PassScope(char const* name) noexcept;
+			~PassScope() noexcept;
+			PassScope(PassScope const&) = delete;
+			PassScope& operator=(PassScope const&) = delete;
+		};
+
+		// OpenGL 1.1 entry points are not loaded through GLEW, so call sites count them with these.
+
+		inline void drawArrays(GLenum mode, GLint first, GLsizei count) noexcept
+		{
+			if (detail::s_statsEnabled) { detail::countDraw(mode, count); }
+			glDrawArrays(mode, first, count);
+		}
+
+		inline void drawElements(GLenum mode, GLsizei count, GLenum type, void const* indices) noexcept
+		{
+			if (detail::s_statsEnabled) { detail::countDraw(mode, count); }
+			glDrawElements(mode, count, type, indices);
+		}
+
+		inline void bindTexture(GLenum target, GLuint texture) noexcept
+		{
+			if (detail::s_statsEnabled) { detail::count(&FrameStats::textureBinds); }
+			glBindTexture(target, texture);
+		}
+
+		inline void texImage2D(
+			GLenum target, GLint level, GLint internalFormat,
+			GLsizei width, GLsizei height, GLint border,
+			GLenum format, GLenum type, void const* pixels) noexcept
+		{
+			if (detail::s_statsEnabled) { detail::countTextureUpload(width, height, format, type, pixels); }
+			glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+		}
+	}
+}
+
+#ifdef BE_GL_STATS_DISABLE
+#define BE_GL_STATS_PASS(name) static_cast<void>(0)
+#else
+#define BE_GL_STATS_PASS(name)\
+	::be::gl::PassScope CRESS_MOO_ANONYMOUS_IDENTIFIER{ name }
+#endif
@@ -0,0 +1,111 @@
+/*
+//	be/gpu_memory
+//	Accounts for the GPU memory held by GL objects, by category and debug label.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glew/glew.h>
+
+namespace be
+{
+	namespace gpu_memory
+	{
+		enum class Category : std::uint8_t
+		{
+			Other,
+			Mesh, // vertex, index and draw id buffers
+			Texture, // loaded or streamed images
+			RenderTarget, // framebuffers and their attachments
+			Streaming, // per-frame upload rings
+			Glyph, // font glyph textures
+		};
+		inline constexpr std::size_t categoryCount = 6;
+
+		char const* toString(Category category) noexcept;
+
+		enum class ObjectKind : std::uint8_t
+		{
+			Buffer,
+			Texture,
+			FrameBuffer, // holds no storage of its own; tracked for leak reports
+		};
+
+		/*
+		//	The be::mem::gl factories track the objects they create and their deleters untrack them.
+		//	The code that allocates storage records its size, since only it knows the format:
+		//		auto texture = be::mem::gl::makeTexture(be::gpu_memory::Category::RenderTarget, "shadow map");
+		//		be::gl::texImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, w, h, ...);
+		//		be::gpu_memory::setTextureLevel(texture.get(), 0, w, h, GL_DEPTH_COMPONENT);
+		//	Sizes are estimates from the internal format; drivers may pad or compress.
+		//	|label| must have static storage duration (e.g. a string literal).
+		//	Main thread (GL context) only.
+		*/
+
+		// Tracking an already tracked object changes its category and label, keeping its size.
+		void track(ObjectKind kind, GLuint name, Category category, char const* label);
+		void untrack(ObjectKind kind, GLuint name) noexcept;
+
+		// Untracked names are ignored.
+		void setBufferBytes(GLuint buffer, std::uint64_t bytes) noexcept;
+		// A zero width or height releases the level.
+		void setTextureLevel(GLuint texture, GLint level, GLsizei width, GLsizei height, GLenum internalFormat) noexcept;
+		// Reads the size of each level back from GL, up to the first empty one,
+		// for textures a library allocated, e.g. SOIL.
+		// |target| is GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP. Leaves the texture bound to GL_TEXTURE0, as SOIL does.
+		void measureTexture(GLuint texture, GLenum target) noexcept;
+
+		struct CategoryTotals
+		{
+			std::uint64_t bytes{};
+			std::uint64_t objects{};
+		};
+
+		struct Totals
+		{
+			std::uint64_t bytes{};
+			std::uint64_t objects{};
+			std::uint64_t peakBytes{};
+			std::uint64_t frameAllocatedBytes{}; // since the last beginFrame
+			std::uint64_t frameReleasedBytes{};
+			std::array<CategoryTotals, categoryCount> categories{};
+		};
+
+		struct LabelTotals
+		{
+			char const* label{};
+			Category category{};
+			std::uint64_t bytes{};
+			std::uint64_t objects{};
+		};
+
+		struct LiveObject
+		{
+			ObjectKind kind{};
+			GLuint name{};
+			Category category{};
+			char const* label{};
+			std::uint64_t bytes{};
+		};
+
+		// Zeroes the frame counts. Application calls this at the start of each frame.
+		void beginFrame() noexcept;
+
+		Totals getTotals() noexcept;
+
+		// Largest first.
+		std::vector<LabelTotals> getLabelTotals();
+
+		std::vector<LiveObject> getLiveObjects();
+
+		// Logs every object still tracked as a leak. Application calls this after destroying the game.
+		void logLiveObjects() noexcept;
+	}
+}
@@ -0,0 +1,55 @@
+/*
+//	be/headless
+//	Offscreen OpenGL context for running without a display.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+namespace be
+{
+	namespace headless
+	{
+		class HeadlessContextException final : public std::runtime_error
+		{
+		public:
+			explicit HeadlessContextException(std::string const& msg)
+				: std::runtime_error("[be::headless] headless context exception: " + msg)
+			{}
+		};
+
+		/*
+		//	Creates an OpenGL 3.3 compatibility context and makes it current on the calling thread.
+		//	The default framebuffer (0) is an offscreen surface of the given size,
+		//	so rendering code that targets framebuffer 0 works unchanged.
+		//
+		//	Linux: an EGL pbuffer, preferring the Mesa surfaceless platform.
+		//		Software GL (llvmpipe) is sufficient; set LIBGL_ALWAYS_SOFTWARE=1 to force it.
+		//	Win32: a hidden freeglut window.
+		*/
+		class Context
+		{
+		private:
+			struct Impl;
+			Impl* m_impl;
+
+		public:
+			Context(int width, int height);
+			~Context() noexcept;
+			Context(Context const&) = delete;
+			Context& operator=(Context const&) = delete;
+
+			int width() const noexcept;
+			int height() const noexcept;
+
+			// Equivalent of swapping buffers. Blocks until the GPU has finished the frame,
+			// so frame timings measure the work rather than how far ahead the driver queued it.
+			void finishFrame() noexcept;
+		};
+	}
+}
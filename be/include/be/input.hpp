@@ -10,8 +10,11 @@
 
 #include <glew/glew.h>
 #include <freeglut/freeglut.h>
-#include <map>
-#include <optional>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 #include <glm/vec2.hpp>
 
 namespace be
@@ -26,8 +29,102 @@ namespace be
 		GoingDownAgain = 0b0111,
 	};
 
-	template<class Key>
-	using InputMap = std::map<Key, InputState>;
+	/*
+	//	Fixed-size state of every key of one kind, indexed through KeyIndex::of(key).
+	//	Keys without an index read as CurrentlyUp and ignore updates.
+	//	A bit per key records which ones changed since the last afterUpdate,
+	//	so afterUpdate only visits those.
+	*/
+	template<class Key, std::size_t N, class KeyIndex>
+	class InputTable
+	{
+	private:
+		static constexpr std::size_t wordBits = 64;
+		static constexpr std::size_t wordCount = (N + wordBits - 1) / wordBits;
+
+		std::array<InputState, N> m_states{};
+		std::array<std::uint64_t, wordCount> m_changed{};
+
+	public:
+		using key_type = Key;
+		static constexpr std::size_t size = N;
+
+		static constexpr std::size_t indexOf(Key const key) noexcept { return KeyIndex::of(key); }
+
+		constexpr InputState get(Key const key) const noexcept
+		{
+			std::size_t const i = indexOf(key);
+			return i < N ? m_states[i] : InputState::CurrentlyUp;
+		}
+
+		// Returns the new state, or CurrentlyUp for keys without an index.
+		constexpr InputState set(Key const key, InputState const state) noexcept
+		{
+			std::size_t const i = indexOf(key);
+			if (i >= N) { return InputState::CurrentlyUp; }
+			m_states[i] = state;
+			m_changed[i / wordBits] |= std::uint64_t{ 1 } << (i % wordBits);
+			return state;
+		}
+
+		// Calls f(InputState&) for each state changed since the last call, and forgets the changes.
+		template<class F>
+		constexpr void consumeChanged(F&& f) noexcept
+		{
+			for (std::size_t w = 0; w < wordCount; ++w)
+			{
+				std::uint64_t bits = std::exchange(m_changed[w], 0);
+				while (bits)
+				{
+					std::size_t const bit = static_cast<std::size_t>(std::countr_zero(bits));
+					bits &= bits - 1;
+					f(m_states[w * wordBits + bit]);
+				}
+			}
+		}
+
+		constexpr void clear() noexcept
+		{
+			m_states.fill(InputState::CurrentlyUp);
+			m_changed.fill(0);
+		}
+	};
+
+	namespace input
+	{
+		struct KeyboardKeyIndex
+		{
+			static constexpr std::size_t of(unsigned char const key) noexcept { return key; }
+		};
+
+		// Packs GLUT_KEY_F1..F12 then GLUT_KEY_LEFT..GLUT_KEY_ALT_R (freeglut) into 0..29.
+		struct SpecialKeyIndex
+		{
+			static constexpr std::size_t count = 12 + (0x75 - 0x64 + 1);
+
+			static constexpr std::size_t of(int const key) noexcept
+			{
+				if (key >= 0x01 && key <= 0x0C) { return static_cast<std::size_t>(key - 0x01); }
+				if (key >= 0x64 && key <= 0x75) { return static_cast<std::size_t>(12 + key - 0x64); }
+				return count;
+			}
+		};
+
+		// GLUT_LEFT_BUTTON, MIDDLE, RIGHT, the wheel as buttons 3 and 4, and a few extra buttons.
+		struct MouseButtonIndex
+		{
+			static constexpr std::size_t count = 8;
+
+			static constexpr std::size_t of(int const button) noexcept
+			{
+				return button >= 0 && button < static_cast<int>(count) ? static_cast<std::size_t>(button) : count;
+			}
+		};
+	}
+
+	using KeyboardKeyTable = InputTable<unsigned char, 256, input::KeyboardKeyIndex>;
+	using SpecialKeyTable = InputTable<int, input::SpecialKeyIndex::count, input::SpecialKeyIndex>;
+	using MouseButtonTable = InputTable<int, input::MouseButtonIndex::count, input::MouseButtonIndex>;
 
 	/*enum class MouseWheelState : std::int_fast8_t
 	{
@@ -38,9 +135,9 @@ namespace be
 
 	struct Input
 	{
-		InputMap<unsigned char> keyboardKeys;
-		InputMap<int> specialKeys;
-		InputMap<int> mouseButtons;
+		KeyboardKeyTable keyboardKeys;
+		SpecialKeyTable specialKeys;
+		MouseButtonTable mouseButtons;
 	};
 
 	namespace input
@@ -68,61 +165,45 @@ namespace be
 			return InputState::GoingUp == state;
 		}
 
-		inline void clearInputStates(Input& input) noexcept
+		inline constexpr void clearInputStates(Input& input) noexcept
 		{
 			input.keyboardKeys.clear();
 			input.specialKeys.clear();
 			input.mouseButtons.clear();
 		}
 
-		template<class Key>
-		InputState getElseConsiderUp(InputMap<Key> const& states, Key const& key) noexcept
+		template<class Table>
+		constexpr InputState getElseConsiderUp(Table const& states, typename Table::key_type const key) noexcept
 		{
-			if (auto const it = states.find(static_cast<Key>(key));
-				it != states.end())
-			{
-				return it->second;
-			}
-			else
-			{
-				return InputState::CurrentlyUp;
-			}
+			return states.get(key);
 		}
 
-		template<class Key>
-		InputState informGoingDown(InputMap<Key>& states, Key const& key)
+		template<class Table>
+		constexpr InputState informGoingDown(Table& states, typename Table::key_type const key) noexcept
 		{
-			auto& state = states[key];
-			switch (state)
+			switch (states.get(key))
 			{
 			case InputState::CurrentlyDown:
 			case InputState::GoingDown:
 			case InputState::GoingDownAgain:
-				state = InputState::GoingDownAgain;
-				break;
+				return states.set(key, InputState::GoingDownAgain);
 			default:
-				state = InputState::GoingDown;
-				break;
+				return states.set(key, InputState::GoingDown);
 			}
-			return state;
 		}
 
-		template<class Key>
-		InputState informGoingUp(InputMap<Key>& states, Key const& key)
+		template<class Table>
+		constexpr InputState informGoingUp(Table& states, typename Table::key_type const key) noexcept
 		{
-			auto& state = states[key];
-			switch (state)
+			switch (states.get(key))
 			{
 			case InputState::CurrentlyUp:
 			case InputState::GoingUp:
 			case InputState::GoingUpAgain:
-				state = InputState::GoingUpAgain;
-				break;
+				return states.set(key, InputState::GoingUpAgain);
 			default:
-				state = InputState::GoingUp;
-				break;
+				return states.set(key, InputState::GoingUp);
 			}
-			return state;
 		}
 
 		//MouseWheelState informGoingPositive(Input& input, int wheel)
@@ -130,7 +211,7 @@ namespace be
 		//	input.mouseWheels[wheel] = MouseWheelState::Positive;
 		//}
 
-		inline void afterUpdate(InputState& state) noexcept
+		inline constexpr void afterUpdate(InputState& state) noexcept
 		{
 			switch (state)
 			{
@@ -145,16 +226,13 @@ namespace be
 			}
 		}
 
-		template<class Key>
-		void afterUpdate(InputMap<Key>& states) noexcept
+		template<class Key, std::size_t N, class KeyIndex>
+		constexpr void afterUpdate(InputTable<Key, N, KeyIndex>& states) noexcept
 		{
-			for (auto& [_, state] : states)
-			{
-				afterUpdate(state);
-			}
+			states.consumeChanged([](InputState& state) { afterUpdate(state); });
 		}
 
-		inline void afterUpdate(Input& input) noexcept
+		inline constexpr void afterUpdate(Input& input) noexcept
 		{
 			afterUpdate(input.keyboardKeys);
 			afterUpdate(input.specialKeys);
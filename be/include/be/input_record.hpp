@@ -0,0 +1,76 @@
+/*
+//	be/input_record
+//	Records the input a Game receives, keyed by update step, and replays it deterministically.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "be/game.hpp"
+
+namespace be
+{
+	namespace input_record
+	{
+		class InputRecordException final : public std::runtime_error
+		{
+		public:
+			explicit InputRecordException(std::string const& msg)
+				: std::runtime_error("[be::input_record] input record exception: " + msg)
+			{}
+		};
+
+		// One per Game input callback. Values are stored in the file, so only append.
+		enum class EventType : std::uint8_t
+		{
+			WindowSize = 0, // a = width, b = height
+			WindowPosition = 1, // a = x, b = y
+			MousePosition = 2, // a = x, b = y
+			KeyDown = 3, // a = key
+			KeyUp = 4, // a = key
+			SpecialDown = 5, // a = keycode
+			SpecialUp = 6, // a = keycode
+			MouseButtonDown = 7, // a = button
+			MouseButtonUp = 8, // a = button
+			MouseWheelPositive = 9, // a = wheel
+			MouseWheelNegative = 10, // a = wheel
+			MouseMoveWhileAnyDown = 11,
+			MouseMoveWhileAllUp = 12,
+			MouseEnteredWindow = 13,
+			MouseLeftWindow = 14,
+		};
+
+		struct Event
+		{
+			std::uint64_t step{}; // delivered before the Game::Update with this index
+			EventType type{};
+			std::int32_t a{};
+			std::int32_t b{};
+		};
+
+		struct Log
+		{
+			double fixedTimestep{}; // replays must step by the same amount
+			std::uint64_t endStep{}; // updates run while recording
+			std::vector<Event> events; // in delivery order
+		};
+
+		/*
+		//	Little endian: "BEIR", a u32 version, the f64 timestep, the u64 end step and event count,
+		//	then per event the step delta from the previous event, the type, and its arguments,
+		//	all as LEB128 varints (arguments zigzag encoded). A typical event takes 3 to 6 bytes.
+		*/
+		void writeLog(std::string const& path, Log const& log);
+		Log readLog(std::string const& path);
+
+		// Calls the Game method the event came from.
+		void dispatch(Game& game, Event const& event);
+	}
+}
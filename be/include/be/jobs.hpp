@@ -0,0 +1,174 @@
+/*
+//	be/jobs
+//	Fixed pool of worker threads with work-stealing deques, parallel loops and a main thread queue.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace be
+{
+	namespace jobs
+	{
+		class JobsException final : public std::runtime_error
+		{
+		public:
+			explicit JobsException(std::string const& msg)
+				: std::runtime_error("[be::jobs] jobs exception: " + msg)
+			{}
+		};
+
+		/*
+		//	Counts the unfinished jobs that were run with it.
+		//	A job that depends on others waits on their counter, which runs queued jobs meanwhile.
+		//	Must outlive the jobs that reference it.
+		*/
+		class Counter
+		{
+		private:
+			std::atomic<std::size_t> m_pending{ 0 };
+
+		public:
+			Counter() = default;
+			Counter(Counter const&) = delete;
+			Counter& operator=(Counter const&) = delete;
+
+			bool isDone() const noexcept { return 0 == m_pending.load(std::memory_order_acquire); }
+
+			void add(std::size_t n = 1) noexcept { m_pending.fetch_add(n, std::memory_order_relaxed); }
+			void done() noexcept { m_pending.fetch_sub(1, std::memory_order_release); }
+		};
+
+		// Must not throw. Copied when queued, so |data| must outlive the job, not the Job itself.
+		struct Job
+		{
+			void (*function)(void* data, std::size_t begin, std::size_t end) noexcept = nullptr;
+			void* data = nullptr;
+			std::size_t begin{};
+			std::size_t end{};
+			Counter* counter = nullptr; // optional
+		};
+
+		/*
+		//	Starts |workerCount| worker threads. The calling thread becomes the main thread.
+		//	Only the main thread and the workers queue jobs; other threads run them inline.
+		//	With zero workers every job runs inline on the thread that runs it.
+		*/
+		void start(unsigned workerCount);
+
+		// Finishes the queued jobs, then joins the workers. Main thread only.
+		void stop() noexcept;
+
+		bool isRunning() noexcept;
+		bool isMainThread() noexcept;
+		unsigned getWorkerCount() noexcept; // 0 when not running
+
+		// One fewer than the hardware threads, leaving one for the main thread.
+		unsigned getDefaultWorkerCount() noexcept;
+
+		// Queues the job, or runs it inline if it cannot be queued.
+		void run(Job const& job) noexcept;
+
+		// Runs queued jobs on the calling thread until the counter is done.
+		void wait(Counter const& counter) noexcept;
+
+		// Queues |task| to run on the main thread during the next runMainThreadTasks, e.g. for GL calls.
+		void runOnMainThread(std::function<void()> task);
+
+		// Main thread only. Called once per frame by Application. Returns the number of tasks run.
+		std::size_t runMainThreadTasks() noexcept;
+
+		class Scope
+		{
+		public:
+			explicit Scope(unsigned workerCount) { start(workerCount); }
+			~Scope() noexcept { stop(); }
+			Scope(Scope const&) = delete;
+			Scope& operator=(Scope const&) = delete;
+		};
+
+		namespace detail
+		{
+			// queues without waking a worker, so a batch can wake them once.
+			void submit(Job const& job) noexcept;
+			void wakeWorkers() noexcept;
+
+			template <typename Body>
+			struct ParallelFor
+			{
+				Body const* body;
+				std::atomic<bool> failed{ false };
+				std::exception_ptr exception{};
+
+				static void invoke(void* data, std::size_t begin, std::size_t end) noexcept
+				{
+					auto& self = *static_cast<ParallelFor*>(data);
+					if (self.failed.load(std::memory_order_relaxed)) { return; }
+					try
+					{
+						(*self.body)(begin, end);
+					}
+					catch (...)
+					{
+						// the first exception wins; the rest are dropped.
+						if (!self.failed.exchange(true)) { self.exception = std::current_exception(); }
+					}
+				}
+			};
+		}
+
+		/*
+		//	Calls body(begin, end) over disjoint ranges covering [0, count) and returns when all are done.
+		//	The range is split into a few chunks per thread, none smaller than |minChunkSize|.
+		//	The calling thread takes the first chunk. If a body throws, the remaining chunks
+		//	are skipped and the first exception is rethrown here.
+		*/
+		template <typename Body>
+		void parallelFor(std::size_t const count, Body const& body, std::size_t const minChunkSize = 1)
+		{
+			if (count == 0) { return; }
+
+			std::size_t const threads = static_cast<std::size_t>(getWorkerCount()) + 1;
+			std::size_t const chunksPerThread = 4;
+			std::size_t const chunkSize = std::max<std::size_t>(
+				std::max<std::size_t>(minChunkSize, 1),
+				(count + threads * chunksPerThread - 1) / (threads * chunksPerThread));
+
+			if (threads == 1 || chunkSize >= count)
+			{
+				body(std::size_t{ 0 }, count);
+				return;
+			}
+
+			detail::ParallelFor<Body> state{ &body };
+			Counter counter;
+			for (std::size_t begin = chunkSize; begin < count; begin += chunkSize)
+			{
+				counter.add();
+				detail::submit(Job{
+					.function = &detail::ParallelFor<Body>::invoke,
+					.data = &state,
+					.begin = begin,
+					.end = std::min(count, begin + chunkSize),
+					.counter = &counter,
+					});
+			}
+			detail::wakeWorkers();
+
+			detail::ParallelFor<Body>::invoke(&state, 0, chunkSize);
+			wait(counter);
+
+			if (state.exception) { std::rethrow_exception(state.exception); }
+		}
+	}
+}
@@ -0,0 +1,179 @@
+/*
+//	be/light_clusters
+//	Clustered forward lighting: point lights binned into view-space froxels on the CPU every frame.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "be/mem/gl.hpp"
+#include "be/stream_buffer.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		class LightClustersException final : public std::runtime_error
+		{
+		public:
+			explicit LightClustersException(std::string const& msg)
+				: std::runtime_error("[be::gl] light clusters exception: " + msg)
+			{}
+		};
+
+		struct ClusteredLight
+		{
+			glm::vec3 position{}; // world space
+			float range = 1.0f; // the light fades to nothing here
+			glm::vec3 color = glm::vec3(1.0f);
+		};
+
+		// The perspective camera the clusters are built for.
+		struct ClusterView
+		{
+			glm::mat4 view = glm::mat4();
+			float fovY = 1.0f; // radians
+			float aspect = 1.0f;
+			float nearClip = 0.1f;
+			float farClip = 100.0f;
+			glm::ivec2 viewportSize = glm::ivec2(1);
+		};
+
+		// Measured by the latest assign.
+		struct LightClusterStats
+		{
+			double assignMs{}; // CPU time binning the lights, including the upload copy
+			std::uint32_t visibleLights{}; // lights touching at least one cluster
+			std::uint32_t indices{}; // light references over all clusters
+			std::uint32_t occupiedClusters{};
+			std::uint32_t maxLightsPerCluster{};
+			std::uint32_t droppedIndices{}; // references past maxIndices, left out
+		};
+
+		/*
+		//	The view frustum is split into tilesX by tilesY screen tiles and |slices| depth slices,
+		//	spaced logarithmically between the near and far clip so froxels stay roughly cubic.
+		//
+		//	assign bins the lights in two parallel phases on be::jobs:
+		//		1. each light's view-space bounding box is projected to a range of tiles and slices,
+		//		   four lights at a time in SSE2 over structure-of-arrays scratch, finding slices by
+		//		   comparing against the slice boundaries rather than taking a log per light;
+		//		2. each slice gathers the lights whose range covers it and writes a compact index list
+		//		   per cluster (count, then fill), so no cluster has a fixed capacity.
+		//	The slices are then joined into one list in order, so the result does not depend on timing.
+		//	The box is conservative: a cluster may list a light that just misses it, never the reverse.
+		//
+		//	Shaders paste in lightClustersGlsl and call calcClusteredLighting; its uniforms are set with
+		//	uniformLightClusters while lightTexture() and dataTexture() are bound as GL_TEXTURE_BUFFERs.
+		*/
+		class LightClusters
+		{
+		private:
+			int m_tilesX{};
+			int m_tilesY{};
+			int m_slices{};
+			int m_maxLights{};
+			int m_maxIndices{};
+
+			// per light, structure of arrays. A light touches no cluster if its min slice is above its max.
+			std::vector<float> m_viewX, m_viewY, m_viewZ, m_range;
+			std::vector<std::int32_t> m_minX, m_maxX, m_minY, m_maxY, m_minSlice, m_maxSlice;
+			std::vector<float> m_sliceStarts; // the view depth each slice after the first starts at
+
+			// per slice: (first, count) for each of its clusters, first counting from the slice's own indices.
+			struct SliceLists
+			{
+				std::vector<std::uint32_t> clusters;
+				std::vector<std::uint32_t> indices;
+			};
+			std::vector<SliceLists> m_sliceLists;
+
+			std::vector<glm::vec4> m_lightTexels;
+			std::vector<std::uint32_t> m_data; // per cluster (first, count), then the indices
+
+			StreamBuffer m_lightStream;
+			StreamBuffer m_dataStream;
+			mem::gl::Texture m_lightTexture;
+			mem::gl::Texture m_dataTexture;
+			GLint m_lightBase{};
+			GLint m_dataBase{};
+
+			ClusterView m_view;
+			LightClusterStats m_stats;
+
+		public:
+			struct CreateInfo
+			{
+				int tilesX = 16; // require > 0
+				int tilesY = 9; // require > 0
+				int slices = 24; // require > 0
+				int maxLights = 1024; // require > 0
+				int maxIndices = 16 * 9 * 24 * 16; // light references over all clusters per frame. require > 0
+			};
+
+			LightClusters() = default;
+			explicit LightClusters(CreateInfo const& info);
+
+			int tilesX() const noexcept { return m_tilesX; }
+			int tilesY() const noexcept { return m_tilesY; }
+			int slices() const noexcept { return m_slices; }
+			int clusterCount() const noexcept { return m_tilesX * m_tilesY * m_slices; }
+			int maxLights() const noexcept { return m_maxLights; }
+
+			// Bins and uploads |lights|. Throws if there are more than maxLights.
+			void assign(ClusterView const& view, std::span<ClusteredLight const> lights);
+
+			LightClusterStats const& stats() const noexcept { return m_stats; }
+
+			// Per light: position and range, then colour; GL_RGBA32F.
+			GLuint lightTexture() const noexcept { return m_lightTexture.get(); }
+			// Per cluster: first index and count, then the light indices; GL_R32UI.
+			GLuint dataTexture() const noexcept { return m_dataTexture.get(); }
+			// Where the latest assign starts in each texture, in texels.
+			GLint lightBase() const noexcept { return m_lightBase; }
+			GLint dataBase() const noexcept { return m_dataBase; }
+			// The view of the latest assign.
+			ClusterView const& view() const noexcept { return m_view; }
+
+			// Call after the draws that read the latest assign.
+			void fence();
+		};
+
+		/*
+		//	GLSL for fragment shaders, pasted in ahead of their main:
+		//		vec3 calcClusteredLighting(vec3 worldPosition, vec3 normal, vec3 viewDir)
+		//			the Blinn-Phong diffuse and specular of every light in the fragment's cluster,
+		//			attenuated by (1 - distance / range) squared
+		//		int countClusterLights(vec3 worldPosition)
+		//			how many lights that fragment loops over, for heat maps
+		*/
+		extern char const* const lightClustersGlsl;
+
+		struct LightClusterUniformLocations
+		{
+			GLuint lights{};
+			GLuint data{};
+			GLuint lightBase{};
+			GLuint dataBase{};
+			GLuint counts{};
+			GLuint tileSize{};
+			GLuint depthRow{};
+			GLuint sliceScaleBias{};
+		};
+		LightClusterUniformLocations getLightClusterUniformLocations(GLuint program);
+		// |lightsUnit| and |dataUnit| are the texture units lightTexture() and dataTexture() are bound to.
+		void uniformLightClusters(LightClusterUniformLocations const& locations, LightClusters const& clusters, GLint lightsUnit, GLint dataUnit);
+	}
+}
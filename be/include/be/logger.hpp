@@ -1,6 +1,6 @@
 /*
 //	be/logger
-//	Used by Application for logging exceptions.
+//	Used by Application for logging exceptions and leveled messages.
 //
 //	Elijah Shadbolt
 //	2019
@@ -8,8 +8,25 @@
 
 #pragma once
 
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
 namespace be
 {
+	enum class LogLevel : std::uint8_t
+	{
+		Debug,
+		Info,
+		Warning,
+		Error,
+	};
+
+	char const* toString(LogLevel level) noexcept;
+
+
+
 	// Interface
 	class Logger
 	{
@@ -24,14 +41,25 @@ namespace be
 
 	private:
 		// INTERFACE METHODS
-		virtual void LogException() noexcept = 0;
+		virtual void LogException() noexcept = 0; // called inside a catch block
+		virtual void Log(LogLevel level, std::string_view message) noexcept = 0;
+		// false if messages of |level| would be discarded, so logf can skip formatting them.
+		virtual bool IsEnabled(LogLevel) const noexcept { return true; }
 
 	public:
 		void logException() noexcept { LogException(); }
+		void log(LogLevel level, std::string_view message) noexcept { Log(level, message); }
+		bool isEnabled(LogLevel level) const noexcept { return IsEnabled(level); }
+
+		// printf style. Formats into a stack buffer, so messages past maxFormattedLength are truncated.
+		static constexpr std::size_t maxFormattedLength = 511;
+		void logf(LogLevel level, char const* format, ...) noexcept;
+		void vlogf(LogLevel level, char const* format, std::va_list args) noexcept;
 	};
 
 
 
+	// Writes synchronously to std::cerr. See be/async_logger.hpp for use inside the frame loop.
 	class DefaultLogger final : public Logger
 	{
 	public:
@@ -43,5 +71,6 @@ namespace be
 		DefaultLogger& operator=(DefaultLogger const&) = default;
 	private:
 		void LogException() noexcept final;
+		void Log(LogLevel level, std::string_view message) noexcept final;
 	};
 }
@@ -0,0 +1,62 @@
+/*
+//	be/mem/frame_arena
+//	A bump allocator for temporaries that only live until the end of the frame.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace be
+{
+	namespace mem
+	{
+		/*
+		//	Allocating bumps a pointer, deallocating does nothing, and reset frees everything at once.
+		//	It is a std::pmr::memory_resource, so the std::pmr containers can use it:
+		//		be::mem::FrameVector<Material const*> materials{ &be::mem::getFrameArena() };
+		//	A frame that needs more than the block holds gets overflow blocks from the heap,
+		//	and the next reset grows the block to fit, so steady-state frames never touch the heap.
+		//	Not thread safe.
+		*/
+		class FrameArena final : public std::pmr::memory_resource
+		{
+		private:
+			std::unique_ptr<std::byte[]> m_block;
+			std::size_t m_capacity{};
+			std::size_t m_used{};
+			std::vector<std::unique_ptr<std::byte[]>> m_overflow;
+			std::size_t m_overflowBytes{};
+			std::size_t m_peak{};
+
+		public:
+			explicit FrameArena(std::size_t capacity = 256 * 1024);
+			FrameArena(FrameArena const&) = delete;
+			FrameArena& operator=(FrameArena const&) = delete;
+
+			// Invalidates everything allocated since the last reset.
+			void reset();
+
+			std::size_t capacity() const noexcept { return m_capacity; }
+			std::size_t used() const noexcept { return m_used + m_overflowBytes; } // since the last reset
+			std::size_t peak() const noexcept { return m_peak; } // most used in one frame
+
+		private:
+			void* do_allocate(std::size_t bytes, std::size_t alignment) final;
+			void do_deallocate(void*, std::size_t, std::size_t) noexcept final {}
+			bool do_is_equal(std::pmr::memory_resource const& other) const noexcept final { return this == &other; }
+		};
+
+		template<class T>
+		using FrameVector = std::pmr::vector<T>;
+
+		// Reset by Application at the start of each frame. Main thread only.
+		FrameArena& getFrameArena() noexcept;
+	}
+}
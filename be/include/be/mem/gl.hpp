@@ -13,6 +13,8 @@
 #include <memory>
 #include <cress/moo/defer.hpp>
 #include "fraii.hpp"
+#include "be/gl_stats.hpp"
+#include "be/gpu_memory.hpp"
 
 namespace be
 {
@@ -46,29 +48,46 @@ namespace be
 
 
 
-			struct BufferDeleter { void operator()(GLuint p) { glDeleteBuffers(1, &p); } };
+			// The factories below track their objects in be::gpu_memory; see there for recording sizes.
+
+			struct BufferDeleter { void operator()(GLuint p) { if (p) { gpu_memory::untrack(gpu_memory::ObjectKind::Buffer, p); } glDeleteBuffers(1, &p); } };
 			using Buffer = Fraii<GLuint, BufferDeleter>;
-			inline Buffer makeBuffer() { GLuint p; glGenBuffers(1, &p); return Buffer(p); }
+			inline Buffer makeBuffer(gpu_memory::Category category = gpu_memory::Category::Other, char const* label = "unlabelled")
+			{
+				GLuint p; glGenBuffers(1, &p); Buffer b(p);
+				gpu_memory::track(gpu_memory::ObjectKind::Buffer, p, category, label);
+				return b;
+			}
 
 
 
-			struct TextureDeleter { void operator()(GLuint p) { glDeleteTextures(1, &p); } };
+			struct TextureDeleter { void operator()(GLuint p) { if (p) { gpu_memory::untrack(gpu_memory::ObjectKind::Texture, p); } glDeleteTextures(1, &p); } };
 			using Texture = Fraii<GLuint, TextureDeleter>;
-			inline Texture makeTexture() { GLuint p; glGenTextures(1, &p); return Texture(p); }
+			inline Texture makeTexture(gpu_memory::Category category = gpu_memory::Category::Other, char const* label = "unlabelled")
+			{
+				GLuint p; glGenTextures(1, &p); Texture t(p);
+				gpu_memory::track(gpu_memory::ObjectKind::Texture, p, category, label);
+				return t;
+			}
 
 #define BE_BIND_TEXTURE_SCOPE(target, texture, unit)\
 	glActiveTexture(unit);\
-	glBindTexture(target, texture);\
+	::be::gl::bindTexture(target, texture);\
 	CRESS_MOO_DEFER_CALLABLE([]()noexcept{\
 		glActiveTexture(unit);\
-		glBindTexture(target, 0);\
+		::be::gl::bindTexture(target, 0);\
 	});\
 
 
 
-			struct FrameBufferDeleter { void operator()(GLuint p) { glDeleteFramebuffers(1, &p); } };
+			struct FrameBufferDeleter { void operator()(GLuint p) { if (p) { gpu_memory::untrack(gpu_memory::ObjectKind::FrameBuffer, p); } glDeleteFramebuffers(1, &p); } };
 			using FrameBuffer = Fraii<GLuint, FrameBufferDeleter>;
-			inline FrameBuffer makeFrameBuffer() { GLuint p; glGenFramebuffers(1, &p); return FrameBuffer(p); }
+			inline FrameBuffer makeFrameBuffer(gpu_memory::Category category = gpu_memory::Category::RenderTarget, char const* label = "unlabelled")
+			{
+				GLuint p; glGenFramebuffers(1, &p); FrameBuffer f(p);
+				gpu_memory::track(gpu_memory::ObjectKind::FrameBuffer, p, category, label);
+				return f;
+			}
 
 #define BE_BIND_FRAMEBUFFER_SCOPE(target, framebuffer)\
 	glBindFramebuffer(target, framebuffer);\
@@ -76,6 +95,12 @@ namespace be
 
 
 
+			struct SyncDeleter { void operator()(GLsync p) { if (p) { glDeleteSync(p); } } };
+			using Sync = Fraii<GLsync, SyncDeleter>;
+			inline Sync makeFenceSync() { return Sync(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)); }
+
+
+
 		}
 		//~ namespace
 	}
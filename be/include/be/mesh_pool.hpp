@@ -0,0 +1,158 @@
+/*
+//	be/mesh_pool
+//	Many meshes of one vertex format in shared buffers behind a single vertex array.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "be/gl.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		class MeshPoolException final : public std::runtime_error
+		{
+		public:
+			explicit MeshPoolException(std::string const& msg)
+				: std::runtime_error("[be::gl] mesh pool exception: " + msg)
+			{}
+		};
+
+		/*
+		//	First-fit allocator of ranges of some unit (vertices, indices, texels...).
+		//	Freed ranges are merged with free neighbours, so the free list stays short
+		//	and a run of frees gives back one large range.
+		*/
+		class FreeListAllocator
+		{
+		private:
+			std::map<GLuint, GLuint> m_free; // offset -> count, no two adjacent
+			GLuint m_capacity{};
+			GLuint m_used{};
+
+		public:
+			FreeListAllocator() = default;
+			explicit FreeListAllocator(GLuint capacity);
+
+			// The offset of |count| free units, or std::nullopt if no free range is large enough.
+			std::optional<GLuint> allocate(GLuint count);
+			void free(GLuint offset, GLuint count);
+
+			// Appends free units at the end.
+			void grow(GLuint newCapacity);
+
+			GLuint capacity() const noexcept { return m_capacity; }
+			GLuint used() const noexcept { return m_used; }
+			std::size_t freeRangeCount() const noexcept { return m_free.size(); }
+		};
+
+		struct VertexAttribute
+		{
+			GLuint index{};
+			GLint size{};
+			GLenum type = GL_FLOAT;
+			GLboolean normalized = GL_FALSE;
+			GLsizei offset{};
+		};
+
+		struct VertexFormat
+		{
+			GLsizei stride{};
+			std::vector<VertexAttribute> attributes;
+		};
+
+		// The layout makeBasicMesh uses for BasicVertex.
+		VertexFormat const& basicVertexFormat();
+
+		// The first location after the BasicVertex attributes.
+		constexpr GLint basicDrawIdAttribute = 3;
+
+		// Where a mesh lives in its pool. Indices are relative to baseVertex.
+		struct MeshRange
+		{
+			GLint baseVertex{};
+			GLuint vertexCount{};
+			GLuint firstIndex{};
+			GLsizei indexCount{};
+			GLenum mode = GL_TRIANGLES;
+		};
+
+		/*
+		//	Sub-allocates the vertices and 32-bit indices of many meshes out of one vertex buffer
+		//	and one element buffer, both behind one vertex array. Bind that vertex array once
+		//	per pass with BE_BIND_MESH_POOL_SCOPE, then draw each range with glDrawElementsBaseVertex.
+		//	The buffers grow by copying when full; ranges keep their offsets.
+		//	Ranges stay allocated until removed or the pool is destroyed.
+		*/
+		class MeshPool
+		{
+		private:
+			VertexFormat m_format;
+			mem::gl::VertexArray m_vertexArray;
+			mem::gl::Buffer m_vertexBuffer;
+			mem::gl::Buffer m_elementBuffer;
+			mem::gl::Buffer m_drawIdBuffer;
+			GLint m_drawIdAttribute = -1;
+			GLuint m_maxDrawIds{};
+			FreeListAllocator m_vertices;
+			FreeListAllocator m_indices;
+
+			void growVertices(GLuint minCapacity);
+			void growIndices(GLuint minCapacity);
+			void setUpVertexArray();
+
+		public:
+			struct CreateInfo
+			{
+				VertexFormat format = basicVertexFormat();
+				GLuint vertexCapacity = 64 * 1024; // require > 0
+				GLuint indexCapacity = 3 * 64 * 1024; // require > 0
+
+				// When >= 0, the vertex array also feeds this location with an unsigned integer
+				// that counts 0, 1, 2... per instance. A multi-draw sets each draw's baseInstance
+				// to its index, so the shader reads which draw it is in (see be::gl::MultiDrawBatch).
+				GLint drawIdAttribute = -1;
+				GLuint maxDrawIds = 4096;
+			};
+
+			MeshPool() = default;
+			explicit MeshPool(CreateInfo const& info);
+
+			MeshRange add(
+				void const* vertices,
+				GLuint vertexCount,
+				GLuint const* indices,
+				GLsizei indexCount,
+				GLenum mode = GL_TRIANGLES
+			);
+
+			// Requires the pool to have the basic vertex format.
+			MeshRange add(std::vector<BasicVertex> const& vertices, std::vector<GLuint> const& indices);
+
+			void remove(MeshRange const& range);
+
+			// The pool's vertex array must be bound.
+			void draw(MeshRange const& range) const noexcept;
+
+			GLuint vertexArray() const noexcept { return m_vertexArray.get(); }
+			GLint drawIdAttribute() const noexcept { return m_drawIdAttribute; }
+			GLuint maxDrawIds() const noexcept { return m_drawIdAttribute >= 0 ? m_maxDrawIds : 0; }
+			VertexFormat const& format() const noexcept { return m_format; }
+			FreeListAllocator const& vertices() const noexcept { return m_vertices; }
+			FreeListAllocator const& indices() const noexcept { return m_indices; }
+		};
+	}
+}
+
+#define BE_BIND_MESH_POOL_SCOPE(pool)\
+	BE_BIND_VERTEX_ARRAY_SCOPE((pool).vertexArray())
@@ -0,0 +1,99 @@
+/*
+//	be/multi_draw
+//	Batches many draws from one mesh pool into a single glMultiDrawElementsIndirect.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <glm/vec4.hpp>
+
+#include "be/mesh_pool.hpp"
+#include "be/stream_buffer.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		class MultiDrawException final : public std::runtime_error
+		{
+		public:
+			explicit MultiDrawException(std::string const& msg)
+				: std::runtime_error("[be::gl] multi draw exception: " + msg)
+			{}
+		};
+
+		// Layout fixed by the GL spec.
+		struct DrawElementsIndirectCommand
+		{
+			GLuint count{};
+			GLuint instanceCount{};
+			GLuint firstIndex{};
+			GLint baseVertex{};
+			GLuint baseInstance{};
+		};
+
+		// GL 4.3 or ARB_multi_draw_indirect (which needs base instance support).
+		bool isMultiDrawIndirectSupported() noexcept;
+
+		/*
+		//	Collects draws of ranges in one MeshPool, each with a few vec4s of per-draw data
+		//	(matrices, material parameters...), and issues them together.
+		//
+		//	The per-draw data is streamed into a buffer texture. The shader finds its draw's data at
+		//		texelFetch(perDraw, perDrawBase + int(drawId) * texelsPerDraw + i)
+		//	where perDrawBase is a uniform set by submit and drawId is the pool's draw id attribute.
+		//	With multi-draw-indirect support the whole batch is one glMultiDrawElementsIndirect,
+		//	so the CPU cost of submit does not grow with the number of draws.
+		//	Otherwise submit loops over the draws, setting perDrawBase for each one.
+		*/
+		class MultiDrawBatch
+		{
+		private:
+			StreamBuffer m_commandStream;
+			StreamBuffer m_perDrawStream;
+			mem::gl::Texture m_perDrawTexture;
+			std::vector<DrawElementsIndirectCommand> m_commands;
+			std::vector<glm::vec4> m_perDraw;
+			GLsizei m_texelsPerDraw{};
+			GLsizei m_maxDraws{};
+			GLenum m_mode = GL_TRIANGLES;
+			bool m_indirect = false;
+
+		public:
+			struct CreateInfo
+			{
+				GLsizei texelsPerDraw = 4; // require > 0
+				GLsizei maxDraws = 4096; // per submit. require > 0
+				bool allowIndirect = true; // false forces the loop
+			};
+
+			MultiDrawBatch() = default;
+			explicit MultiDrawBatch(CreateInfo const& info);
+
+			bool isIndirect() const noexcept { return m_indirect; }
+			GLsizei texelsPerDraw() const noexcept { return m_texelsPerDraw; }
+			GLsizei maxDraws() const noexcept { return m_maxDraws; }
+			std::size_t size() const noexcept { return m_commands.size(); }
+			bool empty() const noexcept { return m_commands.empty(); }
+
+			void clear() noexcept;
+
+			// Returns texelsPerDraw texels for the caller to fill, valid until the next add.
+			// Every range in a batch must have the same mode.
+			glm::vec4* add(MeshRange const& range);
+
+			/*
+			//	Draws everything added since the last clear, then clears.
+			//	The pool's vertex array must be bound, and the program in use must read per-draw data
+			//	as described above. Binds the buffer texture to |textureUnit|.
+			*/
+			void submit(MeshPool const& pool, GLuint textureUnit, GLint perDrawSamplerLocation, GLint perDrawBaseLocation);
+		};
+	}
+}
@@ -32,5 +32,8 @@ namespace be
 		inline void recalcProjection(Camera& camera) { camera.projection = calcProjection(camera); }
 		inline void recalcVP(Camera& camera) { camera.vp = camera.projection * camera.view; }
 		void recalc(Camera& camera);
+
+		// How many pixels one world unit at |distance| in front of the camera covers on a viewport |viewportHeight| pixels tall.
+		float calcPixelsPerUnit(Camera const& camera, float distance, float viewportHeight);
 	}
 }
@@ -0,0 +1,32 @@
+
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+
+namespace be
+{
+	namespace pink
+	{
+		struct Aabb
+		{
+			glm::vec3 min = glm::vec3(0.0f);
+			glm::vec3 max = glm::vec3(0.0f);
+		};
+
+		// Planes point inwards: a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for all six.
+		struct Frustum
+		{
+			std::array<glm::vec4, 6> planes;
+		};
+
+		// Extracts the clip planes of an OpenGL view-projection matrix.
+		Frustum calcFrustum(glm::mat4 const& viewProjection) noexcept;
+
+		// The axis-aligned box enclosing |bounds| after the affine transform |m|.
+		Aabb transformAabb(Aabb const& bounds, glm::mat4 const& m) noexcept;
+
+		// Conservative: may report a box just outside a frustum corner as visible.
+		bool isVisible(Frustum const& frustum, Aabb const& worldBounds) noexcept;
+	}
+}
@@ -1,12 +1,13 @@
 
 #pragma once
 
-#include <functional>
 #include <set>
 #include <assimp/material.h>
 #include <be/be.hpp>
+#include <be/function_ref.hpp>
 
 #include "camera.hpp"
+#include "culling.hpp"
 
 namespace be
 {
@@ -21,28 +22,42 @@ namespace be
 
 			struct Mesh
 			{
-				be::gl::BasicMesh data;
-				std::weak_ptr<Material> material;
+				be::gl::BasicMesh data; // empty when the mesh lives in a pool
+				be::gl::MeshPool* pool{};
+				be::gl::MeshRange range; // valid when pool is set
+				std::uint32_t material{}; // index into Model::materials
+				Aabb bounds; // model space
+				// model space triangles kept on the CPU, e.g. for occlusion culling.
+				std::vector<glm::vec3> positions;
+				std::vector<std::uint32_t> indices;
 			};
 
 			struct Node
 			{
 				std::weak_ptr<Node> parent{};
 				std::set<std::shared_ptr<Node>> children;
-				std::set<std::weak_ptr<Mesh>, std::owner_less<std::weak_ptr<Mesh>>> meshes;
+				std::vector<std::uint32_t> meshes; // indices into Model::meshes
 				glm::mat4 localTransformation;
 			};
 
+			// Materials and meshes are stored densely and referred to by index, so drawing locks no weak_ptr.
+			// Moving the model keeps pointers to them valid.
 			struct Model
 			{
-				std::vector<std::shared_ptr<Material>> materials;
-				std::vector<std::shared_ptr<Mesh>> meshes;
+				std::vector<Material> materials;
+				std::vector<Mesh> meshes;
 				std::shared_ptr<Node> rootNode;
 			};
 
 
 
-			Model loadModel(std::string const& filename);
+			// With a pool, the meshes are added to it instead of getting their own buffers.
+			// The pool must outlive the model.
+			Model loadModel(std::string const& filename, be::gl::MeshPool* pool = nullptr);
+
+			// Binds whichever vertex array the mesh lives in. To draw many pooled meshes,
+			// bind the pool once and draw each mesh's range instead.
+			void drawMesh(Mesh const& mesh);
 
 
 
@@ -58,22 +73,50 @@ namespace be
 
 
 
-			using DrawNodeCallback = std::function<void(
+			// Non-owning, so rendering a model never allocates. The callable must outlive the call.
+			using DrawNodeCallback = be::FunctionRef<void(
 				be::pink::model::Node const& node,
 				glm::mat4 const& modelMatrix
 				)>;
 
 			void renderModelNode(
 				std::shared_ptr<Node> const& node,
-				DrawNodeCallback const& drawNode,
+				DrawNodeCallback drawNode,
 				NodeModelMatrixMap const& modelMatrices
 			);
 
+			// Resolves each node's model matrix while walking the tree, so it needs no NodeModelMatrixMap.
 			void renderModel(
 				Model const& model,
-				DrawNodeCallback const& drawNode,
+				DrawNodeCallback drawNode,
 				glm::mat4 const& parentModelMatrix
 			);
+
+
+
+			struct MeshInstance
+			{
+				Mesh const* mesh; // owned by the Model
+				glm::mat4 modelMatrix;
+			};
+
+			using MeshInstanceCallback = be::FunctionRef<void(MeshInstance const& instance)>;
+
+			// Visits every mesh of the model with its resolved model matrix, in the order renderModel visits them.
+			// Touches no GL state, so it may run on any thread.
+			void forEachMeshInstance(
+				Model const& model,
+				glm::mat4 const& parentModelMatrix,
+				MeshInstanceCallback visit
+			);
+
+			// Appends every mesh of the model with its resolved model matrix, in the order renderModel visits them.
+			// Touches no GL state, so it may run on any thread.
+			void flattenModel(
+				Model const& model,
+				glm::mat4 const& parentModelMatrix,
+				std::vector<MeshInstance>& instances
+			);
 		}
 	}
 }
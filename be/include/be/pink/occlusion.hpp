@@ -0,0 +1,136 @@
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "culling.hpp"
+
+namespace be
+{
+	namespace pink
+	{
+		class OcclusionException final : public std::runtime_error
+		{
+		public:
+			explicit OcclusionException(std::string const& msg)
+				: std::runtime_error("[be::pink] occlusion exception: " + msg)
+			{}
+		};
+
+		// Measured by the latest rasterize.
+		struct OcclusionStats
+		{
+			double rasterMs{};
+			std::uint32_t occluderTriangles{}; // after near clipping, back-face culling and dropping those on no pixel centre
+			std::uint32_t coveredPixels{}; // pixels at least one occluder touches
+		};
+
+		/*
+		//	A CPU occlusion culler, so it behaves the same with or without a GPU:
+		//		buffer.begin(camera.vp);
+		//		for each of a few large occluders: buffer.addOccluder(positions, indices, model);
+		//		buffer.rasterize();
+		//		then, from any thread: if (!buffer.isVisible(worldBounds)) skip the draw
+		//
+		//	Occluder triangles are rasterised into a small depth buffer in horizontal bands on be::jobs,
+		//	each band touching only its own rows, keeping the nearest depth per pixel and the farthest
+		//	per 8x8 block. Each block an occluder touches is first tested at its corners: it is skipped
+		//	if the occluder misses it or cannot come nearer than its farthest depth, and filled without
+		//	edge tests if the occluder covers all of it. Otherwise SSE2 evaluates the edges four pixels
+		//	at a time into a coverage mask, and the depths under the mask take the nearer depth.
+		//	An occluder only covers the pixels that lie wholly inside it, not those whose
+		//	centre it contains, so an edge or a gap between occluders never closes over a pixel that
+		//	shows something behind; each covered pixel takes the farthest depth the occluder reaches
+		//	within it; and triangles are clipped to the near plane. So an object is only reported hidden
+		//	if it really is, at the cost of keeping some that are. The two triangles of a flat quad are
+		//	drawn as one polygon, so no seam is left open along their diagonal; other shared edges are.
+		//
+		//	isVisible tests an object's screen rectangle at its nearest depth: a block whose farthest
+		//	depth is nearer than that rejects 64 pixels at once, otherwise its pixels are read.
+		*/
+		class OcclusionBuffer
+		{
+		private:
+			int m_width{};
+			int m_height{};
+			int m_blocksX{};
+			int m_blocksY{};
+			glm::mat4 m_viewProjection = glm::mat4();
+
+			// A convex occluder in window coordinates (x and y in pixels, z in [0, 1]), ready to draw.
+			// Everything is measured from the centre of its first pixel (x0, y0), so steps stay small.
+			struct Polygon
+			{
+				static constexpr int maxEdges = 5; // a quad clipped by the near plane
+				int edgeCount{};
+				// edge k is at least 0 at the centre of a pixel wholly on its inner side:
+				//	edgeStart[k] + edgeStepX[k] * (x - x0) + edgeStepY[k] * (y - y0)
+				std::array<float, maxEdges> edgeStart{};
+				std::array<float, maxEdges> edgeStepX{};
+				std::array<float, maxEdges> edgeStepY{};
+				// the farthest depth the polygon reaches within a pixel, capped at maxZ.
+				float zStart{};
+				float zStepX{};
+				float zStepY{};
+				float maxZ{};
+				int x0{}, x1{}, y0{}, y1{}; // pixels whose centres are within its bounds, inclusive
+			};
+			std::vector<Polygon> m_polygons;
+
+			std::vector<float> m_depth; // per pixel, rows from the bottom. 1 where nothing was drawn
+			std::vector<float> m_blockMaxDepth; // per 8x8 block
+
+			OcclusionStats m_stats;
+
+			// Clips |corners| (clip space, in order around a convex polygon) to the near plane and queues it.
+			// Returns false, queuing nothing, if |mustBeFlat| and it is not flat and convex on screen.
+			bool addPolygon(std::span<glm::vec4 const> corners, bool mustBeFlat);
+
+		public:
+			static constexpr int blockSize = 8;
+			// the instruction set rasterize uses, for reports.
+			static constexpr char const* simd = "sse2";
+
+			struct CreateInfo
+			{
+				int width = 256; // require a positive multiple of blockSize
+				int height = 144; // require a positive multiple of blockSize
+			};
+
+			OcclusionBuffer() = default;
+			explicit OcclusionBuffer(CreateInfo const& info);
+
+			int width() const noexcept { return m_width; }
+			int height() const noexcept { return m_height; }
+
+			// Clears the depth and the occluders for a camera. |viewProjection| is an OpenGL one.
+			void begin(glm::mat4 const& viewProjection);
+
+			// Queues triangles, counter-clockwise from the front; back faces are skipped. A triangle that
+			// shares an edge with the one before it and lies in the same plane is drawn with it as one quad.
+			// Occluders should be closed or solid from the camera's side, e.g. walls, terrain, large props.
+			void addOccluder(std::span<glm::vec3 const> positions, std::span<std::uint32_t const> indices, glm::mat4 const& model);
+
+			// Makes room for |triangles| occluder triangles a frame, so frames with that many do not allocate.
+			void reserve(std::size_t triangles);
+
+			// Draws the queued occluders.
+			void rasterize();
+
+			// False only if every pixel |worldBounds| covers is behind an occluder.
+			// Boxes crossing the near plane or off screen are visible. Safe to call from several threads.
+			bool isVisible(Aabb const& worldBounds) const noexcept;
+
+			OcclusionStats const& stats() const noexcept { return m_stats; }
+
+			// Per pixel, rows from the bottom, for debugging.
+			std::span<float const> depth() const noexcept { return m_depth; }
+		};
+	}
+}
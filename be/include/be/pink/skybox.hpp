@@ -40,6 +40,10 @@ namespace be
 			need_ref<glm::mat4 const> cameraProjectionMatrix;
 			need_ref<glm::mat4 const> cameraViewMatrix;
 			float scale = 1.0f;
+			// false: drawn first with depth testing off, painting every pixel.
+			// true: drawn after the opaque scene at the far plane with GL_LEQUAL and no depth writes,
+			// so only the pixels the scene left at the cleared depth of 1 are shaded.
+			bool atFarPlane = false;
 		};
 		void renderSkybox(RenderSkyboxInfo const& info);
 
@@ -2,11 +2,14 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <string_view>
 #include <glm/glm.hpp>
 
 #include "be/need.hpp"
 #include "be/gl.hpp"
 #include "be/ft.hpp"
+#include "be/stream_buffer.hpp"
 
 namespace be
 {
@@ -35,20 +38,18 @@ namespace be
 				glm::vec2 position;
 				glm::vec2 texCoords;
 			};
+			// Each label writes all of its glyph quads into the stream at once, then draws them in one call from the font's atlas.
 			struct TextGlyphMesh
 			{
+				be::gl::StreamBuffer vertexStream;
 				be::mem::gl::VertexArray vertexArray;
-				be::mem::gl::Buffer vertexBuffer; // should be GL_DYNAMIC_DRAW
 			};
 			TextGlyphMesh makeTextGlyphMesh();
 
-			class RenderTextLabelException final : public std::runtime_error
+			enum class RenderTextLabelStatus : std::uint8_t
 			{
-			public:
-				RenderTextLabelException(std::string const& text)
-					: std::runtime_error("[example] render text label exception: "
-						"failed to render all characters of text: " + text)
-				{}
+				Ok,
+				MissingCharacters, // the font lacks some characters of the text. the rest were drawn
 			};
 
 			struct RenderTextLabelInfo
@@ -61,9 +62,9 @@ namespace be
 				need_ref<glm::mat4 const> mvp;
 				need_ref<glm::vec4 const> color;
 				need<glm::vec2> scale;
-				need_ref<std::string const> text;
+				need<std::string_view> text; // e.g. formatted into a be::mem::FrameArena buffer
 			};
-			void renderTextLabel(RenderTextLabelInfo const& info);
+			[[nodiscard]] RenderTextLabelStatus renderTextLabel(RenderTextLabelInfo const& info);
 
 			struct RenderTextLabelLegacyInfo
 			{
@@ -77,7 +78,7 @@ namespace be
 				glm::vec2 scale{};
 				std::string const* text{};
 			};
-			inline void renderTextLabelLegacy(RenderTextLabelLegacyInfo const& info)
+			[[nodiscard]] inline RenderTextLabelStatus renderTextLabelLegacy(RenderTextLabelLegacyInfo const& info)
 			{
 				assert(info.shader);
 				assert(info.mesh);
@@ -86,7 +87,7 @@ namespace be
 				assert(info.color);
 				assert(info.text);
 
-				renderTextLabel(RenderTextLabelInfo{
+				return renderTextLabel(RenderTextLabelInfo{
 					*info.shader,
 					*info.mesh,
 					*info.font,
@@ -95,7 +96,7 @@ namespace be
 					*info.mvp,
 					*info.color,
 					info.scale,
-					*info.text
+					std::string_view(*info.text)
 					});
 			}
 		}
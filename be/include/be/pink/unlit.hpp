@@ -11,6 +11,8 @@ namespace be
 {
 	namespace pink
 	{
+		struct RenderUnlitInfo;
+
 		class UnlitShader
 		{
 		private:
@@ -19,7 +21,14 @@ namespace be
 				GLuint mvp;
 				GLuint tex;
 				GLuint color;
+				GLuint model;
+				GLuint clipPlane;
 			} m_uniformLocations{};
+			// whether the program's clip plane was left set, so the next unclipped draw resets it once.
+			// some drivers clip by gl_ClipDistance even with GL_CLIP_DISTANCE0 disabled.
+			mutable bool m_clipPlaneSet = false;
+
+			friend void renderUnlit(RenderUnlitInfo const& info);
 
 		public:
 			UnlitShader();
@@ -34,6 +43,10 @@ namespace be
 			need<GLuint> tex;
 			need_ref<glm::vec4 const> color;
 			need_ref<glm::mat4 const> mvp;
+			// a world-space plane; the side where dot(plane.xyz, p) + plane.w < 0 is cut away.
+			// enable GL_CLIP_DISTANCE0 around the draw. needs |model| too.
+			glm::vec4 const* clipPlane = nullptr;
+			glm::mat4 const* model = nullptr;
 		};
 		void renderUnlit(RenderUnlitInfo const& info);
 
@@ -0,0 +1,96 @@
+/*
+//	be/profile
+//	Scoped CPU timing zones with Chrome trace export and per-zone statistics.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cress/moo/defer.hpp>
+
+namespace be
+{
+	namespace profile
+	{
+		class ProfileException final : public std::runtime_error
+		{
+		public:
+			explicit ProfileException(std::string const& msg)
+				: std::runtime_error("[be::profile] profile exception: " + msg)
+			{}
+		};
+
+		struct ZoneStats
+		{
+			std::string name;
+			std::uint64_t count{};
+			double meanMs{};
+			double p95Ms{}; // over the most recent samples only
+			double maxMs{};
+		};
+
+		namespace detail
+		{
+			inline std::atomic<bool> s_enabled{ false };
+
+			void beginZone(char const* name) noexcept;
+			void endZone(char const* name) noexcept;
+		}
+
+		inline bool isEnabled() noexcept { return detail::s_enabled.load(std::memory_order_relaxed); }
+		inline void setEnabled(bool enabled) noexcept { detail::s_enabled.store(enabled, std::memory_order_relaxed); }
+
+		/*
+		//	Records a begin event on construction and an end event on destruction
+		//	into the ring buffer of the calling thread.
+		//	The name must have static storage duration (e.g. a string literal).
+		*/
+		class Scope
+		{
+		private:
+			char const* m_name;
+
+		public:
+			explicit Scope(char const* name) noexcept
+				: m_name(isEnabled() ? name : nullptr)
+			{
+				if (m_name) { detail::beginZone(m_name); }
+			}
+			~Scope() noexcept
+			{
+				if (m_name) { detail::endZone(m_name); }
+			}
+			Scope(Scope const&) = delete;
+			Scope& operator=(Scope const&) = delete;
+		};
+
+		// Called once per frame by Application. Folds new events into the zone statistics.
+		void markFrame() noexcept;
+		std::uint64_t getFrameIndex() noexcept;
+
+		std::optional<ZoneStats> getZoneStats(std::string_view name);
+		std::vector<ZoneStats> getAllZoneStats();
+		void resetZoneStats() noexcept;
+
+		// Writes the events of the most recent frames in the Chrome trace event format (chrome://tracing).
+		void writeChromeTrace(std::ostream& out, std::size_t frameCount);
+		void writeChromeTraceFile(std::string const& filePath, std::size_t frameCount);
+	}
+}
+
+#ifdef BE_PROFILE_DISABLE
+#define BE_PROFILE_SCOPE(name) static_cast<void>(0)
+#else
+#define BE_PROFILE_SCOPE(name)\
+	::be::profile::Scope CRESS_MOO_ANONYMOUS_IDENTIFIER{ name }
+#endif
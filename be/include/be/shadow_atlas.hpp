@@ -0,0 +1,157 @@
+/*
+//	be/shadow_atlas
+//	One depth texture shared by every shadowed light, partitioned into tiles by a quadtree.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+#include "be/mem/gl.hpp"
+#include "be/stream_buffer.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		class ShadowAtlasException final : public std::runtime_error
+		{
+		public:
+			explicit ShadowAtlasException(std::string const& msg)
+				: std::runtime_error("[be::gl] shadow atlas exception: " + msg)
+			{}
+		};
+
+		// A square region of the atlas, in texels. A size of 0 means the light got no tile.
+		struct ShadowTile
+		{
+			int x{};
+			int y{};
+			int size{};
+		};
+
+		/*
+		//	Hands out power-of-two squares of a power-of-two square, splitting nodes into quadrants.
+		//	There is no free: clear and allocate everything again when the sizes change.
+		//	Allocating largest first never fragments, so a set of tiles fits whenever their area does.
+		*/
+		class QuadtreeAllocator
+		{
+		private:
+			int m_size{};
+			int m_minTileSize{};
+			std::vector<std::vector<ShadowTile>> m_free; // by depth; depth 0 is the whole square
+
+		public:
+			QuadtreeAllocator() = default;
+			// Both powers of two, with minTileSize <= size.
+			QuadtreeAllocator(int size, int minTileSize);
+
+			int size() const noexcept { return m_size; }
+			int minTileSize() const noexcept { return m_minTileSize; }
+
+			void clear() noexcept;
+
+			// |tileSize| is rounded up to a power of two within [minTileSize, size].
+			std::optional<ShadowTile> allocate(int tileSize);
+		};
+
+		/*
+		//	Each frame:
+		//		atlas.assign(wantedTexels); // one entry per shadowed light, e.g. its size on screen
+		//		atlas.beginDepthPass();
+		//		for each light: atlas.setTileViewport(atlas.tile(i)); draw its depth
+		//		atlas.endDepthPass();
+		//		atlas.clearLights(); for each light: fill atlas.addLight(vp, i); atlas.uploadLights();
+		//		draw with texture() and lightTexture() bound and lightBase() and lightCount() set
+		//		atlas.fenceLights();
+		//	Depth is cleared once for the whole atlas and each light is a viewport, not a framebuffer,
+		//	so the cost of N lights follows the atlas area rather than N.
+		//
+		//	The light table is a buffer texture of texelsPerLight() vec4s per light. Light i starts at
+		//		int base = shadowLightBase + i * texelsPerLight
+		//	with its world-to-light-clip matrix in texels base to base + 3, its tile as a [0,1] rect
+		//	(x, y, width, height) in texel base + 4, and the caller's extra texels after that.
+		//	A light without a tile has an empty rect; shaders should treat it as unshadowed.
+		*/
+		class ShadowAtlas
+		{
+		private:
+			QuadtreeAllocator m_allocator;
+			mem::gl::FrameBuffer m_frameBuffer;
+			mem::gl::Texture m_texture;
+			int m_maxTileSize{};
+			std::vector<ShadowTile> m_tiles;
+			std::vector<std::size_t> m_order; // scratch for assign
+
+			StreamBuffer m_lightStream;
+			mem::gl::Texture m_lightTexture;
+			std::vector<glm::vec4> m_lightTexels;
+			GLint m_lightBase{};
+			int m_extraTexelsPerLight{};
+			int m_maxLights{};
+
+		public:
+			struct CreateInfo
+			{
+				int size = 1024; // width and height in texels. require a power of two
+				int minTileSize = 64; // require a power of two <= size
+				int maxTileSize = 1024; // clamped to size
+				int maxLights = 16; // require > 0
+				int extraTexelsPerLight = 0; // per-light data after the matrix and rect. require >= 0
+				char const* label = "shadow atlas"; // for be::gpu_memory. must be a string literal
+			};
+
+			ShadowAtlas() = default;
+			explicit ShadowAtlas(CreateInfo const& info);
+
+			int size() const noexcept { return m_allocator.size(); }
+			GLuint texture() const noexcept { return m_texture.get(); }
+			int maxLights() const noexcept { return m_maxLights; }
+			int texelsPerLight() const noexcept { return 5 + m_extraTexelsPerLight; }
+
+			/*
+			//	Gives light i a tile of about wantedTexels[i] texels across, rounded down to a power of two
+			//	within [minTileSize, maxTileSize]. Lights are placed largest first; when the atlas is full,
+			//	a light's tile is halved until it fits, down to nothing.
+			//	Throws if there are more than maxLights.
+			*/
+			void assign(std::span<float const> wantedTexels);
+
+			std::size_t tileCount() const noexcept { return m_tiles.size(); }
+			ShadowTile const& tile(std::size_t light) const { return m_tiles.at(light); }
+			std::span<ShadowTile const> tiles() const noexcept { return m_tiles; }
+			glm::vec4 calcTileRect(ShadowTile const& tile) const noexcept;
+
+			// Binds the atlas framebuffer and clears all of its depth, with depth testing on and scissoring enabled.
+			void beginDepthPass();
+			// Restricts drawing to the tile.
+			void setTileViewport(ShadowTile const& tile) noexcept;
+			// Binds framebuffer 0 and turns scissoring and depth testing off.
+			void endDepthPass() noexcept;
+
+			void clearLights() noexcept;
+			// Writes the matrix and rect of the next light, which is given tile(index) (or none, past the assigned tiles).
+			// Returns its extraTexelsPerLight texels for the caller to fill, valid until the next add.
+			glm::vec4* addLight(glm::mat4 const& viewProjection, std::size_t index);
+			std::size_t lightCount() const noexcept;
+			// Streams the lights added since the last clear.
+			void uploadLights();
+			// The table as a GL_TEXTURE_BUFFER of GL_RGBA32F, and the texel its latest upload starts at.
+			GLuint lightTexture() const noexcept { return m_lightTexture.get(); }
+			GLint lightBase() const noexcept { return m_lightBase; }
+			// Call after the draws that read the table.
+			void fenceLights();
+		};
+	}
+}
@@ -0,0 +1,178 @@
+/*
+//	be/slot_map
+//	Dense storage addressed by 32 bit generational handles.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace be
+{
+	class SlotMapException final : public std::runtime_error
+	{
+	public:
+		explicit SlotMapException(std::string const& msg)
+			: std::runtime_error("[be] slot map exception: " + msg)
+		{}
+	};
+
+	/*
+	//	A reference to an element of a SlotMap<T>: 20 bits of slot index and 12 of generation.
+	//	Erasing an element bumps its slot's generation, so old handles to it stop resolving
+	//	instead of reaching whatever takes the slot next. The default handle is null.
+	*/
+	template<class T>
+	class Handle
+	{
+	public:
+		static constexpr std::uint32_t indexBits = 20;
+		static constexpr std::uint32_t maxIndex = (1u << indexBits) - 1;
+		static constexpr std::uint32_t maxGeneration = (1u << (32 - indexBits)) - 1;
+
+	private:
+		std::uint32_t m_value{};
+
+	public:
+		constexpr Handle() noexcept = default;
+		constexpr Handle(std::uint32_t const index, std::uint32_t const generation) noexcept
+			: m_value((generation << indexBits) | (index & maxIndex))
+		{}
+
+		constexpr std::uint32_t index() const noexcept { return m_value & maxIndex; }
+		constexpr std::uint32_t generation() const noexcept { return m_value >> indexBits; }
+		constexpr std::uint32_t value() const noexcept { return m_value; }
+
+		// Generations start at 1, so only the null handle is 0.
+		constexpr explicit operator bool() const noexcept { return m_value != 0; }
+
+		friend constexpr bool operator==(Handle const&, Handle const&) noexcept = default;
+	};
+
+	/*
+	//	The values are kept contiguous, so iterating them touches no gaps,
+	//	and a handle resolves through one indirection with a generation check.
+	//	Erasing moves the last value into the hole; pointers to values do not survive
+	//	an insert or erase, but handles do.
+	//	A slot is reused 4095 times before its generation wraps around.
+	*/
+	template<class T>
+	class SlotMap
+	{
+	public:
+		using HandleType = Handle<T>;
+
+	private:
+		struct Slot
+		{
+			std::uint32_t dense{}; // index into m_values, or the next free slot when free
+			std::uint32_t generation = 1;
+		};
+
+		static constexpr std::uint32_t noFreeSlot = ~std::uint32_t{};
+
+		std::vector<T> m_values;
+		std::vector<std::uint32_t> m_valueSlots; // parallel to m_values
+		std::vector<Slot> m_slots;
+		std::uint32_t m_freeHead = noFreeSlot;
+
+	public:
+		HandleType insert(T&& value)
+		{
+			std::uint32_t index;
+			if (m_freeHead != noFreeSlot)
+			{
+				index = m_freeHead;
+				m_freeHead = m_slots[index].dense;
+			}
+			else
+			{
+				if (m_slots.size() > HandleType::maxIndex)
+				{
+					throw SlotMapException("too many slots");
+				}
+				index = static_cast<std::uint32_t>(m_slots.size());
+				m_slots.push_back(Slot{});
+			}
+
+			m_values.push_back(std::move(value));
+			m_valueSlots.push_back(index);
+			auto& slot = m_slots[index];
+			slot.dense = static_cast<std::uint32_t>(m_values.size() - 1);
+			return HandleType(index, slot.generation);
+		}
+
+		// Returns false if the handle is stale.
+		bool erase(HandleType const handle)
+		{
+			if (!contains(handle)) { return false; }
+
+			auto& slot = m_slots[handle.index()];
+			std::uint32_t const dense = slot.dense;
+			std::uint32_t const last = static_cast<std::uint32_t>(m_values.size() - 1);
+			if (dense != last)
+			{
+				m_values[dense] = std::move(m_values[last]);
+				m_valueSlots[dense] = m_valueSlots[last];
+				m_slots[m_valueSlots[dense]].dense = dense;
+			}
+			m_values.pop_back();
+			m_valueSlots.pop_back();
+
+			slot.generation = slot.generation == HandleType::maxGeneration ? 1 : slot.generation + 1;
+			slot.dense = m_freeHead;
+			m_freeHead = handle.index();
+			return true;
+		}
+
+		// A free slot's generation has not been handed out yet, so stale handles never match it.
+		bool contains(HandleType const handle) const noexcept
+		{
+			return handle.index() < m_slots.size()
+				&& m_slots[handle.index()].generation == handle.generation();
+		}
+
+		// nullptr if the handle is stale.
+		T* find(HandleType const handle) noexcept
+		{
+			return contains(handle) ? &m_values[m_slots[handle.index()].dense] : nullptr;
+		}
+		T const* find(HandleType const handle) const noexcept
+		{
+			return contains(handle) ? &m_values[m_slots[handle.index()].dense] : nullptr;
+		}
+
+		T& at(HandleType const handle)
+		{
+			if (T* const value = find(handle)) { return *value; }
+			throw SlotMapException("stale handle");
+		}
+		T const& at(HandleType const handle) const
+		{
+			if (T const* const value = find(handle)) { return *value; }
+			throw SlotMapException("stale handle");
+		}
+
+		// Swaps in a new value behind the same handle; the old value is destroyed.
+		void replace(HandleType const handle, T&& value)
+		{
+			at(handle) = std::move(value);
+		}
+
+		std::size_t size() const noexcept { return m_values.size(); }
+		bool empty() const noexcept { return m_values.empty(); }
+
+		// The values in no particular order.
+		auto begin() noexcept { return m_values.begin(); }
+		auto end() noexcept { return m_values.end(); }
+		auto begin() const noexcept { return m_values.begin(); }
+		auto end() const noexcept { return m_values.end(); }
+	};
+}
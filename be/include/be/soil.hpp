@@ -12,6 +12,7 @@
 
 #include "be/mem/soil.hpp"
 #include "be/mem/gl.hpp"
+#include "be/profile.hpp"
 
 namespace be
 {
@@ -35,6 +36,7 @@ namespace be
 
 		inline Image load_image(char const* filename, int force_channels)
 		{
+			BE_PROFILE_SCOPE("be::soil::load_image");
 			Image image;
 			image.data.reset(SOIL_load_image(
 				filename,
@@ -53,8 +55,10 @@ namespace be
 			char const* filename,
 			int force_channels,
 			GLuint reuse_texture_id,
-			unsigned int flags)
+			unsigned int flags,
+			char const* label = "soil texture") // for be::gpu_memory. must be a string literal
 		{
+			BE_PROFILE_SCOPE("be::soil::load_OGL_texture");
 			auto texture = mem::gl::Texture(SOIL_load_OGL_texture(
 				filename,
 				force_channels,
@@ -64,6 +68,8 @@ namespace be
 			if (texture == mem::nullFraii) {
 				throw SoilException(std::string(SOIL_last_result()) + " (file at: " + filename + " )");
 			}
+			gpu_memory::track(gpu_memory::ObjectKind::Texture, texture.get(), gpu_memory::Category::Texture, label);
+			gpu_memory::measureTexture(texture.get(), GL_TEXTURE_2D);
 			return texture;
 		}
 
@@ -76,8 +82,10 @@ namespace be
 			const char* z_neg_file,
 			int force_channels,
 			unsigned int reuse_texture_ID,
-			unsigned int flags)
+			unsigned int flags,
+			char const* label = "soil cubemap") // for be::gpu_memory. must be a string literal
 		{
+			BE_PROFILE_SCOPE("be::soil::load_OGL_cubemap");
 			auto texture = mem::gl::Texture(SOIL_load_OGL_cubemap(
 				x_pos_file,
 				x_neg_file,
@@ -92,6 +100,8 @@ namespace be
 			if (texture == mem::nullFraii) {
 				throw SoilException(std::string(SOIL_last_result()) + " (cubemap near: " + x_pos_file + " )");
 			}
+			gpu_memory::track(gpu_memory::ObjectKind::Texture, texture.get(), gpu_memory::Category::Texture, label);
+			gpu_memory::measureTexture(texture.get(), GL_TEXTURE_CUBE_MAP);
 			return texture;
 		}
 
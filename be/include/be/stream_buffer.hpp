@@ -0,0 +1,115 @@
+/*
+//	be/stream_buffer
+//	Ring buffer for uploading per-frame data without stalling on data the GPU is still reading.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "be/mem/gl.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		class StreamBufferException final : public std::runtime_error
+		{
+		public:
+			explicit StreamBufferException(std::string const& msg)
+				: std::runtime_error("[be::gl] stream buffer exception: " + msg)
+			{}
+		};
+
+		struct StreamAllocation
+		{
+			GLintptr offset{}; // bytes from the start of the buffer
+			GLsizeiptr size{};
+			void* data{}; // write only. valid until commit
+		};
+
+		/*
+		//	One large buffer written as a ring, for data that changes every frame:
+		//	text glyph quads, debug geometry, per-draw uniform blocks.
+		//
+		//	With GL 4.4 or ARB_buffer_storage the buffer is mapped once, persistently and coherently.
+		//	fence() marks what was allocated so far as in use by the commands issued so far;
+		//	allocate() waits on those fences before handing the same bytes out again.
+		//	Otherwise each allocation maps its range unsynchronized, and the buffer is orphaned
+		//	with glBufferData each time the ring wraps, so the driver never has to wait either.
+		//
+		//	Usage per batch: allocate, write through data, commit, draw from offset, fence.
+		*/
+		class StreamBuffer
+		{
+		private:
+			struct Region
+			{
+				mem::gl::Sync fence;
+				std::uint64_t begin{}; // linear positions; the ring offset is position % capacity
+				std::uint64_t end{};
+			};
+
+			mem::gl::Buffer m_buffer;
+			GLenum m_target = GL_ARRAY_BUFFER;
+			GLsizeiptr m_capacity{};
+			std::uint8_t* m_persistentData{};
+			std::uint64_t m_head{}; // end of the latest allocation
+			std::uint64_t m_fenced{}; // end of the latest fenced region
+			// a queue from m_firstRegion to the end. unlike a deque, it stops allocating once it has grown.
+			std::vector<Region> m_regions;
+			std::size_t m_firstRegion{};
+			std::uint64_t m_stalls{};
+
+		public:
+			struct CreateInfo
+			{
+				// the target it binds to while creating, mapping or orphaning.
+				// binding GL_ELEMENT_ARRAY_BUFFER changes the bound vertex array, so avoid it for indices.
+				GLenum target = GL_ARRAY_BUFFER;
+				GLsizeiptr capacity = 4 * 1024 * 1024; // bytes. require > 0 and a multiple of 256
+				bool allowPersistentMapping = true; // false forces the orphaning path
+				char const* label = "stream buffer"; // for be::gpu_memory. must be a string literal
+			};
+
+			StreamBuffer() = default;
+			explicit StreamBuffer(CreateInfo const& info);
+			StreamBuffer(StreamBuffer&& other) noexcept;
+			StreamBuffer& operator=(StreamBuffer&& other) noexcept;
+			StreamBuffer(StreamBuffer const&) = delete;
+			StreamBuffer& operator=(StreamBuffer const&) = delete;
+			~StreamBuffer() noexcept = default; // deleting the buffer also unmaps it
+
+			GLuint buffer() const noexcept { return m_buffer.get(); }
+			GLenum target() const noexcept { return m_target; }
+			GLsizeiptr capacity() const noexcept { return m_capacity; }
+			bool isPersistent() const noexcept { return m_persistentData != nullptr; }
+
+			// How many allocations had to wait for the GPU.
+			std::uint64_t stalls() const noexcept { return m_stalls; }
+
+			/*
+			//	Reserves |size| bytes at an offset that is a multiple of |alignment| (a power of two).
+			//	Vertex data drawn with a first vertex needs the vertex size;
+			//	uniform blocks need GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+			//	Throws if more than the capacity would be allocated between two fences.
+			*/
+			StreamAllocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+
+			// Makes the written bytes visible to GL. Call before the next allocate and before drawing.
+			void commit(StreamAllocation const& allocation) noexcept;
+
+			// allocate, copy and commit.
+			StreamAllocation write(void const* data, GLsizeiptr size, GLsizeiptr alignment = 16);
+
+			// Call after the draws that read the allocations, e.g. once per batch or per frame.
+			void fence();
+		};
+	}
+}
@@ -0,0 +1,179 @@
+/*
+//	be/texture_stream
+//	Loads textures in the background, coarsest mip first, and keeps their memory within a budget.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "be/mem/gl.hpp"
+
+namespace be
+{
+	namespace texture_stream
+	{
+		class TextureStreamException final : public std::runtime_error
+		{
+		public:
+			explicit TextureStreamException(std::string const& msg)
+				: std::runtime_error("[be::texture_stream] texture stream exception: " + msg)
+			{}
+		};
+
+		struct TextureHandle
+		{
+			std::uint32_t index{};
+		};
+
+		struct TextureStreamStats
+		{
+			std::size_t textures{};
+			std::size_t residentBytes{}; // mip levels in GL, not counting placeholders
+			std::size_t budgetBytes{};
+			std::size_t pendingDecodes{};
+			std::uint64_t uploadedBytes{}; // since construction
+			std::uint64_t evictedBytes{}; // since construction
+		};
+
+		/*
+		//	load() returns at once with a GL texture that shows a 1x1 placeholder colour.
+		//	A streaming thread decodes the file and builds its mip chain on the CPU;
+		//	update() then uploads the levels from the coarsest up to the one requested,
+		//	a few per frame. GL_TEXTURE_BASE_LEVEL hides the levels that are not resident yet,
+		//	so the texture name never changes and can be bound like any other.
+		//
+		//	Each frame, request() the size a texture is seen at, e.g.
+		//		be::pink::calcPixelsPerUnit(camera, distance, viewportHeight) * worldUnitsPerTextureRepeat
+		//	When the resident levels would exceed the budget, the finest levels of the textures that
+		//	need them least (finer than requested, or not requested for longest) are evicted.
+		//	The decoded pixels are dropped once the requested levels are resident,
+		//	and decoded again if a finer level is requested later.
+		//
+		//	Textures are RGBA8 with a box-filtered mip chain. Main thread (GL context) only,
+		//	apart from the streaming thread it owns.
+		*/
+		class TextureStreamer
+		{
+		public:
+			struct CreateInfo
+			{
+				std::size_t budgetBytes = 256 * 1024 * 1024;
+				std::size_t uploadBytesPerFrame = 4 * 1024 * 1024; // at least one level is uploaded per frame
+				glm::u8vec4 placeholderColor = glm::u8vec4(128, 128, 128, 255);
+			};
+
+			struct TextureInfo
+			{
+				GLint wrap = GL_REPEAT;
+				float initialTexels = 64.0f; // requested until the first request()
+				char const* label = "streamed texture"; // for be::gpu_memory. must be a string literal
+			};
+
+		private:
+			struct DecodeRequest
+			{
+				std::uint32_t index{};
+				std::filesystem::path filename;
+				float texels{};
+			};
+
+			struct Decoded
+			{
+				std::uint32_t index{};
+				int width{};
+				int height{};
+				int firstLevel{};
+				std::vector<std::vector<std::uint8_t>> levels; // firstLevel and coarser
+				std::string error; // not empty if decoding failed
+			};
+
+			struct Entry
+			{
+				mem::gl::Texture texture;
+				std::filesystem::path filename;
+				int width{}; // 0 until the first decode
+				int height{};
+				int levelCount{};
+				int residentTop{}; // finest resident level. levelCount when none are
+				int wantedTop{};
+				float requestedTexels{}; // largest request this frame
+				std::uint64_t lastRequestFrame{};
+				bool decodePending = false;
+				bool failed = false;
+				Decoded decoded;
+			};
+
+			CreateInfo m_info;
+			std::vector<Entry> m_entries;
+			std::size_t m_residentBytes{};
+			std::uint64_t m_uploadedBytes{};
+			std::uint64_t m_evictedBytes{};
+			std::uint64_t m_frame{};
+			std::vector<std::uint32_t> m_uploadOrder; // reused every update
+			std::vector<Decoded> m_arrived; // reused every update
+
+			// shared with the streaming thread
+			mutable std::mutex m_mutex;
+			std::condition_variable m_wake; // for the streaming thread
+			std::condition_variable m_decodeDone; // for flush
+			std::deque<DecodeRequest> m_requests;
+			std::vector<Decoded> m_decoded;
+			std::size_t m_pendingDecodes{};
+			bool m_stopping = false;
+			std::thread m_thread;
+
+		public:
+			explicit TextureStreamer(CreateInfo const& info);
+			~TextureStreamer() noexcept; // joins the streaming thread, abandoning queued decodes
+			TextureStreamer(TextureStreamer const&) = delete;
+			TextureStreamer& operator=(TextureStreamer const&) = delete;
+
+			TextureHandle load(std::filesystem::path const& filename);
+			TextureHandle load(std::filesystem::path const& filename, TextureInfo const& info);
+
+			GLuint texture(TextureHandle handle) const;
+
+			// The texels across the texture's longest side that the caller would like resident.
+			// Several requests in one frame keep the largest.
+			void request(TextureHandle handle, float texels);
+
+			// Once per frame: receives decoded textures, applies the requests, evicts and uploads.
+			void update();
+
+			// Waits for every decode and uploads every wanted level now, ignoring uploadBytesPerFrame.
+			// For loading screens, and benchmarks that must not measure streaming.
+			void flush();
+
+			TextureStreamStats stats() const;
+
+		private:
+			void runStreamingThread() noexcept;
+
+			Entry& entry(TextureHandle handle);
+			Entry const& entry(TextureHandle handle) const;
+
+			static int levelFor(Entry const& e, float texels) noexcept;
+			static std::size_t levelBytes(Entry const& e, int level) noexcept;
+
+			void step(std::size_t uploadLimit);
+			void receive(Decoded&& decoded);
+			void uploadNextLevel(Entry& e);
+			void evictTopLevel(Entry& e);
+			bool makeRoom(std::uint32_t forIndex, std::size_t bytes);
+		};
+	}
+}
@@ -0,0 +1,83 @@
+/*
+//	be/alloc_counter
+//	Counts heap allocations, to check that a steady-state frame makes none.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "be/alloc_counter.hpp"
+
+#ifdef BE_COUNT_ALLOCATIONS
+
+namespace be
+{
+	namespace alloc_counter
+	{
+		namespace detail
+		{
+			static std::atomic<std::uint64_t> s_count{ 0 };
+
+			static void* allocate(std::size_t size, std::size_t const alignment)
+			{
+				s_count.fetch_add(1, std::memory_order_relaxed);
+				if (size == 0) { size = 1; }
+#ifdef _WIN32
+				void* const p = _aligned_malloc(size, alignment);
+#else
+				size = (size + alignment - 1) / alignment * alignment;
+				void* const p = std::aligned_alloc(alignment, size);
+#endif
+				if (!p) { throw std::bad_alloc(); }
+				return p;
+			}
+
+			static void release(void* const p) noexcept
+			{
+#ifdef _WIN32
+				_aligned_free(p);
+#else
+				std::free(p);
+#endif
+			}
+		}
+
+		std::uint64_t getAllocationCount() noexcept
+		{
+			return detail::s_count.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+// the array and nothrow forms call these, so they are counted too.
+void* operator new(std::size_t const size)
+{
+	return be::alloc_counter::detail::allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new(std::size_t const size, std::align_val_t const alignment)
+{
+	return be::alloc_counter::detail::allocate(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* const p) noexcept { be::alloc_counter::detail::release(p); }
+void operator delete(void* const p, std::size_t) noexcept { be::alloc_counter::detail::release(p); }
+void operator delete(void* const p, std::align_val_t) noexcept { be::alloc_counter::detail::release(p); }
+void operator delete(void* const p, std::size_t, std::align_val_t) noexcept { be::alloc_counter::detail::release(p); }
+
+#else
+
+namespace be
+{
+	namespace alloc_counter
+	{
+		std::uint64_t getAllocationCount() noexcept
+		{
+			return 0;
+		}
+	}
+}
+
+#endif
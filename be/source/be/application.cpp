@@ -1,11 +1,29 @@
 
 #include <glew/glew.h>
 #include <freeglut/freeglut.h>
+#include <algorithm>
 #include <chrono>
+#include <cstdarg>
 #include <thread>
 #include <atomic>
 #include <mutex>
-
+#include <optional>
+#include <vector>
+
+#ifdef _WIN32
+#include <glew/wglew.h>
+#else
+#include <glew/glxew.h>
+#endif
+
+#include "be/error_stats.hpp"
+#include "be/frame_pacing.hpp"
+#include "be/gpu_memory.hpp"
+#include "be/headless.hpp"
+#include "be/input_record.hpp"
+#include "be/jobs.hpp"
+#include "be/mem/frame_arena.hpp"
+#include "be/profile.hpp"
 #include "be/application.hpp"
 
 namespace be
@@ -25,6 +43,9 @@ namespace be
 	GlewInitException::GlewInitException(char const* what) : RunException(what) {}
 	GlewInitException::GlewInitException(std::string const& what) : RunException(what) {}
 
+	HeadlessInitException::HeadlessInitException(char const* what) : RunException(what) {}
+	HeadlessInitException::HeadlessInitException(std::string const& what) : RunException(what) {}
+
 
 
 	namespace Application
@@ -47,16 +68,43 @@ namespace be
 			static Logger* s_logger = nullptr;
 			static std::unique_ptr<Game> s_game = nullptr;
 
+			static std::optional<frame_pacing::FixedTimestep> s_timestep;
+			static frame_pacing::Clock::time_point s_lastTick;
+			static frame_pacing::Clock::duration s_frameInterval{};
+			static frame_pacing::Clock::time_point s_nextFrameDeadline;
+			static float s_interpolation = 0.0f;
+
+			static headless::Context* s_headlessContext = nullptr;
+			static std::atomic<bool> s_headlessExitRequested{ false };
+
+			static std::uint64_t s_updateStep = 0; // Game::Update calls so far
+			static std::optional<input_record::Log> s_recording;
+			static std::optional<input_record::Log> s_replay;
+			static std::size_t s_replayNext = 0;
+			static bool s_exitWhenReplayEnds = false;
+
 
 
 			static Game* getGame() noexcept;
 			static Logger* getLogger() noexcept;
 			static void logException() noexcept;
+			static void log(LogLevel level, std::string_view message) noexcept;
 
+#ifdef _WIN32
 			static BOOL WINAPI onConsoleClose(DWORD ctrl);
+#endif
 
 			static void close() noexcept;
 
+			static void setSwapInterval(int interval) noexcept;
+			static void paceFrame() noexcept;
+
+			static void deliverInput(input_record::Event const& event) noexcept;
+			static void handleInput(input_record::EventType type, int a = 0, int b = 0) noexcept;
+			static void replayInput() noexcept;
+			static bool replayEnded() noexcept;
+			static void writeRecording(char const* path) noexcept;
+
 			static void update() noexcept;
 			static void render() noexcept;
 			static void onReshape(int width, int height) noexcept;
@@ -72,10 +120,19 @@ namespace be
 			static void onPosition(int x, int y) noexcept;
 
 			static void init(ApplicationRunInfo const& info);
+			static void initHeadless(ApplicationRunInfo const& info);
+			static void createGame(ApplicationRunInfo const& info);
+			static RunStats runHeadlessFrames(ApplicationRunInfo const& info, headless::Context& context);
+			static void runHeadless(ApplicationRunInfo const& info);
 			static void run(ApplicationRunInfo const& info) noexcept;
 
 			static bool wantsToExit() noexcept;
 			static void exit() noexcept;
+
+			static bool isHeadless() noexcept;
+			static bool isReplayingInput() noexcept;
+			static int getWindowWidth() noexcept;
+			static int getWindowHeight() noexcept;
 		}
 	}
 
@@ -96,8 +153,14 @@ namespace be
 		if (s_logger) { s_logger->logException(); }
 	}
 
+	void Application::detail::log(LogLevel const level, std::string_view const message) noexcept
+	{
+		if (s_logger) { s_logger->log(level, message); }
+	}
+
 
 
+#ifdef _WIN32
 	BOOL WINAPI Application::detail::onConsoleClose(DWORD ctrl)
 	{
 		try
@@ -147,6 +210,7 @@ namespace be
 			std::terminate();
 		}
 	}
+#endif
 
 
 
@@ -171,6 +235,8 @@ namespace be
 			if (cleaning)
 			{
 				s_game.reset();
+				// anything the game created and is still tracked has leaked.
+				gpu_memory::logLiveObjects();
 
 				{
 					std::scoped_lock<std::mutex> _{ s_closingMutex };
@@ -187,19 +253,140 @@ namespace be
 
 
 
+	void Application::detail::setSwapInterval(int interval) noexcept
+	{
+#ifdef _WIN32
+		if (WGLEW_EXT_swap_control) { wglSwapIntervalEXT(interval); }
+#else
+		if (GLXEW_EXT_swap_control) { glXSwapIntervalEXT(glXGetCurrentDisplay(), glXGetCurrentDrawable(), interval); }
+		else if (GLXEW_MESA_swap_control) { glXSwapIntervalMESA(static_cast<unsigned int>(interval)); }
+#endif
+	}
+
+	void Application::detail::paceFrame() noexcept
+	{
+		if (s_frameInterval == frame_pacing::Clock::duration::zero()) { return; }
+
+		BE_PROFILE_SCOPE("Application::paceFrame");
+
+		frame_pacing::sleepUntil(s_nextFrameDeadline);
+
+		// keep a steady cadence, but do not try to catch up after a long stall.
+		s_nextFrameDeadline += s_frameInterval;
+		auto const now = frame_pacing::Clock::now();
+		if (s_nextFrameDeadline < now)
+		{
+			s_nextFrameDeadline = now + s_frameInterval;
+		}
+	}
+
+
+
+	void Application::detail::deliverInput(input_record::Event const& event) noexcept
+	{
+		try { input_record::dispatch(*getGame(), event); }
+		catch (...) { logException(); }
+	}
+
+	void Application::detail::handleInput(input_record::EventType const type, int const a, int const b) noexcept
+	{
+		// a replay owns the input, so the game sees exactly what was recorded.
+		if (s_replay) { return; }
+
+		input_record::Event const event{ s_updateStep, type, a, b };
+		if (s_recording)
+		{
+			try { s_recording->events.push_back(event); }
+			catch (...) { logException(); }
+		}
+		deliverInput(event);
+	}
+
+	void Application::detail::replayInput() noexcept
+	{
+		if (!s_replay) { return; }
+
+		auto const& events = s_replay->events;
+		while (s_replayNext < events.size() && events[s_replayNext].step <= s_updateStep)
+		{
+			deliverInput(events[s_replayNext]);
+			++s_replayNext;
+		}
+	}
+
+	bool Application::detail::replayEnded() noexcept
+	{
+		return s_replay && s_exitWhenReplayEnds && s_updateStep >= s_replay->endStep;
+	}
+
+	void Application::detail::writeRecording(char const* const path) noexcept
+	{
+		if (!s_recording) { return; }
+
+		try
+		{
+			s_recording->endStep = s_updateStep;
+			input_record::writeLog(path, *s_recording);
+			if (s_logger)
+			{
+				s_logger->logf(LogLevel::Info, "[be] recorded %zu input events over %llu updates to %s",
+					s_recording->events.size(),
+					static_cast<unsigned long long>(s_updateStep),
+					path);
+			}
+		}
+		catch (...) { logException(); }
+		s_recording.reset();
+	}
+
+
+
 	void Application::detail::update() noexcept
 	{
 		try
 		{
+			paceFrame();
+
+			BE_PROFILE_SCOPE("Application::update");
+
 			if (wantsToExit())
 			{
 				exit();
 				return;
 			}
 
+			auto const now = frame_pacing::Clock::now();
+			double const elapsed = frame_pacing::Seconds(now - s_lastTick).count();
+			s_lastTick = now;
+
+			error_stats::beginFrame();
+			gpu_memory::beginFrame();
+			mem::getFrameArena().reset();
+
+			auto& timestep = *s_timestep;
+			int const steps = timestep.advance(elapsed);
+			float const deltaTime = static_cast<float>(timestep.step());
+
+			jobs::runMainThreadTasks();
+
 			auto& app = *getGame();
-			try { app.update(); }
-			catch (...) { logException(); }
+			for (int i = 0; i < steps; ++i)
+			{
+				if (replayEnded())
+				{
+					exit();
+					break;
+				}
+				replayInput();
+				try
+				{
+					BE_PROFILE_SCOPE("Game::Update");
+					app.update(deltaTime);
+				}
+				catch (...) { logException(); }
+				++s_updateStep;
+			}
+			s_interpolation = static_cast<float>(timestep.interpolation());
 
 			glutPostRedisplay();
 		}
@@ -216,11 +403,22 @@ namespace be
 	{
 		try
 		{
-			auto& app = *getGame();
-			try { app.render(); }
-			catch (...) { logException(); }
+			{
+				BE_PROFILE_SCOPE("Application::render");
+
+				auto& app = *getGame();
+				try
+				{
+					BE_PROFILE_SCOPE("Game::Render");
+					app.render(s_interpolation);
+				}
+				catch (...) { logException(); }
+
+				BE_PROFILE_SCOPE("glutSwapBuffers");
+				glutSwapBuffers();
+			}
 
-			glutSwapBuffers();
+			profile::markFrame();
 		}
 		catch (...)
 		{
@@ -233,174 +431,71 @@ namespace be
 
 	void Application::detail::onReshape(int width, int height) noexcept
 	{
-		try
-		{
-			glViewport(0, 0, width, height);
-
-			auto& app = *getGame();
-			try { app.onWindowSizeChanged(width, height); }
-			catch (...) { logException(); }
-		}
-		catch (...) { logException(); std::terminate(); }
+		// the viewport follows the real window even while a replay feeds the game recorded sizes.
+		glViewport(0, 0, width, height);
+		handleInput(input_record::EventType::WindowSize, width, height);
 	}
 
 
 
 	void Application::detail::onKeyGoingDown(unsigned char key, int x, int y) noexcept
 	{
-		try
-		{
-			auto& app = *getGame();
-			try { app.onMousePositionInWindowChanged(x, y); }
-			catch (...) { logException(); }
-			try { app.onKeyGoingDown(key); }
-			catch (...) { logException(); }
-		}
-		catch (...) { logException(); std::terminate(); }
+		handleInput(input_record::EventType::MousePosition, x, y);
+		handleInput(input_record::EventType::KeyDown, key);
 	}
 	void Application::detail::onKeyGoingUp(unsigned char key, int x, int y) noexcept
 	{
-		try
-		{
-			auto& app = *getGame();
-			try { app.onMousePositionInWindowChanged(x, y); }
-			catch (...) { logException(); }
-			try { app.onKeyGoingUp(key); }
-			catch (...) { logException(); }
-		}
-		catch (...) { logException(); std::terminate(); }
+		handleInput(input_record::EventType::MousePosition, x, y);
+		handleInput(input_record::EventType::KeyUp, key);
 	}
 	void Application::detail::onSpecialGoingDown(int key, int x, int y) noexcept
 	{
-		try
-		{
-			auto& app = *getGame();
-			try { app.onMousePositionInWindowChanged(x, y); }
-			catch (...) { logException(); }
-			try { app.onSpecialGoingDown(key); }
-			catch (...) { logException(); }
-		}
-		catch (...) { logException(); std::terminate(); }
+		handleInput(input_record::EventType::MousePosition, x, y);
+		handleInput(input_record::EventType::SpecialDown, key);
 	}
 	void Application::detail::onSpecialGoingUp(int key, int x, int y) noexcept
 	{
-		try
-		{
-			auto& app = *getGame();
-			try { app.onMousePositionInWindowChanged(x, y); }
-			catch (...) { logException(); }
-			try { app.onSpecialGoingUp(key); }
-			catch (...) { logException(); }
-		}
-		catch (...) { logException(); std::terminate(); }
+		handleInput(input_record::EventType::MousePosition, x, y);
+		handleInput(input_record::EventType::SpecialUp, key);
 	}
 	void Application::detail::onMouseButton(int button, int state, int x, int y) noexcept
 	{
-		try
-		{
-			auto& app = *getGame();
-
-			try { app.onMousePositionInWindowChanged(x, y); }
-			catch (...) { logException(); }
-
-			switch (state)
-			{
-			case GLUT_DOWN:
-			{
-				try { app.onMouseButtonGoingDown(button); }
-				catch (...) { logException(); }
-			}
-			break;
-			case GLUT_UP:
-			{
-				try { app.onMouseButtonGoingUp(button); }
-				catch (...) { logException(); }
-			}
-			break;
-			}
-		}
-		catch (...)
+		handleInput(input_record::EventType::MousePosition, x, y);
+		switch (state)
 		{
-			logException();
-			std::terminate();
+		case GLUT_DOWN: handleInput(input_record::EventType::MouseButtonDown, button); break;
+		case GLUT_UP: handleInput(input_record::EventType::MouseButtonUp, button); break;
 		}
 	}
 	void Application::detail::onMouseMoveWhileAllUp(int x, int y) noexcept
 	{
-		try
-		{
-			auto& app = *getGame();
-			try { app.onMousePositionInWindowChanged(x, y); }
-			catch (...) { logException(); }
-			try { app.onMouseMoveWhileAllUp(); }
-			catch (...) { logException(); }
-		}
-		catch (...) { logException(); std::terminate(); }
+		handleInput(input_record::EventType::MousePosition, x, y);
+		handleInput(input_record::EventType::MouseMoveWhileAllUp);
 	}
 	void Application::detail::onMouseMoveWhileAnyDown(int x, int y) noexcept
 	{
-		try
-		{
-			auto& app = *getGame();
-			try { app.onMousePositionInWindowChanged(x, y); }
-			catch (...) { logException(); }
-			try { app.onMouseMoveWhileAnyDown(); }
-			catch (...) { logException(); }
-		}
-		catch (...) { logException(); std::terminate(); }
+		handleInput(input_record::EventType::MousePosition, x, y);
+		handleInput(input_record::EventType::MouseMoveWhileAnyDown);
 	}
 	void Application::detail::onMouseWheel(int wheel, int direction, int x, int y) noexcept
 	{
-		try
-		{
-			auto& app = *getGame();
-			try { app.onMousePositionInWindowChanged(x, y); }
-			catch (...) { logException(); }
-			if (direction < 0)
-			{
-				try { app.onMouseWheelNegative(wheel); }
-				catch (...) { logException(); }
-			}
-			else
-			{
-				try { app.onMouseWheelPositive(wheel); }
-				catch (...) { logException(); }
-			}
-		}
-		catch (...) { logException(); std::terminate(); }
+		handleInput(input_record::EventType::MousePosition, x, y);
+		handleInput(direction < 0
+			? input_record::EventType::MouseWheelNegative
+			: input_record::EventType::MouseWheelPositive,
+			wheel);
 	}
 	void Application::detail::onMouseEntry(int state) noexcept
 	{
-		try
+		switch (state)
 		{
-			auto& app = *getGame();
-			switch (state)
-			{
-			case GLUT_LEFT:
-			{
-				try { app.onMouseLeftWindow(); }
-				catch (...) { logException(); }
-			}
-			break;
-			case GLUT_ENTERED:
-			{
-				try { app.onMouseEnteredWindow(); }
-				catch (...) { logException(); }
-			}
-			break;
-			}
+		case GLUT_LEFT: handleInput(input_record::EventType::MouseLeftWindow); break;
+		case GLUT_ENTERED: handleInput(input_record::EventType::MouseEnteredWindow); break;
 		}
-		catch (...) { logException(); std::terminate(); }
 	}
 	void Application::detail::onPosition(int x, int y) noexcept
 	{
-		try
-		{
-			auto& app = *getGame();
-			try { app.onWindowPositionChanged(x, y); }
-			catch (...) { logException(); }
-		}
-		catch (...) { logException(); std::terminate(); }
+		handleInput(input_record::EventType::WindowPosition, x, y);
 	}
 
 
@@ -427,7 +522,9 @@ namespace be
 		if (0 != glewInit()) { throw GlewInitException(); }
 
 		// callbacks
+#ifdef _WIN32
 		SetConsoleCtrlHandler(onConsoleClose, TRUE);
+#endif
 
 		glutCloseFunc(close);
 
@@ -452,10 +549,153 @@ namespace be
 		glEnable(GL_CULL_FACE);
 		glCullFace(GL_BACK);
 
+		setSwapInterval(info.vsync ? 1 : 0);
+
 		//glutSetOption(GLUT_MULTISAMPLE, 8); // anti aliasing
 		//glEnable(GL_MULTISAMPLE); // anti aliasing
 	}
 
+	void Application::detail::initHeadless(ApplicationRunInfo const& info)
+	{
+		glewExperimental = GL_TRUE;
+		auto const glewResult = glewInit();
+		// glewInit also loads the window system extensions, which fails without a display.
+		// the core entry points are loaded before that, so the error is harmless here.
+		if (GLEW_OK != glewResult && GLEW_ERROR_NO_GLX_DISPLAY != glewResult) { throw GlewInitException(); }
+		if (!GLEW_VERSION_3_3) { throw HeadlessInitException("[be] headless init exception: OpenGL 3.3 is not supported"); }
+
+		glViewport(0, 0, info.windowWidth, info.windowHeight);
+
+		// initial GL properties
+		glFrontFace(GL_CCW);
+
+		glEnable(GL_CULL_FACE);
+		glCullFace(GL_BACK);
+	}
+
+
+
+	void Application::detail::createGame(ApplicationRunInfo const& info)
+	{
+		{
+			BE_PROFILE_SCOPE("Application::createGame");
+			s_game = info.createGame();
+		}
+		if (s_game == nullptr)
+		{
+			throw CreateGameException();
+		}
+	}
+
+
+
+	RunStats Application::detail::runHeadlessFrames(ApplicationRunInfo const& info, headless::Context& context)
+	{
+		using frame_pacing::Clock;
+
+		RunStats stats;
+		std::vector<double> frameMs;
+		frameMs.reserve(info.headlessFrameCount > 0 ? static_cast<std::size_t>(info.headlessFrameCount) : 1024);
+
+		float const deltaTime = static_cast<float>(info.fixedTimestep);
+		auto const start = Clock::now();
+		auto const deadline = info.headlessSeconds > 0.0
+			? start + std::chrono::duration_cast<Clock::duration>(frame_pacing::Seconds(info.headlessSeconds))
+			: Clock::time_point::max();
+
+		auto& app = *getGame();
+		while (!s_headlessExitRequested.load())
+		{
+			if (info.headlessFrameCount > 0 && stats.frames >= static_cast<std::uint64_t>(info.headlessFrameCount)) { break; }
+			if (replayEnded()) { break; }
+			auto const frameStart = Clock::now();
+			if (frameStart >= deadline) { break; }
+
+			error_stats::beginFrame();
+			gpu_memory::beginFrame();
+			mem::getFrameArena().reset();
+
+			{
+				BE_PROFILE_SCOPE("Application::update");
+				jobs::runMainThreadTasks();
+				replayInput();
+				try
+				{
+					BE_PROFILE_SCOPE("Game::Update");
+					app.update(deltaTime);
+				}
+				catch (...) { logException(); }
+				++s_updateStep;
+				++stats.updates;
+			}
+
+			{
+				BE_PROFILE_SCOPE("Application::render");
+				try
+				{
+					BE_PROFILE_SCOPE("Game::Render");
+					app.render(0.0f);
+				}
+				catch (...) { logException(); }
+
+				BE_PROFILE_SCOPE("headless::Context::finishFrame");
+				context.finishFrame();
+			}
+
+			profile::markFrame();
+
+			frameMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count());
+			++stats.frames;
+		}
+
+		stats.totalSeconds = frame_pacing::Seconds(Clock::now() - start).count();
+		if (!frameMs.empty())
+		{
+			double total = 0.0;
+			for (auto const ms : frameMs) { total += ms; }
+			stats.meanFrameMs = total / static_cast<double>(frameMs.size());
+			auto const [minIt, maxIt] = std::minmax_element(frameMs.begin(), frameMs.end());
+			stats.minFrameMs = *minIt;
+			stats.maxFrameMs = *maxIt;
+			auto const k = std::min(frameMs.size() - 1, (frameMs.size() * 95) / 100);
+			std::nth_element(frameMs.begin(), frameMs.begin() + k, frameMs.end());
+			stats.p95FrameMs = frameMs[k];
+		}
+		return stats;
+	}
+
+	void Application::detail::runHeadless(ApplicationRunInfo const& info)
+	{
+		headless::Context context{ info.windowWidth, info.windowHeight };
+		s_headlessContext = &context;
+
+		try
+		{
+			initHeadless(info);
+			createGame(info);
+			RunStats const stats = runHeadlessFrames(info, context);
+			// the game owns GL objects, so it must be destroyed while the context is alive.
+			close();
+
+			// through the logger, so a caller's own output keeps stdout to itself.
+			logf(LogLevel::Info, "[be] headless run: %llu frames, %llu updates in %.3f s",
+				static_cast<unsigned long long>(stats.frames),
+				static_cast<unsigned long long>(stats.updates),
+				stats.totalSeconds);
+			logf(LogLevel::Info, "[be] frame ms: mean %.3f, p95 %.3f, min %.3f, max %.3f",
+				stats.meanFrameMs, stats.p95FrameMs, stats.minFrameMs, stats.maxFrameMs);
+			if (info.runStats) { *info.runStats = stats; }
+		}
+		catch (...)
+		{
+			close();
+			s_headlessContext = nullptr;
+			throw;
+		}
+
+		s_headlessContext = nullptr;
+	}
+
 
 
 	void Application::detail::run(ApplicationRunInfo const& info) noexcept
@@ -469,7 +709,16 @@ namespace be
 				|| info.windowWidth <= 0
 				|| info.windowHeight <= 0
 				|| info.windowTitle == nullptr
-				|| info.createGame == nullptr)
+				|| info.createGame == nullptr
+				|| !(info.fixedTimestep > 0.0)
+				|| info.maxUpdatesPerFrame <= 0
+				|| info.jobWorkerCount < -1
+				|| !(info.maxFrameRate >= 0.0)
+				|| info.headlessFrameCount < 0
+				|| !(info.headlessSeconds >= 0.0)
+				|| (info.recordInputPath && info.replayInputPath)
+				|| (info.headless && info.headlessFrameCount == 0 && info.headlessSeconds == 0.0
+					&& !(info.replayInputPath && info.exitWhenReplayEnds)))
 			{
 				throw RunInfoException();
 			}
@@ -479,22 +728,56 @@ namespace be
 				throw RunAgainException();
 			}
 
-			init(info);
+			profile::setEnabled(info.enableProfiler);
 
-			s_game = info.createGame();
-			if (s_game == nullptr)
+			// a replay steps by the recorded timestep, whatever the caller asked for.
+			ApplicationRunInfo runInfo = info;
+			if (info.replayInputPath)
 			{
-				throw CreateGameException();
+				s_replay = input_record::readLog(info.replayInputPath);
+				s_exitWhenReplayEnds = info.exitWhenReplayEnds;
+				runInfo.fixedTimestep = s_replay->fixedTimestep;
+			}
+			else if (info.recordInputPath)
+			{
+				s_recording.emplace();
+				s_recording->fixedTimestep = info.fixedTimestep;
 			}
 
-			glutMainLoop();
-			close();
+			// outlives the game, so jobs it started can finish before the workers are joined.
+			jobs::Scope const jobScope{ info.jobWorkerCount < 0
+				? jobs::getDefaultWorkerCount()
+				: static_cast<unsigned>(info.jobWorkerCount) };
+
+			if (runInfo.headless)
+			{
+				runHeadless(runInfo);
+			}
+			else
+			{
+				init(runInfo);
+				createGame(runInfo);
+
+				s_timestep.emplace(runInfo.fixedTimestep, runInfo.maxUpdatesPerFrame);
+				s_frameInterval = info.maxFrameRate > 0.0
+					? std::chrono::duration_cast<frame_pacing::Clock::duration>(frame_pacing::Seconds(1.0 / info.maxFrameRate))
+					: frame_pacing::Clock::duration::zero();
+				s_lastTick = frame_pacing::Clock::now();
+				s_nextFrameDeadline = s_lastTick + s_frameInterval;
+
+				frame_pacing::TimerResolutionScope const timerResolution;
+				glutMainLoop();
+				close();
+			}
 		}
 		catch (...)
 		{
 			logException();
 		}
 
+		// even after a failure, since the recording is what reproduces it.
+		writeRecording(info.recordInputPath);
+
 		s_logger = nullptr;
 	}
 
@@ -507,9 +790,34 @@ namespace be
 
 	void Application::detail::exit() noexcept
 	{
+		if (s_headlessContext)
+		{
+			s_headlessExitRequested.store(true);
+			return;
+		}
 		glutLeaveMainLoop();
 	}
 
+	bool Application::detail::isHeadless() noexcept
+	{
+		return s_headlessContext != nullptr;
+	}
+
+	bool Application::detail::isReplayingInput() noexcept
+	{
+		return s_replay.has_value();
+	}
+
+	int Application::detail::getWindowWidth() noexcept
+	{
+		return s_headlessContext ? s_headlessContext->width() : glutGet(GLUT_WINDOW_WIDTH);
+	}
+
+	int Application::detail::getWindowHeight() noexcept
+	{
+		return s_headlessContext ? s_headlessContext->height() : glutGet(GLUT_WINDOW_HEIGHT);
+	}
+
 
 
 	void Application::run(ApplicationRunInfo const& info) noexcept
@@ -536,4 +844,40 @@ namespace be
 	{
 		detail::logException();
 	}
+
+	void Application::log(LogLevel const level, std::string_view const message) noexcept
+	{
+		detail::log(level, message);
+	}
+
+	void Application::logf(LogLevel const level, char const* const format, ...) noexcept
+	{
+		auto* const logger = detail::getLogger();
+		if (!logger) { return; }
+
+		va_list args;
+		va_start(args, format);
+		logger->vlogf(level, format, args);
+		va_end(args);
+	}
+
+	bool Application::isHeadless() noexcept
+	{
+		return detail::isHeadless();
+	}
+
+	bool Application::isReplayingInput() noexcept
+	{
+		return detail::isReplayingInput();
+	}
+
+	int Application::getWindowWidth() noexcept
+	{
+		return detail::getWindowWidth();
+	}
+
+	int Application::getWindowHeight() noexcept
+	{
+		return detail::getWindowHeight();
+	}
 }
@@ -0,0 +1,321 @@
+/*
+//	be/async_logger
+//	A Logger that never blocks the caller on I/O: messages go through a lock-free ring
+//	to a background thread, which writes them to sinks and collapses repeats.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <unordered_map>
+
+#include "be/async_logger.hpp"
+
+namespace be
+{
+	// SINKS
+
+	void ConsoleLogSink::Write(LogLevel const level, std::string_view const line)
+	{
+		auto& stream = level >= LogLevel::Warning ? std::cerr : std::cout;
+		stream << line << '\n';
+	}
+
+	void ConsoleLogSink::Flush()
+	{
+		std::cout.flush();
+	}
+
+	FileLogSink::FileLogSink(std::string const& path)
+		: m_file(path, std::ios::out | std::ios::trunc)
+	{
+		if (!m_file)
+		{
+			throw LoggerException("failed to open " + path);
+		}
+	}
+
+	void FileLogSink::Write(LogLevel, std::string_view const line)
+	{
+		m_file << line << '\n';
+	}
+
+	void FileLogSink::Flush()
+	{
+		m_file.flush();
+	}
+
+
+
+	// CONSUMER
+
+	struct AsyncLogger::Consumer
+	{
+		struct Repeat
+		{
+			Clock::time_point windowEnd;
+			LogLevel level{};
+			std::uint64_t count{}; // not written since the window opened
+		};
+
+		std::vector<std::shared_ptr<LogSink>> sinks;
+		std::chrono::milliseconds repeatWindow{};
+		Clock::time_point start;
+		std::size_t dequeuePosition = 0;
+		std::uint64_t reportedDropped = 0;
+		bool wrote = false;
+		std::unordered_map<std::string, Repeat> repeats; // keyed by level and message
+		std::string key;
+		std::string line;
+
+		void write(LogLevel const level, Clock::time_point const time, std::string_view const message)
+		{
+			char prefix[48];
+			double const seconds = std::chrono::duration<double>(time - start).count();
+			int const length = std::snprintf(prefix, sizeof(prefix), "[%9.3f] [%s] ", seconds, toString(level));
+
+			line.assign(prefix, static_cast<std::size_t>(std::max(length, 0)));
+			line.append(message);
+
+			for (auto const& sink : sinks)
+			{
+				try { sink->write(level, line); }
+				catch (...) {}
+			}
+			wrote = true;
+		}
+
+		void writeRepeats(LogLevel const level, Clock::time_point const time, std::uint64_t const count, std::string_view const message)
+		{
+			char text[64];
+			int const length = std::snprintf(text, sizeof(text), "repeated %llu more times: ",
+				static_cast<unsigned long long>(count));
+			std::string repeated(text, static_cast<std::size_t>(std::max(length, 0)));
+			repeated.append(message);
+			write(level, time, repeated);
+		}
+
+		void process(LogLevel const level, Clock::time_point const time, std::string_view const message)
+		{
+			if (repeatWindow.count() <= 0)
+			{
+				write(level, time, message);
+				return;
+			}
+
+			key.assign(1, static_cast<char>(level));
+			key.append(message);
+			auto const [it, inserted] = repeats.try_emplace(key);
+			auto& repeat = it->second;
+			if (!inserted && time < repeat.windowEnd)
+			{
+				++repeat.count;
+				return;
+			}
+
+			if (repeat.count > 0)
+			{
+				writeRepeats(level, time, repeat.count, message);
+			}
+			repeat = Repeat{ time + repeatWindow, level, 0 };
+			write(level, time, message);
+		}
+
+		// Reports the repeats of windows that have closed, or of all windows.
+		void closeWindows(Clock::time_point const now, bool const all)
+		{
+			for (auto it = repeats.begin(); it != repeats.end();)
+			{
+				auto const& repeat = it->second;
+				if (!all && now < repeat.windowEnd)
+				{
+					++it;
+					continue;
+				}
+				if (repeat.count > 0)
+				{
+					writeRepeats(repeat.level, now, repeat.count, std::string_view(it->first).substr(1));
+				}
+				it = repeats.erase(it);
+			}
+		}
+
+		void flush()
+		{
+			if (!wrote) { return; }
+			wrote = false;
+			for (auto const& sink : sinks)
+			{
+				try { sink->flush(); }
+				catch (...) {}
+			}
+		}
+	};
+
+
+
+	// ASYNC LOGGER
+
+	AsyncLogger::AsyncLogger(CreateInfo const& info)
+		: m_mask(info.capacity - 1)
+		, m_minLevel(info.minLevel)
+	{
+		if (info.capacity < 2 || (info.capacity & (info.capacity - 1)) != 0)
+		{
+			throw LoggerException("capacity must be a power of two");
+		}
+
+		m_slots = std::make_unique<Slot[]>(info.capacity);
+		for (std::size_t i = 0; i < info.capacity; ++i)
+		{
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		m_consumer = std::make_unique<Consumer>();
+		m_consumer->sinks = info.sinks;
+		if (m_consumer->sinks.empty())
+		{
+			m_consumer->sinks.push_back(std::make_shared<ConsoleLogSink>());
+		}
+		m_consumer->repeatWindow = info.repeatWindow;
+		m_consumer->start = Clock::now();
+
+		m_thread = std::thread([this] { run(); });
+	}
+
+	AsyncLogger::~AsyncLogger() noexcept
+	{
+		m_stopping.store(true, std::memory_order_release);
+		m_signal.fetch_add(1, std::memory_order_release);
+		m_signal.notify_one();
+		if (m_thread.joinable()) { m_thread.join(); }
+	}
+
+	void AsyncLogger::LogException() noexcept
+	{
+		char text[maxMessageLength + 1];
+		try { throw; }
+		catch (std::exception const& e) { std::snprintf(text, sizeof(text), "! Exception: %s", e.what()); }
+		catch (char const* what) { std::snprintf(text, sizeof(text), "! Exception: %s", what); }
+		catch (...) { std::snprintf(text, sizeof(text), "! Exception: unknown"); }
+
+		if (!tryEnqueue(LogLevel::Error, text))
+		{
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void AsyncLogger::Log(LogLevel const level, std::string_view const message) noexcept
+	{
+		if (!isEnabled(level)) { return; }
+		if (!tryEnqueue(level, message))
+		{
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// Bounded MPSC queue after Dmitry Vyukov: each slot's sequence says whose turn it is,
+	// so producers only contend on one compare-exchange of the enqueue position.
+	bool AsyncLogger::tryEnqueue(LogLevel const level, std::string_view const message) noexcept
+	{
+		Slot* slot = nullptr;
+		std::size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			slot = &m_slots[position & m_mask];
+			std::size_t const sequence = slot->sequence.load(std::memory_order_acquire);
+			auto const difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+			if (difference == 0)
+			{
+				if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false; // full: the consumer has not released this slot yet
+			}
+			else
+			{
+				position = m_enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		std::size_t const length = std::min(message.size(), maxMessageLength);
+		slot->time = Clock::now();
+		slot->level = level;
+		slot->length = static_cast<std::uint8_t>(length);
+		std::memcpy(slot->text, message.data(), length);
+		slot->sequence.store(position + 1, std::memory_order_release);
+
+		m_signal.fetch_add(1, std::memory_order_release);
+		m_signal.notify_one();
+		return true;
+	}
+
+	bool AsyncLogger::drain()
+	{
+		auto& consumer = *m_consumer;
+		bool any = false;
+		for (;;)
+		{
+			auto& slot = m_slots[consumer.dequeuePosition & m_mask];
+			if (slot.sequence.load(std::memory_order_acquire) != consumer.dequeuePosition + 1) { break; }
+
+			try { consumer.process(slot.level, slot.time, std::string_view(slot.text, slot.length)); }
+			catch (...) {}
+
+			slot.sequence.store(consumer.dequeuePosition + m_mask + 1, std::memory_order_release);
+			++consumer.dequeuePosition;
+			any = true;
+		}
+
+		std::uint64_t const dropped = m_dropped.load(std::memory_order_relaxed);
+		if (dropped > consumer.reportedDropped)
+		{
+			char text[96];
+			std::snprintf(text, sizeof(text), "[be] dropped %llu log messages because the ring was full",
+				static_cast<unsigned long long>(dropped - consumer.reportedDropped));
+			consumer.reportedDropped = dropped;
+			try { consumer.write(LogLevel::Warning, Clock::now(), text); }
+			catch (...) {}
+		}
+		return any;
+	}
+
+	void AsyncLogger::run() noexcept
+	{
+		auto& consumer = *m_consumer;
+		// open repeat windows need a wake up when they close, even if nothing else is logged.
+		constexpr std::chrono::milliseconds repeatPoll{ 50 };
+
+		for (;;)
+		{
+			std::uint32_t const seen = m_signal.load(std::memory_order_acquire);
+			bool const stopping = m_stopping.load(std::memory_order_acquire);
+
+			bool const any = drain();
+			try { consumer.closeWindows(Clock::now(), stopping); }
+			catch (...) {}
+			consumer.flush();
+
+			if (stopping) { return; }
+			if (any) { continue; }
+
+			if (consumer.repeats.empty())
+			{
+				m_signal.wait(seen, std::memory_order_acquire);
+			}
+			else
+			{
+				std::this_thread::sleep_for(repeatPoll);
+			}
+		}
+	}
+}
@@ -7,24 +7,29 @@ namespace be
 	{
 		namespace meshes
 		{
-			be::gl::BasicMesh makeQuadMesh()
-			{
-				using Vertex = be::gl::BasicVertex;
+			using Vertex = be::gl::BasicVertex;
 
-				float const h = 0.5f;
-				Vertex const vertices[4] = { Vertex
-				{ { -h, -h, 0 }, { 0, 0, 1 }, { 0, 1 } },
-				{ { +h, -h, 0 }, { 0, 0, 1 }, { 1, 1 } },
-				{ { +h, +h, 0 }, { 0, 0, 1 }, { 1, 0 } },
-				{ { -h, +h, 0 }, { 0, 0, 1 }, { 0, 0 } },
-				};
+			static float const h = 0.5f;
+			static Vertex const quadVertices[4] = { Vertex
+			{ { -h, -h, 0 }, { 0, 0, 1 }, { 0, 1 } },
+			{ { +h, -h, 0 }, { 0, 0, 1 }, { 1, 1 } },
+			{ { +h, +h, 0 }, { 0, 0, 1 }, { 1, 0 } },
+			{ { -h, +h, 0 }, { 0, 0, 1 }, { 0, 0 } },
+			};
 
-				GLuint const indices[3 * 2] = {
-					0, 1, 2,
-					2, 3, 0,
-				};
+			static GLuint const quadIndices[3 * 2] = {
+				0, 1, 2,
+				2, 3, 0,
+			};
 
-				return be::gl::makeBasicMesh(vertices, indices);
+			be::gl::BasicMesh makeQuadMesh()
+			{
+				return be::gl::makeBasicMesh(quadVertices, quadIndices);
+			}
+
+			be::gl::MeshRange addQuadMesh(be::gl::MeshPool& pool)
+			{
+				return pool.add(quadVertices, 4, quadIndices, 3 * 2);
 			}
 		}
 	}
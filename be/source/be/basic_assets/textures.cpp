@@ -12,7 +12,7 @@ namespace be
 			{
 				auto const path = basicAssetsFolder / "textures/flag.png";
 				auto const str = path.string();
-				auto texture = be::soil::load_OGL_texture(str.c_str(), SOIL_LOAD_RGBA, 0, 0);
+				auto texture = be::soil::load_OGL_texture(str.c_str(), SOIL_LOAD_RGBA, 0, 0, "flag");
 				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -32,7 +32,8 @@ namespace be
 					(dir + "ft.tga").c_str(),
 					SOIL_LOAD_RGB,
 					0,
-					SOIL_FLAG_MIPMAPS
+					SOIL_FLAG_MIPMAPS,
+					"skybox"
 				);
 				BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_CUBE_MAP, texture.get(), GL_TEXTURE0);
 				glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
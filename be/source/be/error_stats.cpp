@@ -0,0 +1,68 @@
+/*
+//	be/error_stats
+//	Counts recoverable errors on per-frame paths instead of throwing them.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include "be/application.hpp"
+#include "be/error_stats.hpp"
+
+namespace be
+{
+	namespace error_stats
+	{
+		// sites are only ever added, so readers can walk the list without a lock.
+		static std::atomic<ErrorSite*> s_sites{ nullptr };
+
+		ErrorSite::ErrorSite(char const* const name) noexcept
+			: m_name(name)
+		{
+			m_next = s_sites.load(std::memory_order_relaxed);
+			while (!s_sites.compare_exchange_weak(m_next, this, std::memory_order_release, std::memory_order_relaxed)) {}
+		}
+
+		void ErrorSite::report(std::string_view const detail) noexcept
+		{
+			m_frame.fetch_add(1, std::memory_order_relaxed);
+			if (0 == m_total.fetch_add(1, std::memory_order_relaxed))
+			{
+				be::Application::logf(LogLevel::Warning, "[be] %s: %.*s (only the first is logged, see be/error_stats.hpp)",
+					m_name, static_cast<int>(detail.size()), detail.data());
+			}
+		}
+
+		void beginFrame() noexcept
+		{
+			for (auto* site = s_sites.load(std::memory_order_acquire); site; site = site->m_next)
+			{
+				site->m_frame.store(0, std::memory_order_relaxed);
+			}
+		}
+
+		std::vector<ErrorStats> getAllErrorStats()
+		{
+			std::vector<ErrorStats> stats;
+			for (auto* site = s_sites.load(std::memory_order_acquire); site; site = site->m_next)
+			{
+				auto const total = site->totalCount();
+				if (total > 0)
+				{
+					stats.push_back(ErrorStats{ site->m_name, site->frameCount(), total });
+				}
+			}
+			return stats;
+		}
+
+		std::uint64_t getFrameErrorCount() noexcept
+		{
+			std::uint64_t count = 0;
+			for (auto* site = s_sites.load(std::memory_order_acquire); site; site = site->m_next)
+			{
+				count += site->frameCount();
+			}
+			return count;
+		}
+	}
+}
@@ -0,0 +1,51 @@
+/*
+//	be/frame_pacing
+//	Fixed simulation timestep and precise frame rate limiting.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+#include "be/frame_pacing.hpp"
+
+namespace be
+{
+	namespace frame_pacing
+	{
+		void sleepUntil(Clock::time_point deadline, Seconds spinThreshold) noexcept
+		{
+			auto const coarseDeadline = deadline - std::chrono::duration_cast<Clock::duration>(spinThreshold);
+			if (Clock::now() < coarseDeadline)
+			{
+				std::this_thread::sleep_until(coarseDeadline);
+			}
+
+			while (Clock::now() < deadline)
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		TimerResolutionScope::TimerResolutionScope() noexcept
+		{
+#ifdef _WIN32
+			timeBeginPeriod(1);
+#endif
+		}
+
+		TimerResolutionScope::~TimerResolutionScope() noexcept
+		{
+#ifdef _WIN32
+			timeEndPeriod(1);
+#endif
+		}
+	}
+}
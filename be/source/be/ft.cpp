@@ -1,7 +1,9 @@
 
+#include <algorithm>
 #include <vector>
 
 #include "be/mem/ft.hpp"
+#include "be/profile.hpp"
 
 #include "be/ft.hpp"
 
@@ -9,27 +11,10 @@ namespace be
 {
 	namespace ft
 	{
-		namespace
-		{
-			static be::mem::gl::Texture makeGlyphTexture(FT_Face const face)
-			{
-				auto texture = be::mem::gl::makeTexture();
-				BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, texture.get(), GL_TEXTURE0);
-				
-				auto const& b = face->glyph->bitmap;
-				glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, b.width, b.rows, 0, GL_RED, GL_UNSIGNED_BYTE, b.buffer);
-
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-				return texture;
-			}
-		}
-
 		Font loadFont(char const* const filePath, FT_UInt const glyphWidth, FT_UInt const glyphHeight)
 		{
+			BE_PROFILE_SCOPE("be::ft::loadFont");
+
 			Font font;
 			std::map<GLubyte, FT_Error> notLoaded;
 
@@ -42,8 +27,11 @@ namespace be
 					throw LoadFontException("set pixel sizes failed", filePath, e);
 				}
 
-				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-				CRESS_MOO_DEFER_EXPRESSION(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+				// the glyphs are packed in rows, a texel apart so linear filtering never reaches a neighbour.
+				int const atlasWidth = 16 * static_cast<int>(std::max(glyphWidth, glyphHeight)) + 2;
+				std::vector<GLubyte> texels;
+				glm::ivec2 cursor = glm::ivec2(1, 1);
+				int rowHeight = 0;
 
 				// load the glyphs
 				for (GLubyte c = 0U; c < 128U; ++c)
@@ -54,16 +42,56 @@ namespace be
 						continue;
 					}
 
-					FontGlyph glyph;
-					glyph.texture = makeGlyphTexture(face.get());
-
 					auto const* p = face->glyph;
+					FontGlyph glyph;
 					glyph.size = glm::ivec2(p->bitmap.width, p->bitmap.rows);
 					glyph.bearing = glm::ivec2(p->bitmap_left, p->bitmap_top);
 					glyph.advance = p->advance.x >> 6;
 
-					font.insert(std::pair<GLchar, FontGlyph>(c, std::move(glyph)));
+					if (glyph.size.x > atlasWidth - 2)
+					{
+						throw LoadFontException("a glyph is wider than the atlas", filePath, 0);
+					}
+					if (cursor.x + glyph.size.x + 1 > atlasWidth)
+					{
+						cursor = glm::ivec2(1, cursor.y + rowHeight + 1);
+						rowHeight = 0;
+					}
+					rowHeight = std::max(rowHeight, glyph.size.y);
+					texels.resize(static_cast<std::size_t>(atlasWidth) * (cursor.y + rowHeight + 1), 0);
+					for (int y = 0; y < glyph.size.y; ++y)
+					{
+						std::copy_n(
+							p->bitmap.buffer + static_cast<std::ptrdiff_t>(y) * p->bitmap.pitch,
+							glyph.size.x,
+							texels.begin() + static_cast<std::ptrdiff_t>(cursor.y + y) * atlasWidth + cursor.x);
+					}
+					glyph.atlasMin = glm::vec2(cursor);
+					glyph.atlasMax = glm::vec2(cursor + glyph.size);
+					cursor.x += glyph.size.x + 1;
+
+					font.glyphs.insert(std::pair<GLchar, FontGlyph>(c, glyph));
+				}
+
+				int const atlasHeight = static_cast<int>(texels.size()) / atlasWidth;
+				for (auto& [c, glyph] : font.glyphs)
+				{
+					glyph.atlasMin /= glm::vec2(atlasWidth, atlasHeight);
+					glyph.atlasMax /= glm::vec2(atlasWidth, atlasHeight);
 				}
+
+				font.atlas = be::mem::gl::makeTexture(be::gpu_memory::Category::Glyph, "font atlas");
+				BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, font.atlas.get(), GL_TEXTURE0);
+
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+				CRESS_MOO_DEFER_EXPRESSION(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+				be::gl::texImage2D(GL_TEXTURE_2D, 0, GL_RED, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+				be::gpu_memory::setTextureLevel(font.atlas.get(), 0, atlasWidth, atlasHeight, GL_RED);
+
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 			}
 
 			// return
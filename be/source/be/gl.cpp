@@ -116,7 +116,7 @@ namespace be
 		void drawBasicMesh(BasicMesh const& mesh)
 		{
 			BE_BIND_VERTEX_ARRAY_SCOPE(mesh.vertexArray.get());
-			glDrawElements(mesh.mode, mesh.count, GL_UNSIGNED_INT, nullptr);
+			be::gl::drawElements(mesh.mode, mesh.count, GL_UNSIGNED_INT, nullptr);
 		}
 
 		BasicMesh makeBasicMesh(
@@ -131,13 +131,15 @@ namespace be
 			auto vertexArray = be::mem::gl::makeVertexArray();
 			BE_BIND_VERTEX_ARRAY_SCOPE(vertexArray.get());
 
-			auto elementBuffer = be::mem::gl::makeBuffer();
+			auto elementBuffer = be::mem::gl::makeBuffer(gpu_memory::Category::Mesh, "basic mesh");
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer.get());
 			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize, indicesData, GL_STATIC_DRAW);
+			gpu_memory::setBufferBytes(elementBuffer.get(), static_cast<std::uint64_t>(indicesSize));
 
-			auto vertexBuffer = be::mem::gl::makeBuffer();
+			auto vertexBuffer = be::mem::gl::makeBuffer(gpu_memory::Category::Mesh, "basic mesh");
 			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.get());
 			glBufferData(GL_ARRAY_BUFFER, verticesSize, verticesData, GL_STATIC_DRAW);
+			gpu_memory::setBufferBytes(vertexBuffer.get(), static_cast<std::uint64_t>(verticesSize));
 
 			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<GLvoid const*>(offsetof(Vertex, position)));
 			glEnableVertexAttribArray(0);
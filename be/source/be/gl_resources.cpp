@@ -0,0 +1,50 @@
+/*
+//	be/gl_resources
+//	A registry of GL resources addressed by generational handles.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include "be/gl_resources.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		namespace
+		{
+			template<class T>
+			GLuint findName(SlotMap<T> const& map, Handle<T> const handle) noexcept
+			{
+				T const* const resource = map.find(handle);
+				return resource ? resource->get() : 0;
+			}
+		}
+
+		MeshHandle ResourceRegistry::add(BasicMesh&& mesh) { return m_meshes.insert(std::move(mesh)); }
+		TextureHandle ResourceRegistry::add(mem::gl::Texture&& texture) { return m_textures.insert(std::move(texture)); }
+		ProgramHandle ResourceRegistry::add(mem::gl::Program&& program) { return m_programs.insert(std::move(program)); }
+		FrameBufferHandle ResourceRegistry::add(mem::gl::FrameBuffer&& frameBuffer) { return m_frameBuffers.insert(std::move(frameBuffer)); }
+
+		void ResourceRegistry::replace(MeshHandle const handle, BasicMesh&& mesh) { m_meshes.replace(handle, std::move(mesh)); }
+		void ResourceRegistry::replace(TextureHandle const handle, mem::gl::Texture&& texture) { m_textures.replace(handle, std::move(texture)); }
+		void ResourceRegistry::replace(ProgramHandle const handle, mem::gl::Program&& program) { m_programs.replace(handle, std::move(program)); }
+		void ResourceRegistry::replace(FrameBufferHandle const handle, mem::gl::FrameBuffer&& frameBuffer) { m_frameBuffers.replace(handle, std::move(frameBuffer)); }
+
+		void ResourceRegistry::remove(MeshHandle const handle) noexcept { m_meshes.erase(handle); }
+		void ResourceRegistry::remove(TextureHandle const handle) noexcept { m_textures.erase(handle); }
+		void ResourceRegistry::remove(ProgramHandle const handle) noexcept { m_programs.erase(handle); }
+		void ResourceRegistry::remove(FrameBufferHandle const handle) noexcept { m_frameBuffers.erase(handle); }
+
+		BasicMesh const& ResourceRegistry::mesh(MeshHandle const handle) const { return m_meshes.at(handle); }
+		GLuint ResourceRegistry::texture(TextureHandle const handle) const { return m_textures.at(handle).get(); }
+		GLuint ResourceRegistry::program(ProgramHandle const handle) const { return m_programs.at(handle).get(); }
+		GLuint ResourceRegistry::frameBuffer(FrameBufferHandle const handle) const { return m_frameBuffers.at(handle).get(); }
+
+		BasicMesh const* ResourceRegistry::findMesh(MeshHandle const handle) const noexcept { return m_meshes.find(handle); }
+		GLuint ResourceRegistry::findTexture(TextureHandle const handle) const noexcept { return findName(m_textures, handle); }
+		GLuint ResourceRegistry::findProgram(ProgramHandle const handle) const noexcept { return findName(m_programs, handle); }
+		GLuint ResourceRegistry::findFrameBuffer(FrameBufferHandle const handle) const noexcept { return findName(m_frameBuffers, handle); }
+	}
+}
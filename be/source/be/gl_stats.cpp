@@ -0,0 +1,336 @@
+/*
+//	be/gl_stats
+//	Counts the OpenGL calls, primitives and upload bytes of each frame, and times them on the GPU, bucketed by pass.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <cstring>
+
+#include "be/gl_stats.hpp"
+
+// X(glewName, PFNNAME, parameters, arguments, counting statement)
+#define BE_GL_STATS_HOOKS(X)\
+	X(UseProgram, USEPROGRAM, (GLuint program), (program), count(&FrameStats::programBinds))\
+	X(BindVertexArray, BINDVERTEXARRAY, (GLuint array), (array), count(&FrameStats::vertexArrayBinds))\
+	X(BindFramebuffer, BINDFRAMEBUFFER, (GLenum target, GLuint framebuffer), (target, framebuffer), count(&FrameStats::frameBufferBinds))\
+	X(BufferData, BUFFERDATA, (GLenum target, GLsizeiptr size, void const* data, GLenum usage), (target, size, data, usage), if (data) { count(&FrameStats::bufferUploadBytes, static_cast<std::uint64_t>(size)); })\
+	X(BufferSubData, BUFFERSUBDATA, (GLenum target, GLintptr offset, GLsizeiptr size, void const* data), (target, offset, size, data), count(&FrameStats::bufferUploadBytes, static_cast<std::uint64_t>(size)))\
+	X(DrawArraysInstanced, DRAWARRAYSINSTANCED, (GLenum mode, GLint first, GLsizei n, GLsizei instances), (mode, first, n, instances), countDraw(mode, n, instances))\
+	X(DrawElementsInstanced, DRAWELEMENTSINSTANCED, (GLenum mode, GLsizei n, GLenum type, void const* indices, GLsizei instances), (mode, n, type, indices, instances), countDraw(mode, n, instances))\
+	X(DrawElementsBaseVertex, DRAWELEMENTSBASEVERTEX, (GLenum mode, GLsizei n, GLenum type, void* indices, GLint baseVertex), (mode, n, type, indices, baseVertex), countDraw(mode, n))\
+	X(Uniform1i, UNIFORM1I, (GLint l, GLint v0), (l, v0), count(&FrameStats::uniformCalls))\
+	X(Uniform1f, UNIFORM1F, (GLint l, GLfloat v0), (l, v0), count(&FrameStats::uniformCalls))\
+	X(Uniform2f, UNIFORM2F, (GLint l, GLfloat v0, GLfloat v1), (l, v0, v1), count(&FrameStats::uniformCalls))\
+	X(Uniform3f, UNIFORM3F, (GLint l, GLfloat v0, GLfloat v1, GLfloat v2), (l, v0, v1, v2), count(&FrameStats::uniformCalls))\
+	X(Uniform4f, UNIFORM4F, (GLint l, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (l, v0, v1, v2, v3), count(&FrameStats::uniformCalls))\
+	X(Uniform1iv, UNIFORM1IV, (GLint l, GLsizei n, GLint const* v), (l, n, v), count(&FrameStats::uniformCalls))\
+	X(Uniform1fv, UNIFORM1FV, (GLint l, GLsizei n, GLfloat const* v), (l, n, v), count(&FrameStats::uniformCalls))\
+	X(Uniform2fv, UNIFORM2FV, (GLint l, GLsizei n, GLfloat const* v), (l, n, v), count(&FrameStats::uniformCalls))\
+	X(Uniform3fv, UNIFORM3FV, (GLint l, GLsizei n, GLfloat const* v), (l, n, v), count(&FrameStats::uniformCalls))\
+	X(Uniform4fv, UNIFORM4FV, (GLint l, GLsizei n, GLfloat const* v), (l, n, v), count(&FrameStats::uniformCalls))\
+	X(UniformMatrix2fv, UNIFORMMATRIX2FV, (GLint l, GLsizei n, GLboolean t, GLfloat const* v), (l, n, t, v), count(&FrameStats::uniformCalls))\
+	X(UniformMatrix3fv, UNIFORMMATRIX3FV, (GLint l, GLsizei n, GLboolean t, GLfloat const* v), (l, n, t, v), count(&FrameStats::uniformCalls))\
+	X(UniformMatrix4fv, UNIFORMMATRIX4FV, (GLint l, GLsizei n, GLboolean t, GLfloat const* v), (l, n, t, v), count(&FrameStats::uniformCalls))
+
+#define BE_GL_STATS_DEFINE_HOOK(name, NAME, parameters, arguments, counting)\
+	static PFNGL##NAME##PROC s_##name = nullptr;\
+	static void GLAPIENTRY count##name parameters\
+	{\
+		counting;\
+		s_##name arguments;\
+	}
+
+#define BE_GL_STATS_INSTALL_HOOK(name, NAME, parameters, arguments, counting)\
+	s_##name = __glew##name;\
+	if (s_##name) { __glew##name = count##name; }
+
+#define BE_GL_STATS_REMOVE_HOOK(name, NAME, parameters, arguments, counting)\
+	if (s_##name) { __glew##name = s_##name; }\
+	s_##name = nullptr;
+
+namespace be
+{
+	namespace gl
+	{
+		namespace detail
+		{
+			BE_GL_STATS_HOOKS(BE_GL_STATS_DEFINE_HOOK)
+
+			static std::uint64_t primitiveCount(GLenum mode, GLsizei n) noexcept
+			{
+				if (n <= 0) { return 0; }
+				auto const v = static_cast<std::uint64_t>(n);
+				switch (mode)
+				{
+				case GL_POINTS: return v;
+				case GL_LINES: return v / 2;
+				case GL_LINE_STRIP: return v - 1;
+				case GL_LINE_LOOP: return v;
+				case GL_TRIANGLES: return v / 3;
+				case GL_TRIANGLE_STRIP:
+				case GL_TRIANGLE_FAN: return v >= 3 ? v - 2 : 0;
+				case GL_QUADS: return v / 4;
+				default: return 0;
+				}
+			}
+
+			static std::uint64_t bytesPerPixel(GLenum format, GLenum type) noexcept
+			{
+				std::uint64_t components = 4;
+				switch (format)
+				{
+				case GL_RED:
+				case GL_DEPTH_COMPONENT:
+				case GL_STENCIL_INDEX:
+				case GL_ALPHA:
+				case GL_LUMINANCE:
+					components = 1;
+					break;
+				case GL_RG:
+				case GL_LUMINANCE_ALPHA:
+				case GL_DEPTH_STENCIL:
+					components = 2;
+					break;
+				case GL_RGB:
+				case GL_BGR:
+					components = 3;
+					break;
+				default:
+					break;
+				}
+
+				switch (type)
+				{
+				case GL_UNSIGNED_BYTE:
+				case GL_BYTE:
+					return components;
+				case GL_UNSIGNED_SHORT:
+				case GL_SHORT:
+				case GL_HALF_FLOAT:
+					return components * 2;
+				case GL_UNSIGNED_INT_24_8:
+					return 4;
+				default:
+					return components * 4;
+				}
+			}
+
+			void countDraw(GLenum mode, GLsizei n, GLsizei instances) noexcept
+			{
+				count(&FrameStats::drawCalls);
+				count(&FrameStats::primitives, primitiveCount(mode, n) * static_cast<std::uint64_t>(instances > 0 ? instances : 0));
+			}
+
+			void countTextureUpload(GLsizei width, GLsizei height, GLenum format, GLenum type, void const* pixels) noexcept
+			{
+				// without pixel data the call only allocates storage.
+				if (!pixels || width <= 0 || height <= 0) { return; }
+				count(&FrameStats::textureUploadBytes,
+					static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height) * bytesPerPixel(format, type));
+			}
+
+			struct PendingTimer
+			{
+				GLuint begin{};
+				GLuint end{};
+				std::ptrdiff_t pass{};
+				bool outermost{};
+			};
+
+			static bool s_gpuTimingEnabled = false;
+			static std::vector<GLuint> s_freeQueries;
+			static std::vector<PendingTimer> s_pendingTimers; // in the order they were ended, which is the order they complete
+			static std::size_t s_openTimers = 0;
+
+			static GLuint acquireQuery() noexcept
+			{
+				GLuint query = 0;
+				if (s_freeQueries.empty())
+				{
+					glGenQueries(1, &query);
+				}
+				else
+				{
+					query = s_freeQueries.back();
+					s_freeQueries.pop_back();
+				}
+				return query;
+			}
+
+			static void releaseQuery(GLuint query) noexcept
+			{
+				try
+				{
+					s_freeQueries.push_back(query);
+				}
+				catch (...) { glDeleteQueries(1, &query); }
+			}
+
+			static void resolveTimers() noexcept
+			{
+				std::size_t resolved = 0;
+				for (; resolved < s_pendingTimers.size(); ++resolved)
+				{
+					auto const& timer = s_pendingTimers[resolved];
+					GLint available = GL_FALSE;
+					glGetQueryObjectiv(timer.end, GL_QUERY_RESULT_AVAILABLE, &available);
+					if (!available) { break; }
+
+					GLuint64 begin = 0, end = 0;
+					glGetQueryObjectui64v(timer.begin, GL_QUERY_RESULT, &begin);
+					glGetQueryObjectui64v(timer.end, GL_QUERY_RESULT, &end);
+					std::uint64_t const nanoseconds = end > begin ? end - begin : 0;
+					s_passStats[timer.pass].stats.gpuNanoseconds += nanoseconds;
+					if (timer.outermost) { s_frameStats.gpuNanoseconds += nanoseconds; }
+
+					releaseQuery(timer.begin);
+					releaseQuery(timer.end);
+				}
+				s_pendingTimers.erase(s_pendingTimers.begin(), s_pendingTimers.begin() + static_cast<std::ptrdiff_t>(resolved));
+			}
+
+			static std::ptrdiff_t findPass(char const* name) noexcept
+			{
+				for (std::size_t i = 0; i < s_passStats.size(); ++i)
+				{
+					auto const* const other = s_passStats[i].name;
+					if (other == name || 0 == std::strcmp(other, name)) { return static_cast<std::ptrdiff_t>(i); }
+				}
+				return -1;
+			}
+		}
+
+		void setStatsEnabled(bool enabled) noexcept
+		{
+			using namespace detail;
+
+			if (enabled == s_statsEnabled) { return; }
+			s_statsEnabled = enabled;
+
+			if (enabled)
+			{
+				BE_GL_STATS_HOOKS(BE_GL_STATS_INSTALL_HOOK)
+			}
+			else
+			{
+				BE_GL_STATS_HOOKS(BE_GL_STATS_REMOVE_HOOK)
+			}
+		}
+
+		bool setGpuTimingEnabled(bool enabled) noexcept
+		{
+			using namespace detail;
+
+			if (enabled == s_gpuTimingEnabled) { return true; }
+			if (enabled)
+			{
+				if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query) { return false; }
+				s_gpuTimingEnabled = true;
+				return true;
+			}
+
+			s_gpuTimingEnabled = false;
+			for (auto const& timer : s_pendingTimers)
+			{
+				glDeleteQueries(1, &timer.begin);
+				glDeleteQueries(1, &timer.end);
+			}
+			s_pendingTimers.clear();
+			if (!s_freeQueries.empty())
+			{
+				glDeleteQueries(static_cast<GLsizei>(s_freeQueries.size()), s_freeQueries.data());
+				s_freeQueries.clear();
+			}
+			return true;
+		}
+
+		bool isGpuTimingEnabled() noexcept
+		{
+			return detail::s_gpuTimingEnabled;
+		}
+
+		FrameStats getPassStats(std::string_view name) noexcept
+		{
+			for (auto const& pass : detail::s_passStats)
+			{
+				if (name == pass.name) { return pass.stats; }
+			}
+			return {};
+		}
+
+		void resetFrameStats() noexcept
+		{
+			detail::s_frameStats = {};
+			// keep the entries so a steady frame does not allocate; zero them instead.
+			for (auto& pass : detail::s_passStats) { pass.stats = {}; }
+			if (detail::s_gpuTimingEnabled) { detail::resolveTimers(); }
+		}
+
+		PassScope::PassScope(char const* name) noexcept
+		{
+			if (!detail::s_statsEnabled) { return; }
+
+			auto index = detail::findPass(name);
+			if (index < 0)
+			{
+				try
+				{
+					detail::s_passStats.push_back(PassStats{ name });
+				}
+				catch (...) { return; }
+				index = static_cast<std::ptrdiff_t>(detail::s_passStats.size()) - 1;
+			}
+
+			m_previous = detail::s_currentPass;
+			m_active = true;
+			detail::s_currentPass = index;
+
+			if (detail::s_gpuTimingEnabled)
+			{
+				m_beginQuery = detail::acquireQuery();
+				if (m_beginQuery)
+				{
+					glQueryCounter(m_beginQuery, GL_TIMESTAMP);
+					++detail::s_openTimers;
+				}
+			}
+		}
+
+		PassScope::~PassScope() noexcept
+		{
+			using namespace detail;
+
+			if (!m_active) { return; }
+			auto const pass = s_currentPass;
+			s_currentPass = m_previous;
+
+			if (!m_beginQuery) { return; }
+			--s_openTimers;
+			if (!s_gpuTimingEnabled)
+			{
+				// disabled while this pass was open.
+				glDeleteQueries(1, &m_beginQuery);
+				return;
+			}
+
+			GLuint const endQuery = acquireQuery();
+			if (!endQuery)
+			{
+				releaseQuery(m_beginQuery);
+				return;
+			}
+			glQueryCounter(endQuery, GL_TIMESTAMP);
+			try
+			{
+				s_pendingTimers.push_back(PendingTimer{ m_beginQuery, endQuery, pass, s_openTimers == 0 });
+			}
+			catch (...)
+			{
+				releaseQuery(m_beginQuery);
+				releaseQuery(endQuery);
+			}
+		}
+	}
+}
@@ -0,0 +1,316 @@
+/*
+//	be/gpu_memory
+//	Accounts for the GPU memory held by GL objects, by category and debug label.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "be/application.hpp"
+#include "be/gl_stats.hpp"
+#include "be/gpu_memory.hpp"
+
+namespace be
+{
+	namespace gpu_memory
+	{
+		namespace
+		{
+			constexpr std::size_t maxTextureLevels = 16;
+
+			struct Record
+			{
+				Category category{};
+				char const* label{};
+				std::uint64_t bytes{};
+				std::array<std::uint64_t, maxTextureLevels> levelBytes{}; // textures only
+			};
+
+			struct State
+			{
+				std::unordered_map<std::uint64_t, Record> records;
+				Totals totals;
+				bool warnedUnknownFormat = false; // bytesPerTexel warns only once
+			};
+
+			// never destroyed, so that GL objects in other static storage can untrack at exit.
+			State& state() noexcept
+			{
+				static State* const s = new State();
+				return *s;
+			}
+
+			std::uint64_t makeKey(ObjectKind const kind, GLuint const name) noexcept
+			{
+				return (static_cast<std::uint64_t>(kind) << 32) | name;
+			}
+
+			Record* find(ObjectKind const kind, GLuint const name) noexcept
+			{
+				auto const it = state().records.find(makeKey(kind, name));
+				return it == state().records.end() ? nullptr : &it->second;
+			}
+
+			CategoryTotals& totalsOf(Category const category) noexcept
+			{
+				return state().totals.categories[static_cast<std::size_t>(category)];
+			}
+
+			void resize(Record& record, std::uint64_t const bytes) noexcept
+			{
+				auto& totals = state().totals;
+				auto& category = totalsOf(record.category);
+				if (bytes > record.bytes)
+				{
+					std::uint64_t const grown = bytes - record.bytes;
+					totals.bytes += grown;
+					totals.frameAllocatedBytes += grown;
+					category.bytes += grown;
+					totals.peakBytes = std::max(totals.peakBytes, totals.bytes);
+				}
+				else
+				{
+					std::uint64_t const shrunk = record.bytes - bytes;
+					totals.bytes -= shrunk;
+					totals.frameReleasedBytes += shrunk;
+					category.bytes -= shrunk;
+				}
+				record.bytes = bytes;
+			}
+
+			void setLevelBytes(Record& record, GLint const level, std::uint64_t const bytes) noexcept
+			{
+				auto& levelBytes = record.levelBytes[static_cast<std::size_t>(level)];
+				resize(record, record.bytes - levelBytes + bytes);
+				levelBytes = bytes;
+			}
+
+			// three channel formats are counted as four, as drivers pad them.
+			std::uint64_t bytesPerTexel(GLenum const internalFormat) noexcept
+			{
+				switch (internalFormat)
+				{
+				case GL_RED:
+				case GL_R8:
+				case GL_R8UI:
+				case GL_ALPHA:
+				case GL_LUMINANCE:
+					return 1;
+				case GL_RG:
+				case GL_RG8:
+				case GL_R16:
+				case GL_R16F:
+				case GL_R16UI:
+				case GL_DEPTH_COMPONENT16:
+					return 2;
+				case GL_RGB:
+				case GL_RGB8:
+				case GL_SRGB8:
+				case GL_RGBA:
+				case GL_RGBA8:
+				case GL_SRGB8_ALPHA8:
+				case GL_RGB10_A2:
+				case GL_R11F_G11F_B10F:
+				case GL_RG16:
+				case GL_RG16F:
+				case GL_R32F:
+				case GL_R32I:
+				case GL_R32UI:
+				case GL_DEPTH_COMPONENT:
+				case GL_DEPTH_COMPONENT24:
+				case GL_DEPTH_COMPONENT32:
+				case GL_DEPTH_COMPONENT32F:
+				case GL_DEPTH_STENCIL:
+				case GL_DEPTH24_STENCIL8:
+					return 4;
+				case GL_RGB16:
+				case GL_RGB16F:
+				case GL_RGBA16:
+				case GL_RGBA16F:
+				case GL_RG32F:
+				case GL_DEPTH32F_STENCIL8:
+					return 8;
+				case GL_RGB32F:
+				case GL_RGBA32F:
+					return 16;
+				default:
+					if (!state().warnedUnknownFormat)
+					{
+						state().warnedUnknownFormat = true;
+						be::Application::logf(LogLevel::Warning,
+							"[be] gpu_memory: internal format 0x%04X has no known size, so its textures are counted at 4 bytes a texel",
+							static_cast<unsigned>(internalFormat));
+					}
+					return 4;
+				}
+			}
+		}
+
+		char const* toString(Category const category) noexcept
+		{
+			switch (category)
+			{
+			case Category::Mesh: return "meshes";
+			case Category::Texture: return "textures";
+			case Category::RenderTarget: return "render targets";
+			case Category::Streaming: return "streaming";
+			case Category::Glyph: return "glyphs";
+			default: return "other";
+			}
+		}
+
+		void track(ObjectKind const kind, GLuint const name, Category const category, char const* const label)
+		{
+			if (!name) { return; }
+			auto const [it, inserted] = state().records.try_emplace(makeKey(kind, name));
+			auto& record = it->second;
+			if (!inserted)
+			{
+				// move the bytes to the new category.
+				auto& previous = totalsOf(record.category);
+				previous.bytes -= record.bytes;
+				--previous.objects;
+			}
+			else
+			{
+				++state().totals.objects;
+			}
+			record.category = category;
+			record.label = label;
+			auto& totals = totalsOf(category);
+			totals.bytes += record.bytes;
+			++totals.objects;
+		}
+
+		void untrack(ObjectKind const kind, GLuint const name) noexcept
+		{
+			auto& records = state().records;
+			auto const it = records.find(makeKey(kind, name));
+			if (it == records.end()) { return; }
+			resize(it->second, 0);
+			--totalsOf(it->second.category).objects;
+			--state().totals.objects;
+			records.erase(it);
+		}
+
+		void setBufferBytes(GLuint const buffer, std::uint64_t const bytes) noexcept
+		{
+			if (auto* const record = find(ObjectKind::Buffer, buffer))
+			{
+				resize(*record, bytes);
+			}
+		}
+
+		void setTextureLevel(
+			GLuint const texture, GLint const level,
+			GLsizei const width, GLsizei const height, GLenum const internalFormat) noexcept
+		{
+			auto* const record = find(ObjectKind::Texture, texture);
+			if (!record || level < 0 || static_cast<std::size_t>(level) >= maxTextureLevels) { return; }
+
+			std::uint64_t const bytes = width > 0 && height > 0
+				? static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height) * bytesPerTexel(internalFormat)
+				: 0;
+			setLevelBytes(*record, level, bytes);
+		}
+
+		void measureTexture(GLuint const texture, GLenum const target) noexcept
+		{
+			auto* const record = find(ObjectKind::Texture, texture);
+			if (!record) { return; }
+
+			bool const cubemap = GL_TEXTURE_CUBE_MAP == target;
+			GLenum const face = cubemap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : target;
+			std::uint64_t const faces = cubemap ? 6 : 1;
+
+			glActiveTexture(GL_TEXTURE0);
+			be::gl::bindTexture(target, texture);
+			for (GLint level = 0; level < static_cast<GLint>(maxTextureLevels); ++level)
+			{
+				GLint width = 0, height = 0, internalFormat = 0;
+				glGetTexLevelParameteriv(face, level, GL_TEXTURE_WIDTH, &width);
+				glGetTexLevelParameteriv(face, level, GL_TEXTURE_HEIGHT, &height);
+				if (width <= 0) { break; } // past the end of the mip chain
+				glGetTexLevelParameteriv(face, level, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+				std::uint64_t const bytes = width > 0 && height > 0
+					? faces * static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height)
+						* bytesPerTexel(static_cast<GLenum>(internalFormat))
+					: 0;
+				setLevelBytes(*record, level, bytes);
+			}
+		}
+
+		void beginFrame() noexcept
+		{
+			state().totals.frameAllocatedBytes = 0;
+			state().totals.frameReleasedBytes = 0;
+		}
+
+		Totals getTotals() noexcept
+		{
+			return state().totals;
+		}
+
+		std::vector<LabelTotals> getLabelTotals()
+		{
+			std::vector<LabelTotals> labels;
+			for (auto const& [key, record] : state().records)
+			{
+				auto const it = std::find_if(labels.begin(), labels.end(), [&](LabelTotals const& l)
+					{
+						return l.category == record.category
+							&& (l.label == record.label || (l.label && record.label && 0 == std::strcmp(l.label, record.label)));
+					});
+				if (it == labels.end())
+				{
+					labels.push_back(LabelTotals{ record.label, record.category, record.bytes, 1 });
+				}
+				else
+				{
+					it->bytes += record.bytes;
+					++it->objects;
+				}
+			}
+			std::sort(labels.begin(), labels.end(), [](LabelTotals const& a, LabelTotals const& b) { return a.bytes > b.bytes; });
+			return labels;
+		}
+
+		std::vector<LiveObject> getLiveObjects()
+		{
+			std::vector<LiveObject> objects;
+			objects.reserve(state().records.size());
+			for (auto const& [key, record] : state().records)
+			{
+				objects.push_back(LiveObject{
+					static_cast<ObjectKind>(key >> 32),
+					static_cast<GLuint>(key & 0xffffffffu),
+					record.category,
+					record.label,
+					record.bytes,
+					});
+			}
+			return objects;
+		}
+
+		void logLiveObjects() noexcept
+		{
+			if (state().records.empty()) { return; }
+			try
+			{
+				be::Application::logf(LogLevel::Warning, "[be] %llu GL objects holding %llu bytes were not deleted:",
+					static_cast<unsigned long long>(state().totals.objects), static_cast<unsigned long long>(state().totals.bytes));
+				for (auto const& label : getLabelTotals())
+				{
+					be::Application::logf(LogLevel::Warning, "[be]   %s (%s): %llu objects, %llu bytes",
+						label.label ? label.label : "unlabelled", toString(label.category),
+						static_cast<unsigned long long>(label.objects), static_cast<unsigned long long>(label.bytes));
+				}
+			}
+			catch (...) {}
+		}
+	}
+}
@@ -0,0 +1,194 @@
+/*
+//	be/headless
+//	Offscreen OpenGL context for running without a display.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <cstring>
+#include <memory>
+#include <glew/glew.h>
+#include <freeglut/freeglut.h>
+
+#ifndef _WIN32
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "be/headless.hpp"
+
+namespace be
+{
+	namespace headless
+	{
+#ifdef _WIN32
+
+		struct Context::Impl
+		{
+			int width{};
+			int height{};
+			int window{};
+		};
+
+		Context::Context(int width, int height)
+			: m_impl(nullptr)
+		{
+			auto impl = std::make_unique<Impl>();
+			impl->width = width;
+			impl->height = height;
+
+			int argc = 1;
+			char name[] = "be-headless";
+			char* argv[] = { name, nullptr };
+			glutInit(&argc, argv);
+			glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH | GLUT_STENCIL);
+			glutInitWindowSize(width, height);
+			glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+			impl->window = glutCreateWindow(name);
+			if (impl->window <= 0)
+			{
+				throw HeadlessContextException("glutCreateWindow failed");
+			}
+			glutHideWindow();
+
+			m_impl = impl.release();
+		}
+
+		Context::~Context() noexcept
+		{
+			if (m_impl->window > 0) { glutDestroyWindow(m_impl->window); }
+			delete m_impl;
+		}
+
+		void Context::finishFrame() noexcept
+		{
+			glFinish();
+		}
+
+#else
+
+		struct Context::Impl
+		{
+			int width{};
+			int height{};
+			EGLDisplay display = EGL_NO_DISPLAY;
+			EGLSurface surface = EGL_NO_SURFACE;
+			EGLContext context = EGL_NO_CONTEXT;
+
+			~Impl() noexcept
+			{
+				if (display == EGL_NO_DISPLAY) { return; }
+				eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+				if (context != EGL_NO_CONTEXT) { eglDestroyContext(display, context); }
+				if (surface != EGL_NO_SURFACE) { eglDestroySurface(display, surface); }
+				eglTerminate(display);
+			}
+		};
+
+		static EGLDisplay getDisplay() noexcept
+		{
+			char const* const extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+			if (extensions && std::strstr(extensions, "EGL_MESA_platform_surfaceless"))
+			{
+				auto const getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+					eglGetProcAddress("eglGetPlatformDisplayEXT"));
+				if (getPlatformDisplay)
+				{
+					EGLDisplay const display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+					if (display != EGL_NO_DISPLAY) { return display; }
+				}
+			}
+			return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		}
+
+		Context::Context(int width, int height)
+			: m_impl(nullptr)
+		{
+			auto impl = std::make_unique<Impl>();
+			impl->width = width;
+			impl->height = height;
+
+			impl->display = getDisplay();
+			if (impl->display == EGL_NO_DISPLAY)
+			{
+				throw HeadlessContextException("no EGL display");
+			}
+			if (!eglInitialize(impl->display, nullptr, nullptr))
+			{
+				impl->display = EGL_NO_DISPLAY;
+				throw HeadlessContextException("eglInitialize failed");
+			}
+
+			EGLint const configAttribs[] = {
+				EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+				EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+				EGL_RED_SIZE, 8,
+				EGL_GREEN_SIZE, 8,
+				EGL_BLUE_SIZE, 8,
+				EGL_ALPHA_SIZE, 8,
+				EGL_DEPTH_SIZE, 24,
+				EGL_STENCIL_SIZE, 8,
+				EGL_NONE
+			};
+			EGLConfig config{};
+			EGLint numConfigs = 0;
+			if (!eglChooseConfig(impl->display, configAttribs, &config, 1, &numConfigs) || numConfigs < 1)
+			{
+				throw HeadlessContextException("no EGL config with pbuffer and desktop OpenGL support");
+			}
+
+			EGLint const surfaceAttribs[] = {
+				EGL_WIDTH, width,
+				EGL_HEIGHT, height,
+				EGL_NONE
+			};
+			impl->surface = eglCreatePbufferSurface(impl->display, config, surfaceAttribs);
+			if (impl->surface == EGL_NO_SURFACE)
+			{
+				throw HeadlessContextException("eglCreatePbufferSurface failed");
+			}
+
+			if (!eglBindAPI(EGL_OPENGL_API))
+			{
+				throw HeadlessContextException("eglBindAPI(EGL_OPENGL_API) failed");
+			}
+
+			// the renderers use legacy features (e.g. GL_QUADS), so ask for a compatibility profile.
+			EGLint const contextAttribs[] = {
+				EGL_CONTEXT_MAJOR_VERSION, 3,
+				EGL_CONTEXT_MINOR_VERSION, 3,
+				EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+				EGL_NONE
+			};
+			impl->context = eglCreateContext(impl->display, config, EGL_NO_CONTEXT, contextAttribs);
+			if (impl->context == EGL_NO_CONTEXT)
+			{
+				throw HeadlessContextException("eglCreateContext failed");
+			}
+
+			if (!eglMakeCurrent(impl->display, impl->surface, impl->surface, impl->context))
+			{
+				throw HeadlessContextException("eglMakeCurrent failed");
+			}
+
+			m_impl = impl.release();
+		}
+
+		Context::~Context() noexcept
+		{
+			delete m_impl;
+		}
+
+		void Context::finishFrame() noexcept
+		{
+			glFinish();
+			eglSwapBuffers(m_impl->display, m_impl->surface);
+		}
+
+#endif
+
+		int Context::width() const noexcept { return m_impl->width; }
+		int Context::height() const noexcept { return m_impl->height; }
+	}
+}
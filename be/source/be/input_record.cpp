@@ -0,0 +1,217 @@
+/*
+//	be/input_record
+//	Records the input a Game receives, keyed by update step, and replays it deterministically.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "be/input_record.hpp"
+
+namespace be
+{
+	namespace input_record
+	{
+		static constexpr char magic[4] = { 'B', 'E', 'I', 'R' };
+		static constexpr std::uint32_t version = 1;
+		static constexpr std::uint8_t typeCount = 15;
+
+		static int argumentCount(EventType const type) noexcept
+		{
+			switch (type)
+			{
+			case EventType::WindowSize:
+			case EventType::WindowPosition:
+			case EventType::MousePosition:
+				return 2;
+			case EventType::MouseMoveWhileAnyDown:
+			case EventType::MouseMoveWhileAllUp:
+			case EventType::MouseEnteredWindow:
+			case EventType::MouseLeftWindow:
+				return 0;
+			default:
+				return 1;
+			}
+		}
+
+		static void putFixed(std::vector<std::uint8_t>& out, std::uint64_t value, int bytes)
+		{
+			for (int i = 0; i < bytes; ++i)
+			{
+				out.push_back(static_cast<std::uint8_t>(value & 0xFF));
+				value >>= 8;
+			}
+		}
+
+		static void putVarint(std::vector<std::uint8_t>& out, std::uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				out.push_back(static_cast<std::uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+			out.push_back(static_cast<std::uint8_t>(value));
+		}
+
+		static std::uint64_t zigzag(std::int32_t const value) noexcept
+		{
+			return static_cast<std::uint32_t>((value << 1) ^ (value >> 31));
+		}
+
+		static std::int32_t unzigzag(std::uint64_t const value) noexcept
+		{
+			auto const v = static_cast<std::uint32_t>(value);
+			return static_cast<std::int32_t>((v >> 1) ^ (~(v & 1) + 1));
+		}
+
+		class Reader
+		{
+		private:
+			std::vector<std::uint8_t> const& m_data;
+			std::size_t m_position = 0;
+
+		public:
+			explicit Reader(std::vector<std::uint8_t> const& data) : m_data(data) {}
+
+			std::uint8_t byte()
+			{
+				if (m_position >= m_data.size()) { throw InputRecordException("unexpected end of file"); }
+				return m_data[m_position++];
+			}
+
+			std::uint64_t fixed(int const bytes)
+			{
+				std::uint64_t value = 0;
+				for (int i = 0; i < bytes; ++i)
+				{
+					value |= static_cast<std::uint64_t>(byte()) << (8 * i);
+				}
+				return value;
+			}
+
+			std::uint64_t varint()
+			{
+				std::uint64_t value = 0;
+				for (int shift = 0; shift < 64; shift += 7)
+				{
+					std::uint8_t const b = byte();
+					value |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+					if (!(b & 0x80)) { return value; }
+				}
+				throw InputRecordException("malformed varint");
+			}
+		};
+
+		void writeLog(std::string const& path, Log const& log)
+		{
+			std::vector<std::uint8_t> out;
+			out.reserve(32 + log.events.size() * 4);
+
+			out.insert(out.end(), std::begin(magic), std::end(magic));
+			putFixed(out, version, 4);
+			putFixed(out, std::bit_cast<std::uint64_t>(log.fixedTimestep), 8);
+			putFixed(out, log.endStep, 8);
+			putFixed(out, log.events.size(), 8);
+
+			std::uint64_t step = 0;
+			for (auto const& event : log.events)
+			{
+				if (event.step < step) { throw InputRecordException("events are not in step order"); }
+				putVarint(out, event.step - step);
+				step = event.step;
+
+				out.push_back(static_cast<std::uint8_t>(event.type));
+				int const count = argumentCount(event.type);
+				if (count > 0) { putVarint(out, zigzag(event.a)); }
+				if (count > 1) { putVarint(out, zigzag(event.b)); }
+			}
+
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<char const*>(out.data()), static_cast<std::streamsize>(out.size()));
+			if (!file)
+			{
+				throw InputRecordException("failed to write " + path);
+			}
+		}
+
+		Log readLog(std::string const& path)
+		{
+			std::ifstream file(path, std::ios::binary);
+			if (!file)
+			{
+				throw InputRecordException("failed to open " + path);
+			}
+			std::vector<std::uint8_t> const data{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+			Reader reader{ data };
+			char header[4];
+			for (auto& c : header) { c = static_cast<char>(reader.byte()); }
+			if (0 != std::memcmp(header, magic, sizeof(magic)))
+			{
+				throw InputRecordException(path + " is not an input record");
+			}
+			if (reader.fixed(4) != version)
+			{
+				throw InputRecordException(path + " has an unsupported version");
+			}
+
+			Log log;
+			log.fixedTimestep = std::bit_cast<double>(reader.fixed(8));
+			log.endStep = reader.fixed(8);
+			std::uint64_t const count = reader.fixed(8);
+			if (!(log.fixedTimestep > 0.0) || count > data.size())
+			{
+				throw InputRecordException(path + " has a corrupt header");
+			}
+
+			log.events.reserve(static_cast<std::size_t>(count));
+			std::uint64_t step = 0;
+			for (std::uint64_t i = 0; i < count; ++i)
+			{
+				Event event;
+				step += reader.varint();
+				event.step = step;
+
+				std::uint8_t const type = reader.byte();
+				if (type >= typeCount)
+				{
+					throw InputRecordException(path + " has an unknown event type");
+				}
+				event.type = static_cast<EventType>(type);
+				int const arguments = argumentCount(event.type);
+				if (arguments > 0) { event.a = unzigzag(reader.varint()); }
+				if (arguments > 1) { event.b = unzigzag(reader.varint()); }
+
+				log.events.push_back(event);
+			}
+			return log;
+		}
+
+		void dispatch(Game& game, Event const& event)
+		{
+			switch (event.type)
+			{
+			case EventType::WindowSize: game.onWindowSizeChanged(event.a, event.b); break;
+			case EventType::WindowPosition: game.onWindowPositionChanged(event.a, event.b); break;
+			case EventType::MousePosition: game.onMousePositionInWindowChanged(event.a, event.b); break;
+			case EventType::KeyDown: game.onKeyGoingDown(static_cast<unsigned char>(event.a)); break;
+			case EventType::KeyUp: game.onKeyGoingUp(static_cast<unsigned char>(event.a)); break;
+			case EventType::SpecialDown: game.onSpecialGoingDown(event.a); break;
+			case EventType::SpecialUp: game.onSpecialGoingUp(event.a); break;
+			case EventType::MouseButtonDown: game.onMouseButtonGoingDown(event.a); break;
+			case EventType::MouseButtonUp: game.onMouseButtonGoingUp(event.a); break;
+			case EventType::MouseWheelPositive: game.onMouseWheelPositive(event.a); break;
+			case EventType::MouseWheelNegative: game.onMouseWheelNegative(event.a); break;
+			case EventType::MouseMoveWhileAnyDown: game.onMouseMoveWhileAnyDown(); break;
+			case EventType::MouseMoveWhileAllUp: game.onMouseMoveWhileAllUp(); break;
+			case EventType::MouseEnteredWindow: game.onMouseEnteredWindow(); break;
+			case EventType::MouseLeftWindow: game.onMouseLeftWindow(); break;
+			}
+		}
+	}
+}
@@ -0,0 +1,359 @@
+/*
+//	be/jobs
+//	Fixed pool of worker threads with work-stealing deques, parallel loops and a main thread queue.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "be/application.hpp"
+#include "be/jobs.hpp"
+#include "be/profile.hpp"
+
+namespace be
+{
+	namespace jobs
+	{
+		namespace detail
+		{
+			constexpr std::size_t queueCapacity = 4096; // power of two
+			constexpr std::int64_t queueMask = static_cast<std::int64_t>(queueCapacity) - 1;
+
+			/*
+			//	Where a queued job lives until whoever takes it has copied it out.
+			//	|queued| is set by the owner when it fills the slot and cleared, with release, after the copy,
+			//	so the owner never overwrites a job that a stalled thief is still reading.
+			*/
+			struct Slot
+			{
+				Job job{};
+				std::atomic<bool> queued{ false };
+			};
+
+			/*
+			//	Chase-Lev work-stealing deque of fixed capacity
+			//	("Correct and Efficient Work-Stealing for Weak Memory Models", Le et al. 2013).
+			//	The owner pushes and pops at the bottom; other threads steal from the top.
+			*/
+			class Deque
+			{
+			private:
+				alignas(64) std::atomic<std::int64_t> m_top{ 0 };
+				alignas(64) std::atomic<std::int64_t> m_bottom{ 0 };
+				std::array<std::atomic<Slot*>, queueCapacity> m_buffer{};
+
+			public:
+				// owner only. False when full.
+				bool push(Slot* const job) noexcept
+				{
+					std::int64_t const b = m_bottom.load(std::memory_order_relaxed);
+					std::int64_t const t = m_top.load(std::memory_order_acquire);
+					if (b - t >= static_cast<std::int64_t>(queueCapacity)) { return false; }
+
+					// release on the slot as well as the fence publishes the job's contents to the thief
+					// in a way thread sanitizers can follow; it costs nothing extra on x86.
+					m_buffer[b & queueMask].store(job, std::memory_order_release);
+					std::atomic_thread_fence(std::memory_order_release);
+					m_bottom.store(b + 1, std::memory_order_relaxed);
+					return true;
+				}
+
+				// owner only.
+				Slot* pop() noexcept
+				{
+					std::int64_t const b = m_bottom.load(std::memory_order_relaxed) - 1;
+					m_bottom.store(b, std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+					std::int64_t t = m_top.load(std::memory_order_relaxed);
+
+					if (t > b)
+					{
+						// empty
+						m_bottom.store(b + 1, std::memory_order_relaxed);
+						return nullptr;
+					}
+
+					Slot* job = m_buffer[b & queueMask].load(std::memory_order_relaxed);
+					if (t == b)
+					{
+						// the last job; race the thieves for it.
+						if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+						{
+							job = nullptr;
+						}
+						m_bottom.store(b + 1, std::memory_order_relaxed);
+					}
+					return job;
+				}
+
+				// any thread.
+				Slot* steal() noexcept
+				{
+					std::int64_t t = m_top.load(std::memory_order_acquire);
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+					std::int64_t const b = m_bottom.load(std::memory_order_acquire);
+					if (t >= b) { return nullptr; }
+
+					Slot* const job = m_buffer[t & queueMask].load(std::memory_order_acquire);
+					if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					{
+						return nullptr;
+					}
+					return job;
+				}
+			};
+
+			/*
+			//	Each participating thread owns a deque and a ring of job slots.
+			*/
+			struct Participant
+			{
+				Deque deque;
+				std::array<Slot, queueCapacity * 2> slots{};
+				std::size_t nextSlot = 0;
+				std::uint32_t nextVictim = 0;
+			};
+
+			static std::vector<std::unique_ptr<Participant>> s_participants; // [0] is the main thread
+			static std::vector<std::thread> s_workers;
+			static std::atomic<bool> s_running{ false };
+			static std::atomic<bool> s_stopping{ false };
+			static std::atomic<std::uint32_t> s_wakeSignal{ 0 };
+			static std::thread::id s_mainThread{};
+
+			static std::mutex s_mainThreadMutex;
+			static std::vector<std::function<void()>> s_mainThreadTasks;
+			static std::vector<std::function<void()>> s_mainThreadTasksRunning; // swapped in, so tasks may queue more tasks
+
+			static thread_local Participant* t_participant = nullptr;
+
+			static void execute(Job const& job) noexcept
+			{
+				job.function(job.data, job.begin, job.end);
+				if (job.counter) { job.counter->done(); }
+			}
+
+			static bool tryRunOne(Participant& self) noexcept
+			{
+				Slot* job = self.deque.pop();
+				if (!job)
+				{
+					auto const count = static_cast<std::uint32_t>(s_participants.size());
+					for (std::uint32_t i = 0; i < count && !job; ++i)
+					{
+						auto& victim = *s_participants[(self.nextVictim + i) % count];
+						if (&victim == &self) { continue; }
+						job = victim.deque.steal();
+					}
+					++self.nextVictim;
+				}
+				if (!job) { return false; }
+
+				Job const copy = job->job;
+				job->queued.store(false, std::memory_order_release);
+				execute(copy);
+				return true;
+			}
+
+			static void workerMain(Participant* const self) noexcept
+			{
+				t_participant = self;
+
+				while (true)
+				{
+					std::uint32_t const signal = s_wakeSignal.load(std::memory_order_acquire);
+
+					if (tryRunOne(*self)) { continue; }
+
+					if (s_stopping.load(std::memory_order_acquire)) { break; }
+
+					// spin briefly before sleeping, since jobs tend to arrive in bursts.
+					bool found = false;
+					for (int i = 0; i < 64 && !found; ++i)
+					{
+						std::this_thread::yield();
+						found = tryRunOne(*self);
+					}
+					if (found) { continue; }
+
+					s_wakeSignal.wait(signal, std::memory_order_acquire);
+				}
+
+				t_participant = nullptr;
+			}
+
+			void submit(Job const& job) noexcept
+			{
+				auto* const self = t_participant;
+				if (!self)
+				{
+					execute(job);
+					return;
+				}
+
+				Slot& slot = self->slots[self->nextSlot];
+				if (slot.queued.load(std::memory_order_acquire))
+				{
+					// still being copied by a thief that took it a full ring ago.
+					execute(job);
+					return;
+				}
+				self->nextSlot = (self->nextSlot + 1) % self->slots.size();
+				slot.job = job;
+				slot.queued.store(true, std::memory_order_relaxed);
+				if (!self->deque.push(&slot))
+				{
+					slot.queued.store(false, std::memory_order_relaxed);
+					execute(job);
+				}
+			}
+
+			void wakeWorkers() noexcept
+			{
+				if (s_workers.empty()) { return; }
+				s_wakeSignal.fetch_add(1, std::memory_order_release);
+				s_wakeSignal.notify_all();
+			}
+		}
+
+		void start(unsigned const workerCount)
+		{
+			using namespace detail;
+
+			if (s_running.load())
+			{
+				throw JobsException("already running");
+			}
+
+			s_participants.clear();
+			s_participants.reserve(static_cast<std::size_t>(workerCount) + 1);
+			for (unsigned i = 0; i <= workerCount; ++i)
+			{
+				s_participants.push_back(std::make_unique<Participant>());
+				s_participants.back()->nextVictim = i + 1;
+			}
+
+			s_stopping.store(false);
+			s_mainThread = std::this_thread::get_id();
+			t_participant = s_participants[0].get();
+			s_running.store(true);
+
+			try
+			{
+				s_workers.reserve(workerCount);
+				for (unsigned i = 1; i <= workerCount; ++i)
+				{
+					s_workers.emplace_back(workerMain, s_participants[i].get());
+				}
+			}
+			catch (...)
+			{
+				stop();
+				throw JobsException("failed to start worker threads");
+			}
+		}
+
+		void stop() noexcept
+		{
+			using namespace detail;
+
+			if (!s_running.load()) { return; }
+
+			// the main thread helps finish what it queued.
+			if (t_participant)
+			{
+				while (tryRunOne(*t_participant)) {}
+			}
+
+			s_stopping.store(true, std::memory_order_release);
+			s_wakeSignal.fetch_add(1, std::memory_order_release);
+			s_wakeSignal.notify_all();
+			for (auto& worker : s_workers) { worker.join(); }
+			s_workers.clear();
+
+			t_participant = nullptr;
+			s_participants.clear();
+			s_mainThread = {};
+			s_running.store(false);
+
+			std::lock_guard const lock{ s_mainThreadMutex };
+			s_mainThreadTasks.clear();
+		}
+
+		bool isRunning() noexcept
+		{
+			return detail::s_running.load();
+		}
+
+		bool isMainThread() noexcept
+		{
+			return detail::s_running.load() && std::this_thread::get_id() == detail::s_mainThread;
+		}
+
+		unsigned getWorkerCount() noexcept
+		{
+			return detail::s_running.load() ? static_cast<unsigned>(detail::s_workers.size()) : 0;
+		}
+
+		unsigned getDefaultWorkerCount() noexcept
+		{
+			unsigned const hardware = std::thread::hardware_concurrency();
+			return hardware > 1 ? hardware - 1 : 0;
+		}
+
+		void run(Job const& job) noexcept
+		{
+			if (job.counter) { job.counter->add(); }
+			detail::submit(job);
+			detail::wakeWorkers();
+		}
+
+		void wait(Counter const& counter) noexcept
+		{
+			BE_PROFILE_SCOPE("be::jobs::wait");
+
+			while (!counter.isDone())
+			{
+				if (!detail::t_participant || !detail::tryRunOne(*detail::t_participant))
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		void runOnMainThread(std::function<void()> task)
+		{
+			std::lock_guard const lock{ detail::s_mainThreadMutex };
+			detail::s_mainThreadTasks.push_back(std::move(task));
+		}
+
+		std::size_t runMainThreadTasks() noexcept
+		{
+			using namespace detail;
+
+			{
+				std::lock_guard const lock{ s_mainThreadMutex };
+				if (s_mainThreadTasks.empty()) { return 0; }
+				s_mainThreadTasksRunning.swap(s_mainThreadTasks);
+			}
+
+			BE_PROFILE_SCOPE("be::jobs::runMainThreadTasks");
+
+			std::size_t const count = s_mainThreadTasksRunning.size();
+			for (auto& task : s_mainThreadTasksRunning)
+			{
+				try { task(); }
+				catch (...) { Application::logException(); }
+			}
+			s_mainThreadTasksRunning.clear();
+			return count;
+		}
+	}
+}
@@ -0,0 +1,415 @@
+/*
+//	be/light_clusters
+//	Clustered forward lighting: point lights binned into view-space froxels on the CPU every frame.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <immintrin.h>
+
+#include "be/gl_stats.hpp"
+#include "be/jobs.hpp"
+#include "be/light_clusters.hpp"
+#include "be/profile.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		// Room for a few uploads before the ring wraps onto data still being read.
+		static GLsizeiptr streamCapacity(GLsizeiptr const bytesPerUpload)
+		{
+			GLsizeiptr const uploadsInFlight = 4;
+			return (bytesPerUpload * uploadsInFlight + 255) / 256 * 256;
+		}
+
+		LightClusters::LightClusters(CreateInfo const& info)
+			: m_tilesX(info.tilesX)
+			, m_tilesY(info.tilesY)
+			, m_slices(info.slices)
+			, m_maxLights(info.maxLights)
+			, m_maxIndices(info.maxIndices)
+		{
+			if (info.tilesX <= 0 || info.tilesY <= 0 || info.slices <= 0 || info.maxLights <= 0 || info.maxIndices <= 0)
+			{
+				throw LightClustersException("the cluster counts, maxLights and maxIndices must be positive");
+			}
+
+			auto const lightBytes = static_cast<GLsizeiptr>(m_maxLights) * 2 * static_cast<GLsizeiptr>(sizeof(glm::vec4));
+			m_lightStream = StreamBuffer({
+				.target = GL_TEXTURE_BUFFER,
+				.capacity = streamCapacity(lightBytes),
+				.label = "light clusters lights",
+				});
+			auto const dataBytes = (static_cast<GLsizeiptr>(clusterCount()) * 2 + m_maxIndices)
+				* static_cast<GLsizeiptr>(sizeof(std::uint32_t));
+			m_dataStream = StreamBuffer({
+				.target = GL_TEXTURE_BUFFER,
+				.capacity = streamCapacity(dataBytes),
+				.label = "light clusters data",
+				});
+
+			// views of the streams' storage, which is already counted.
+			m_lightTexture = mem::gl::makeTexture(gpu_memory::Category::Streaming, "light clusters lights");
+			be::gl::bindTexture(GL_TEXTURE_BUFFER, m_lightTexture.get());
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_lightStream.buffer());
+			m_dataTexture = mem::gl::makeTexture(gpu_memory::Category::Streaming, "light clusters data");
+			be::gl::bindTexture(GL_TEXTURE_BUFFER, m_dataTexture.get());
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_dataStream.buffer());
+			be::gl::bindTexture(GL_TEXTURE_BUFFER, 0);
+
+			auto const maxLights = static_cast<std::size_t>(m_maxLights);
+			for (auto* v : { &m_viewX, &m_viewY, &m_viewZ, &m_range }) { v->reserve(maxLights); }
+			for (auto* v : { &m_minX, &m_maxX, &m_minY, &m_maxY, &m_minSlice, &m_maxSlice }) { v->reserve(maxLights); }
+			m_sliceLists.resize(static_cast<std::size_t>(m_slices));
+			m_sliceStarts.reserve(static_cast<std::size_t>(m_slices));
+			m_lightTexels.reserve(maxLights * 2);
+			m_data.reserve(static_cast<std::size_t>(clusterCount()) * 2 + static_cast<std::size_t>(m_maxIndices));
+		}
+
+		void LightClusters::assign(ClusterView const& view, std::span<ClusteredLight const> const lights)
+		{
+			BE_PROFILE_SCOPE("be::gl::LightClusters::assign");
+			auto const start = std::chrono::steady_clock::now();
+
+			if (lights.size() > static_cast<std::size_t>(m_maxLights))
+			{
+				throw LightClustersException("more than maxLights lights");
+			}
+			m_view = view;
+			m_stats = LightClusterStats{};
+
+			std::size_t const count = lights.size();
+			for (auto* v : { &m_viewX, &m_viewY, &m_viewZ, &m_range }) { v->resize(count); }
+			for (auto* v : { &m_minX, &m_maxX, &m_minY, &m_maxY, &m_minSlice, &m_maxSlice }) { v->resize(count); }
+
+			float const nearClip = std::max(view.nearClip, 1e-4f);
+			float const farClip = std::max(view.farClip, nearClip * 1.001f);
+			float const tanY = std::tan(view.fovY * 0.5f);
+			float const invTanX = 1.0f / (tanY * view.aspect);
+			float const invTanY = 1.0f / tanY;
+			float const tilesX = static_cast<float>(m_tilesX);
+			float const tilesY = static_cast<float>(m_tilesY);
+
+			// slice s starts where log(depth) has gone s / slices of the way from the near plane to the far,
+			// so a depth's slice is how many of the starts after the first it has passed, with no log per light.
+			m_sliceStarts.resize(static_cast<std::size_t>(m_slices) - 1);
+			for (int s = 1; s < m_slices; ++s)
+			{
+				m_sliceStarts[s - 1] = nearClip * std::pow(farClip / nearClip, static_cast<float>(s) / static_cast<float>(m_slices));
+			}
+			std::span<float const> const sliceStarts = m_sliceStarts;
+
+			// 1. each light's box of clusters, over plain arrays.
+			jobs::parallelFor(count, [&](std::size_t const begin, std::size_t const end) {
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					glm::vec4 const p = view.view * glm::vec4(lights[i].position, 1.0f);
+					m_viewX[i] = p.x;
+					m_viewY[i] = p.y;
+					m_viewZ[i] = p.z;
+					m_range[i] = std::max(lights[i].range, 0.0f);
+				}
+
+				float const* const vx = m_viewX.data();
+				float const* const vy = m_viewY.data();
+				float const* const vz = m_viewZ.data();
+				float const* const vr = m_range.data();
+				std::int32_t* const minX = m_minX.data();
+				std::int32_t* const maxX = m_maxX.data();
+				std::int32_t* const minY = m_minY.data();
+				std::int32_t* const maxY = m_maxY.data();
+				std::int32_t* const minSlice = m_minSlice.data();
+				std::int32_t* const maxSlice = m_maxSlice.data();
+
+				// four lights at a time in SSE2 lanes, the same arithmetic as the scalar tail below.
+				__m128 const zero = _mm_setzero_ps();
+				__m128 const one = _mm_set1_ps(1.0f);
+				__m128 const minusOne = _mm_set1_ps(-1.0f);
+				__m128 const half = _mm_set1_ps(0.5f);
+				__m128 const nearV = _mm_set1_ps(nearClip);
+				__m128 const farV = _mm_set1_ps(farClip);
+				__m128 const invTanXV = _mm_set1_ps(invTanX);
+				__m128 const invTanYV = _mm_set1_ps(invTanY);
+				__m128 const tilesXV = _mm_set1_ps(tilesX);
+				__m128 const tilesYV = _mm_set1_ps(tilesY);
+				__m128 const lastTileX = _mm_set1_ps(tilesX - 1.0f);
+				__m128 const lastTileY = _mm_set1_ps(tilesY - 1.0f);
+				auto const toTile = [&](__m128 const ndc, __m128 const tiles, __m128 const lastTile) {
+					__m128 const t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ndc, half), half), tiles);
+					return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(t, zero), lastTile));
+				};
+				auto const toSlice = [&](__m128 const d) {
+					// each start passed subtracts a true (-1) lane.
+					__m128i slice = _mm_setzero_si128();
+					for (float const sliceStart : sliceStarts)
+					{
+						slice = _mm_sub_epi32(slice, _mm_castps_si128(_mm_cmpge_ps(d, _mm_set1_ps(sliceStart))));
+					}
+					return slice;
+				};
+				auto const toSliceOne = [&](float const d) {
+					std::int32_t slice = 0;
+					for (float const sliceStart : sliceStarts) { slice += d >= sliceStart ? 1 : 0; }
+					return slice;
+				};
+
+				std::size_t i = begin;
+				for (; i + 4 <= end; i += 4)
+				{
+					__m128 const x = _mm_loadu_ps(vx + i);
+					__m128 const y = _mm_loadu_ps(vy + i);
+					__m128 const depth = _mm_sub_ps(zero, _mm_loadu_ps(vz + i));
+					__m128 const r = _mm_loadu_ps(vr + i);
+					__m128 const dn = _mm_min_ps(_mm_max_ps(_mm_sub_ps(depth, r), nearV), farV);
+					__m128 const df = _mm_min_ps(_mm_max_ps(_mm_add_ps(depth, r), nearV), farV);
+					__m128 const inDepth = _mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(depth, r), nearV), _mm_cmplt_ps(_mm_sub_ps(depth, r), farV));
+
+					__m128 const invN = _mm_div_ps(one, dn);
+					__m128 const invF = _mm_div_ps(one, df);
+					__m128 const xMin = _mm_sub_ps(x, r);
+					__m128 const xMax = _mm_add_ps(x, r);
+					__m128 const yMin = _mm_sub_ps(y, r);
+					__m128 const yMax = _mm_add_ps(y, r);
+					__m128 const x0 = _mm_mul_ps(_mm_min_ps(_mm_mul_ps(xMin, invN), _mm_mul_ps(xMin, invF)), invTanXV);
+					__m128 const x1 = _mm_mul_ps(_mm_max_ps(_mm_mul_ps(xMax, invN), _mm_mul_ps(xMax, invF)), invTanXV);
+					__m128 const y0 = _mm_mul_ps(_mm_min_ps(_mm_mul_ps(yMin, invN), _mm_mul_ps(yMin, invF)), invTanYV);
+					__m128 const y1 = _mm_mul_ps(_mm_max_ps(_mm_mul_ps(yMax, invN), _mm_mul_ps(yMax, invF)), invTanYV);
+					__m128 const onScreen = _mm_and_ps(
+						_mm_and_ps(_mm_cmpge_ps(x1, minusOne), _mm_cmple_ps(x0, one)),
+						_mm_and_ps(_mm_cmpge_ps(y1, minusOne), _mm_cmple_ps(y0, one)));
+					__m128i const lit = _mm_castps_si128(_mm_and_ps(_mm_and_ps(inDepth, onScreen), _mm_cmpgt_ps(r, zero)));
+
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(minX + i), toTile(x0, tilesXV, lastTileX));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(maxX + i), toTile(x1, tilesXV, lastTileX));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(minY + i), toTile(y0, tilesYV, lastTileY));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(maxY + i), toTile(y1, tilesYV, lastTileY));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(minSlice + i), toSlice(dn));
+					// an empty range culls the light from every slice.
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(maxSlice + i),
+						_mm_or_si128(_mm_and_si128(lit, toSlice(df)), _mm_andnot_si128(lit, _mm_set1_epi32(-1))));
+				}
+
+				for (; i < end; ++i)
+				{
+					// the view looks down -z; depths are positive in front of it.
+					float const depth = -vz[i];
+					float const r = vr[i];
+					float const dn = std::clamp(depth - r, nearClip, farClip);
+					float const df = std::clamp(depth + r, nearClip, farClip);
+					bool const inDepth = depth + r > nearClip && depth - r < farClip;
+
+					// the sphere's view-space box, projected at both ends of its depth range.
+					float const invN = 1.0f / dn;
+					float const invF = 1.0f / df;
+					float const x0 = std::min((vx[i] - r) * invN, (vx[i] - r) * invF) * invTanX;
+					float const x1 = std::max((vx[i] + r) * invN, (vx[i] + r) * invF) * invTanX;
+					float const y0 = std::min((vy[i] - r) * invN, (vy[i] - r) * invF) * invTanY;
+					float const y1 = std::max((vy[i] + r) * invN, (vy[i] + r) * invF) * invTanY;
+					bool const onScreen = x1 >= -1.0f && x0 <= 1.0f && y1 >= -1.0f && y0 <= 1.0f;
+
+					minX[i] = static_cast<std::int32_t>(std::clamp((x0 * 0.5f + 0.5f) * tilesX, 0.0f, tilesX - 1.0f));
+					maxX[i] = static_cast<std::int32_t>(std::clamp((x1 * 0.5f + 0.5f) * tilesX, 0.0f, tilesX - 1.0f));
+					minY[i] = static_cast<std::int32_t>(std::clamp((y0 * 0.5f + 0.5f) * tilesY, 0.0f, tilesY - 1.0f));
+					maxY[i] = static_cast<std::int32_t>(std::clamp((y1 * 0.5f + 0.5f) * tilesY, 0.0f, tilesY - 1.0f));
+					minSlice[i] = toSliceOne(dn);
+					// an empty range culls the light from every slice.
+					maxSlice[i] = (inDepth && onScreen && r > 0.0f) ? toSliceOne(df) : -1;
+				}
+				}, 64);
+
+			// 2. each slice's lists: count per cluster, offsets, then fill, in light order.
+			int const tilesPerSlice = m_tilesX * m_tilesY;
+			jobs::parallelFor(static_cast<std::size_t>(m_slices), [&](std::size_t const begin, std::size_t const end) {
+				for (std::size_t s = begin; s < end; ++s)
+				{
+					auto const slice = static_cast<std::int32_t>(s);
+					auto& lists = m_sliceLists[s];
+					lists.clusters.assign(static_cast<std::size_t>(tilesPerSlice) * 2, 0u);
+					for (std::size_t i = 0; i < count; ++i)
+					{
+						if (m_minSlice[i] > slice || m_maxSlice[i] < slice) { continue; }
+						for (std::int32_t y = m_minY[i]; y <= m_maxY[i]; ++y)
+						{
+							for (std::int32_t x = m_minX[i]; x <= m_maxX[i]; ++x)
+							{
+								++lists.clusters[(static_cast<std::size_t>(y) * m_tilesX + x) * 2 + 1];
+							}
+						}
+					}
+
+					std::uint32_t first = 0;
+					for (int c = 0; c < tilesPerSlice; ++c)
+					{
+						lists.clusters[c * 2] = first;
+						first += lists.clusters[c * 2 + 1];
+						lists.clusters[c * 2 + 1] = 0; // counted again while filling
+					}
+					lists.indices.resize(first);
+
+					for (std::size_t i = 0; i < count; ++i)
+					{
+						if (m_minSlice[i] > slice || m_maxSlice[i] < slice) { continue; }
+						for (std::int32_t y = m_minY[i]; y <= m_maxY[i]; ++y)
+						{
+							for (std::int32_t x = m_minX[i]; x <= m_maxX[i]; ++x)
+							{
+								auto const c = (static_cast<std::size_t>(y) * m_tilesX + x) * 2;
+								lists.indices[lists.clusters[c] + lists.clusters[c + 1]++] = static_cast<std::uint32_t>(i);
+							}
+						}
+					}
+				}
+				});
+
+			// 3. the slices joined in order, up to maxIndices.
+			auto const clusters = static_cast<std::size_t>(clusterCount());
+			m_data.resize(clusters * 2);
+			auto const maxIndices = static_cast<std::uint32_t>(m_maxIndices);
+			std::uint32_t offset = 0;
+			for (std::size_t s = 0; s < m_sliceLists.size(); ++s)
+			{
+				auto const& lists = m_sliceLists[s];
+				auto const kept = std::min<std::uint32_t>(static_cast<std::uint32_t>(lists.indices.size()), maxIndices - offset);
+				for (int c = 0; c < tilesPerSlice; ++c)
+				{
+					std::uint32_t const first = lists.clusters[c * 2];
+					std::uint32_t const wanted = lists.clusters[c * 2 + 1];
+					std::uint32_t const n = first < kept ? std::min(wanted, kept - first) : 0u;
+					auto const d = (s * tilesPerSlice + c) * 2;
+					m_data[d] = offset + first;
+					m_data[d + 1] = n;
+					m_stats.occupiedClusters += n > 0 ? 1u : 0u;
+					m_stats.maxLightsPerCluster = std::max(m_stats.maxLightsPerCluster, n);
+				}
+				m_data.insert(m_data.end(), lists.indices.begin(), lists.indices.begin() + kept);
+				m_stats.droppedIndices += static_cast<std::uint32_t>(lists.indices.size()) - kept;
+				offset += kept;
+			}
+			m_stats.indices = offset;
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				m_stats.visibleLights += m_minSlice[i] <= m_maxSlice[i] ? 1u : 0u;
+			}
+
+			m_lightTexels.clear();
+			for (auto const& light : lights)
+			{
+				m_lightTexels.push_back(glm::vec4(light.position, light.range));
+				m_lightTexels.push_back(glm::vec4(light.color, 0.0f));
+			}
+
+			m_lightBase = 0;
+			if (!m_lightTexels.empty())
+			{
+				auto const written = m_lightStream.write(
+					m_lightTexels.data(),
+					static_cast<GLsizeiptr>(m_lightTexels.size() * sizeof(glm::vec4)),
+					sizeof(glm::vec4));
+				m_lightBase = static_cast<GLint>(written.offset / static_cast<GLintptr>(sizeof(glm::vec4)));
+			}
+			auto const written = m_dataStream.write(
+				m_data.data(),
+				static_cast<GLsizeiptr>(m_data.size() * sizeof(std::uint32_t)),
+				sizeof(std::uint32_t));
+			m_dataBase = static_cast<GLint>(written.offset / static_cast<GLintptr>(sizeof(std::uint32_t)));
+
+			m_stats.assignMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		void LightClusters::fence()
+		{
+			m_lightStream.fence();
+			m_dataStream.fence();
+		}
+
+		char const* const lightClustersGlsl = R"__(
+uniform samplerBuffer clusterLights; // per light: position and range, colour
+uniform usamplerBuffer clusterData; // per cluster: first and count; then the light indices
+uniform int clusterLightBase;
+uniform int clusterDataBase;
+uniform ivec3 clusterCounts; // tiles across, tiles up, depth slices
+uniform vec2 clusterTileSize; // in pixels
+uniform vec4 clusterDepthRow; // the view matrix's third row
+uniform vec2 clusterSliceScaleBias; // slice = log(view depth) * x + y
+
+int findCluster(vec3 worldPosition)
+{
+	float depth = -dot(clusterDepthRow, vec4(worldPosition, 1.0f));
+	ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterTileSize), ivec2(0), clusterCounts.xy - 1);
+	int slice = clamp(int(log(max(depth, 1e-4f)) * clusterSliceScaleBias.x + clusterSliceScaleBias.y), 0, clusterCounts.z - 1);
+	return (slice * clusterCounts.y + tile.y) * clusterCounts.x + tile.x;
+}
+
+int countClusterLights(vec3 worldPosition)
+{
+	return int(texelFetch(clusterData, clusterDataBase + findCluster(worldPosition) * 2 + 1).r);
+}
+
+vec3 calcClusteredLighting(vec3 worldPosition, vec3 normal, vec3 viewDir)
+{
+	int cluster = clusterDataBase + findCluster(worldPosition) * 2;
+	int first = int(texelFetch(clusterData, cluster).r);
+	int count = int(texelFetch(clusterData, cluster + 1).r);
+	int indices = clusterDataBase + clusterCounts.x * clusterCounts.y * clusterCounts.z * 2 + first;
+
+	vec3 lighting = vec3(0.0f);
+	for (int k = 0; k < count; ++k)
+	{
+		int i = clusterLightBase + int(texelFetch(clusterData, indices + k).r) * 2;
+		vec4 positionRange = texelFetch(clusterLights, i);
+		vec3 lightColor = texelFetch(clusterLights, i + 1).rgb;
+
+		vec3 toLight = positionRange.xyz - worldPosition;
+		float distance = length(toLight);
+		float attenuation = clamp(1.0f - distance / positionRange.w, 0.0f, 1.0f);
+		attenuation *= attenuation;
+
+		vec3 lightDir = toLight / max(distance, 1e-4f);
+		float diff = max(dot(lightDir, normal), 0.0f);
+		vec3 halfwayDir = normalize(lightDir + viewDir);
+		float spec = pow(max(dot(normal, halfwayDir), 0.0f), 64.0f);
+		lighting += attenuation * lightColor * (diff + spec);
+	}
+	return lighting;
+}
+)__";
+
+		LightClusterUniformLocations getLightClusterUniformLocations(GLuint const program)
+		{
+			LightClusterUniformLocations locations;
+			locations.lights = glGetUniformLocation(program, "clusterLights");
+			locations.data = glGetUniformLocation(program, "clusterData");
+			locations.lightBase = glGetUniformLocation(program, "clusterLightBase");
+			locations.dataBase = glGetUniformLocation(program, "clusterDataBase");
+			locations.counts = glGetUniformLocation(program, "clusterCounts");
+			locations.tileSize = glGetUniformLocation(program, "clusterTileSize");
+			locations.depthRow = glGetUniformLocation(program, "clusterDepthRow");
+			locations.sliceScaleBias = glGetUniformLocation(program, "clusterSliceScaleBias");
+			return locations;
+		}
+
+		void uniformLightClusters(LightClusterUniformLocations const& locations, LightClusters const& clusters, GLint const lightsUnit, GLint const dataUnit)
+		{
+			auto const& view = clusters.view();
+			float const nearClip = std::max(view.nearClip, 1e-4f);
+			float const farClip = std::max(view.farClip, nearClip * 1.001f);
+			float const sliceScale = static_cast<float>(clusters.slices()) / std::log(farClip / nearClip);
+
+			glUniform1i(locations.lights, lightsUnit);
+			glUniform1i(locations.data, dataUnit);
+			glUniform1i(locations.lightBase, clusters.lightBase());
+			glUniform1i(locations.dataBase, clusters.dataBase());
+			glUniform3i(locations.counts, clusters.tilesX(), clusters.tilesY(), clusters.slices());
+			glUniform2f(locations.tileSize,
+				static_cast<float>(view.viewportSize.x) / static_cast<float>(clusters.tilesX()),
+				static_cast<float>(view.viewportSize.y) / static_cast<float>(clusters.tilesY()));
+			glUniform4f(locations.depthRow, view.view[0][2], view.view[1][2], view.view[2][2], view.view[3][2]);
+			glUniform2f(locations.sliceScaleBias, sliceScale, -std::log(nearClip) * sliceScale);
+		}
+	}
+}
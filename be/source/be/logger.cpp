@@ -1,17 +1,55 @@
 /*
 //	be/logger
-//	Used by Application for logging exceptions.
+//	Used by Application for logging exceptions and leveled messages.
 //
 //	Elijah Shadbolt
 //	2019
 */
 
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
 #include <iostream>
 
 #include "be/logger.hpp"
 
 namespace be
 {
+	char const* toString(LogLevel const level) noexcept
+	{
+		switch (level)
+		{
+		case LogLevel::Debug: return "debug";
+		case LogLevel::Info: return "info";
+		case LogLevel::Warning: return "warning";
+		case LogLevel::Error: return "error";
+		}
+		return "unknown";
+	}
+
+
+
+	void Logger::logf(LogLevel const level, char const* const format, ...) noexcept
+	{
+		va_list args;
+		va_start(args, format);
+		vlogf(level, format, args);
+		va_end(args);
+	}
+
+	void Logger::vlogf(LogLevel const level, char const* const format, std::va_list args) noexcept
+	{
+		if (!isEnabled(level)) { return; }
+
+		char buffer[maxFormattedLength + 1];
+		int const length = std::vsnprintf(buffer, sizeof(buffer), format, args);
+		if (length < 0) { return; }
+
+		Log(level, std::string_view(buffer, std::min<std::size_t>(static_cast<std::size_t>(length), maxFormattedLength)));
+	}
+
+
+
 	void DefaultLogger::LogException() noexcept
 	{
 		std::cerr << "! Exception: ";
@@ -21,4 +59,10 @@ namespace be
 		catch (...) { std::cerr << "unknown"; }
 		std::cerr << '\n';
 	}
+
+	void DefaultLogger::Log(LogLevel const level, std::string_view const message) noexcept
+	{
+		try { std::cerr << '[' << toString(level) << "] " << message << '\n'; }
+		catch (...) {}
+	}
 }
@@ -0,0 +1,66 @@
+/*
+//	be/mem/frame_arena
+//	A bump allocator for temporaries that only live until the end of the frame.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <algorithm>
+#include <cstdint>
+
+#include "be/mem/frame_arena.hpp"
+
+namespace be
+{
+	namespace mem
+	{
+		// Rounds |address| up to |alignment|, a power of two.
+		static std::uintptr_t alignUp(std::uintptr_t const address, std::size_t const alignment) noexcept
+		{
+			return (address + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+		}
+
+		FrameArena::FrameArena(std::size_t const capacity)
+			: m_block(new std::byte[std::max<std::size_t>(capacity, 1)])
+			, m_capacity(std::max<std::size_t>(capacity, 1))
+		{
+		}
+
+		void FrameArena::reset()
+		{
+			m_peak = std::max(m_peak, used());
+			if (!m_overflow.empty())
+			{
+				// clear keeps the capacity of m_overflow, so the next overflow only allocates its block.
+				m_overflow.clear();
+				m_capacity = std::max(m_capacity * 2, m_peak);
+				m_block.reset(new std::byte[m_capacity]);
+			}
+			m_used = 0;
+			m_overflowBytes = 0;
+		}
+
+		void* FrameArena::do_allocate(std::size_t const bytes, std::size_t const alignment)
+		{
+			auto const base = reinterpret_cast<std::uintptr_t>(m_block.get());
+			auto const address = alignUp(base + m_used, alignment);
+			if (address + bytes <= base + m_capacity)
+			{
+				m_used = address + bytes - base;
+				return reinterpret_cast<void*>(address);
+			}
+
+			std::size_t const size = bytes + alignment;
+			m_overflow.emplace_back(new std::byte[size]);
+			m_overflowBytes += size;
+			return reinterpret_cast<void*>(alignUp(reinterpret_cast<std::uintptr_t>(m_overflow.back().get()), alignment));
+		}
+
+		FrameArena& getFrameArena() noexcept
+		{
+			static FrameArena arena;
+			return arena;
+		}
+	}
+}
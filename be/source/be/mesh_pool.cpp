@@ -0,0 +1,307 @@
+/*
+//	be/mesh_pool
+//	Many meshes of one vertex format in shared buffers behind a single vertex array.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+#include "be/mesh_pool.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		// FREE LIST ALLOCATOR
+
+		FreeListAllocator::FreeListAllocator(GLuint const capacity)
+		{
+			grow(capacity);
+		}
+
+		std::optional<GLuint> FreeListAllocator::allocate(GLuint const count)
+		{
+			if (count == 0) { return std::nullopt; }
+
+			for (auto it = m_free.begin(); it != m_free.end(); ++it)
+			{
+				if (it->second < count) { continue; }
+
+				GLuint const offset = it->first;
+				GLuint const remaining = it->second - count;
+				m_free.erase(it);
+				if (remaining > 0)
+				{
+					m_free.emplace(offset + count, remaining);
+				}
+				m_used += count;
+				return offset;
+			}
+			return std::nullopt;
+		}
+
+		void FreeListAllocator::free(GLuint offset, GLuint count)
+		{
+			if (count == 0) { return; }
+
+			auto next = m_free.lower_bound(offset);
+			auto previous = next == m_free.begin() ? m_free.end() : std::prev(next);
+			if (offset + count > m_capacity
+				|| (next != m_free.end() && next->first < offset + count)
+				|| (previous != m_free.end() && previous->first + previous->second > offset))
+			{
+				throw MeshPoolException("freed range is not allocated");
+			}
+			m_used -= count;
+
+			// merge with the free neighbours.
+			if (previous != m_free.end() && previous->first + previous->second == offset)
+			{
+				offset = previous->first;
+				count += previous->second;
+				m_free.erase(previous);
+			}
+			if (next != m_free.end() && next->first == offset + count)
+			{
+				count += next->second;
+				m_free.erase(next);
+			}
+
+			m_free.emplace(offset, count);
+		}
+
+		void FreeListAllocator::grow(GLuint const newCapacity)
+		{
+			if (newCapacity <= m_capacity) { return; }
+
+			GLuint const added = newCapacity - m_capacity;
+			GLuint const oldCapacity = m_capacity;
+			m_capacity = newCapacity;
+			m_used += added;
+			free(oldCapacity, added);
+		}
+
+
+
+		// VERTEX FORMAT
+
+		VertexFormat const& basicVertexFormat()
+		{
+			static VertexFormat const format{
+				sizeof(BasicVertex),
+				{
+					{ 0, 3, GL_FLOAT, GL_FALSE, offsetof(BasicVertex, position) },
+					{ 1, 3, GL_FLOAT, GL_FALSE, offsetof(BasicVertex, normal) },
+					{ 2, 2, GL_FLOAT, GL_FALSE, offsetof(BasicVertex, texCoords) },
+				}
+			};
+			return format;
+		}
+
+
+
+		// MESH POOL
+
+		// Makes a buffer of |newBytes| holding the first |oldBytes| of |old|.
+		static mem::gl::Buffer makeGrownBuffer(GLuint const old, GLsizeiptr const oldBytes, GLsizeiptr const newBytes)
+		{
+			auto buffer = mem::gl::makeBuffer(gpu_memory::Category::Mesh, "mesh pool");
+			glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.get());
+			CRESS_MOO_DEFER_EXPRESSION(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+			glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+			gpu_memory::setBufferBytes(buffer.get(), static_cast<std::uint64_t>(newBytes));
+
+			if (old && oldBytes > 0)
+			{
+				glBindBuffer(GL_COPY_READ_BUFFER, old);
+				CRESS_MOO_DEFER_EXPRESSION(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+			}
+			return buffer;
+		}
+
+		// Doubles until |minCapacity| fits.
+		static GLuint grownCapacity(GLuint capacity, GLuint const minCapacity)
+		{
+			capacity = std::max<GLuint>(capacity, 1);
+			while (capacity < minCapacity)
+			{
+				if (capacity > 0x7fffffffu)
+				{
+					throw MeshPoolException("capacity overflow");
+				}
+				capacity *= 2;
+			}
+			return capacity;
+		}
+
+		MeshPool::MeshPool(CreateInfo const& info)
+			: m_format(info.format)
+			, m_drawIdAttribute(info.drawIdAttribute)
+			, m_maxDrawIds(info.maxDrawIds)
+		{
+			if (info.vertexCapacity == 0 || info.indexCapacity == 0 || m_format.stride <= 0)
+			{
+				throw MeshPoolException("capacities and stride must be positive");
+			}
+			if (m_drawIdAttribute >= 0 && m_maxDrawIds == 0)
+			{
+				throw MeshPoolException("maxDrawIds must be positive");
+			}
+
+			m_vertexArray = mem::gl::makeVertexArray();
+
+			if (m_drawIdAttribute >= 0)
+			{
+				std::vector<GLuint> drawIds(m_maxDrawIds);
+				for (GLuint i = 0; i < m_maxDrawIds; ++i) { drawIds[i] = i; }
+
+				m_drawIdBuffer = mem::gl::makeBuffer(gpu_memory::Category::Mesh, "mesh pool draw ids");
+				glBindBuffer(GL_ARRAY_BUFFER, m_drawIdBuffer.get());
+				glBufferData(GL_ARRAY_BUFFER, drawIds.size() * sizeof(GLuint), drawIds.data(), GL_STATIC_DRAW);
+				gpu_memory::setBufferBytes(m_drawIdBuffer.get(), drawIds.size() * sizeof(GLuint));
+
+				BE_BIND_VERTEX_ARRAY_SCOPE(m_vertexArray.get());
+				auto const index = static_cast<GLuint>(m_drawIdAttribute);
+				glVertexAttribIPointer(index, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+				glVertexAttribDivisor(index, 1);
+				glEnableVertexAttribArray(index);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+			}
+
+			growVertices(info.vertexCapacity);
+			growIndices(info.indexCapacity);
+		}
+
+		void MeshPool::growVertices(GLuint const minCapacity)
+		{
+			GLuint const capacity = grownCapacity(m_vertices.capacity(), minCapacity);
+			GLsizeiptr const stride = m_format.stride;
+			m_vertexBuffer = makeGrownBuffer(m_vertexBuffer.get(),
+				m_vertices.capacity() * stride, capacity * stride);
+			m_vertices.grow(capacity);
+			setUpVertexArray();
+		}
+
+		void MeshPool::growIndices(GLuint const minCapacity)
+		{
+			GLuint const capacity = grownCapacity(m_indices.capacity(), minCapacity);
+			GLsizeiptr const size = sizeof(GLuint);
+			m_elementBuffer = makeGrownBuffer(m_elementBuffer.get(),
+				m_indices.capacity() * size, capacity * size);
+			m_indices.grow(capacity);
+			setUpVertexArray();
+		}
+
+		void MeshPool::setUpVertexArray()
+		{
+			if (!m_vertexBuffer.get() || !m_elementBuffer.get()) { return; }
+
+			BE_BIND_VERTEX_ARRAY_SCOPE(m_vertexArray.get());
+
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_elementBuffer.get());
+
+			glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer.get());
+			CRESS_MOO_DEFER_EXPRESSION(glBindBuffer(GL_ARRAY_BUFFER, 0));
+			for (auto const& attribute : m_format.attributes)
+			{
+				glVertexAttribPointer(attribute.index, attribute.size, attribute.type, attribute.normalized,
+					m_format.stride, reinterpret_cast<GLvoid const*>(static_cast<std::size_t>(attribute.offset)));
+				glEnableVertexAttribArray(attribute.index);
+			}
+		}
+
+		MeshRange MeshPool::add(
+			void const* const vertices,
+			GLuint const vertexCount,
+			GLuint const* const indices,
+			GLsizei const indexCount,
+			GLenum const mode)
+		{
+			if (!m_vertexArray.get())
+			{
+				throw MeshPoolException("add called on an empty mesh pool");
+			}
+			if (vertexCount == 0 || indexCount <= 0 || !vertices || !indices)
+			{
+				throw MeshPoolException("a mesh needs vertices and indices");
+			}
+
+			auto const indexUnits = static_cast<GLuint>(indexCount);
+
+			auto vertexOffset = m_vertices.allocate(vertexCount);
+			if (!vertexOffset)
+			{
+				growVertices(m_vertices.capacity() + vertexCount);
+				vertexOffset = m_vertices.allocate(vertexCount);
+			}
+
+			auto indexOffset = m_indices.allocate(indexUnits);
+			if (!indexOffset)
+			{
+				try
+				{
+					growIndices(m_indices.capacity() + indexUnits);
+				}
+				catch (...)
+				{
+					m_vertices.free(*vertexOffset, vertexCount);
+					throw;
+				}
+				indexOffset = m_indices.allocate(indexUnits);
+			}
+
+			GLsizeiptr const stride = m_format.stride;
+
+			// the copy targets leave both the bound vertex array and GL_ARRAY_BUFFER alone.
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer.get());
+			glBufferSubData(GL_COPY_WRITE_BUFFER, *vertexOffset * stride, vertexCount * stride, vertices);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_elementBuffer.get());
+			glBufferSubData(GL_COPY_WRITE_BUFFER, *indexOffset * sizeof(GLuint), indexUnits * sizeof(GLuint), indices);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+			MeshRange range;
+			range.baseVertex = static_cast<GLint>(*vertexOffset);
+			range.vertexCount = vertexCount;
+			range.firstIndex = *indexOffset;
+			range.indexCount = indexCount;
+			range.mode = mode;
+			return range;
+		}
+
+		MeshRange MeshPool::add(std::vector<BasicVertex> const& vertices, std::vector<GLuint> const& indices)
+		{
+			if (m_format.stride != static_cast<GLsizei>(sizeof(BasicVertex)))
+			{
+				throw MeshPoolException("BasicVertex does not match the pool's vertex format");
+			}
+			return add(
+				vertices.data(),
+				static_cast<GLuint>(vertices.size()),
+				indices.data(),
+				static_cast<GLsizei>(indices.size())
+			);
+		}
+
+		void MeshPool::remove(MeshRange const& range)
+		{
+			m_vertices.free(static_cast<GLuint>(range.baseVertex), range.vertexCount);
+			m_indices.free(range.firstIndex, static_cast<GLuint>(range.indexCount));
+		}
+
+		void MeshPool::draw(MeshRange const& range) const noexcept
+		{
+			glDrawElementsBaseVertex(
+				range.mode,
+				range.indexCount,
+				GL_UNSIGNED_INT,
+				reinterpret_cast<void*>(static_cast<std::size_t>(range.firstIndex) * sizeof(GLuint)),
+				range.baseVertex
+			);
+		}
+	}
+}
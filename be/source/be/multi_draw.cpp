@@ -0,0 +1,192 @@
+/*
+//	be/multi_draw
+//	Batches many draws from one mesh pool into a single glMultiDrawElementsIndirect.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <algorithm>
+#include <cstdint>
+
+#include "be/gl_stats.hpp"
+#include "be/multi_draw.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		bool isMultiDrawIndirectSupported() noexcept
+		{
+			return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+		}
+
+		// Room for a few submits per frame before the ring wraps onto data still being drawn.
+		static GLsizeiptr streamCapacity(GLsizeiptr const bytesPerSubmit)
+		{
+			GLsizeiptr const submitsInFlight = 4;
+			return (bytesPerSubmit * submitsInFlight + 255) / 256 * 256;
+		}
+
+		MultiDrawBatch::MultiDrawBatch(CreateInfo const& info)
+			: m_texelsPerDraw(info.texelsPerDraw)
+			, m_maxDraws(info.maxDraws)
+			, m_indirect(info.allowIndirect && isMultiDrawIndirectSupported())
+		{
+			if (info.texelsPerDraw <= 0 || info.maxDraws <= 0)
+			{
+				throw MultiDrawException("texelsPerDraw and maxDraws must be positive");
+			}
+
+			auto const maxDraws = static_cast<GLsizeiptr>(m_maxDraws);
+
+			m_perDrawStream = StreamBuffer({
+				.target = GL_TEXTURE_BUFFER,
+				.capacity = streamCapacity(maxDraws * m_texelsPerDraw * static_cast<GLsizeiptr>(sizeof(glm::vec4))),
+				.label = "multi draw per-draw data",
+				});
+
+			// a view of the stream's storage, which is already counted.
+			m_perDrawTexture = mem::gl::makeTexture(gpu_memory::Category::Streaming, "multi draw per-draw data");
+			be::gl::bindTexture(GL_TEXTURE_BUFFER, m_perDrawTexture.get());
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_perDrawStream.buffer());
+			be::gl::bindTexture(GL_TEXTURE_BUFFER, 0);
+
+			if (m_indirect)
+			{
+				m_commandStream = StreamBuffer({
+					.target = GL_DRAW_INDIRECT_BUFFER,
+					.capacity = streamCapacity(maxDraws * static_cast<GLsizeiptr>(sizeof(DrawElementsIndirectCommand))),
+					.label = "multi draw commands",
+					});
+			}
+
+			m_commands.reserve(static_cast<std::size_t>(m_maxDraws));
+			m_perDraw.reserve(static_cast<std::size_t>(m_maxDraws) * m_texelsPerDraw);
+		}
+
+		void MultiDrawBatch::clear() noexcept
+		{
+			m_commands.clear();
+			m_perDraw.clear();
+		}
+
+		glm::vec4* MultiDrawBatch::add(MeshRange const& range)
+		{
+			if (m_texelsPerDraw <= 0)
+			{
+				throw MultiDrawException("add called on an empty batch");
+			}
+			if (m_commands.size() >= static_cast<std::size_t>(m_maxDraws))
+			{
+				throw MultiDrawException("more than maxDraws draws in one batch");
+			}
+			if (m_commands.empty())
+			{
+				m_mode = range.mode;
+			}
+			else if (range.mode != m_mode)
+			{
+				throw MultiDrawException("every draw in a batch must have the same mode");
+			}
+
+			DrawElementsIndirectCommand command;
+			command.count = static_cast<GLuint>(range.indexCount);
+			command.instanceCount = 1;
+			command.firstIndex = range.firstIndex;
+			command.baseVertex = range.baseVertex;
+			command.baseInstance = static_cast<GLuint>(m_commands.size()); // the draw id
+			m_commands.push_back(command);
+
+			m_perDraw.resize(m_perDraw.size() + m_texelsPerDraw);
+			return m_perDraw.data() + m_perDraw.size() - m_texelsPerDraw;
+		}
+
+		void MultiDrawBatch::submit(
+			MeshPool const& pool,
+			GLuint const textureUnit,
+			GLint const perDrawSamplerLocation,
+			GLint const perDrawBaseLocation)
+		{
+			if (m_commands.empty()) { return; }
+			CRESS_MOO_DEFER_EXPRESSION(clear());
+
+			auto const perDraw = m_perDrawStream.write(
+				m_perDraw.data(),
+				static_cast<GLsizeiptr>(m_perDraw.size() * sizeof(glm::vec4)),
+				sizeof(glm::vec4));
+			auto const base = static_cast<GLint>(perDraw.offset / static_cast<GLintptr>(sizeof(glm::vec4)));
+
+			glActiveTexture(GL_TEXTURE0 + textureUnit);
+			be::gl::bindTexture(GL_TEXTURE_BUFFER, m_perDrawTexture.get());
+			CRESS_MOO_DEFER_BEGIN(unbindPerDraw);
+			glActiveTexture(GL_TEXTURE0 + textureUnit);
+			be::gl::bindTexture(GL_TEXTURE_BUFFER, 0);
+			CRESS_MOO_DEFER_END(unbindPerDraw);
+			glUniform1i(perDrawSamplerLocation, static_cast<GLint>(textureUnit));
+
+			auto const drawCount = static_cast<GLuint>(m_commands.size());
+
+			// without draw ids the attribute reads as 0, so the loop below still works.
+			GLuint const maxDrawIds = pool.maxDrawIds();
+			if (m_indirect && maxDrawIds > 0)
+			{
+				// draws past the end of the draw id buffer go in further multi-draws with their own base.
+				if (drawCount > maxDrawIds)
+				{
+					for (GLuint i = maxDrawIds; i < drawCount; ++i)
+					{
+						m_commands[i].baseInstance = i % maxDrawIds;
+					}
+				}
+
+				auto const commands = m_commandStream.write(
+					m_commands.data(),
+					static_cast<GLsizeiptr>(m_commands.size() * sizeof(DrawElementsIndirectCommand)),
+					16);
+
+				glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandStream.buffer());
+				CRESS_MOO_DEFER_EXPRESSION(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+
+				for (GLuint first = 0; first < drawCount; first += maxDrawIds)
+				{
+					GLuint const count = std::min(maxDrawIds, drawCount - first);
+					if (isStatsEnabled())
+					{
+						std::uint64_t indices = 0;
+						for (GLuint i = first; i < first + count; ++i) { indices += m_commands[i].count; }
+						detail::countDraw(m_mode, static_cast<GLsizei>(indices));
+					}
+
+					glUniform1i(perDrawBaseLocation, base + static_cast<GLint>(first) * m_texelsPerDraw);
+					glMultiDrawElementsIndirect(
+						m_mode,
+						GL_UNSIGNED_INT,
+						reinterpret_cast<void const*>(commands.offset + first * sizeof(DrawElementsIndirectCommand)),
+						static_cast<GLsizei>(count),
+						0);
+				}
+
+				m_commandStream.fence();
+			}
+			else
+			{
+				for (GLuint i = 0; i < drawCount; ++i)
+				{
+					auto const& command = m_commands[i];
+
+					MeshRange range;
+					range.baseVertex = command.baseVertex;
+					range.firstIndex = command.firstIndex;
+					range.indexCount = static_cast<GLsizei>(command.count);
+					range.mode = m_mode;
+
+					glUniform1i(perDrawBaseLocation, base + static_cast<GLint>(i) * m_texelsPerDraw);
+					pool.draw(range);
+				}
+			}
+
+			m_perDrawStream.fence();
+		}
+	}
+}
@@ -38,5 +38,13 @@ namespace be
 			recalcProjection(camera);
 			recalcVP(camera);
 		}
+
+		float calcPixelsPerUnit(Camera const& camera, float const distance, float const viewportHeight)
+		{
+			float const visibleHeight = camera.ortho
+				? 2.0f * camera.extentY
+				: 2.0f * glm::max(distance, camera.nearClip) * glm::tan(camera.fovY * 0.5f);
+			return viewportHeight / visibleHeight;
+		}
 	}
 }
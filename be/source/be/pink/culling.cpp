@@ -0,0 +1,66 @@
+
+#include <cmath>
+
+#include "be/pink/culling.hpp"
+
+namespace be
+{
+	namespace pink
+	{
+		Frustum calcFrustum(glm::mat4 const& m) noexcept
+		{
+			// rows of the matrix; glm is column major.
+			glm::vec4 const r0 = glm::vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+			glm::vec4 const r1 = glm::vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+			glm::vec4 const r2 = glm::vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+			glm::vec4 const r3 = glm::vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+			Frustum frustum;
+			frustum.planes = {
+				r3 + r0, // left
+				r3 - r0, // right
+				r3 + r1, // bottom
+				r3 - r1, // top
+				r3 + r2, // near
+				r3 - r2, // far
+			};
+			for (auto& plane : frustum.planes)
+			{
+				float const length = glm::length(glm::vec3(plane));
+				if (length > 0.0f) { plane /= length; }
+			}
+			return frustum;
+		}
+
+		Aabb transformAabb(Aabb const& bounds, glm::mat4 const& m) noexcept
+		{
+			glm::vec3 const centre = (bounds.min + bounds.max) * 0.5f;
+			glm::vec3 const extent = (bounds.max - bounds.min) * 0.5f;
+
+			glm::vec3 const newCentre = glm::vec3(m * glm::vec4(centre, 1.0f));
+			glm::vec3 newExtent = glm::vec3(0.0f);
+			for (int i = 0; i < 3; ++i)
+			{
+				newExtent += glm::abs(glm::vec3(m[i])) * extent[i];
+			}
+			return Aabb{ newCentre - newExtent, newCentre + newExtent };
+		}
+
+		bool isVisible(Frustum const& frustum, Aabb const& worldBounds) noexcept
+		{
+			for (auto const& plane : frustum.planes)
+			{
+				// the corner furthest along the plane normal.
+				glm::vec3 const p = glm::vec3(
+					plane.x >= 0.0f ? worldBounds.max.x : worldBounds.min.x,
+					plane.y >= 0.0f ? worldBounds.max.y : worldBounds.min.y,
+					plane.z >= 0.0f ? worldBounds.max.z : worldBounds.min.z);
+				if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+}
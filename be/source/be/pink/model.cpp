@@ -1,4 +1,5 @@
 
+#include <limits>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -28,7 +29,7 @@ namespace be
 
 						std::string const filename = dir + str.C_Str();
 
-						textures.emplace_back(be::soil::load_OGL_texture(filename.c_str(), SOIL_LOAD_RGBA, 0, 0));
+						textures.emplace_back(be::soil::load_OGL_texture(filename.c_str(), SOIL_LOAD_RGBA, 0, 0, "model texture"));
 					}
 					catch (be::soil::SoilException const&)
 					{
@@ -39,34 +40,37 @@ namespace be
 				return textures;
 			}
 
-			std::shared_ptr<Material> processMaterial(
+			Material processMaterial(
 				std::string const& dir,
 				aiMaterial const* const rawMaterial)
 			{
-				auto material = std::make_shared<Material>();
+				Material material;
 				for (aiTextureType i = static_cast<aiTextureType>(aiTextureType_NONE + 1);
 					i < AI_TEXTURE_TYPE_MAX;
 					i = static_cast<aiTextureType>(i + 1))
 				{
-					material->textureMap[i] = loadTextures(dir, rawMaterial, i);
+					material.textureMap[i] = loadTextures(dir, rawMaterial, i);
 				}
 				return material;
 			}
 
-			std::shared_ptr<Mesh> processMesh(
-				std::vector<std::shared_ptr<Material>> const& sceneMaterials,
-				aiMesh const* const rawMesh)
+			Mesh processMesh(
+				aiMesh const* const rawMesh,
+				be::gl::MeshPool* const pool)
 			{
 				using Vertex = be::gl::BasicVertex;
 
 				// process vertices
 				std::vector<Vertex> vertices;
+				Aabb bounds{ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()) };
 				for (unsigned int i = 0; i < rawMesh->mNumVertices; i++)
 				{
 					Vertex vertex;
 
 					auto const& v = rawMesh->mVertices[i];
 					vertex.position = { v.x, v.y, v.z };
+					bounds.min = glm::min(bounds.min, vertex.position);
+					bounds.max = glm::max(bounds.max, vertex.position);
 
 					auto const& n = rawMesh->mNormals[i];
 					vertex.normal = { n.x, n.y, n.z };
@@ -95,14 +99,28 @@ namespace be
 					}
 				}
 
-				auto mesh = std::make_shared<Mesh>();
-				mesh->data = be::gl::makeBasicMesh(vertices, indices);
-				mesh->material = sceneMaterials[rawMesh->mMaterialIndex];
+				Mesh mesh;
+				if (pool)
+				{
+					mesh.pool = pool;
+					mesh.range = pool->add(vertices, indices);
+				}
+				else
+				{
+					mesh.data = be::gl::makeBasicMesh(vertices, indices);
+				}
+				mesh.material = rawMesh->mMaterialIndex;
+				mesh.bounds = vertices.empty() ? Aabb{} : bounds;
+				mesh.positions.reserve(vertices.size());
+				for (auto const& vertex : vertices)
+				{
+					mesh.positions.push_back(vertex.position);
+				}
+				mesh.indices.assign(indices.begin(), indices.end());
 				return mesh;
 			}
 
 			std::shared_ptr<Node> processNode(
-				std::vector<std::shared_ptr<Mesh>> const& sceneMeshes,
 				std::shared_ptr<Node> const& parent,
 				aiNode const* const rawNode)
 			{
@@ -121,22 +139,21 @@ namespace be
 				}
 
 				// meshes
-				for (unsigned int i = 0; i < rawNode->mNumMeshes; ++i)
-				{
-					node->meshes.insert(sceneMeshes[rawNode->mMeshes[i]]);
-				}
+				node->meshes.assign(rawNode->mMeshes, rawNode->mMeshes + rawNode->mNumMeshes);
 
 				// children
 				for (unsigned int i = 0; i < rawNode->mNumChildren; ++i)
 				{
-					node->children.insert(processNode(sceneMeshes, node, rawNode->mChildren[i]));
+					node->children.insert(processNode(node, rawNode->mChildren[i]));
 				}
 
 				return node;
 			}
 
-			Model loadModel(std::string const& filename)
+			Model loadModel(std::string const& filename, be::gl::MeshPool* const pool)
 			{
+				BE_PROFILE_SCOPE("be::pink::model::loadModel");
+
 				Assimp::Importer importer;
 
 				aiScene const* const rawScene = importer.ReadFile(filename,
@@ -156,23 +173,36 @@ namespace be
 
 				auto scene = Model();
 
-				scene.materials.resize(rawScene->mNumMaterials);
+				scene.materials.reserve(rawScene->mNumMaterials);
 				for (unsigned int i = 0; i < rawScene->mNumMaterials; ++i)
 				{
-					scene.materials[i] = processMaterial(dir, rawScene->mMaterials[i]);
+					scene.materials.push_back(processMaterial(dir, rawScene->mMaterials[i]));
 				}
 
-				scene.meshes.resize(rawScene->mNumMeshes);
+				scene.meshes.reserve(rawScene->mNumMeshes);
 				for (unsigned int i = 0; i < rawScene->mNumMeshes; ++i)
 				{
-					scene.meshes[i] = processMesh(scene.materials, rawScene->mMeshes[i]);
+					scene.meshes.push_back(processMesh(rawScene->mMeshes[i], pool));
 				}
 
-				scene.rootNode = processNode(scene.meshes, nullptr, rawScene->mRootNode);
+				scene.rootNode = processNode(nullptr, rawScene->mRootNode);
 
 				return scene;
 			}
 
+			void drawMesh(Mesh const& mesh)
+			{
+				if (mesh.pool)
+				{
+					BE_BIND_MESH_POOL_SCOPE(*mesh.pool);
+					mesh.pool->draw(mesh.range);
+				}
+				else
+				{
+					be::gl::drawBasicMesh(mesh.data);
+				}
+			}
+
 
 
 			glm::mat4 calcModelMatrix(glm::mat4 const& parentModelMatrix, Node const& node)
@@ -207,12 +237,11 @@ namespace be
 
 			void renderModelNode(
 				std::shared_ptr<Node> const& node,
-				DrawNodeCallback const& drawNode,
+				DrawNodeCallback const drawNode,
 				NodeModelMatrixMap const& modelMatrices
 			)
 			{
 				if (!node) { return; }
-				if (!drawNode) { return; }
 
 				glm::mat4 const modelMatrix = [&]() -> glm::mat4 {
 					auto const it = modelMatrices.find(node);
@@ -228,14 +257,65 @@ namespace be
 				}
 			}
 
+			void renderNode(
+				Node const& node,
+				DrawNodeCallback const drawNode,
+				glm::mat4 const& parentModelMatrix)
+			{
+				glm::mat4 const modelMatrix = calcModelMatrix(parentModelMatrix, node);
+				drawNode(node, modelMatrix);
+				for (auto const& child : node.children)
+				{
+					if (child) { renderNode(*child, drawNode, modelMatrix); }
+				}
+			}
+
 			void renderModel(
 				Model const& model,
-				DrawNodeCallback const& drawNode,
+				DrawNodeCallback const drawNode,
 				glm::mat4 const& parentModelMatrix)
 			{
-				if (!drawNode) { return; }
-				auto const modelMatrices = calcModelMatrices(model.rootNode, parentModelMatrix);
-				renderModelNode(model.rootNode, drawNode, modelMatrices);
+				if (!model.rootNode) { return; }
+				renderNode(*model.rootNode, drawNode, parentModelMatrix);
+			}
+
+
+
+			void forEachMeshInstanceOfNode(
+				Model const& model,
+				Node const& node,
+				glm::mat4 const& parentModelMatrix,
+				MeshInstanceCallback const visit)
+			{
+				glm::mat4 const modelMatrix = calcModelMatrix(parentModelMatrix, node);
+				for (auto const index : node.meshes)
+				{
+					visit(MeshInstance{ &model.meshes[index], modelMatrix });
+				}
+				for (auto const& child : node.children)
+				{
+					if (child) { forEachMeshInstanceOfNode(model, *child, modelMatrix, visit); }
+				}
+			}
+
+			void forEachMeshInstance(
+				Model const& model,
+				glm::mat4 const& parentModelMatrix,
+				MeshInstanceCallback const visit)
+			{
+				if (!model.rootNode) { return; }
+				forEachMeshInstanceOfNode(model, *model.rootNode, parentModelMatrix, visit);
+			}
+
+			void flattenModel(
+				Model const& model,
+				glm::mat4 const& parentModelMatrix,
+				std::vector<MeshInstance>& instances)
+			{
+				forEachMeshInstance(model, parentModelMatrix, [&](MeshInstance const& instance)
+				{
+					instances.push_back(instance);
+				});
 			}
 		}
 	}
@@ -0,0 +1,395 @@
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <immintrin.h>
+#include <limits>
+
+#include "be/jobs.hpp"
+#include "be/profile.hpp"
+#include "be/pink/occlusion.hpp"
+
+namespace be
+{
+	namespace pink
+	{
+		OcclusionBuffer::OcclusionBuffer(CreateInfo const& info)
+			: m_width(info.width)
+			, m_height(info.height)
+			, m_blocksX(info.width / blockSize)
+			, m_blocksY(info.height / blockSize)
+		{
+			if (info.width <= 0 || info.height <= 0 || info.width % blockSize != 0 || info.height % blockSize != 0)
+			{
+				throw OcclusionException("the width and height must be positive multiples of " + std::to_string(blockSize));
+			}
+			m_depth.assign(static_cast<std::size_t>(m_width) * m_height, 1.0f);
+			m_blockMaxDepth.assign(static_cast<std::size_t>(m_blocksX) * m_blocksY, 1.0f);
+		}
+
+		void OcclusionBuffer::reserve(std::size_t const triangles)
+		{
+			// each triangle makes at most one polygon.
+			m_polygons.reserve(triangles);
+		}
+
+		void OcclusionBuffer::begin(glm::mat4 const& viewProjection)
+		{
+			m_viewProjection = viewProjection;
+			m_polygons.clear();
+		}
+
+		void OcclusionBuffer::addOccluder(
+			std::span<glm::vec3 const> const positions,
+			std::span<std::uint32_t const> const indices,
+			glm::mat4 const& model)
+		{
+			glm::mat4 const mvp = m_viewProjection * model;
+			auto const corner = [&](std::size_t const index) {
+				if (index >= positions.size())
+				{
+					throw OcclusionException("an index is past the positions");
+				}
+				return mvp * glm::vec4(positions[index], 1.0f);
+			};
+
+			for (std::size_t t = 0; t + 2 < indices.size(); t += 3)
+			{
+				std::array<glm::vec4, 3> const triangle = { corner(indices[t]), corner(indices[t + 1]), corner(indices[t + 2]) };
+
+				// a quad: the next triangle runs back along one of this one's edges, u to v, and adds w between them.
+				bool quad = false;
+				for (int e = 0; e < 3 && !quad && t + 5 < indices.size(); ++e)
+				{
+					std::uint32_t const u = indices[t + e];
+					std::uint32_t const v = indices[t + (e + 1) % 3];
+					for (int f = 0; f < 3; ++f)
+					{
+						if (indices[t + 3 + f] != v || indices[t + 3 + (f + 1) % 3] != u) { continue; }
+						std::array<glm::vec4, 4> const corners = {
+							triangle[e],
+							corner(indices[t + 3 + (f + 2) % 3]),
+							triangle[(e + 1) % 3],
+							triangle[(e + 2) % 3],
+						};
+						quad = addPolygon(corners, true);
+						break;
+					}
+				}
+				if (quad)
+				{
+					t += 3;
+				}
+				else
+				{
+					addPolygon(triangle, false);
+				}
+			}
+		}
+
+		bool OcclusionBuffer::addPolygon(std::span<glm::vec4 const> const corners, bool const mustBeFlat)
+		{
+			// clipped to the near plane, z >= -w, which adds one corner to a convex polygon and at most
+			// one per corner to a quad that turns out not to be.
+			std::array<glm::vec3, 8> window;
+			int count = 0;
+			for (std::size_t v = 0; v < corners.size(); ++v)
+			{
+				glm::vec4 const& a = corners[v];
+				glm::vec4 const& b = corners[(v + 1) % corners.size()];
+				float const da = a.z + a.w;
+				float const db = b.z + b.w;
+				glm::vec4 c[2];
+				int n = 0;
+				if (da >= 0.0f) { c[n++] = a; }
+				if ((da >= 0.0f) != (db >= 0.0f)) { c[n++] = a + (b - a) * (da / (da - db)); }
+				for (int k = 0; k < n; ++k)
+				{
+					glm::vec3 const ndc = glm::vec3(c[k]) / c[k].w;
+					window[count++] = glm::vec3(
+						(ndc.x * 0.5f + 0.5f) * static_cast<float>(m_width),
+						(ndc.y * 0.5f + 0.5f) * static_cast<float>(m_height),
+						std::clamp(ndc.z * 0.5f + 0.5f, 0.0f, 1.0f));
+				}
+			}
+			if (count < 3) { return true; }
+			if (count > Polygon::maxEdges) { return !mustBeFlat; }
+
+			// every turn counter-clockwise, or it is back facing, edge on or, for a quad, not convex.
+			auto const cross = [&](int const k) {
+				glm::vec3 const& a = window[k];
+				glm::vec3 const& b = window[(k + 1) % count];
+				glm::vec3 const& c = window[(k + 2) % count];
+				return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			};
+			int plane = 1; // the fan triangle 0, plane, plane + 1 with the largest area gives the depth plane
+			float area = 0.0f;
+			for (int k = 0; k < count; ++k)
+			{
+				if (cross(k) < 0.0f) { return !mustBeFlat; }
+			}
+			for (int k = 1; k + 1 < count; ++k)
+			{
+				glm::vec3 const& a = window[0];
+				glm::vec3 const& b = window[k];
+				glm::vec3 const& c = window[k + 1];
+				float const fanArea = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+				if (fanArea > area) { area = fanArea; plane = k; }
+			}
+			if (!(area > 0.0f)) { return !mustBeFlat; }
+
+			glm::vec3 const& v0 = window[0];
+			glm::vec3 const& v1 = window[plane];
+			glm::vec3 const& v2 = window[plane + 1];
+			float const invArea = 1.0f / area;
+			float const dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) * invArea;
+			float const dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) * invArea;
+
+			// the plane is pushed back past any corner behind it. A quad that bends more than that allows is two triangles.
+			float behind = 0.0f;
+			float maxZ = 0.0f;
+			float minX = window[0].x, maxX = window[0].x, minY = window[0].y, maxY = window[0].y;
+			for (int k = 0; k < count; ++k)
+			{
+				glm::vec3 const& c = window[k];
+				behind = std::max(behind, c.z - (v0.z + dzdx * (c.x - v0.x) + dzdy * (c.y - v0.y)));
+				maxZ = std::max(maxZ, c.z);
+				minX = std::min(minX, c.x);
+				maxX = std::max(maxX, c.x);
+				minY = std::min(minY, c.y);
+				maxY = std::max(maxY, c.y);
+			}
+			if (mustBeFlat && behind > 1e-5f) { return false; }
+
+			// pixel centres at +0.5 inside the bounds.
+			Polygon polygon;
+			polygon.x0 = std::max(0, static_cast<int>(std::ceil(minX - 0.5f)));
+			polygon.x1 = std::min(m_width - 1, static_cast<int>(std::floor(maxX - 0.5f)));
+			polygon.y0 = std::max(0, static_cast<int>(std::ceil(minY - 0.5f)));
+			polygon.y1 = std::min(m_height - 1, static_cast<int>(std::floor(maxY - 0.5f)));
+			if (polygon.x0 > polygon.x1 || polygon.y0 > polygon.y1) { return true; }
+			float const px0 = static_cast<float>(polygon.x0) + 0.5f;
+			float const py0 = static_cast<float>(polygon.y0) + 0.5f;
+
+			// edge functions, positive inside. Each is lowered by the most it changes from a pixel's
+			// centre to a corner, so a pixel only counts if all of it is inside.
+			polygon.edgeCount = count;
+			for (int k = 0; k < count; ++k)
+			{
+				glm::vec3 const& a = window[k];
+				glm::vec3 const& b = window[(k + 1) % count];
+				float const ex = -(b.y - a.y);
+				float const ey = b.x - a.x;
+				polygon.edgeStepX[k] = ex;
+				polygon.edgeStepY[k] = ey;
+				polygon.edgeStart[k] = ex * (px0 - a.x) + ey * (py0 - a.y) - 0.5f * (std::abs(ex) + std::abs(ey));
+			}
+
+			// the farthest the plane gets within half a pixel of a centre, never past the polygon's far corner.
+			polygon.zStepX = dzdx;
+			polygon.zStepY = dzdy;
+			polygon.zStart = v0.z + dzdx * (px0 - v0.x) + dzdy * (py0 - v0.y) + 0.5f * (std::abs(dzdx) + std::abs(dzdy)) + behind;
+			polygon.maxZ = maxZ;
+			m_polygons.push_back(polygon);
+			return true;
+		}
+
+		void OcclusionBuffer::rasterize()
+		{
+			BE_PROFILE_SCOPE("be::pink::OcclusionBuffer::rasterize");
+			auto const start = std::chrono::steady_clock::now();
+
+			// one band per row of blocks, so no two jobs write the same pixel or block.
+			jobs::parallelFor(static_cast<std::size_t>(m_blocksY), [&](std::size_t const begin, std::size_t const end) {
+				for (std::size_t band = begin; band < end; ++band)
+				{
+					int const bandY0 = static_cast<int>(band) * blockSize;
+					int const bandY1 = bandY0 + blockSize; // exclusive
+					std::fill(
+						m_depth.begin() + static_cast<std::ptrdiff_t>(bandY0) * m_width,
+						m_depth.begin() + static_cast<std::ptrdiff_t>(bandY1) * m_width,
+						1.0f);
+
+					for (int bx = 0; bx < m_blocksX; ++bx)
+					{
+						m_blockMaxDepth[band * m_blocksX + bx] = 1.0f;
+					}
+
+					for (auto const& polygon : m_polygons)
+					{
+						int const y0 = std::max(bandY0, polygon.y0);
+						int const y1 = std::min(bandY1 - 1, polygon.y1);
+						if (y0 > y1) { continue; }
+						int const edgeCount = polygon.edgeCount;
+						float const dyBand = static_cast<float>(bandY0 - polygon.y0);
+
+						for (int bx = polygon.x0 / blockSize; bx <= polygon.x1 / blockSize; ++bx)
+						{
+							int const blockX0 = bx * blockSize;
+							float const dxBlock = static_cast<float>(blockX0 - polygon.x0);
+							float const last = static_cast<float>(blockSize - 1);
+
+							// each edge at the block's extreme pixel centres: below 0 at all of them misses
+							// the block, at least 0 at all of them covers it.
+							bool missed = false;
+							bool covered = true;
+							for (int k = 0; k < edgeCount; ++k)
+							{
+								float const e = polygon.edgeStart[k] + polygon.edgeStepX[k] * dxBlock + polygon.edgeStepY[k] * dyBand;
+								float const acrossX = polygon.edgeStepX[k] * last;
+								float const acrossY = polygon.edgeStepY[k] * last;
+								missed = missed || e + std::max(acrossX, 0.0f) + std::max(acrossY, 0.0f) < 0.0f;
+								covered = covered && e + std::min(acrossX, 0.0f) + std::min(acrossY, 0.0f) >= 0.0f;
+							}
+							if (missed) { continue; }
+
+							// a block already nearer everywhere than the polygon gets within it is left alone.
+							// The block's bound only tightens when the polygon covers all of it.
+							float& blockMax = m_blockMaxDepth[band * m_blocksX + bx];
+							float const z = polygon.zStart + polygon.zStepX * dxBlock + polygon.zStepY * dyBand;
+							float const acrossZX = polygon.zStepX * last;
+							float const acrossZY = polygon.zStepY * last;
+							float const nearestZ = std::min(z + std::min(acrossZX, 0.0f) + std::min(acrossZY, 0.0f), polygon.maxZ);
+							if (nearestZ >= blockMax) { continue; }
+							if (covered)
+							{
+								blockMax = std::min(blockMax, std::min(z + std::max(acrossZX, 0.0f) + std::max(acrossZY, 0.0f), polygon.maxZ));
+							}
+
+							// the block's two columns of four lanes, x - x0 in each.
+							__m128 const lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+							__m128 const dx[2] = {
+								_mm_add_ps(_mm_set1_ps(dxBlock), lanes),
+								_mm_add_ps(_mm_set1_ps(dxBlock + 4.0f), lanes),
+							};
+							__m128 edgeX[Polygon::maxEdges * 2];
+							for (int k = 0; k < edgeCount; ++k)
+							{
+								__m128 const stepX = _mm_set1_ps(polygon.edgeStepX[k]);
+								edgeX[k * 2] = _mm_mul_ps(stepX, dx[0]);
+								edgeX[k * 2 + 1] = _mm_mul_ps(stepX, dx[1]);
+							}
+							__m128 const zStepX = _mm_set1_ps(polygon.zStepX);
+							__m128 const zX[2] = { _mm_mul_ps(zStepX, dx[0]), _mm_mul_ps(zStepX, dx[1]) };
+							__m128 const maxZ = _mm_set1_ps(polygon.maxZ);
+							__m128 const zero = _mm_setzero_ps();
+
+							for (int y = y0; y <= y1; ++y)
+							{
+								float const dy = static_cast<float>(y - polygon.y0);
+								__m128 row[Polygon::maxEdges];
+								for (int k = 0; k < edgeCount; ++k)
+								{
+									row[k] = _mm_set1_ps(polygon.edgeStart[k] + polygon.edgeStepY[k] * dy);
+								}
+								__m128 const rowZ = _mm_set1_ps(polygon.zStart + polygon.zStepY * dy);
+								float* const depthRow = m_depth.data() + static_cast<std::size_t>(y) * m_width + blockX0;
+
+								for (int half = 0; half < 2; ++half)
+								{
+									__m128 mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+									if (!covered)
+									{
+										for (int k = 0; k < edgeCount; ++k)
+										{
+											mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(row[k], edgeX[k * 2 + half]), zero));
+										}
+										if (_mm_movemask_ps(mask) == 0) { continue; }
+									}
+									__m128 const depth = _mm_loadu_ps(depthRow + half * 4);
+									__m128 const nearer = _mm_min_ps(depth, _mm_min_ps(_mm_add_ps(rowZ, zX[half]), maxZ));
+									_mm_storeu_ps(depthRow + half * 4, _mm_or_ps(_mm_and_ps(mask, nearer), _mm_andnot_ps(mask, depth)));
+								}
+							}
+						}
+					}
+
+					for (int bx = 0; bx < m_blocksX; ++bx)
+					{
+						__m128 blockMax = _mm_setzero_ps();
+						for (int y = bandY0; y < bandY1; ++y)
+						{
+							float const* const depthRow = m_depth.data() + static_cast<std::size_t>(y) * m_width + bx * blockSize;
+							blockMax = _mm_max_ps(blockMax, _mm_max_ps(_mm_loadu_ps(depthRow), _mm_loadu_ps(depthRow + 4)));
+						}
+						blockMax = _mm_max_ps(blockMax, _mm_shuffle_ps(blockMax, blockMax, _MM_SHUFFLE(1, 0, 3, 2)));
+						blockMax = _mm_max_ps(blockMax, _mm_shuffle_ps(blockMax, blockMax, _MM_SHUFFLE(2, 3, 0, 1)));
+						m_blockMaxDepth[band * m_blocksX + bx] = _mm_cvtss_f32(blockMax);
+					}
+				}
+				});
+
+			std::uint32_t triangles = 0;
+			for (auto const& polygon : m_polygons)
+			{
+				triangles += static_cast<std::uint32_t>(polygon.edgeCount - 2);
+			}
+			m_stats.occluderTriangles = triangles;
+			m_stats.coveredPixels = static_cast<std::uint32_t>(std::count_if(m_depth.begin(), m_depth.end(),
+				[](float const z) { return z < 1.0f; }));
+			m_stats.rasterMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		bool OcclusionBuffer::isVisible(Aabb const& worldBounds) const noexcept
+		{
+			float minX = std::numeric_limits<float>::max();
+			float minY = std::numeric_limits<float>::max();
+			float maxX = std::numeric_limits<float>::lowest();
+			float maxY = std::numeric_limits<float>::lowest();
+			float minZ = std::numeric_limits<float>::max();
+			// one corner is projected, the other seven step from it along the projected edges.
+			glm::vec3 const size = worldBounds.max - worldBounds.min;
+			glm::vec4 const base = m_viewProjection * glm::vec4(worldBounds.min, 1.0f);
+			glm::vec4 const edgeX = m_viewProjection[0] * size.x;
+			glm::vec4 const edgeY = m_viewProjection[1] * size.y;
+			glm::vec4 const edgeZ = m_viewProjection[2] * size.z;
+			for (int corner = 0; corner < 8; ++corner)
+			{
+				glm::vec4 c = base;
+				if (corner & 1) { c += edgeX; }
+				if (corner & 2) { c += edgeY; }
+				if (corner & 4) { c += edgeZ; }
+				if (c.z < -c.w || c.w <= 0.0f) { return true; } // crosses the near plane
+				glm::vec3 const ndc = glm::vec3(c) / c.w;
+				minX = std::min(minX, ndc.x);
+				maxX = std::max(maxX, ndc.x);
+				minY = std::min(minY, ndc.y);
+				maxY = std::max(maxY, ndc.y);
+				minZ = std::min(minZ, ndc.z);
+			}
+			if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f || minZ > 1.0f) { return true; }
+			minZ = minZ * 0.5f + 0.5f;
+
+			// every pixel the rectangle touches.
+			auto const toPixel = [](float const ndc, int const size) {
+				return std::clamp(static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(size))), 0, size - 1);
+			};
+			int const x0 = toPixel(minX, m_width);
+			int const x1 = toPixel(maxX, m_width);
+			int const y0 = toPixel(minY, m_height);
+			int const y1 = toPixel(maxY, m_height);
+
+			for (int by = y0 / blockSize; by <= y1 / blockSize; ++by)
+			{
+				for (int bx = x0 / blockSize; bx <= x1 / blockSize; ++bx)
+				{
+					if (m_blockMaxDepth[static_cast<std::size_t>(by) * m_blocksX + bx] < minZ) { continue; }
+
+					int const py0 = std::max(y0, by * blockSize);
+					int const py1 = std::min(y1, by * blockSize + blockSize - 1);
+					int const px0 = std::max(x0, bx * blockSize);
+					int const px1 = std::min(x1, bx * blockSize + blockSize - 1);
+					for (int y = py0; y <= py1; ++y)
+					{
+						float const* const depthRow = m_depth.data() + static_cast<std::size_t>(y) * m_width;
+						for (int x = px0; x <= px1; ++x)
+						{
+							if (depthRow[x] >= minZ) { return true; }
+						}
+					}
+				}
+			}
+			return false;
+		}
+	}
+}
@@ -18,7 +18,8 @@ uniform mat4 vp;
 uniform float scale;
 void main()
 {
-	gl_Position = vp * vec4(p * scale, 1);
+	// z = w puts every vertex at the far plane.
+	gl_Position = (vp * vec4(p * scale, 1)).xyww;
 	d = p;
 }
 )__";
@@ -93,9 +94,10 @@ void main()
 			auto vertexArray = be::mem::gl::makeVertexArray();
 			BE_BIND_VERTEX_ARRAY_SCOPE(vertexArray.get());
 
-			auto vertexBuffer = be::mem::gl::makeBuffer();
+			auto vertexBuffer = be::mem::gl::makeBuffer(be::gpu_memory::Category::Mesh, "skybox");
 			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.get());
 			glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices[0], GL_STATIC_DRAW);
+			be::gpu_memory::setBufferBytes(vertexBuffer.get(), sizeof(skyboxVertices));
 
 			glEnableVertexAttribArray(0);
 			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), static_cast<GLvoid*>(0));
@@ -119,14 +121,29 @@ void main()
 			BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_CUBE_MAP, info.cubemap.get(), GL_TEXTURE0);
 			//glUniform1i(shader.uniformLoc_cubemap(), 0);
 
-			GLboolean const b = glIsEnabled(GL_DEPTH_TEST);
-			glDisable(GL_DEPTH_TEST);
-			CRESS_MOO_DEFER_CALLABLE([b]() noexcept { if (b) { glEnable(GL_DEPTH_TEST); } });
-
 			auto const& [vertexArray, vertexBuffer] = info.mesh.get();
 			BE_BIND_VERTEX_ARRAY_SCOPE(vertexArray.get());
 
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+			GLboolean const b = glIsEnabled(GL_DEPTH_TEST);
+			CRESS_MOO_DEFER_CALLABLE([b]() noexcept { if (b) { glEnable(GL_DEPTH_TEST); } else { glDisable(GL_DEPTH_TEST); } });
+			if (!info.atFarPlane)
+			{
+				glDisable(GL_DEPTH_TEST);
+				be::gl::drawArrays(GL_TRIANGLES, 0, 36);
+				return;
+			}
+
+			GLint depthFunc = GL_LESS;
+			GLboolean depthMask = GL_TRUE;
+			glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+			glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+			CRESS_MOO_DEFER_EXPRESSION(glDepthFunc(static_cast<GLenum>(depthFunc)));
+			CRESS_MOO_DEFER_EXPRESSION(glDepthMask(depthMask));
+
+			glEnable(GL_DEPTH_TEST);
+			glDepthFunc(GL_LEQUAL);
+			glDepthMask(GL_FALSE);
+			be::gl::drawArrays(GL_TRIANGLES, 0, 36);
 		}
 	}
 }
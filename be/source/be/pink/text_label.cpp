@@ -57,12 +57,17 @@ void main()
 				using Vertex = TextGlyphVertex;
 
 				TextGlyphMesh mesh;
+				// room for several frames of a screenful of text before the ring wraps.
+				mesh.vertexStream = be::gl::StreamBuffer({
+					.target = GL_ARRAY_BUFFER,
+					.capacity = 4096 * 4 * sizeof(Vertex) * 4,
+					.label = "text glyph quads",
+					});
+
 				mesh.vertexArray = be::mem::gl::makeVertexArray();
 				BE_BIND_VERTEX_ARRAY_SCOPE(mesh.vertexArray.get());
 
-				mesh.vertexBuffer = be::mem::gl::makeBuffer();
-				glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer.get());
-				glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * 4, nullptr, GL_DYNAMIC_DRAW);
+				glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexStream.buffer());
 
 				glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<GLvoid const*>(offsetof(Vertex, position)));
 				glEnableVertexAttribArray(0);
@@ -73,8 +78,10 @@ void main()
 				return mesh;
 			}
 
-			void renderTextLabel(RenderTextLabelInfo const& info)
+			RenderTextLabelStatus renderTextLabel(RenderTextLabelInfo const& info)
 			{
+				BE_GL_STATS_PASS("text label");
+
 				auto const& shader = info.shader.get();
 				auto& mesh = info.mesh.get();
 				auto const& font = info.font.get();
@@ -96,68 +103,83 @@ void main()
 				be::gl::uniformMat4(loc.mvp, mvp);
 				be::gl::uniformVec4(loc.color, color);
 
-				BE_BIND_VERTEX_ARRAY_SCOPE(mesh.vertexArray.get());
-				glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer.get());
-
-				// iterate through the characters of the text
-				glm::vec2 pos = glm::vec2();
-				//std::vector<size_t> unwrittenIndices;
-				bool failed = false;
-				for (size_t i = 0; i < text.size(); ++i)
+				// lays out the glyphs of the text, calling emit(glyph, xpos, ypos, width, height) for each.
+				// returns false if the font lacks a character.
+				auto const layout = [&](auto&& emit) -> bool
 				{
-					auto const c = text[i];
-					if (c == '\n')
+					glm::vec2 pos = glm::vec2();
+					bool complete = true;
+					for (size_t i = 0; i < text.size(); ++i)
 					{
-						pos.x = 0.0f;
-						pos.y -= lineHeight;
-						continue;
-					}
-					else if (c == '\t')
-					{
-						pos.x += tabWidth;
-						continue;
+						auto const c = text[i];
+						if (c == '\n')
+						{
+							pos.x = 0.0f;
+							pos.y -= lineHeight;
+							continue;
+						}
+						else if (c == '\t')
+						{
+							pos.x += tabWidth;
+							continue;
+						}
+
+						auto const it = font.glyphs.find(c);
+						if (it == font.glyphs.cend())
+						{
+							complete = false;
+							continue;
+						}
+
+						be::ft::FontGlyph const& glyph = it->second;
+						CRESS_MOO_DEFER_EXPRESSION(pos.x += glyph.advance * scale.x);
+
+						float const xpos = pos.x
+							+ glyph.bearing.x * scale.x;
+						float const ypos = pos.y
+							- (glyph.size.y - glyph.bearing.y) * scale.y;
+						float const glyphWidth = glyph.size.x * scale.x;
+						float const glyphHeight = glyph.size.y * scale.y;
+
+						emit(glyph, xpos, ypos, glyphWidth, glyphHeight);
 					}
+					return complete;
+				};
+
+				std::size_t glyphCount = 0;
+				bool const failed = !layout([&](be::ft::FontGlyph const&, float, float, float, float) { ++glyphCount; });
 
-					auto const it = font.find(c);
-					if (it == font.cend())
+				if (glyphCount > 0)
+				{
+					// upload every quad of the label at once, then draw them from the stream in one call.
+					auto const allocation = mesh.vertexStream.allocate(
+						static_cast<GLsizeiptr>(glyphCount * 4 * sizeof(TextGlyphVertex)),
+						sizeof(TextGlyphVertex));
 					{
-						//unwrittenIndices.push_back(i);
-						failed = true;
-						continue;
+						auto* vertices = static_cast<TextGlyphVertex*>(allocation.data);
+						layout([&](be::ft::FontGlyph const& glyph, float xpos, float ypos, float glyphWidth, float glyphHeight) {
+							auto const& uv0 = glyph.atlasMin;
+							auto const& uv1 = glyph.atlasMax;
+							*vertices++ = { { xpos, ypos + glyphHeight }, { uv0.x, uv0.y } };
+							*vertices++ = { { xpos, ypos }, { uv0.x, uv1.y } };
+							*vertices++ = { { xpos + glyphWidth, ypos }, { uv1.x, uv1.y } };
+							*vertices++ = { { xpos + glyphWidth, ypos + glyphHeight }, { uv1.x, uv0.y } };
+						});
 					}
+					mesh.vertexStream.commit(allocation);
 
-					be::ft::FontGlyph const& glyph = it->second;
-					CRESS_MOO_DEFER_EXPRESSION(pos.x += glyph.advance * scale.x);
-
-					float const xpos = pos.x
-						+ glyph.bearing.x * scale.x;
-					float const ypos = pos.y
-						- (glyph.size.y - glyph.bearing.y) * scale.y;
-					float const glyphWidth = glyph.size.x * scale.x;
-					float const glyphHeight = glyph.size.y * scale.y;
-
-					TextGlyphVertex const vertices[4] = { TextGlyphVertex
-					{ { xpos, ypos + glyphHeight }, { 0, 0 } },
-					{ { xpos, ypos }, { 0, 1 } },
-					{ { xpos + glyphWidth, ypos }, { 1, 1 } },
-					{ { xpos + glyphWidth, ypos + glyphHeight }, { 1, 0 } },
-					};
+					BE_BIND_VERTEX_ARRAY_SCOPE(mesh.vertexArray.get());
 
-					// update VBO for this glyph.
-					// WARNING: assumes buffer is GL_DYNAMIC_DRAW.
-					glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
+					BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, font.atlas.get(), GL_TEXTURE0);
+					be::gl::drawArrays(
+						GL_QUADS,
+						static_cast<GLint>(allocation.offset / sizeof(TextGlyphVertex)),
+						static_cast<GLsizei>(glyphCount * 4));
 
-					// render the glyph over the mesh
-					BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, glyph.texture.get(), GL_TEXTURE0);
-
-					glDrawArrays(GL_QUADS, 0, 4);
+					mesh.vertexStream.fence();
 				}
 
-				//if (!unwrittenIndices.empty())
-				if (failed)
-				{
-					throw RenderTextLabelException(text);
-				}
+				return failed ? RenderTextLabelStatus::MissingCharacters : RenderTextLabelStatus::Ok;
 			}
 		}
 	}
@@ -21,10 +21,15 @@ layout(location = 1) out vec3 v2fNormal;
 layout(location = 2) out vec2 v2fTexCoords;
 
 uniform mat4 mvp;
+uniform mat4 model = mat4(1.0f);
+uniform vec4 clipPlane = vec4(0.0f); // zero clips nothing
+
+invariant gl_Position; // so its depth can be matched exactly by other programs, e.g. a depth prepass
 
 void main()
 {
 	gl_Position = mvp * vec4(inPosition, 1);
+	gl_ClipDistance[0] = dot(clipPlane, model * vec4(inPosition, 1));
 	v2fPosition = gl_Position.xyz;
 	v2fNormal = inNormal;
 	v2fTexCoords = inTexCoords;
@@ -53,6 +58,8 @@ void main()
 			m_uniformLocations.mvp = glGetUniformLocation(program, "mvp");
 			m_uniformLocations.tex = glGetUniformLocation(program, "tex");
 			m_uniformLocations.color = glGetUniformLocation(program, "color");
+			m_uniformLocations.model = glGetUniformLocation(program, "model");
+			m_uniformLocations.clipPlane = glGetUniformLocation(program, "clipPlane");
 
 			BE_USE_PROGRAM_SCOPE(program);
 			glUniform1i(m_uniformLocations.tex, 0);
@@ -66,6 +73,18 @@ void main()
 			auto const& loc = shader.uniformLocations();
 			be::gl::uniformMat4(loc.mvp, info.mvp);
 			be::gl::uniformVec4(loc.color, info.color);
+			if (info.clipPlane)
+			{
+				assert(info.model);
+				be::gl::uniformVec4(loc.clipPlane, *info.clipPlane);
+				be::gl::uniformMat4(loc.model, *info.model);
+				shader.m_clipPlaneSet = true;
+			}
+			else if (shader.m_clipPlaneSet)
+			{
+				be::gl::uniformVec4(loc.clipPlane, glm::vec4(0.0f));
+				shader.m_clipPlaneSet = false;
+			}
 
 			BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, info.tex, GL_TEXTURE0);
 
@@ -0,0 +1,361 @@
+/*
+//	be/profile
+//	Scoped CPU timing zones with Chrome trace export and per-zone statistics.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+#include "be/profile.hpp"
+
+namespace be
+{
+	namespace profile
+	{
+		namespace detail
+		{
+			enum class EventType : std::uint8_t
+			{
+				Begin,
+				End,
+			};
+
+			struct Event
+			{
+				char const* name{};
+				std::int64_t timestampNs{};
+				EventType type{};
+			};
+
+			// One slot of a ring buffer.
+			// Fields are relaxed atomics so a reader may race the owning writer;
+			// torn slots are discarded by re-checking the head after reading.
+			struct Slot
+			{
+				std::atomic<char const*> name{};
+				std::atomic<std::int64_t> timestampNs{};
+				std::atomic<EventType> type{};
+			};
+
+			// Single-producer ring buffer owned by one thread. Old events are overwritten.
+			struct ThreadBuffer
+			{
+				static constexpr std::uint64_t capacity = 1 << 14;
+				static constexpr std::uint64_t mask = capacity - 1;
+
+				std::array<Slot, capacity> slots;
+				std::atomic<std::uint64_t> head{ 0 };
+				std::uint32_t threadIndex{};
+
+				// consumer state, guarded by s_mutex.
+				std::uint64_t statsCursor = 0;
+				std::vector<Event> openZones;
+
+				void push(char const* name, EventType type) noexcept
+				{
+					auto const h = head.load(std::memory_order_relaxed);
+					// the previous head is visible before any of this slot's new contents.
+					std::atomic_thread_fence(std::memory_order_release);
+					auto& slot = slots[h & mask];
+					slot.name.store(name, std::memory_order_relaxed);
+					slot.timestampNs.store(now(), std::memory_order_relaxed);
+					slot.type.store(type, std::memory_order_relaxed);
+					head.store(h + 1, std::memory_order_release);
+				}
+
+				/*
+				//	Copies the events in the range [first, current head) that are still intact.
+				//	Returns the index one past the last event read.
+				*/
+				std::uint64_t read(std::uint64_t first, std::vector<Event>& out) const
+				{
+					auto const h = head.load(std::memory_order_acquire);
+					first = std::max(first, h > capacity ? h - capacity : 0);
+					auto const begin = out.size();
+					for (auto i = first; i < h; ++i)
+					{
+						auto const& slot = slots[i & mask];
+						out.push_back(Event{
+							slot.name.load(std::memory_order_relaxed),
+							slot.timestampNs.load(std::memory_order_relaxed),
+							slot.type.load(std::memory_order_relaxed),
+							});
+					}
+
+					// anything the writer lapped while we were copying is unreliable,
+					// including the slot of index h2, which it may be writing right now.
+					std::atomic_thread_fence(std::memory_order_acquire);
+					auto const h2 = head.load(std::memory_order_relaxed);
+					auto const oldestValid = h2 >= capacity ? h2 - capacity + 1 : 0;
+					if (oldestValid > first)
+					{
+						auto const torn = static_cast<std::size_t>(std::min(oldestValid, h) - first);
+						out.erase(out.begin() + begin, out.begin() + begin + torn);
+					}
+					return h;
+				}
+
+				static std::int64_t now() noexcept;
+			};
+
+			struct ZoneAccumulator
+			{
+				static constexpr std::size_t windowSize = 256;
+
+				std::uint64_t count = 0;
+				double totalMs = 0.0;
+				double maxMs = 0.0;
+				std::array<float, windowSize> recentMs{};
+				std::size_t recentNext = 0;
+
+				void add(double ms) noexcept
+				{
+					++count;
+					totalMs += ms;
+					maxMs = std::max(maxMs, ms);
+					recentMs[recentNext % windowSize] = static_cast<float>(ms);
+					++recentNext;
+				}
+
+				ZoneStats summarise(std::string_view name) const
+				{
+					ZoneStats stats;
+					stats.name = name;
+					stats.count = count;
+					stats.meanMs = count > 0 ? totalMs / static_cast<double>(count) : 0.0;
+					stats.maxMs = maxMs;
+
+					auto const n = std::min(recentNext, windowSize);
+					if (n > 0)
+					{
+						std::array<float, windowSize> sorted = recentMs;
+						auto const k = std::min(n - 1, (n * 95) / 100);
+						std::nth_element(sorted.begin(), sorted.begin() + k, sorted.begin() + n);
+						stats.p95Ms = sorted[k];
+					}
+					return stats;
+				}
+			};
+
+
+
+			static auto const s_epoch = std::chrono::steady_clock::now();
+
+			static std::mutex s_mutex;
+			static std::vector<std::shared_ptr<ThreadBuffer>> s_threadBuffers;
+			static std::unordered_map<std::string_view, ZoneAccumulator> s_zones;
+
+			static constexpr std::size_t maxFrameHistory = 1024;
+			static std::deque<std::int64_t> s_frameStarts;
+			static std::atomic<std::uint64_t> s_frameIndex{ 0 };
+
+
+
+			std::int64_t ThreadBuffer::now() noexcept
+			{
+				return std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - s_epoch).count();
+			}
+
+			static ThreadBuffer* getThreadBuffer() noexcept
+			{
+				thread_local ThreadBuffer* t_buffer = nullptr;
+				if (!t_buffer)
+				{
+					try
+					{
+						auto buffer = std::make_shared<ThreadBuffer>();
+						std::scoped_lock<std::mutex> _{ s_mutex };
+						buffer->threadIndex = static_cast<std::uint32_t>(s_threadBuffers.size());
+						t_buffer = buffer.get();
+						s_threadBuffers.push_back(std::move(buffer));
+					}
+					catch (...)
+					{
+						return nullptr;
+					}
+				}
+				return t_buffer;
+			}
+
+			void beginZone(char const* name) noexcept
+			{
+				if (auto* const buffer = getThreadBuffer()) { buffer->push(name, EventType::Begin); }
+			}
+
+			void endZone(char const* name) noexcept
+			{
+				if (auto* const buffer = getThreadBuffer()) { buffer->push(name, EventType::End); }
+			}
+
+			// requires s_mutex to be locked.
+			static void accumulate(ThreadBuffer& buffer, std::vector<Event>& scratch)
+			{
+				scratch.clear();
+				auto const before = buffer.statsCursor;
+				auto const h = buffer.head.load(std::memory_order_acquire);
+				if (h > ThreadBuffer::capacity && before < h - ThreadBuffer::capacity)
+				{
+					// events were lost; the open zones can no longer be matched.
+					buffer.openZones.clear();
+				}
+				buffer.statsCursor = buffer.read(before, scratch);
+
+				for (auto const& e : scratch)
+				{
+					if (EventType::Begin == e.type)
+					{
+						buffer.openZones.push_back(e);
+					}
+					else if (!buffer.openZones.empty() && buffer.openZones.back().name == e.name)
+					{
+						auto const begin = buffer.openZones.back();
+						buffer.openZones.pop_back();
+						double const ms = static_cast<double>(e.timestampNs - begin.timestampNs) * 1e-6;
+						s_zones[std::string_view(e.name)].add(ms);
+					}
+				}
+			}
+
+			static void writeJsonString(std::ostream& out, char const* s)
+			{
+				out << '"';
+				for (; s && *s; ++s)
+				{
+					char const c = *s;
+					if (c == '"' || c == '\\') { out << '\\' << c; }
+					else if (static_cast<unsigned char>(c) < 0x20) { out << ' '; }
+					else { out << c; }
+				}
+				out << '"';
+			}
+		}
+
+
+
+		void markFrame() noexcept
+		{
+			try
+			{
+				std::scoped_lock<std::mutex> _{ detail::s_mutex };
+
+				detail::s_frameStarts.push_back(detail::ThreadBuffer::now());
+				while (detail::s_frameStarts.size() > detail::maxFrameHistory)
+				{
+					detail::s_frameStarts.pop_front();
+				}
+				++detail::s_frameIndex;
+
+				thread_local std::vector<detail::Event> scratch;
+				for (auto const& buffer : detail::s_threadBuffers)
+				{
+					detail::accumulate(*buffer, scratch);
+				}
+			}
+			catch (...) {}
+		}
+
+		std::uint64_t getFrameIndex() noexcept
+		{
+			return detail::s_frameIndex.load();
+		}
+
+		std::optional<ZoneStats> getZoneStats(std::string_view name)
+		{
+			std::scoped_lock<std::mutex> _{ detail::s_mutex };
+			if (auto const it = detail::s_zones.find(name);
+				it != detail::s_zones.end())
+			{
+				return it->second.summarise(it->first);
+			}
+			return std::nullopt;
+		}
+
+		std::vector<ZoneStats> getAllZoneStats()
+		{
+			std::vector<ZoneStats> result;
+			{
+				std::scoped_lock<std::mutex> _{ detail::s_mutex };
+				result.reserve(detail::s_zones.size());
+				for (auto const& [name, zone] : detail::s_zones)
+				{
+					result.push_back(zone.summarise(name));
+				}
+			}
+			std::sort(result.begin(), result.end(), [](ZoneStats const& a, ZoneStats const& b) { return a.name < b.name; });
+			return result;
+		}
+
+		void resetZoneStats() noexcept
+		{
+			std::scoped_lock<std::mutex> _{ detail::s_mutex };
+			detail::s_zones.clear();
+		}
+
+		void writeChromeTrace(std::ostream& out, std::size_t frameCount)
+		{
+			std::vector<std::pair<std::uint32_t, std::vector<detail::Event>>> threads;
+			std::vector<std::int64_t> frameStarts;
+			{
+				std::scoped_lock<std::mutex> _{ detail::s_mutex };
+				auto const& frames = detail::s_frameStarts;
+				auto const n = std::min(frameCount, frames.size());
+				frameStarts.assign(frames.end() - n, frames.end());
+				for (auto const& buffer : detail::s_threadBuffers)
+				{
+					auto& [index, events] = threads.emplace_back();
+					index = buffer->threadIndex;
+					buffer->read(0, events);
+				}
+			}
+
+			out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+			bool first = true;
+			auto const writeEvent = [&](char const* name, char phase, std::int64_t ns, std::uint32_t tid) {
+				if (!first) { out << ",\n"; }
+				first = false;
+				out << "{\"name\":";
+				detail::writeJsonString(out, name);
+				out << ",\"ph\":\"" << phase << "\",\"ts\":" << (static_cast<double>(ns) * 1e-3)
+					<< ",\"pid\":1,\"tid\":" << tid;
+				if (phase == 'i') { out << ",\"s\":\"g\""; }
+				out << '}';
+			};
+
+			std::int64_t const windowStart = frameStarts.empty() ? 0 : frameStarts.front();
+			for (auto const& ns : frameStarts)
+			{
+				writeEvent("frame", 'i', ns, 0);
+			}
+			for (auto const& [tid, events] : threads)
+			{
+				for (auto const& e : events)
+				{
+					if (e.timestampNs < windowStart) { continue; }
+					writeEvent(e.name, detail::EventType::Begin == e.type ? 'B' : 'E', e.timestampNs, tid);
+				}
+			}
+			out << "]}\n";
+		}
+
+		void writeChromeTraceFile(std::string const& filePath, std::size_t frameCount)
+		{
+			std::ofstream file{ filePath, std::ios::out | std::ios::trunc };
+			if (!file.good())
+			{
+				throw ProfileException("could not open trace file at: " + filePath);
+			}
+			writeChromeTrace(file, frameCount);
+		}
+	}
+}
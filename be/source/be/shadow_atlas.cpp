@@ -0,0 +1,270 @@
+/*
+//	be/shadow_atlas
+//	One depth texture shared by every shadowed light, partitioned into tiles by a quadtree.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "be/gl_stats.hpp"
+#include "be/shadow_atlas.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		static bool isPowerOfTwo(int const n) noexcept
+		{
+			return n > 0 && (n & (n - 1)) == 0;
+		}
+
+		// the depth of the quadtree whose nodes are |tileSize| across.
+		static std::size_t calcDepth(int const size, int const tileSize) noexcept
+		{
+			std::size_t depth = 0;
+			for (int s = size; s > tileSize; s /= 2) { ++depth; }
+			return depth;
+		}
+
+		QuadtreeAllocator::QuadtreeAllocator(int const size, int const minTileSize)
+			: m_size(size)
+			, m_minTileSize(minTileSize)
+		{
+			if (!isPowerOfTwo(size) || !isPowerOfTwo(minTileSize) || minTileSize > size)
+			{
+				throw ShadowAtlasException("the size and minimum tile size must be powers of two, the tile no larger");
+			}
+			m_free.resize(calcDepth(size, minTileSize) + 1);
+			clear();
+		}
+
+		void QuadtreeAllocator::clear() noexcept
+		{
+			for (auto& level : m_free) { level.clear(); }
+			if (!m_free.empty())
+			{
+				m_free[0].push_back(ShadowTile{ 0, 0, m_size });
+			}
+		}
+
+		std::optional<ShadowTile> QuadtreeAllocator::allocate(int const tileSize)
+		{
+			if (m_free.empty()) { return std::nullopt; }
+
+			int size = m_minTileSize;
+			while (size < tileSize && size < m_size) { size *= 2; }
+			std::size_t const depth = calcDepth(m_size, size);
+
+			// the smallest free node that is big enough.
+			std::size_t from = depth + 1;
+			while (from > 0 && m_free[from - 1].empty()) { --from; }
+			if (from == 0) { return std::nullopt; }
+			--from;
+
+			ShadowTile tile = m_free[from].back();
+			m_free[from].pop_back();
+
+			// split down to the wanted size, keeping the first quadrant and freeing the other three.
+			for (std::size_t d = from; d < depth; ++d)
+			{
+				int const half = tile.size / 2;
+				m_free[d + 1].push_back(ShadowTile{ tile.x + half, tile.y + half, half });
+				m_free[d + 1].push_back(ShadowTile{ tile.x, tile.y + half, half });
+				m_free[d + 1].push_back(ShadowTile{ tile.x + half, tile.y, half });
+				tile.size = half;
+			}
+			return tile;
+		}
+
+		// Room for a few uploads before the ring wraps onto a table still being read.
+		static GLsizeiptr streamCapacity(GLsizeiptr const bytesPerUpload)
+		{
+			GLsizeiptr const uploadsInFlight = 4;
+			return (bytesPerUpload * uploadsInFlight + 255) / 256 * 256;
+		}
+
+		ShadowAtlas::ShadowAtlas(CreateInfo const& info)
+			: m_allocator(info.size, info.minTileSize)
+			, m_maxTileSize(std::clamp(info.maxTileSize, info.minTileSize, info.size))
+			, m_extraTexelsPerLight(info.extraTexelsPerLight)
+			, m_maxLights(info.maxLights)
+		{
+			if (info.maxLights <= 0 || info.extraTexelsPerLight < 0)
+			{
+				throw ShadowAtlasException("maxLights must be positive and extraTexelsPerLight not negative");
+			}
+
+			m_frameBuffer = mem::gl::makeFrameBuffer(gpu_memory::Category::RenderTarget, info.label);
+			m_texture = mem::gl::makeTexture(gpu_memory::Category::RenderTarget, info.label);
+			{
+				BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, m_texture.get(), GL_TEXTURE0);
+				be::gl::texImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
+					info.size, info.size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+				gpu_memory::setTextureLevel(m_texture.get(), 0, info.size, info.size, GL_DEPTH_COMPONENT);
+				// tiles are sampled with texelFetch or clamped inside their rect, so neighbours never blend in.
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			}
+			{
+				BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, m_frameBuffer.get());
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_texture.get(), 0);
+				glDrawBuffer(GL_NONE);
+				glReadBuffer(GL_NONE);
+
+				GLenum const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+				if (status != GL_FRAMEBUFFER_COMPLETE)
+				{
+					throw ShadowAtlasException("incomplete framebuffer " + std::to_string(static_cast<int>(status)));
+				}
+			}
+
+			auto const tableBytes = static_cast<GLsizeiptr>(m_maxLights) * texelsPerLight()
+				* static_cast<GLsizeiptr>(sizeof(glm::vec4));
+			m_lightStream = StreamBuffer({
+				.target = GL_TEXTURE_BUFFER,
+				.capacity = streamCapacity(tableBytes),
+				.label = "shadow atlas lights",
+				});
+
+			// a view of the stream's storage, which is already counted.
+			m_lightTexture = mem::gl::makeTexture(gpu_memory::Category::Streaming, "shadow atlas lights");
+			be::gl::bindTexture(GL_TEXTURE_BUFFER, m_lightTexture.get());
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_lightStream.buffer());
+			be::gl::bindTexture(GL_TEXTURE_BUFFER, 0);
+
+			m_tiles.reserve(static_cast<std::size_t>(m_maxLights));
+			m_order.reserve(static_cast<std::size_t>(m_maxLights));
+			m_lightTexels.reserve(static_cast<std::size_t>(m_maxLights) * texelsPerLight());
+		}
+
+		void ShadowAtlas::assign(std::span<float const> const wantedTexels)
+		{
+			if (wantedTexels.size() > static_cast<std::size_t>(m_maxLights))
+			{
+				throw ShadowAtlasException("more than maxLights lights");
+			}
+
+			int const minTileSize = m_allocator.minTileSize();
+			m_tiles.clear();
+			m_order.clear();
+			for (std::size_t i = 0; i < wantedTexels.size(); ++i)
+			{
+				// rounded down, so no light is given more texels than it asked for beyond the minimum.
+				int size = minTileSize;
+				float const wanted = std::isfinite(wantedTexels[i]) ? wantedTexels[i] : 0.0f;
+				while (size * 2 <= m_maxTileSize && static_cast<float>(size * 2) <= wanted) { size *= 2; }
+				m_tiles.push_back(ShadowTile{ 0, 0, size });
+				m_order.push_back(i);
+			}
+
+			// largest first, so every free node is at least as big as what is left to place.
+			std::stable_sort(m_order.begin(), m_order.end(), [this](std::size_t const a, std::size_t const b) {
+				return m_tiles[a].size > m_tiles[b].size;
+				});
+
+			m_allocator.clear();
+			for (auto const i : m_order)
+			{
+				auto& tile = m_tiles[i];
+				int size = tile.size;
+				tile = ShadowTile{};
+				for (; size >= minTileSize; size /= 2)
+				{
+					if (auto const allocated = m_allocator.allocate(size))
+					{
+						tile = *allocated;
+						break;
+					}
+				}
+			}
+		}
+
+		glm::vec4 ShadowAtlas::calcTileRect(ShadowTile const& tile) const noexcept
+		{
+			float const scale = 1.0f / static_cast<float>(m_allocator.size());
+			return glm::vec4(
+				static_cast<float>(tile.x) * scale,
+				static_cast<float>(tile.y) * scale,
+				static_cast<float>(tile.size) * scale,
+				static_cast<float>(tile.size) * scale);
+		}
+
+		void ShadowAtlas::beginDepthPass()
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer.get());
+			glViewport(0, 0, m_allocator.size(), m_allocator.size());
+			glDisable(GL_SCISSOR_TEST); // glClear is scissored
+			glDepthMask(GL_TRUE);
+			glClear(GL_DEPTH_BUFFER_BIT);
+
+			glEnable(GL_DEPTH_TEST);
+			glDepthFunc(GL_LESS);
+			// the viewport alone lets wide lines and points spill into the neighbouring tiles.
+			glEnable(GL_SCISSOR_TEST);
+		}
+
+		void ShadowAtlas::setTileViewport(ShadowTile const& tile) noexcept
+		{
+			glViewport(tile.x, tile.y, tile.size, tile.size);
+			glScissor(tile.x, tile.y, tile.size, tile.size);
+		}
+
+		void ShadowAtlas::endDepthPass() noexcept
+		{
+			glDisable(GL_SCISSOR_TEST);
+			glDisable(GL_DEPTH_TEST);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+
+		void ShadowAtlas::clearLights() noexcept
+		{
+			m_lightTexels.clear();
+		}
+
+		glm::vec4* ShadowAtlas::addLight(glm::mat4 const& viewProjection, std::size_t const index)
+		{
+			if (lightCount() >= static_cast<std::size_t>(m_maxLights))
+			{
+				throw ShadowAtlasException("more than maxLights lights in the table");
+			}
+
+			bool const hasTile = index < m_tiles.size() && m_tiles[index].size > 0;
+			m_lightTexels.push_back(viewProjection[0]);
+			m_lightTexels.push_back(viewProjection[1]);
+			m_lightTexels.push_back(viewProjection[2]);
+			m_lightTexels.push_back(viewProjection[3]);
+			m_lightTexels.push_back(hasTile ? calcTileRect(m_tiles[index]) : glm::vec4(0.0f));
+			m_lightTexels.resize(m_lightTexels.size() + m_extraTexelsPerLight);
+			return m_lightTexels.data() + m_lightTexels.size() - m_extraTexelsPerLight;
+		}
+
+		std::size_t ShadowAtlas::lightCount() const noexcept
+		{
+			return m_lightTexels.size() / static_cast<std::size_t>(texelsPerLight());
+		}
+
+		void ShadowAtlas::uploadLights()
+		{
+			if (m_lightTexels.empty())
+			{
+				m_lightBase = 0;
+				return;
+			}
+			auto const lights = m_lightStream.write(
+				m_lightTexels.data(),
+				static_cast<GLsizeiptr>(m_lightTexels.size() * sizeof(glm::vec4)),
+				sizeof(glm::vec4));
+			m_lightBase = static_cast<GLint>(lights.offset / static_cast<GLintptr>(sizeof(glm::vec4)));
+		}
+
+		void ShadowAtlas::fenceLights()
+		{
+			m_lightStream.fence();
+		}
+	}
+}
@@ -0,0 +1,195 @@
+/*
+//	be/stream_buffer
+//	Ring buffer for uploading per-frame data without stalling on data the GPU is still reading.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <cstring>
+#include <utility>
+
+#include "be/stream_buffer.hpp"
+
+namespace be
+{
+	namespace gl
+	{
+		static std::uint64_t alignUp(std::uint64_t const position, std::uint64_t const alignment) noexcept
+		{
+			return (position + alignment - 1) / alignment * alignment;
+		}
+
+		StreamBuffer::StreamBuffer(CreateInfo const& info)
+			: m_target(info.target)
+			, m_capacity(info.capacity)
+		{
+			if (info.capacity <= 0 || info.capacity % 256 != 0)
+			{
+				throw StreamBufferException("capacity must be a positive multiple of 256");
+			}
+
+			m_buffer = mem::gl::makeBuffer(gpu_memory::Category::Streaming, info.label);
+			glBindBuffer(m_target, m_buffer.get());
+			CRESS_MOO_DEFER_EXPRESSION(glBindBuffer(m_target, 0));
+
+			if (info.allowPersistentMapping && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage))
+			{
+				GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				glBufferStorage(m_target, m_capacity, nullptr, flags);
+				m_persistentData = static_cast<std::uint8_t*>(glMapBufferRange(m_target, 0, m_capacity, flags));
+				if (!m_persistentData)
+				{
+					throw StreamBufferException("glMapBufferRange failed for a persistent mapping");
+				}
+			}
+			else
+			{
+				glBufferData(m_target, m_capacity, nullptr, GL_STREAM_DRAW);
+			}
+			gpu_memory::setBufferBytes(m_buffer.get(), static_cast<std::uint64_t>(m_capacity));
+		}
+
+		StreamBuffer::StreamBuffer(StreamBuffer&& other) noexcept
+			: m_buffer(std::move(other.m_buffer))
+			, m_target(other.m_target)
+			, m_capacity(std::exchange(other.m_capacity, 0))
+			, m_persistentData(std::exchange(other.m_persistentData, nullptr))
+			, m_head(std::exchange(other.m_head, 0))
+			, m_fenced(std::exchange(other.m_fenced, 0))
+			, m_regions(std::move(other.m_regions))
+			, m_firstRegion(std::exchange(other.m_firstRegion, 0))
+			, m_stalls(std::exchange(other.m_stalls, 0))
+		{
+			other.m_regions.clear();
+		}
+
+		StreamBuffer& StreamBuffer::operator=(StreamBuffer&& other) noexcept
+		{
+			if (this != &other)
+			{
+				m_regions.clear();
+				m_buffer = std::move(other.m_buffer);
+				m_target = other.m_target;
+				m_capacity = std::exchange(other.m_capacity, 0);
+				m_persistentData = std::exchange(other.m_persistentData, nullptr);
+				m_head = std::exchange(other.m_head, 0);
+				m_fenced = std::exchange(other.m_fenced, 0);
+				m_regions = std::move(other.m_regions);
+				m_firstRegion = std::exchange(other.m_firstRegion, 0);
+				m_stalls = std::exchange(other.m_stalls, 0);
+				other.m_regions.clear();
+			}
+			return *this;
+		}
+
+		StreamAllocation StreamBuffer::allocate(GLsizeiptr const size, GLsizeiptr const alignment)
+		{
+			if (!m_buffer.get())
+			{
+				throw StreamBufferException("allocate called on an empty stream buffer");
+			}
+			if (size <= 0 || size > m_capacity || alignment <= 0 || (alignment & (alignment - 1)) != 0)
+			{
+				throw StreamBufferException("invalid allocation size or alignment");
+			}
+
+			auto const capacity = static_cast<std::uint64_t>(m_capacity);
+			auto const bytes = static_cast<std::uint64_t>(size);
+
+			std::uint64_t position = alignUp(m_head, static_cast<std::uint64_t>(alignment));
+			if (position % capacity + bytes > capacity)
+			{
+				// would run off the end; start the next lap instead.
+				position = alignUp(position, capacity);
+			}
+			GLintptr const offset = static_cast<GLintptr>(position % capacity);
+
+			StreamAllocation allocation;
+			allocation.offset = offset;
+			allocation.size = size;
+
+			if (isPersistent())
+			{
+				// the ring bytes of [position, position + size) were last used by [limit - size, limit).
+				std::uint64_t const limit = position + bytes > capacity ? position + bytes - capacity : 0;
+				if (m_head != m_fenced && m_fenced < limit)
+				{
+					throw StreamBufferException("more than the capacity was allocated without a fence");
+				}
+
+				while (m_firstRegion < m_regions.size() && m_regions[m_firstRegion].begin < limit)
+				{
+					GLsync const sync = m_regions[m_firstRegion].fence.get();
+					GLenum result = glClientWaitSync(sync, 0, 0);
+					if (GL_TIMEOUT_EXPIRED == result)
+					{
+						++m_stalls;
+						do
+						{
+							result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+						} while (GL_TIMEOUT_EXPIRED == result);
+					}
+					++m_firstRegion;
+				}
+
+				allocation.data = m_persistentData + offset;
+			}
+			else
+			{
+				glBindBuffer(m_target, m_buffer.get());
+				if (position / capacity != m_head / capacity)
+				{
+					// orphan: the driver keeps the old storage alive for in-flight draws.
+					glBufferData(m_target, m_capacity, nullptr, GL_STREAM_DRAW);
+				}
+				allocation.data = glMapBufferRange(m_target, offset, size,
+					GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+				if (!allocation.data)
+				{
+					throw StreamBufferException("glMapBufferRange failed");
+				}
+			}
+
+			m_head = position + bytes;
+			return allocation;
+		}
+
+		void StreamBuffer::commit(StreamAllocation const& allocation) noexcept
+		{
+			if (!isPersistent() && allocation.data)
+			{
+				glBindBuffer(m_target, m_buffer.get());
+				glUnmapBuffer(m_target);
+			}
+
+			// writes through a persistent mapping bypass the glBufferSubData hook.
+			if (isStatsEnabled())
+			{
+				detail::count(&FrameStats::bufferUploadBytes, static_cast<std::uint64_t>(allocation.size));
+			}
+		}
+
+		StreamAllocation StreamBuffer::write(void const* const data, GLsizeiptr const size, GLsizeiptr const alignment)
+		{
+			auto const allocation = allocate(size, alignment);
+			std::memcpy(allocation.data, data, static_cast<std::size_t>(size));
+			commit(allocation);
+			return allocation;
+		}
+
+		void StreamBuffer::fence()
+		{
+			if (!isPersistent() || m_head == m_fenced) { return; }
+
+			if (m_firstRegion > 0 && m_firstRegion * 2 >= m_regions.size())
+			{
+				// drop the waited regions. erase keeps the capacity.
+				m_regions.erase(m_regions.begin(), m_regions.begin() + m_firstRegion);
+				m_firstRegion = 0;
+			}
+			m_regions.push_back(Region{ mem::gl::makeFenceSync(), m_fenced, m_head });
+			m_fenced = m_head;
+		}
+	}
+}
@@ -0,0 +1,429 @@
+/*
+//	be/texture_stream
+//	Loads textures in the background, coarsest mip first, and keeps their memory within a budget.
+//
+//	Elijah Shadbolt
+//	2019
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "be/error_stats.hpp"
+#include "be/gl_stats.hpp"
+#include "be/soil.hpp"
+#include "be/texture_stream.hpp"
+
+namespace be
+{
+	namespace texture_stream
+	{
+		BE_ERROR_SITE(decodeErrors, "texture stream decode");
+
+		namespace
+		{
+			int calcLevelCount(int const width, int const height) noexcept
+			{
+				int count = 1;
+				for (int size = std::max(width, height); size > 1; size /= 2) { ++count; }
+				return count;
+			}
+
+			int levelSize(int const size, int const level) noexcept
+			{
+				return std::max(1, size >> level);
+			}
+
+			// Halves an RGBA8 image with a 2x2 box filter. Odd edges repeat their last texel.
+			std::vector<std::uint8_t> downsample(std::vector<std::uint8_t> const& src, int const width, int const height)
+			{
+				int const w = std::max(1, width / 2);
+				int const h = std::max(1, height / 2);
+				std::vector<std::uint8_t> dst(static_cast<std::size_t>(w) * h * 4);
+				for (int y = 0; y < h; ++y)
+				{
+					int const y0 = std::min(2 * y, height - 1);
+					int const y1 = std::min(2 * y + 1, height - 1);
+					for (int x = 0; x < w; ++x)
+					{
+						int const x0 = std::min(2 * x, width - 1);
+						int const x1 = std::min(2 * x + 1, width - 1);
+						for (int c = 0; c < 4; ++c)
+						{
+							auto const at = [&](int sx, int sy) { return src[(static_cast<std::size_t>(sy) * width + sx) * 4 + c]; };
+							dst[(static_cast<std::size_t>(y) * w + x) * 4 + c] = static_cast<std::uint8_t>(
+								(at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1) + 2) / 4);
+						}
+					}
+				}
+				return dst;
+			}
+		}
+
+		TextureStreamer::TextureStreamer(CreateInfo const& info)
+			: m_info(info)
+		{
+			if (m_info.budgetBytes == 0)
+			{
+				throw TextureStreamException("budgetBytes must be greater than 0");
+			}
+			m_thread = std::thread([this]() { runStreamingThread(); });
+		}
+
+		TextureStreamer::~TextureStreamer() noexcept
+		{
+			{
+				std::lock_guard lock{ m_mutex };
+				m_stopping = true;
+			}
+			m_wake.notify_all();
+			m_thread.join();
+		}
+
+		TextureHandle TextureStreamer::load(std::filesystem::path const& filename)
+		{
+			return load(filename, TextureInfo{});
+		}
+
+		TextureHandle TextureStreamer::load(std::filesystem::path const& filename, TextureInfo const& info)
+		{
+			Entry e;
+			e.texture = mem::gl::makeTexture(gpu_memory::Category::Texture, info.label);
+			e.filename = filename;
+			e.wantedTop = 0;
+			e.requestedTexels = info.initialTexels;
+
+			{
+				BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, e.texture.get(), GL_TEXTURE0);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, info.wrap);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, info.wrap);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+				be::gl::texImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &m_info.placeholderColor);
+				gpu_memory::setTextureLevel(e.texture.get(), 0, 1, 1, GL_RGBA8);
+			}
+
+			auto const index = static_cast<std::uint32_t>(m_entries.size());
+			m_entries.push_back(std::move(e));
+			return TextureHandle{ index };
+		}
+
+		GLuint TextureStreamer::texture(TextureHandle const handle) const
+		{
+			return entry(handle).texture.get();
+		}
+
+		void TextureStreamer::request(TextureHandle const handle, float const texels)
+		{
+			auto& e = entry(handle);
+			e.requestedTexels = std::max(e.requestedTexels, texels);
+		}
+
+		void TextureStreamer::update()
+		{
+			++m_frame;
+			step(m_info.uploadBytesPerFrame);
+		}
+
+		void TextureStreamer::flush()
+		{
+			while (true)
+			{
+				{
+					std::unique_lock lock{ m_mutex };
+					m_decodeDone.wait(lock, [&]() { return m_pendingDecodes == 0; });
+				}
+				step(std::numeric_limits<std::size_t>::max());
+
+				std::lock_guard lock{ m_mutex };
+				if (m_pendingDecodes == 0) { return; }
+			}
+		}
+
+		void TextureStreamer::step(std::size_t const uploadLimit)
+		{
+			{
+				std::lock_guard lock{ m_mutex };
+				std::swap(m_arrived, m_decoded);
+			}
+			for (auto& decoded : m_arrived)
+			{
+				receive(std::move(decoded));
+			}
+			m_arrived.clear();
+
+			m_uploadOrder.clear();
+			for (std::uint32_t i = 0; i < m_entries.size(); ++i)
+			{
+				auto& e = m_entries[i];
+				if (e.failed) { continue; }
+
+				if (e.requestedTexels > 0.0f)
+				{
+					e.lastRequestFrame = m_frame;
+					if (e.levelCount > 0)
+					{
+						e.wantedTop = levelFor(e, e.requestedTexels);
+						e.requestedTexels = 0.0f;
+					}
+				}
+
+				bool const needsMore = e.levelCount == 0 || e.residentTop > e.wantedTop;
+				if (!needsMore)
+				{
+					// done; the pixels can be decoded again if a finer level is wanted later.
+					e.decoded.levels.clear();
+					e.decoded.levels.shrink_to_fit();
+					continue;
+				}
+
+				bool const haveNextLevel = !e.decoded.levels.empty() && e.decoded.firstLevel < e.residentTop;
+				if (haveNextLevel)
+				{
+					m_uploadOrder.push_back(i);
+				}
+				else if (!e.decodePending)
+				{
+					e.decodePending = true;
+					float const texels = e.levelCount == 0
+						? e.requestedTexels
+						: static_cast<float>(std::max(levelSize(e.width, e.wantedTop), levelSize(e.height, e.wantedTop)));
+					{
+						std::lock_guard lock{ m_mutex };
+						m_requests.push_back(DecodeRequest{ i, e.filename, texels });
+						++m_pendingDecodes;
+					}
+					m_wake.notify_one();
+				}
+			}
+
+			// the most recently requested first, then the furthest from what they want.
+			std::sort(m_uploadOrder.begin(), m_uploadOrder.end(), [&](std::uint32_t const a, std::uint32_t const b)
+				{
+					auto const& ea = m_entries[a];
+					auto const& eb = m_entries[b];
+					if (ea.lastRequestFrame != eb.lastRequestFrame) { return ea.lastRequestFrame > eb.lastRequestFrame; }
+					return ea.residentTop - ea.wantedTop > eb.residentTop - eb.wantedTop;
+				});
+
+			std::size_t uploaded = 0;
+			for (auto const i : m_uploadOrder)
+			{
+				auto& e = m_entries[i];
+				while (e.residentTop > e.wantedTop && e.decoded.firstLevel < e.residentTop)
+				{
+					std::size_t const bytes = levelBytes(e, e.residentTop - 1);
+					if (uploaded > 0 && uploaded + bytes > uploadLimit) { return; }
+					if (!makeRoom(i, bytes)) { break; }
+					uploadNextLevel(e);
+					uploaded += bytes;
+				}
+			}
+		}
+
+		TextureStreamStats TextureStreamer::stats() const
+		{
+			TextureStreamStats s;
+			s.textures = m_entries.size();
+			s.residentBytes = m_residentBytes;
+			s.budgetBytes = m_info.budgetBytes;
+			{
+				std::lock_guard lock{ m_mutex };
+				s.pendingDecodes = m_pendingDecodes;
+			}
+			s.uploadedBytes = m_uploadedBytes;
+			s.evictedBytes = m_evictedBytes;
+			return s;
+		}
+
+		void TextureStreamer::runStreamingThread() noexcept
+		{
+			std::unique_lock lock{ m_mutex };
+			while (true)
+			{
+				m_wake.wait(lock, [&]() { return m_stopping || !m_requests.empty(); });
+				if (m_stopping) { return; }
+
+				auto const request = std::move(m_requests.front());
+				m_requests.pop_front();
+				lock.unlock();
+
+				Decoded decoded;
+				decoded.index = request.index;
+				try
+				{
+					auto const filename = request.filename.string();
+					auto image = be::soil::load_image(filename.c_str(), SOIL_LOAD_RGBA);
+					decoded.width = image.width;
+					decoded.height = image.height;
+
+					std::size_t const bytes = static_cast<std::size_t>(image.width) * image.height * 4;
+					std::vector<std::uint8_t> level(image.data.get(), image.data.get() + bytes);
+					image.data.reset();
+
+					// keep the level that covers the request and everything coarser.
+					int const maxSize = std::max(image.width, image.height);
+					int firstLevel = 0;
+					while (request.texels > 0.0f && (maxSize >> (firstLevel + 1)) >= request.texels) { ++firstLevel; }
+					decoded.firstLevel = firstLevel;
+
+					int const levelCount = calcLevelCount(image.width, image.height);
+					for (int l = 0; l < levelCount; ++l)
+					{
+						if (l > 0)
+						{
+							level = downsample(level, levelSize(image.width, l - 1), levelSize(image.height, l - 1));
+						}
+						if (l >= firstLevel) { decoded.levels.push_back(level); }
+					}
+				}
+				catch (std::exception const& e)
+				{
+					decoded.levels.clear();
+					decoded.error = e.what();
+				}
+
+				lock.lock();
+				m_decoded.push_back(std::move(decoded));
+				--m_pendingDecodes;
+				m_decodeDone.notify_all();
+			}
+		}
+
+		TextureStreamer::Entry& TextureStreamer::entry(TextureHandle const handle)
+		{
+			if (handle.index >= m_entries.size()) { throw TextureStreamException("invalid texture handle"); }
+			return m_entries[handle.index];
+		}
+
+		TextureStreamer::Entry const& TextureStreamer::entry(TextureHandle const handle) const
+		{
+			if (handle.index >= m_entries.size()) { throw TextureStreamException("invalid texture handle"); }
+			return m_entries[handle.index];
+		}
+
+		int TextureStreamer::levelFor(Entry const& e, float const texels) noexcept
+		{
+			// the coarsest level at least |texels| across.
+			int const maxSize = std::max(e.width, e.height);
+			int level = 0;
+			while (level + 1 < e.levelCount && (maxSize >> (level + 1)) >= texels) { ++level; }
+			return level;
+		}
+
+		std::size_t TextureStreamer::levelBytes(Entry const& e, int const level) noexcept
+		{
+			return static_cast<std::size_t>(levelSize(e.width, level)) * levelSize(e.height, level) * 4;
+		}
+
+		void TextureStreamer::receive(Decoded&& decoded)
+		{
+			auto& e = m_entries[decoded.index];
+			e.decodePending = false;
+			if (!decoded.error.empty())
+			{
+				e.failed = true;
+				decodeErrors.report(decoded.error);
+				return;
+			}
+			if (e.levelCount == 0)
+			{
+				e.width = decoded.width;
+				e.height = decoded.height;
+				e.levelCount = calcLevelCount(e.width, e.height);
+				e.residentTop = e.levelCount;
+				e.wantedTop = levelFor(e, e.requestedTexels);
+				e.requestedTexels = 0.0f;
+			}
+			e.decoded = std::move(decoded);
+		}
+
+		void TextureStreamer::uploadNextLevel(Entry& e)
+		{
+			int const level = e.residentTop - 1;
+			auto const& pixels = e.decoded.levels[static_cast<std::size_t>(level - e.decoded.firstLevel)];
+
+			BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, e.texture.get(), GL_TEXTURE0);
+			if (e.residentTop == e.levelCount)
+			{
+				// the first real level replaces the placeholder.
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, e.levelCount - 1);
+				if (level != 0)
+				{
+					be::gl::texImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+					gpu_memory::setTextureLevel(e.texture.get(), 0, 0, 0, GL_RGBA8);
+				}
+			}
+			be::gl::texImage2D(GL_TEXTURE_2D, level, GL_RGBA8,
+				levelSize(e.width, level), levelSize(e.height, level), 0,
+				GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+			gpu_memory::setTextureLevel(e.texture.get(), level, levelSize(e.width, level), levelSize(e.height, level), GL_RGBA8);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+
+			e.residentTop = level;
+			std::size_t const bytes = levelBytes(e, level);
+			m_residentBytes += bytes;
+			m_uploadedBytes += bytes;
+		}
+
+		void TextureStreamer::evictTopLevel(Entry& e)
+		{
+			int const level = e.residentTop;
+
+			BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, e.texture.get(), GL_TEXTURE0);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+			// a zero sized image releases the level's storage.
+			be::gl::texImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			gpu_memory::setTextureLevel(e.texture.get(), level, 0, 0, GL_RGBA8);
+
+			e.residentTop = level + 1;
+			std::size_t const bytes = levelBytes(e, level);
+			m_residentBytes -= bytes;
+			m_evictedBytes += bytes;
+		}
+
+		bool TextureStreamer::makeRoom(std::uint32_t const forIndex, std::size_t const bytes)
+		{
+			auto const& target = m_entries[forIndex];
+			while (m_residentBytes + bytes > m_info.budgetBytes)
+			{
+				// evict from textures holding finer levels than they want first, then the least recently requested.
+				Entry* victim = nullptr;
+				for (std::uint32_t i = 0; i < m_entries.size(); ++i)
+				{
+					auto& e = m_entries[i];
+					// the coarsest level stays, so every loaded texture keeps something to show.
+					if (i == forIndex || e.residentTop >= e.levelCount - 1) { continue; }
+					bool const excess = e.residentTop < e.wantedTop;
+					if (!excess && e.lastRequestFrame >= target.lastRequestFrame) { continue; }
+
+					if (!victim)
+					{
+						victim = &e;
+						continue;
+					}
+					bool const victimExcess = victim->residentTop < victim->wantedTop;
+					if (excess != victimExcess)
+					{
+						if (excess) { victim = &e; }
+					}
+					else if (e.lastRequestFrame != victim->lastRequestFrame)
+					{
+						if (e.lastRequestFrame < victim->lastRequestFrame) { victim = &e; }
+					}
+					else if (levelBytes(e, e.residentTop) > levelBytes(*victim, victim->residentTop))
+					{
+						victim = &e;
+					}
+				}
+				if (!victim) { return false; }
+				evictTopLevel(*victim);
+			}
+			return true;
+		}
+	}
+}
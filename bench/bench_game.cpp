@@ -0,0 +1,251 @@
+
+#include "assets.hpp"
+#include "bench_game.hpp"
+
+namespace bench
+{
+	BenchGame::BenchGame(CreateInfo const& info)
+		: params(info.params)
+		, warmupFrames(info.warmupFrames)
+		, samples(&info.samples.get())
+		, passTotals(&info.passTotals.get())
+	{
+		skyboxCubemap = resources.add(be::basic_assets::textures::loadSkyboxCubemap(example::assets::basicAssetsFolder));
+		skyboxMesh = be::pink::makeSkyboxMesh();
+
+		quadMesh = resources.add(be::basic_assets::meshes::makeQuadMesh());
+		cubeMesh = resources.add(be::basic_assets::meshes::makeCubeMesh());
+
+		meshPool = be::gl::MeshPool({ .drawIdAttribute = be::gl::basicDrawIdAttribute });
+		quadRange = be::basic_assets::meshes::addQuadMesh(meshPool);
+
+		textureStreamer.emplace(be::texture_stream::TextureStreamer::CreateInfo{});
+		groundTexture = example::loadGroundTexture(*textureStreamer);
+		flagTexture = resources.add(be::basic_assets::textures::loadFlagTexture(example::assets::basicAssetsFolder));
+
+		picketFenceModel = example::loadPicketFenceModel(&meshPool);
+
+		textGlyphMesh = be::pink::text_label::makeTextGlyphMesh();
+		FT_UInt const fontSize = 24;
+		arialFont = be::basic_assets::fonts::loadArialFont(example::assets::basicAssetsFolder, fontSize, 0);
+		lineHeight = static_cast<float>(fontSize) * 1.5f;
+		tabWidth = static_cast<float>(4 * arialFont.glyphs.at(' ').advance);
+
+		audio = be::mem::fmod::System_Create();
+		be::mem::fmod::require_ok(audio->setOutput(FMOD_OUTPUTTYPE_NOSOUND), "[bench] FMOD::System::setOutput failed");
+		be::mem::fmod::require_ok(audio->init(30, FMOD_INIT_NORMAL, nullptr), "[bench] FMOD::System::init failed");
+
+		shadowScene.emplace(typename example::ShadowScene::CreateInfo{
+			.audio = *audio,
+			.quadCount = params.quads,
+			.fenceCount = params.fences,
+			.labelCount = params.labels,
+			.shadowMapSize = params.shadowMapSize,
+			.extraLightCount = params.shadowLights,
+			.pointLight = params.pointLight,
+			.clusteredLightCount = params.clusteredLights,
+			.occluderCount = params.occluders,
+			.filteredShadows = !params.hardShadows,
+			.depthPrepass = params.depthPrepass,
+			// far enough back to see the procedural grids.
+			.cameraPosition = glm::vec3(0.0f, 8.0f, 30.0f),
+			});
+
+		if (params.water)
+		{
+			waterScene.emplace(example::WaterScene::CreateInfo{
+				.targetScale = params.waterTargetScale,
+				.refreshInterval = params.waterRefreshInterval,
+				});
+		}
+
+		this->onWindowSizeChanged(be::Application::getWindowWidth(), be::Application::getWindowHeight());
+		this->update(0.0f);
+
+		be::gl::setStatsEnabled(true);
+		static_cast<void>(be::gl::setGpuTimingEnabled(true)); // gpuMsMean stays 0 without timer queries
+	}
+
+	BenchGame::~BenchGame() noexcept
+	{
+		static_cast<void>(be::gl::setGpuTimingEnabled(false));
+		be::gl::setStatsEnabled(false);
+	}
+
+	void BenchGame::Update(float deltaTime)
+	{
+		shadowScene->update({
+			.deltaTime = deltaTime,
+			.input = input,
+			.mousePositionInWindow = mousePosition,
+			.previousMousePositionInWindow = previousMousePosition,
+			.windowSize = windowSize,
+			.windowAspect = windowAspect,
+			.isFullScreen = false,
+			.lineHeight = lineHeight,
+			.audio = *audio
+			});
+
+		if (waterScene)
+		{
+			waterScene->update({
+				.windowSize = windowSize,
+				.windowAspect = windowAspect,
+				});
+		}
+
+		previousMousePosition = mousePosition;
+		be::input::afterUpdate(input);
+	}
+
+	void BenchGame::Render(float interpolation)
+	{
+		using be::frame_pacing::Clock;
+
+		auto frameStart = Clock::now();
+		auto frameAllocations = be::alloc_counter::getAllocationCount();
+		be::gl::resetFrameStats();
+
+		textureStreamer->request(groundTexture, shadowScene->calcGroundTextureTexels(windowSize));
+		textureStreamer->update();
+		if (frameIndex == warmupFrames)
+		{
+			// measured frames must not depend on how fast the streaming thread decodes. The first sample
+			// spans from this frame's start, so it starts again after the wait and the decoder's allocations.
+			textureStreamer->flush();
+			frameStart = Clock::now();
+			frameAllocations = be::alloc_counter::getAllocationCount();
+		}
+
+		if (waterScene)
+		{
+			// drawn first so the shadow scene's colour pass is what ends up on screen.
+			waterScene->render({
+				.windowSize = windowSize,
+				.windowAspect = windowAspect,
+
+				.resources = resources,
+
+				.quadMesh = quadMesh,
+				.unlitShader = unlitShader,
+				.flagTexture = flagTexture,
+
+				.skyboxShader = skyboxShader,
+				.skyboxMesh = skyboxMesh,
+				.skyboxCubemap = skyboxCubemap,
+
+				.waterShader = waterShader,
+				.waterTexture = flagTexture,
+				});
+		}
+
+		shadowScene->render({
+			.interpolation = interpolation,
+			.windowSize = windowSize,
+
+			.resources = resources,
+
+			.skyboxShader = skyboxShader,
+			.skyboxMesh = skyboxMesh,
+			.skyboxCubemap = skyboxCubemap,
+
+			.shadowShader = shadowShader,
+			.evsmBlurShader = evsmBlurShader,
+			.pointShadowShader = pointShadowShader,
+
+			.lightGizmoShader = lightGizmoShader,
+
+			.quadMesh = quadMesh,
+			.cubeMesh = cubeMesh,
+
+			.meshPool = meshPool,
+			.quadRange = quadRange,
+
+			.depthMapQuadShader = depthMapQuadShader,
+
+			.groundShader = groundShader,
+			.groundTexture = textureStreamer->texture(groundTexture),
+
+			.unlitShader = unlitShader,
+			.flagTexture = flagTexture,
+
+			.picketFenceShader = picketFenceShader,
+			.picketFenceModel = picketFenceModel,
+
+			.textLabelShader = textLabelShader,
+			.textGlyphMesh = textGlyphMesh,
+			.font = arialFont,
+			.lineHeight = lineHeight,
+			.tabWidth = tabWidth,
+			});
+
+		auto const submitEnd = Clock::now();
+
+		if (previousFrameStart && frameIndex > warmupFrames)
+		{
+			samples->push_back(FrameSample{
+				.frameMs = std::chrono::duration<double, std::milli>(frameStart - *previousFrameStart).count(),
+				.submitMs = std::chrono::duration<double, std::milli>(submitEnd - frameStart).count(),
+				.heapAllocations = frameAllocations - previousFrameAllocations,
+				.gpuMemoryBytes = be::gpu_memory::getTotals().bytes,
+				.gl = be::gl::getFrameStats(),
+				.clusters = shadowScene->lightClusterStats(),
+				.occlusion = shadowScene->occlusionStats(),
+				});
+
+			for (auto const& pass : be::gl::getAllPassStats())
+			{
+				auto const it = std::find_if(passTotals->begin(), passTotals->end(),
+					[&](be::gl::PassStats const& p) { return p.name == pass.name; });
+				if (it == passTotals->end()) { passTotals->push_back(pass); }
+				else { it->stats += pass.stats; }
+			}
+		}
+		previousFrameStart = frameStart;
+		previousFrameAllocations = frameAllocations;
+		++frameIndex;
+	}
+
+	void BenchGame::OnMousePositionInWindowChanged(int x, int y)
+	{
+		mousePosition.x = x;
+		mousePosition.y = y;
+	}
+
+	void BenchGame::OnKeyGoingDown(unsigned char key)
+	{
+		be::input::informGoingDown(input.keyboardKeys, key);
+	}
+
+	void BenchGame::OnKeyGoingUp(unsigned char key)
+	{
+		be::input::informGoingUp(input.keyboardKeys, key);
+	}
+
+	void BenchGame::OnSpecialGoingDown(int keycode)
+	{
+		be::input::informGoingDown(input.specialKeys, keycode);
+	}
+
+	void BenchGame::OnSpecialGoingUp(int keycode)
+	{
+		be::input::informGoingUp(input.specialKeys, keycode);
+	}
+
+	void BenchGame::OnMouseButtonGoingDown(int button)
+	{
+		be::input::informGoingDown(input.mouseButtons, button);
+	}
+
+	void BenchGame::OnMouseButtonGoingUp(int button)
+	{
+		be::input::informGoingUp(input.mouseButtons, button);
+	}
+
+	void BenchGame::OnWindowSizeChanged(int width, int height)
+	{
+		windowSize.x = width;
+		windowSize.y = height;
+		windowAspect = static_cast<float>(windowSize.x) / static_cast<float>(windowSize.y);
+	}
+}
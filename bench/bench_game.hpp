@@ -0,0 +1,136 @@
+/*
+//	be_bench
+//	A headless game that renders a procedurally scaled copy of the example scenes
+//	and records per-frame measurements.
+*/
+
+#pragma once
+
+#include "shadow_scene.hpp"
+#include "water_scene.hpp"
+
+namespace bench
+{
+	struct SceneParams
+	{
+		int quads = 2;
+		int fences = 1;
+		int labels = 1;
+		int shadowMapSize = 1024;
+		int shadowLights = 0; // fixed shadowed lights sharing the atlas with the moving one
+		bool water = false;
+		float waterTargetScale = 0.5f; // the reflection and refraction targets' size as a fraction of the window's
+		int waterRefreshInterval = 1; // frames between reflection and refraction refreshes; 0 only when the camera moves
+		bool depthPrepass = false;
+		bool hardShadows = false;
+		bool pointLight = false;
+		int clusteredLights = 0; // unshadowed point lights binned into froxels each frame, 0 to 1024
+		int occluders = 0; // nearest fences rasterised on the CPU to cull what they hide; 0 is off
+	};
+
+	// One entry per measured frame.
+	struct FrameSample
+	{
+		double frameMs{}; // start of the previous frame to the start of this one
+		double submitMs{}; // CPU time spent issuing this frame's GL calls
+		std::uint64_t heapAllocations{}; // over the same span as frameMs. 0 unless be::alloc_counter::isEnabled
+		std::uint64_t gpuMemoryBytes{}; // held by tracked GL objects after submitting. see be/gpu_memory.hpp
+		be::gl::FrameStats gl{};
+		be::gl::LightClusterStats clusters{};
+		be::pink::OcclusionStats occlusion{};
+	};
+
+	class BenchGame final : public be::Game
+	{
+	private:
+		SceneParams params;
+		int warmupFrames{};
+		std::vector<FrameSample>* samples;
+		std::vector<be::gl::PassStats>* passTotals;
+
+		int frameIndex = 0;
+		std::optional<be::frame_pacing::Clock::time_point> previousFrameStart;
+		std::uint64_t previousFrameAllocations{};
+
+		be::Input input;
+		glm::ivec2 mousePosition{};
+		glm::ivec2 previousMousePosition{};
+		glm::ivec2 windowSize{};
+		float windowAspect = 1.0f;
+
+
+		// RESOURCES
+
+		std::optional<be::texture_stream::TextureStreamer> textureStreamer; // declared before the textures it streams
+		be::gl::ResourceRegistry resources; // owns what the handles below refer to
+
+		be::pink::SkyboxShader skyboxShader;
+		be::pink::SkyboxMesh skyboxMesh;
+		be::gl::TextureHandle skyboxCubemap;
+
+		example::ShadowShader shadowShader;
+		example::EvsmBlurShader evsmBlurShader;
+		example::PointShadowShader pointShadowShader;
+
+		example::LightGizmoShader lightGizmoShader;
+
+		be::gl::MeshHandle quadMesh;
+		be::gl::MeshHandle cubeMesh;
+
+		be::gl::MeshPool meshPool; // declared before the models that live in it
+		be::gl::MeshRange quadRange;
+
+		example::DepthMapQuadShader depthMapQuadShader;
+
+		example::GroundShader groundShader;
+		be::texture_stream::TextureHandle groundTexture;
+
+		be::pink::UnlitShader unlitShader;
+		be::gl::TextureHandle flagTexture;
+
+		example::PicketFenceShader picketFenceShader;
+		be::pink::model::Model picketFenceModel;
+
+		be::pink::text_label::TextLabelShader textLabelShader;
+		be::pink::text_label::TextGlyphMesh textGlyphMesh;
+		be::ft::Font arialFont;
+		float lineHeight{};
+		float tabWidth{};
+
+		example::WaterShader waterShader;
+
+		be::mem::fmod::System audio;
+
+
+		// SCENES
+
+		std::optional<example::ShadowScene> shadowScene;
+		std::optional<example::WaterScene> waterScene;
+
+	public:
+		struct CreateInfo
+		{
+			SceneParams params;
+			int warmupFrames = 0; // frames rendered before samples are recorded
+			be::need_ref<std::vector<FrameSample>> samples;
+			be::need_ref<std::vector<be::gl::PassStats>> passTotals; // summed over the measured frames
+		};
+		explicit BenchGame(CreateInfo const& info);
+		~BenchGame() noexcept final;
+		BenchGame(BenchGame const&) = delete;
+		BenchGame& operator=(BenchGame const&) = delete;
+
+	private:
+		void Update(float deltaTime) final;
+		void Render(float interpolation) final;
+		// only replayed input arrives here, see --replay.
+		void OnMousePositionInWindowChanged(int x, int y) final;
+		void OnKeyGoingDown(unsigned char key) final;
+		void OnKeyGoingUp(unsigned char key) final;
+		void OnSpecialGoingDown(int keycode) final;
+		void OnSpecialGoingUp(int keycode) final;
+		void OnMouseButtonGoingDown(int button) final;
+		void OnMouseButtonGoingUp(int button) final;
+		void OnWindowSizeChanged(int width, int height) final;
+	};
+}
@@ -0,0 +1,128 @@
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ostream>
+#include <thread>
+#include <be/be.hpp>
+
+#include "job_scaling.hpp"
+
+namespace bench
+{
+	namespace
+	{
+		// A hierarchy one level deep: each object's world matrix is its parent's times its own TRS,
+		// then its bounds are tested against a frustum, as the scene prepare phase does.
+		struct Workload
+		{
+			std::vector<be::pink::BasicTransform> locals;
+			std::vector<glm::mat4> parents;
+			std::vector<glm::mat4> worlds;
+			std::vector<unsigned char> visible;
+			be::pink::Frustum frustum;
+
+			explicit Workload(std::size_t const count)
+				: locals(count)
+				, parents(16)
+				, worlds(count)
+				, visible(count)
+			{
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					auto& t = locals[i];
+					float const f = static_cast<float>(i);
+					t.translation = glm::vec3(std::fmod(f * 0.37f, 50.0f) - 25.0f, std::fmod(f * 0.11f, 10.0f), -std::fmod(f * 0.53f, 80.0f));
+					t.rotation = be::pink::quatFromEulerDeg({ 0.0f, std::fmod(f * 7.0f, 360.0f), 0.0f });
+					t.scale = 1.0f + std::fmod(f * 0.01f, 1.0f);
+				}
+				for (std::size_t i = 0; i < parents.size(); ++i)
+				{
+					parents[i] = be::pink::calcTrs(glm::vec3(static_cast<float>(i), 0.0f, 0.0f), glm::quat(), 1.0f);
+				}
+				frustum = be::pink::calcFrustum(
+					glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f)
+					* glm::lookAt(glm::vec3(0.0f, 5.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+			}
+
+			void run(std::size_t const begin, std::size_t const end) noexcept
+			{
+				be::pink::Aabb const bounds{ glm::vec3(-0.5f), glm::vec3(0.5f) };
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					worlds[i] = parents[i % parents.size()] * be::pink::calcTrs(locals[i]);
+					visible[i] = be::pink::isVisible(frustum, be::pink::transformAabb(bounds, worlds[i])) ? 1 : 0;
+				}
+			}
+		};
+	}
+
+	std::vector<JobScalingResult> runJobScaling(JobScalingParams const& params)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		unsigned const maxThreads = params.maxThreads > 0
+			? params.maxThreads
+			: std::max(1u, std::thread::hardware_concurrency());
+
+		Workload workload{ params.transforms };
+		std::size_t const minChunkSize = 1024;
+
+		std::vector<JobScalingResult> results;
+		std::vector<double> samples;
+		samples.reserve(params.iterations);
+
+		for (unsigned threads = 1; threads <= maxThreads; ++threads)
+		{
+			be::jobs::Scope const jobs{ threads - 1 };
+
+			for (int i = 0; i < params.warmupIterations; ++i)
+			{
+				be::jobs::parallelFor(params.transforms, [&](std::size_t b, std::size_t e) { workload.run(b, e); }, minChunkSize);
+			}
+
+			samples.clear();
+			for (int i = 0; i < params.iterations; ++i)
+			{
+				auto const start = Clock::now();
+				be::jobs::parallelFor(params.transforms, [&](std::size_t b, std::size_t e) { workload.run(b, e); }, minChunkSize);
+				samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+			}
+
+			JobScalingResult result;
+			result.threads = threads;
+			double total = 0.0;
+			for (auto const ms : samples) { total += ms; }
+			result.meanMs = total / static_cast<double>(samples.size());
+			result.minMs = *std::min_element(samples.begin(), samples.end());
+			result.speedup = results.empty() ? 1.0 : results.front().meanMs / result.meanMs;
+			results.push_back(result);
+		}
+		return results;
+	}
+
+	void writeJobScalingJson(
+		std::ostream& out,
+		JobScalingParams const& params,
+		std::vector<JobScalingResult> const& results)
+	{
+		out << "{\n"
+			<< "  \"name\": \"job-scaling-t" << params.transforms << "\",\n"
+			<< "  \"params\": { \"transforms\": " << params.transforms
+			<< ", \"iterations\": " << params.iterations
+			<< " },\n"
+			<< "  \"results\": [";
+		bool first = true;
+		for (auto const& result : results)
+		{
+			out << (first ? "\n" : ",\n");
+			first = false;
+			out << "    { \"threads\": " << result.threads
+				<< ", \"meanMs\": " << result.meanMs
+				<< ", \"minMs\": " << result.minMs
+				<< ", \"speedup\": " << result.speedup
+				<< " }";
+		}
+		out << "\n  ]\n}\n";
+	}
+}
@@ -0,0 +1,37 @@
+/*
+//	be_bench
+//	Times a synthetic transform workload on be::jobs with an increasing number of threads.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+namespace bench
+{
+	struct JobScalingParams
+	{
+		std::size_t transforms = 200000; // require > 0
+		int iterations = 300; // require > 0
+		int warmupIterations = 30; // require >= 0
+		unsigned maxThreads = 0; // 0 means the hardware threads
+	};
+
+	struct JobScalingResult
+	{
+		unsigned threads{}; // the main thread plus workers
+		double meanMs{};
+		double minMs{};
+		double speedup{}; // of the mean, relative to one thread
+	};
+
+	// Restarts be::jobs for each thread count, so be::jobs must not be running.
+	std::vector<JobScalingResult> runJobScaling(JobScalingParams const& params);
+
+	void writeJobScalingJson(
+		std::ostream& out,
+		JobScalingParams const& params,
+		std::vector<JobScalingResult> const& results);
+}
@@ -0,0 +1,303 @@
+/*
+USAGE
+be_bench [options]
+
+SCENE
+--quads N			textured quads in the shadow scene (default 2)
+--fences N			picket fence model instances (default 1)
+--labels N			HUD text labels (default 1)
+--shadow-res N		shadow atlas width and height, a power of two (default 1024)
+--shadow-lights N	fixed shadowed lights sharing the atlas with the moving one, 0 to 15 (default 0)
+--water				also render the three WaterScene passes
+--water-scale X		reflection and refraction target size as a fraction of the window (default 0.5)
+--water-refresh N	frames between reflection and refraction refreshes; 0 refreshes
+					only when the camera moves (default 1)
+--hard-shadows		compare against the shadow map directly instead of filtering it (see example/evsm.hpp)
+--point-light		add a point light with cube map shadows drawn in one pass (see example/point_shadow.hpp)
+--lights N			unshadowed point lights shaded by clustered forward lighting, 0 to 1024 (default 0)
+					(see be/light_clusters.hpp); --lights 1000 is the stress test
+--depth-prepass		lay down the shadow scene's depth before its colour pass;
+					compare "shadow colour.gpuMsMean" with and without
+--occluders N		rasterise the N nearest fences on the CPU and skip the flags and fences they hide
+					(see be/pink/occlusion.hpp); 0 is off (default 0)
+
+RUN
+--frames N			measured frames (default 300)
+--warmup N			frames rendered before measuring (default 30)
+--width N			framebuffer width (default 960)
+--height N			framebuffer height (default 540)
+--example-dir PATH	directory the example assets are loaded relative to (default ../example)
+--replay PATH		drive the scene with input recorded by "example --record PATH";
+					the run also ends when the recording does. pass the recorded --width and --height
+
+BASELINE
+--baseline PATH		compare against the entry for this scene in a baseline file
+--tolerance X		allowed relative increase of timing metrics (default 0.10)
+--update-baseline	write this run's metrics into the baseline file instead of comparing
+
+JOB SCALING
+--job-scaling		instead of rendering, time a synthetic transform workload on be::jobs
+					with 1, 2, ... up to --max-threads threads; --frames and --warmup count iterations
+--transforms N		transforms per iteration (default 200000)
+--max-threads N		most threads to try (default the hardware threads)
+
+OCCLUSION
+--occlusion-bench	instead of rendering, time be::pink::OcclusionBuffer on a synthetic scene:
+					occluder triangles rasterised per ms and boxes tested per ms;
+					--frames and --warmup count iterations, --max-threads sets the threads;
+					first checks boxes beside, between and behind walls whose answer is
+					known, and lists any it gets wrong as failedChecks
+--walls N			box occluders (default 64)
+--boxes N			boxes tested per iteration (default 100000)
+
+EXPECTATIONS
+--expect "PASS.METRIC<=N"	fail if a per-frame GL count of a pass exceeds N, e.g.
+						--expect "text label.drawCalls<=2" --expect "frame.stateChanges<=400"
+						passes are the BE_GL_STATS_PASS names; "frame" is the whole frame.
+						a text label is one draw call, two with its drop shadow, so the
+						first example holds for the default --labels 1
+						with be built with BE_COUNT_ALLOCATIONS, --expect "frame.heapAllocations<=0"
+						checks that steady-state frames make no heap allocations
+
+Prints one JSON object to stdout.
+Exits with 1 if any metric regressed against the baseline, an expectation failed or an occlusion check
+failed, 2 if the run failed.
+Runs in a hidden window on Windows, the only platform the solution builds for.
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <be/application.hpp>
+
+#include "bench_game.hpp"
+#include "job_scaling.hpp"
+#include "occlusion_bench.hpp"
+#include "report.hpp"
+
+namespace bench
+{
+	struct Options
+	{
+		SceneParams scene;
+		int frames = 300;
+		int warmupFrames = 30;
+		int width = 960;
+		int height = 540;
+		std::string exampleDir = "../example";
+		std::string replayPath;
+		std::string baselinePath;
+		double tolerance = 0.10;
+		bool updateBaseline = false;
+		std::vector<Expectation> expectations;
+		bool jobScaling = false;
+		JobScalingParams jobScalingParams;
+		bool occlusionBench = false;
+		OcclusionBenchParams occlusionBenchParams;
+	};
+
+	static bool parseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			char const* const arg = argv[i];
+			bool const hasValue = i + 1 < argc;
+			auto const is = [arg](char const* name) { return 0 == std::strcmp(arg, name); };
+
+			if (is("--water")) { options.scene.water = true; }
+			else if (is("--depth-prepass")) { options.scene.depthPrepass = true; }
+			else if (is("--hard-shadows")) { options.scene.hardShadows = true; }
+			else if (is("--point-light")) { options.scene.pointLight = true; }
+			else if (is("--update-baseline")) { options.updateBaseline = true; }
+			else if (is("--job-scaling")) { options.jobScaling = true; }
+			else if (is("--occlusion-bench")) { options.occlusionBench = true; }
+			else if (!hasValue)
+			{
+				std::cerr << "[bench] missing value or unknown option: " << arg << "\n";
+				return false;
+			}
+			else if (is("--quads")) { options.scene.quads = std::atoi(argv[++i]); }
+			else if (is("--fences")) { options.scene.fences = std::atoi(argv[++i]); }
+			else if (is("--labels")) { options.scene.labels = std::atoi(argv[++i]); }
+			else if (is("--shadow-res")) { options.scene.shadowMapSize = std::atoi(argv[++i]); }
+			else if (is("--shadow-lights")) { options.scene.shadowLights = std::atoi(argv[++i]); }
+			else if (is("--lights")) { options.scene.clusteredLights = std::atoi(argv[++i]); }
+			else if (is("--occluders")) { options.scene.occluders = std::atoi(argv[++i]); }
+			else if (is("--water-scale")) { options.scene.waterTargetScale = static_cast<float>(std::atof(argv[++i])); }
+			else if (is("--water-refresh")) { options.scene.waterRefreshInterval = std::atoi(argv[++i]); }
+			else if (is("--frames")) { options.frames = std::atoi(argv[++i]); }
+			else if (is("--warmup")) { options.warmupFrames = std::atoi(argv[++i]); }
+			else if (is("--width")) { options.width = std::atoi(argv[++i]); }
+			else if (is("--height")) { options.height = std::atoi(argv[++i]); }
+			else if (is("--example-dir")) { options.exampleDir = argv[++i]; }
+			else if (is("--replay")) { options.replayPath = std::filesystem::absolute(argv[++i]).string(); }
+			else if (is("--baseline")) { options.baselinePath = argv[++i]; }
+			else if (is("--tolerance")) { options.tolerance = std::atof(argv[++i]); }
+			else if (is("--transforms")) { options.jobScalingParams.transforms = static_cast<std::size_t>(std::atoll(argv[++i])); }
+			else if (is("--max-threads"))
+			{
+				options.jobScalingParams.maxThreads = static_cast<unsigned>(std::atoi(argv[++i]));
+				options.occlusionBenchParams.threads = options.jobScalingParams.maxThreads;
+			}
+			else if (is("--walls")) { options.occlusionBenchParams.walls = std::atoi(argv[++i]); }
+			else if (is("--boxes")) { options.occlusionBenchParams.boxes = static_cast<std::size_t>(std::atoll(argv[++i])); }
+			else if (is("--expect"))
+			{
+				auto const expectation = parseExpectation(argv[++i]);
+				if (!expectation)
+				{
+					std::cerr << "[bench] malformed expectation: " << argv[i] << "\n";
+					return false;
+				}
+				options.expectations.push_back(*expectation);
+			}
+			else
+			{
+				std::cerr << "[bench] unknown option: " << arg << "\n";
+				return false;
+			}
+		}
+
+		if (options.frames <= 0 || options.warmupFrames < 0 || options.tolerance < 0.0)
+		{
+			std::cerr << "[bench] invalid options\n";
+			return false;
+		}
+		if (options.jobScaling && options.jobScalingParams.transforms == 0)
+		{
+			std::cerr << "[bench] invalid options\n";
+			return false;
+		}
+		if (options.occlusionBench && (options.occlusionBenchParams.walls <= 0 || options.occlusionBenchParams.boxes == 0))
+		{
+			std::cerr << "[bench] invalid options\n";
+			return false;
+		}
+		options.jobScalingParams.iterations = options.frames;
+		options.jobScalingParams.warmupIterations = options.warmupFrames;
+		options.occlusionBenchParams.iterations = options.frames;
+		options.occlusionBenchParams.warmupIterations = options.warmupFrames;
+		if (options.updateBaseline && options.baselinePath.empty())
+		{
+			std::cerr << "[bench] --update-baseline requires --baseline\n";
+			return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace bench;
+
+	Options options;
+	if (!parseOptions(argc, argv, options)) { return 2; }
+
+	if (options.jobScaling)
+	{
+		try
+		{
+			auto const results = runJobScaling(options.jobScalingParams);
+			writeJobScalingJson(std::cout, options.jobScalingParams, results);
+			return 0;
+		}
+		catch (std::exception const& e)
+		{
+			std::cerr << e.what() << "\n";
+			return 2;
+		}
+	}
+
+	if (options.occlusionBench)
+	{
+		try
+		{
+			auto const result = runOcclusionBench(options.occlusionBenchParams);
+			writeOcclusionBenchJson(std::cout, options.occlusionBenchParams, result);
+			return result.failedChecks.empty() ? 0 : 1;
+		}
+		catch (std::exception const& e)
+		{
+			std::cerr << e.what() << "\n";
+			return 2;
+		}
+	}
+
+	// the example scenes load their assets relative to the example directory.
+	std::error_code ec;
+	std::filesystem::current_path(options.exampleDir, ec);
+	if (ec)
+	{
+		std::cerr << "[bench] could not enter example directory: " << options.exampleDir << "\n";
+		return 2;
+	}
+
+	std::vector<FrameSample> samples;
+	samples.reserve(options.frames);
+	std::vector<be::gl::PassStats> passTotals;
+
+	be::DefaultLogger logger;
+	be::ApplicationRunInfo info = {};
+	info.logger = &logger;
+	info.argc = &argc;
+	info.argv = argv;
+	info.createGame = [&] {
+		return std::make_unique<BenchGame>(typename BenchGame::CreateInfo{
+			.params = options.scene,
+			.warmupFrames = options.warmupFrames,
+			.samples = samples,
+			.passTotals = passTotals,
+			});
+	};
+	info.windowWidth = options.width;
+	info.windowHeight = options.height;
+	info.windowTitle = "be_bench";
+	info.headless = true;
+	// one extra frame closes the interval of the last measured frame.
+	info.headlessFrameCount = options.warmupFrames + options.frames + 1;
+	info.replayInputPath = options.replayPath.empty() ? nullptr : options.replayPath.c_str();
+	be::Application::run(info);
+
+	if (samples.empty())
+	{
+		std::cerr << "[bench] the run produced no samples\n";
+		return 2;
+	}
+
+	try
+	{
+		auto const name = makeSceneName(options.scene);
+		auto const metrics = summarise(samples);
+
+		std::vector<Regression> regressions;
+		if (!options.baselinePath.empty())
+		{
+			auto baseline = readBaseline(options.baselinePath);
+			if (options.updateBaseline)
+			{
+				baseline[name] = makeBaselineEntry(metrics);
+				writeBaseline(options.baselinePath, baseline);
+			}
+			else if (auto const it = baseline.find(name); it != baseline.end())
+			{
+				regressions = compare(it->second, metrics, options.tolerance);
+			}
+			else
+			{
+				std::cerr << "[bench] no baseline entry for " << name << "\n";
+			}
+		}
+
+		auto const failedExpectations = check(options.expectations, metrics, passTotals, samples.size());
+
+		writeResultJson(std::cout, name, options.scene, samples.size(), metrics, passTotals,
+			be::error_stats::getAllErrorStats(), regressions, failedExpectations);
+		return regressions.empty() && failedExpectations.empty() ? 0 : 1;
+	}
+	catch (std::exception const& e)
+	{
+		std::cerr << e.what() << "\n";
+		return 2;
+	}
+}
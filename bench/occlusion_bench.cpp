@@ -0,0 +1,202 @@
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <ostream>
+#include <thread>
+#include <glm/gtx/transform.hpp>
+#include <be/be.hpp>
+
+#include "occlusion_bench.hpp"
+
+namespace bench
+{
+	namespace
+	{
+		// A unit cube, counter-clockwise from outside.
+		std::array<glm::vec3, 8> makeCubePositions()
+		{
+			std::array<glm::vec3, 8> positions;
+			for (int i = 0; i < 8; ++i)
+			{
+				positions[i] = glm::vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1) - glm::vec3(0.5f);
+			}
+			return positions;
+		}
+		std::array<glm::vec3, 8> const cubePositions = makeCubePositions();
+		std::array<std::uint32_t, 36> const cubeIndices = {
+			0, 2, 3, 0, 3, 1, // -z
+			4, 5, 7, 4, 7, 6, // +z
+			0, 4, 6, 0, 6, 2, // -x
+			1, 3, 7, 1, 7, 5, // +x
+			0, 1, 5, 0, 5, 4, // -y
+			2, 6, 7, 2, 7, 3, // +y
+		};
+
+		// Rows of walls across the middle distance, with boxes scattered in front, among and behind them.
+		struct Workload
+		{
+			glm::mat4 viewProjection;
+			std::vector<glm::mat4> walls;
+			std::vector<be::pink::Aabb> boxes;
+			std::vector<unsigned char> visible;
+
+			Workload(int const wallCount, std::size_t const boxCount)
+				: walls(wallCount)
+				, boxes(boxCount)
+				, visible(boxCount)
+			{
+				viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f)
+					* glm::lookAt(glm::vec3(0.0f, 2.0f, 20.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+				int const columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<float>(wallCount)))));
+				for (int i = 0; i < wallCount; ++i)
+				{
+					float const x = (static_cast<float>(i % columns) - 0.5f * static_cast<float>(columns - 1)) * 4.0f;
+					float const z = -static_cast<float>(i / columns) * 4.0f;
+					walls[i] = glm::translate(glm::vec3(x, 1.5f, z)) * glm::scale(glm::vec3(3.0f, 3.0f, 0.3f));
+				}
+				for (std::size_t i = 0; i < boxCount; ++i)
+				{
+					float const f = static_cast<float>(i);
+					glm::vec3 const centre = glm::vec3(std::fmod(f * 0.37f, 50.0f) - 25.0f, std::fmod(f * 0.11f, 4.0f), 10.0f - std::fmod(f * 0.53f, 70.0f));
+					boxes[i] = be::pink::Aabb{ centre - glm::vec3(0.25f), centre + glm::vec3(0.25f) };
+				}
+			}
+
+			void rasterize(be::pink::OcclusionBuffer& buffer) const
+			{
+				buffer.begin(viewProjection);
+				for (auto const& wall : walls)
+				{
+					buffer.addOccluder(cubePositions, cubeIndices, wall);
+				}
+				buffer.rasterize();
+			}
+
+			void test(be::pink::OcclusionBuffer const& buffer, std::size_t const begin, std::size_t const end) noexcept
+			{
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					visible[i] = buffer.isVisible(boxes[i]) ? 1 : 0;
+				}
+			}
+		};
+	}
+
+	std::vector<std::string> checkOcclusion()
+	{
+		// an orthographic camera down -z, so world x and y are the buffer's pixel coordinates.
+		be::pink::OcclusionBuffer buffer{ be::pink::OcclusionBuffer::CreateInfo{} };
+		float const width = static_cast<float>(buffer.width());
+		float const height = static_cast<float>(buffer.height());
+		auto const wall = [&](float const x0, float const x1) {
+			return glm::translate(glm::vec3(0.5f * (x0 + x1), 0.5f * height, -5.0f)) * glm::scale(glm::vec3(x1 - x0, height, 1.0f));
+		};
+		buffer.begin(glm::ortho(0.0f, width, 0.0f, height, 0.1f, 100.0f));
+		// edges a fifth of a pixel either side of pixel centres, and a one-pixel gap at x = 20.5 to 21.5.
+		buffer.addOccluder(cubePositions, cubeIndices, wall(0.0f, 10.7f));
+		buffer.addOccluder(cubePositions, cubeIndices, wall(14.0f, 20.5f));
+		buffer.addOccluder(cubePositions, cubeIndices, wall(21.5f, 40.0f));
+		buffer.rasterize();
+
+		struct Case
+		{
+			char const* name;
+			be::pink::Aabb bounds;
+			bool visible;
+		};
+		float const y = 0.5f * height;
+		Case const cases[] = {
+			{ "behind", { glm::vec3(5.0f, y, -9.0f), glm::vec3(6.0f, y + 1.0f, -8.0f) }, false },
+			{ "behind the gap's edges", { glm::vec3(15.0f, y, -9.0f), glm::vec3(19.9f, y + 1.0f, -8.0f) }, false },
+			{ "in front", { glm::vec3(5.0f, y, -3.0f), glm::vec3(6.0f, y + 1.0f, -2.0f) }, true },
+			{ "beside the edge", { glm::vec3(10.75f, y, -9.0f), glm::vec3(10.95f, y + 1.0f, -8.0f) }, true },
+			{ "through the gap", { glm::vec3(20.8f, y, -9.0f), glm::vec3(21.2f, y + 1.0f, -8.0f) }, true },
+		};
+
+		std::vector<std::string> failed;
+		for (auto const& c : cases)
+		{
+			if (buffer.isVisible(c.bounds) != c.visible) { failed.push_back(c.name); }
+		}
+		return failed;
+	}
+
+	OcclusionBenchResult runOcclusionBench(OcclusionBenchParams const& params)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		unsigned const threads = params.threads > 0
+			? params.threads
+			: std::max(1u, std::thread::hardware_concurrency());
+		be::jobs::Scope const jobs{ threads - 1 };
+
+		Workload workload{ params.walls, params.boxes };
+		be::pink::OcclusionBuffer buffer{ be::pink::OcclusionBuffer::CreateInfo{} };
+		std::size_t const minChunkSize = 1024;
+
+		auto const test = [&] {
+			be::jobs::parallelFor(params.boxes, [&](std::size_t b, std::size_t e) { workload.test(buffer, b, e); }, minChunkSize);
+		};
+
+		for (int i = 0; i < params.warmupIterations; ++i)
+		{
+			workload.rasterize(buffer);
+			test();
+		}
+
+		double rasterMs = 0.0;
+		double testMs = 0.0;
+		for (int i = 0; i < params.iterations; ++i)
+		{
+			auto const rasterStart = Clock::now();
+			workload.rasterize(buffer);
+			auto const testStart = Clock::now();
+			test();
+			auto const testEnd = Clock::now();
+			rasterMs += std::chrono::duration<double, std::milli>(testStart - rasterStart).count();
+			testMs += std::chrono::duration<double, std::milli>(testEnd - testStart).count();
+		}
+
+		OcclusionBenchResult result;
+		result.failedChecks = checkOcclusion();
+		result.threads = threads;
+		result.triangles = buffer.stats().occluderTriangles;
+		result.rasterMsMean = rasterMs / static_cast<double>(params.iterations);
+		result.testMsMean = testMs / static_cast<double>(params.iterations);
+		result.trianglesPerMs = result.rasterMsMean > 0.0 ? static_cast<double>(result.triangles) / result.rasterMsMean : 0.0;
+		result.testsPerMs = result.testMsMean > 0.0 ? static_cast<double>(params.boxes) / result.testMsMean : 0.0;
+		auto const hidden = std::count(workload.visible.begin(), workload.visible.end(), 0);
+		result.hiddenFraction = static_cast<double>(hidden) / static_cast<double>(params.boxes);
+		return result;
+	}
+
+	void writeOcclusionBenchJson(
+		std::ostream& out,
+		OcclusionBenchParams const& params,
+		OcclusionBenchResult const& result)
+	{
+		out << "{\n"
+			<< "  \"name\": \"occlusion-w" << params.walls << "_b" << params.boxes << "\",\n"
+			<< "  \"params\": { \"walls\": " << params.walls
+			<< ", \"boxes\": " << params.boxes
+			<< ", \"iterations\": " << params.iterations
+			<< ", \"threads\": " << result.threads
+			<< ", \"simd\": \"" << be::pink::OcclusionBuffer::simd << "\""
+			<< " },\n"
+			<< "  \"results\": { \"triangles\": " << result.triangles
+			<< ", \"rasterMsMean\": " << result.rasterMsMean
+			<< ", \"trianglesPerMs\": " << result.trianglesPerMs
+			<< ", \"testMsMean\": " << result.testMsMean
+			<< ", \"testsPerMs\": " << result.testsPerMs
+			<< ", \"hiddenFraction\": " << result.hiddenFraction
+			<< " },\n"
+			<< "  \"failedChecks\": [";
+		for (std::size_t i = 0; i < result.failedChecks.size(); ++i)
+		{
+			out << (i > 0 ? ", " : "") << "\"" << result.failedChecks[i] << "\"";
+		}
+		out << "]\n}\n";
+	}
+}
@@ -0,0 +1,49 @@
+/*
+//	be_bench
+//	Times be::pink::OcclusionBuffer on a synthetic scene: how fast occluders are rasterised
+//	and how fast boxes are tested against them.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+	struct OcclusionBenchParams
+	{
+		int walls = 64; // box occluders, 12 triangles each. require > 0
+		std::size_t boxes = 100000; // boxes tested per iteration. require > 0
+		int iterations = 300; // require > 0
+		int warmupIterations = 30; // require >= 0
+		unsigned threads = 0; // the main thread plus workers; 0 means the hardware threads
+	};
+
+	struct OcclusionBenchResult
+	{
+		unsigned threads{};
+		std::size_t triangles{}; // rasterised per iteration, after clipping, back-face culling and dropping those on no pixel centre
+		double rasterMsMean{};
+		double trianglesPerMs{};
+		double testMsMean{};
+		double testsPerMs{};
+		double hiddenFraction{}; // of the boxes, reported hidden
+		std::vector<std::string> failedChecks; // names of the cases checkOcclusion got wrong
+	};
+
+	// Rasterises walls a fraction of a pixel apart and tests boxes whose answer is known:
+	// beside a wall's edge, seen through a one-pixel gap, behind a wall and in front of one.
+	// Returns the names of the cases the buffer got wrong. Needs no be::jobs workers.
+	std::vector<std::string> checkOcclusion();
+
+	// Starts be::jobs for the run, so be::jobs must not be running.
+	OcclusionBenchResult runOcclusionBench(OcclusionBenchParams const& params);
+
+	void writeOcclusionBenchJson(
+		std::ostream& out,
+		OcclusionBenchParams const& params,
+		OcclusionBenchResult const& result);
+}
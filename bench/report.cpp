@@ -0,0 +1,419 @@
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "report.hpp"
+
+namespace bench
+{
+	namespace
+	{
+		double mean(std::vector<double> const& values)
+		{
+			if (values.empty()) { return 0.0; }
+			double total = 0.0;
+			for (auto const v : values) { total += v; }
+			return total / static_cast<double>(values.size());
+		}
+
+		double p95(std::vector<double> values)
+		{
+			if (values.empty()) { return 0.0; }
+			auto const k = std::min(values.size() - 1, (values.size() * 95) / 100);
+			std::nth_element(values.begin(), values.begin() + k, values.end());
+			return values[k];
+		}
+
+		// Reads the subset of JSON that writeBaseline produces: objects, strings and numbers.
+		class BaselineParser
+		{
+		private:
+			std::string const& m_text;
+			std::size_t m_pos = 0;
+
+		public:
+			explicit BaselineParser(std::string const& text) : m_text(text) {}
+
+			Baseline parse()
+			{
+				Baseline baseline;
+				parseObject([&](std::string const& name) {
+					auto& entry = baseline[name];
+					parseObject([&](std::string const& key) {
+						double const value = parseNumber();
+						for (std::size_t m = 0; m < metricCount; ++m)
+						{
+							if (key == metricInfos[m].name)
+							{
+								entry.metrics.*metricInfos[m].member = value;
+								entry.present[m] = true;
+							}
+						}
+						});
+					});
+				skipWhitespace();
+				if (m_pos != m_text.size()) { fail("trailing characters"); }
+				return baseline;
+			}
+
+		private:
+			[[noreturn]] void fail(char const* what) const
+			{
+				throw std::runtime_error("[bench] baseline parse exception: "
+					+ std::string(what) + " at offset " + std::to_string(m_pos));
+			}
+
+			void skipWhitespace()
+			{
+				while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) { ++m_pos; }
+			}
+
+			bool consume(char c)
+			{
+				skipWhitespace();
+				if (m_pos < m_text.size() && m_text[m_pos] == c) { ++m_pos; return true; }
+				return false;
+			}
+
+			void expect(char c)
+			{
+				if (!consume(c)) { fail("unexpected character"); }
+			}
+
+			std::string parseString()
+			{
+				expect('"');
+				std::string s;
+				while (m_pos < m_text.size() && m_text[m_pos] != '"')
+				{
+					if (m_text[m_pos] == '\\') { ++m_pos; }
+					if (m_pos < m_text.size()) { s.push_back(m_text[m_pos++]); }
+				}
+				expect('"');
+				return s;
+			}
+
+			double parseNumber()
+			{
+				skipWhitespace();
+				char const* const begin = m_text.c_str() + m_pos;
+				char* end = nullptr;
+				double const value = std::strtod(begin, &end);
+				if (end == begin) { fail("expected a number"); }
+				m_pos += static_cast<std::size_t>(end - begin);
+				return value;
+			}
+
+			template<class OnMember>
+			void parseObject(OnMember&& onMember)
+			{
+				expect('{');
+				if (consume('}')) { return; }
+				do
+				{
+					std::string const key = parseString();
+					expect(':');
+					onMember(key);
+				} while (consume(','));
+				expect('}');
+			}
+		};
+	}
+
+	std::string makeSceneName(SceneParams const& params)
+	{
+		std::ostringstream name;
+		name << "q" << params.quads
+			<< "_f" << params.fences
+			<< "_l" << params.labels
+			<< "_s" << params.shadowMapSize
+			<< (params.shadowLights > 0 ? "_sl" + std::to_string(params.shadowLights) : "")
+			<< (params.water ? "_water" : "")
+			<< (params.water && params.waterTargetScale != 0.5f ? "_ws" + std::to_string(params.waterTargetScale).substr(0, 4) : "")
+			<< (params.water && params.waterRefreshInterval != 1 ? "_wr" + std::to_string(params.waterRefreshInterval) : "")
+			<< (params.depthPrepass ? "_prepass" : "")
+			<< (params.hardShadows ? "_hard" : "")
+			<< (params.pointLight ? "_point" : "")
+			<< (params.clusteredLights > 0 ? "_lights" + std::to_string(params.clusteredLights) : "")
+			<< (params.occluders > 0 ? "_occ" + std::to_string(params.occluders) : "");
+		return name.str();
+	}
+
+	Metrics perFrame(be::gl::FrameStats const& total, std::size_t frameCount)
+	{
+		Metrics metrics;
+		if (frameCount == 0) { return metrics; }
+		double const n = static_cast<double>(frameCount);
+		metrics.drawCalls = static_cast<double>(total.drawCalls) / n;
+		metrics.primitives = static_cast<double>(total.primitives) / n;
+		metrics.stateChanges = static_cast<double>(total.stateChanges()) / n;
+		metrics.uniformCalls = static_cast<double>(total.uniformCalls) / n;
+		metrics.bufferUploadBytes = static_cast<double>(total.bufferUploadBytes) / n;
+		metrics.textureUploadBytes = static_cast<double>(total.textureUploadBytes) / n;
+		metrics.gpuMsMean = static_cast<double>(total.gpuNanoseconds) / n * 1e-6;
+		return metrics;
+	}
+
+	Metrics summarise(std::vector<FrameSample> const& samples)
+	{
+		std::vector<double> frameMs, submitMs, clusterMs, occlusionMs;
+		frameMs.reserve(samples.size());
+		submitMs.reserve(samples.size());
+		clusterMs.reserve(samples.size());
+		occlusionMs.reserve(samples.size());
+		be::gl::FrameStats total;
+		std::uint64_t heapAllocations = 0;
+		std::uint64_t gpuMemoryBytes = 0;
+		std::uint64_t clusterIndices = 0;
+		std::uint32_t clusterLightsMax = 0;
+		for (auto const& s : samples)
+		{
+			clusterMs.push_back(s.clusters.assignMs);
+			clusterIndices += s.clusters.indices;
+			clusterLightsMax = std::max(clusterLightsMax, s.clusters.maxLightsPerCluster);
+			occlusionMs.push_back(s.occlusion.rasterMs);
+			frameMs.push_back(s.frameMs);
+			submitMs.push_back(s.submitMs);
+			total += s.gl;
+			heapAllocations += s.heapAllocations;
+			gpuMemoryBytes = std::max(gpuMemoryBytes, s.gpuMemoryBytes);
+		}
+
+		Metrics metrics = perFrame(total, samples.size());
+		if (!samples.empty())
+		{
+			metrics.heapAllocations = static_cast<double>(heapAllocations) / static_cast<double>(samples.size());
+			metrics.clusterIndicesMean = static_cast<double>(clusterIndices) / static_cast<double>(samples.size());
+		}
+		metrics.gpuMemoryBytes = static_cast<double>(gpuMemoryBytes);
+		metrics.clusterLightsMax = static_cast<double>(clusterLightsMax);
+		metrics.clusterMsMean = mean(clusterMs);
+		metrics.occlusionMsMean = mean(occlusionMs);
+		metrics.frameMsMean = mean(frameMs);
+		metrics.frameMsP95 = p95(frameMs);
+		metrics.submitMsMean = mean(submitMs);
+		metrics.submitMsP95 = p95(std::move(submitMs));
+		return metrics;
+	}
+
+	std::optional<Expectation> parseExpectation(std::string const& text)
+	{
+		auto const op = text.find("<=");
+		if (op == std::string::npos) { return std::nullopt; }
+		auto const dot = text.rfind('.', op);
+		if (dot == std::string::npos || dot == 0) { return std::nullopt; }
+
+		Expectation expectation;
+		expectation.pass = text.substr(0, dot);
+		expectation.metric = text.substr(dot + 1, op - dot - 1);
+
+		auto const valueText = text.substr(op + 2);
+		char* end = nullptr;
+		expectation.max = std::strtod(valueText.c_str(), &end);
+		if (valueText.empty() || *end != '\0') { return std::nullopt; }
+
+		for (auto const& info : metricInfos)
+		{
+			if (MetricKind::Count == info.kind && expectation.metric == info.name) { return expectation; }
+		}
+		return std::nullopt;
+	}
+
+	std::vector<FailedExpectation> check(
+		std::vector<Expectation> const& expectations,
+		Metrics const& frame,
+		std::vector<be::gl::PassStats> const& passTotals,
+		std::size_t frameCount)
+	{
+		std::vector<FailedExpectation> failed;
+		for (auto const& e : expectations)
+		{
+			Metrics metrics = frame;
+			if (e.pass != "frame")
+			{
+				// a pass that never ran counts as zero.
+				auto const it = std::find_if(passTotals.begin(), passTotals.end(),
+					[&](be::gl::PassStats const& p) { return e.pass == p.name; });
+				metrics = perFrame(it != passTotals.end() ? it->stats : be::gl::FrameStats{}, frameCount);
+			}
+
+			for (auto const& info : metricInfos)
+			{
+				if (e.metric == info.name && metrics.*info.member > e.max)
+				{
+					failed.push_back(FailedExpectation{ e, metrics.*info.member });
+				}
+			}
+		}
+		return failed;
+	}
+
+	BaselineEntry makeBaselineEntry(Metrics const& metrics)
+	{
+		BaselineEntry entry;
+		entry.metrics = metrics;
+		entry.present.fill(true);
+		return entry;
+	}
+
+	std::vector<Regression> compare(BaselineEntry const& baseline, Metrics const& current, double tolerance)
+	{
+		std::vector<Regression> regressions;
+		for (std::size_t m = 0; m < metricCount; ++m)
+		{
+			auto const& info = metricInfos[m];
+			if (!baseline.present[m]) { continue; }
+			double const b = baseline.metrics.*info.member;
+			double const c = current.*info.member;
+			double const limit = MetricKind::Timing == info.kind ? b * (1.0 + tolerance) : b;
+			if (c > limit)
+			{
+				regressions.push_back(Regression{ info.name, b, c, limit });
+			}
+		}
+		return regressions;
+	}
+
+	void writeResultJson(
+		std::ostream& out,
+		std::string const& name,
+		SceneParams const& params,
+		std::size_t frameCount,
+		Metrics const& metrics,
+		std::vector<be::gl::PassStats> const& passTotals,
+		std::vector<be::error_stats::ErrorStats> const& errors,
+		std::vector<Regression> const& regressions,
+		std::vector<FailedExpectation> const& failedExpectations)
+	{
+		// every digit, so a byte count written here reads back as the same number.
+		auto const precision = out.precision(std::numeric_limits<double>::max_digits10);
+		out << "{\n"
+			<< "  \"name\": \"" << name << "\",\n"
+			<< "  \"params\": { "
+			<< "\"quads\": " << params.quads
+			<< ", \"fences\": " << params.fences
+			<< ", \"labels\": " << params.labels
+			<< ", \"shadowMapSize\": " << params.shadowMapSize
+			<< ", \"shadowLights\": " << params.shadowLights
+			<< ", \"water\": " << (params.water ? "true" : "false")
+			<< ", \"waterTargetScale\": " << params.waterTargetScale
+			<< ", \"waterRefreshInterval\": " << params.waterRefreshInterval
+			<< ", \"depthPrepass\": " << (params.depthPrepass ? "true" : "false")
+			<< ", \"hardShadows\": " << (params.hardShadows ? "true" : "false")
+			<< ", \"pointLight\": " << (params.pointLight ? "true" : "false")
+			<< ", \"clusteredLights\": " << params.clusteredLights
+			<< ", \"occluders\": " << params.occluders
+			<< " },\n"
+			<< "  \"frames\": " << frameCount << ",\n"
+			<< "  \"metrics\": { ";
+		bool first = true;
+		for (auto const& info : metricInfos)
+		{
+			if (!first) { out << ", "; }
+			first = false;
+			out << "\"" << info.name << "\": " << metrics.*info.member;
+		}
+		out << " },\n"
+			<< "  \"passes\": {";
+		bool firstPass = true;
+		for (auto const& pass : passTotals)
+		{
+			auto const passMetrics = perFrame(pass.stats, frameCount);
+			out << (firstPass ? "\n" : ",\n");
+			firstPass = false;
+			out << "    \"" << pass.name << "\": { ";
+			first = true;
+			for (auto const& info : metricInfos)
+			{
+				if (!info.perPass) { continue; }
+				if (!first) { out << ", "; }
+				first = false;
+				out << "\"" << info.name << "\": " << passMetrics.*info.member;
+			}
+			out << " }";
+		}
+		out << (passTotals.empty() ? "},\n" : "\n  },\n")
+			<< "  \"errors\": { ";
+		first = true;
+		for (auto const& error : errors)
+		{
+			if (!first) { out << ", "; }
+			first = false;
+			out << "\"" << error.name << "\": " << error.total;
+		}
+		out << " },\n"
+			<< "  \"regressions\": [";
+		first = true;
+		for (auto const& r : regressions)
+		{
+			out << (first ? "\n" : ",\n");
+			first = false;
+			out << "    { \"metric\": \"" << r.metric
+				<< "\", \"baseline\": " << r.baseline
+				<< ", \"current\": " << r.current
+				<< ", \"limit\": " << r.limit << " }";
+		}
+		out << (regressions.empty() ? "],\n" : "\n  ],\n")
+			<< "  \"failedExpectations\": [";
+		first = true;
+		for (auto const& f : failedExpectations)
+		{
+			out << (first ? "\n" : ",\n");
+			first = false;
+			out << "    { \"pass\": \"" << f.expectation.pass
+				<< "\", \"metric\": \"" << f.expectation.metric
+				<< "\", \"max\": " << f.expectation.max
+				<< ", \"actual\": " << f.actual << " }";
+		}
+		out << (failedExpectations.empty() ? "]\n" : "\n  ]\n")
+			<< "}\n";
+		out.precision(precision);
+	}
+
+	Baseline readBaseline(std::string const& filePath)
+	{
+		std::ifstream file{ filePath };
+		if (!file.good()) { return {}; }
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		std::string const text = buffer.str();
+		return BaselineParser(text).parse();
+	}
+
+	void writeBaseline(std::string const& filePath, Baseline const& baseline)
+	{
+		std::ofstream file{ filePath, std::ios::out | std::ios::trunc };
+		if (!file.good())
+		{
+			throw std::runtime_error("[bench] could not open baseline file at: " + filePath);
+		}
+
+		// every digit, since counts compare exactly: a rounded 50331648 would regress against itself.
+		file.precision(std::numeric_limits<double>::max_digits10);
+		file << "{";
+		bool firstScene = true;
+		for (auto const& [name, entry] : baseline)
+		{
+			file << (firstScene ? "\n" : ",\n");
+			firstScene = false;
+			file << "  \"" << name << "\": { ";
+			bool first = true;
+			for (std::size_t m = 0; m < metricCount; ++m)
+			{
+				// left out rather than written as 0, so a later run does not compare against it.
+				if (!entry.present[m]) { continue; }
+				if (!first) { file << ", "; }
+				first = false;
+				file << "\"" << metricInfos[m].name << "\": " << entry.metrics.*metricInfos[m].member;
+			}
+			file << " }";
+		}
+		file << "\n}\n";
+	}
+}
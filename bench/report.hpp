@@ -0,0 +1,150 @@
+/*
+//	be_bench
+//	Summarises frame samples, prints them as JSON and compares them against a stored baseline.
+*/
+
+#pragma once
+
+#include <array>
+#include <iosfwd>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bench_game.hpp"
+
+namespace bench
+{
+	struct Metrics
+	{
+		double frameMsMean{};
+		double frameMsP95{};
+		double submitMsMean{};
+		double submitMsP95{};
+		double gpuMsMean{}; // from timer queries a few frames late; 0 if the context has none
+		// per frame
+		double drawCalls{};
+		double primitives{};
+		double stateChanges{};
+		double uniformCalls{};
+		double bufferUploadBytes{};
+		double textureUploadBytes{};
+		double heapAllocations{}; // whole frame only. needs BE_COUNT_ALLOCATIONS
+		double clusterMsMean{}; // CPU time binning the clustered lights. whole frame only
+		double clusterIndicesMean{}; // light references over all clusters. whole frame only
+		double occlusionMsMean{}; // CPU time rasterising the occluders. whole frame only
+		// not per frame
+		double gpuMemoryBytes{}; // most held by tracked GL objects in any measured frame. whole frame only
+		double clusterLightsMax{}; // most lights any one cluster (so any one pixel) looped over in any measured frame
+	};
+
+	enum class MetricKind
+	{
+		Timing, // noisy; compared with a relative tolerance
+		Count, // deterministic; any increase is a regression
+	};
+
+	struct MetricInfo
+	{
+		char const* name;
+		double Metrics::* member;
+		MetricKind kind;
+		bool perPass = true; // also reported for each pass
+	};
+
+	inline constexpr MetricInfo metricInfos[] = {
+		{ "frameMsMean", &Metrics::frameMsMean, MetricKind::Timing, false },
+		{ "frameMsP95", &Metrics::frameMsP95, MetricKind::Timing, false },
+		{ "submitMsMean", &Metrics::submitMsMean, MetricKind::Timing, false },
+		{ "submitMsP95", &Metrics::submitMsP95, MetricKind::Timing, false },
+		{ "gpuMsMean", &Metrics::gpuMsMean, MetricKind::Timing },
+		{ "drawCalls", &Metrics::drawCalls, MetricKind::Count },
+		{ "primitives", &Metrics::primitives, MetricKind::Count },
+		{ "stateChanges", &Metrics::stateChanges, MetricKind::Count },
+		{ "uniformCalls", &Metrics::uniformCalls, MetricKind::Count },
+		{ "bufferUploadBytes", &Metrics::bufferUploadBytes, MetricKind::Count },
+		{ "textureUploadBytes", &Metrics::textureUploadBytes, MetricKind::Count },
+		{ "heapAllocations", &Metrics::heapAllocations, MetricKind::Count, false },
+		{ "gpuMemoryBytes", &Metrics::gpuMemoryBytes, MetricKind::Count, false },
+		{ "clusterMsMean", &Metrics::clusterMsMean, MetricKind::Timing, false },
+		{ "clusterIndicesMean", &Metrics::clusterIndicesMean, MetricKind::Count, false },
+		{ "clusterLightsMax", &Metrics::clusterLightsMax, MetricKind::Count, false },
+		{ "occlusionMsMean", &Metrics::occlusionMsMean, MetricKind::Timing, false },
+	};
+
+	struct Regression
+	{
+		std::string metric;
+		double baseline{};
+		double current{};
+		double limit{};
+	};
+
+	/*
+	//	An upper bound on a per-frame GL count, written as "pass.metric<=value",
+	//	e.g. "text label.drawCalls<=2". The pass "frame" means the whole frame.
+	*/
+	struct Expectation
+	{
+		std::string pass;
+		std::string metric;
+		double max{};
+	};
+
+	struct FailedExpectation
+	{
+		Expectation expectation;
+		double actual{};
+	};
+
+	// Returns std::nullopt if the text is malformed or names an unknown metric.
+	std::optional<Expectation> parseExpectation(std::string const& text);
+
+	inline constexpr std::size_t metricCount = sizeof(metricInfos) / sizeof(metricInfos[0]);
+
+	struct BaselineEntry
+	{
+		Metrics metrics;
+		// by index into metricInfos. Metrics added since the baseline was written are not compared.
+		std::array<bool, metricCount> present{};
+	};
+
+	// Every metric present.
+	BaselineEntry makeBaselineEntry(Metrics const& metrics);
+
+	// Baseline metrics keyed by scene name.
+	using Baseline = std::map<std::string, BaselineEntry>;
+
+	std::string makeSceneName(SceneParams const& params);
+
+	Metrics summarise(std::vector<FrameSample> const& samples);
+
+	// Averages GL counts and GPU time over |frameCount| frames. CPU timing fields are left zero.
+	Metrics perFrame(be::gl::FrameStats const& total, std::size_t frameCount);
+
+	std::vector<FailedExpectation> check(
+		std::vector<Expectation> const& expectations,
+		Metrics const& frame,
+		std::vector<be::gl::PassStats> const& passTotals,
+		std::size_t frameCount);
+
+	// Skips metrics the baseline does not contain.
+	std::vector<Regression> compare(BaselineEntry const& baseline, Metrics const& current, double tolerance);
+
+	void writeResultJson(
+		std::ostream& out,
+		std::string const& name,
+		SceneParams const& params,
+		std::size_t frameCount,
+		Metrics const& metrics,
+		std::vector<be::gl::PassStats> const& passTotals,
+		std::vector<be::error_stats::ErrorStats> const& errors, // totals over the whole run
+		std::vector<Regression> const& regressions,
+		std::vector<FailedExpectation> const& failedExpectations);
+
+	// Throws std::runtime_error if the file exists but cannot be parsed.
+	// A missing file is an empty baseline.
+	Baseline readBaseline(std::string const& filePath);
+	void writeBaseline(std::string const& filePath, Baseline const& baseline);
+}
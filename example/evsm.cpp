@@ -0,0 +1,214 @@
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "evsm.hpp"
+
+namespace example
+{
+	// beyond this the squared positive moment overflows a 32 bit float.
+	static constexpr float maxEvsmExponent = 42.0f;
+
+	static glm::vec2 calcEvsmExponents(EvsmSettings const& settings)
+	{
+		return glm::vec2(
+			std::clamp(settings.positiveExponent, 0.0f, maxEvsmExponent),
+			std::clamp(settings.negativeExponent, 0.0f, maxEvsmExponent));
+	}
+
+	EvsmBlurShader::EvsmBlurShader()
+	{
+		char const* const vertexShader = R"__(
+#version 330 core
+void main()
+{
+	// (-1,-1), (3,-1), (-1,3): one triangle covering the viewport.
+	vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(p * 2.0f - 1.0f, 0.0f, 1.0f);
+}
+)__";
+		char const* const fragmentShader = R"__(
+#version 330 core
+
+out vec4 outMoments;
+
+uniform sampler2D source;
+uniform bool warpSource; // the source is a depth map: warp each tap into moments
+uniform ivec2 direction;
+uniform int radius;
+uniform float weights[9]; // by distance from the centre tap
+uniform vec2 exponents;
+uniform ivec4 tile; // the texels the taps are clamped to: min x, min y, max x, max y
+
+vec4 calcMoments(float depth)
+{
+	float x = depth * 2.0f - 1.0f;
+	float positive = exp(exponents.x * x);
+	float negative = -exp(-exponents.y * x);
+	return vec4(positive, positive * positive, negative, negative * negative);
+}
+
+void main()
+{
+	ivec2 coord = ivec2(gl_FragCoord.xy);
+	vec4 sum = vec4(0.0f);
+	for (int i = -radius; i <= radius; ++i)
+	{
+		vec4 tap = texelFetch(source, clamp(coord + direction * i, tile.xy, tile.zw), 0);
+		sum += weights[abs(i)] * (warpSource ? calcMoments(tap.r) : tap);
+	}
+	outMoments = sum;
+}
+)__";
+		m_shader = be::gl::makeBasicShaderProgram(vertexShader, fragmentShader, "evsm.cpp blur");
+		GLuint const program = m_shader.program.get();
+		m_uniformLocations.source = glGetUniformLocation(program, "source");
+		m_uniformLocations.warpSource = glGetUniformLocation(program, "warpSource");
+		m_uniformLocations.direction = glGetUniformLocation(program, "direction");
+		m_uniformLocations.radius = glGetUniformLocation(program, "radius");
+		m_uniformLocations.weights = glGetUniformLocation(program, "weights");
+		m_uniformLocations.exponents = glGetUniformLocation(program, "exponents");
+		m_uniformLocations.tile = glGetUniformLocation(program, "tile");
+
+		BE_USE_PROGRAM_SCOPE(program);
+		glUniform1i(m_uniformLocations.source, 0);
+
+		m_emptyVertexArray = be::mem::gl::makeVertexArray();
+	}
+
+	EvsmTarget makeEvsmTarget(int const size, int const levels, char const* const label)
+	{
+		bool const mipmapped = levels > 1;
+		EvsmTarget target;
+		target.size = size;
+		target.frameBuffer = be::mem::gl::makeFrameBuffer(be::gpu_memory::Category::RenderTarget, label);
+		target.texture = be::mem::gl::makeTexture(be::gpu_memory::Category::RenderTarget, label);
+
+		BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, target.texture.get(), GL_TEXTURE0);
+		GLint level = 0;
+		for (int levelSize = size; ; levelSize = std::max(1, levelSize / 2), ++level)
+		{
+			be::gl::texImage2D(GL_TEXTURE_2D, level, GL_RGBA32F, levelSize, levelSize, 0, GL_RGBA, GL_FLOAT, NULL);
+			be::gpu_memory::setTextureLevel(target.texture.get(), level, levelSize, levelSize, GL_RGBA32F);
+			if (level + 1 >= levels || levelSize == 1) { break; }
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mipmapped ? GL_LINEAR : GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, target.frameBuffer.get());
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture.get(), 0);
+
+		GLenum const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			throw std::runtime_error("[example] framebuffer exception: "
+				+ std::to_string(static_cast<int>(status)));
+		}
+		return target;
+	}
+
+	void filterEvsm(
+		EvsmBlurShader const& shader,
+		GLuint const depthTexture,
+		std::span<be::gl::ShadowTile const> const tiles,
+		EvsmTarget& scratch,
+		EvsmTarget& moments,
+		EvsmSettings const& settings
+	)
+	{
+		// a normalised Gaussian with the radius at two standard deviations.
+		int const radius = std::clamp(settings.blurRadius, 0, EvsmBlurShader::maxBlurRadius);
+		float const sigma = std::max(0.5f, static_cast<float>(radius) * 0.5f);
+		std::array<GLfloat, EvsmBlurShader::maxBlurRadius + 1> weights{};
+		float total = 0.0f;
+		for (int i = 0; i <= radius; ++i)
+		{
+			weights[i] = std::exp(-static_cast<float>(i * i) / (2.0f * sigma * sigma));
+			total += i == 0 ? weights[i] : 2.0f * weights[i];
+		}
+		for (auto& weight : weights) { weight /= total; }
+
+		auto const& loc = shader.uniformLocations();
+		BE_USE_PROGRAM_SCOPE(shader.program());
+		BE_BIND_VERTEX_ARRAY_SCOPE(shader.emptyVertexArray());
+		glUniform1i(loc.radius, radius);
+		glUniform1fv(loc.weights, static_cast<GLsizei>(weights.size()), weights.data());
+		be::gl::uniformVec2(loc.exponents, calcEvsmExponents(settings));
+
+		// the full-screen triangle covers only the tile's viewport.
+		auto const drawTiles = [&]()
+		{
+			for (auto const& tile : tiles)
+			{
+				if (tile.size <= 0) { continue; }
+				glViewport(tile.x, tile.y, tile.size, tile.size);
+				glUniform4i(loc.tile, tile.x, tile.y, tile.x + tile.size - 1, tile.y + tile.size - 1);
+				be::gl::drawArrays(GL_TRIANGLES, 0, 3);
+			}
+		};
+
+		{
+			BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, scratch.frameBuffer.get());
+			BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, depthTexture, GL_TEXTURE0);
+			glUniform1i(loc.warpSource, GL_TRUE);
+			glUniform2i(loc.direction, 1, 0);
+			drawTiles();
+		}
+
+		{
+			BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, moments.frameBuffer.get());
+			BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, scratch.texture.get(), GL_TEXTURE0);
+			glUniform1i(loc.warpSource, GL_FALSE);
+			glUniform2i(loc.direction, 0, 1);
+			drawTiles();
+		}
+
+		BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, moments.texture.get(), GL_TEXTURE0);
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	char const* const evsmSampleGlsl = R"__(
+uniform vec2 evsmExponents;
+uniform float evsmLightBleedReduction;
+uniform float evsmVarianceBias;
+
+float evsmChebyshev(vec2 moments, float mean, float minVariance)
+{
+	float variance = max(moments.y - moments.x * moments.x, minVariance);
+	float d = mean - moments.x;
+	float pMax = variance / (variance + d * d);
+	// cut off the tail of the bound, where light leaks between overlapping occluders.
+	pMax = clamp((pMax - evsmLightBleedReduction) / (1.0f - evsmLightBleedReduction), 0.0f, 1.0f);
+	return mean <= moments.x ? 1.0f : pMax;
+}
+
+float evsmVisibility(sampler2D moments, vec3 lightCoords, float lod)
+{
+	vec4 m = textureLod(moments, lightCoords.xy, lod);
+	float x = lightCoords.z * 2.0f - 1.0f;
+	vec2 warped = vec2(exp(evsmExponents.x * x), -exp(-evsmExponents.y * x));
+	vec2 minVariance = evsmVarianceBias * evsmExponents * warped;
+	minVariance *= minVariance;
+	return min(evsmChebyshev(m.xy, warped.x, minVariance.x), evsmChebyshev(m.zw, warped.y, minVariance.y));
+}
+)__";
+
+	EvsmUniformLocations getEvsmUniformLocations(GLuint const program)
+	{
+		return EvsmUniformLocations{
+			.exponents = static_cast<GLuint>(glGetUniformLocation(program, "evsmExponents")),
+			.lightBleedReduction = static_cast<GLuint>(glGetUniformLocation(program, "evsmLightBleedReduction")),
+			.varianceBias = static_cast<GLuint>(glGetUniformLocation(program, "evsmVarianceBias")),
+		};
+	}
+
+	void uniformEvsm(EvsmUniformLocations const& locations, EvsmSettings const& settings)
+	{
+		be::gl::uniformVec2(locations.exponents, calcEvsmExponents(settings));
+		glUniform1f(locations.lightBleedReduction, std::clamp(settings.lightBleedReduction, 0.0f, 0.99f));
+		glUniform1f(locations.varianceBias, settings.varianceBias);
+	}
+}
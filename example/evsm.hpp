@@ -0,0 +1,93 @@
+
+#pragma once
+
+#include <span>
+#include <be/be.hpp>
+
+namespace example
+{
+	/*
+	//	Exponential variance shadow maps: the light's depth map is warped into two exponential moments
+	//	per texel and blurred, so a fragment's visibility is one trilinear, mipmapped fetch
+	//	bounded by Chebyshev's inequality, and the shadow edges come out soft.
+	*/
+	struct EvsmSettings
+	{
+		// Steepness of the positive and negative warps. Higher leaks less light where occluders overlap.
+		// Clamped to what 32 bit float moments can hold (42 and 42).
+		float positiveExponent = 40.0f;
+		float negativeExponent = 5.0f;
+		// 0 to 1. Cuts off the low end of the Chebyshev bound, where leaked light shows, at the cost of harder penumbrae.
+		float lightBleedReduction = 0.3f;
+		// Scales the minimum variance with the warped depth, hiding acne on surfaces facing the light.
+		float varianceBias = 0.0005f;
+		// Texels blurred on each side; 0 to maxBlurRadius.
+		int blurRadius = 3;
+	};
+
+	class EvsmBlurShader
+	{
+	private:
+		be::gl::ShaderProgram m_shader{};
+		struct UniformLocations {
+			GLuint source;
+			GLuint warpSource;
+			GLuint direction;
+			GLuint radius;
+			GLuint weights;
+			GLuint exponents;
+			GLuint tile;
+		} m_uniformLocations{};
+		be::mem::gl::VertexArray m_emptyVertexArray; // the full-screen triangle comes from gl_VertexID
+
+	public:
+		static constexpr int maxBlurRadius = 8;
+
+		EvsmBlurShader();
+		GLuint program() const { return m_shader.program.get(); }
+		UniformLocations const& uniformLocations() const { return m_uniformLocations; }
+		GLuint emptyVertexArray() const { return m_emptyVertexArray.get(); }
+	};
+
+	// A square RGBA32F colour target holding warped moments: positive, positive squared, negative, negative squared.
+	struct EvsmTarget
+	{
+		be::mem::gl::FrameBuffer frameBuffer;
+		be::mem::gl::Texture texture;
+		int size{};
+	};
+
+	// Targets with more than one level are sampled with trilinear filtering. A lookup at level L within half a
+	// level-L texel of a tile's edge filters in the neighbouring tile, so it must be kept further inside.
+	// An atlas should stop while its smallest tile is still a few texels across, so that tile has an inside.
+	EvsmTarget makeEvsmTarget(int size, int levels, char const* label);
+
+	// Warps and blurs each tile of the |depthTexture| atlas horizontally into |scratch|, then vertically
+	// into |moments|, and rebuilds the mipmaps of |moments|. The taps stay inside their tile.
+	// Both targets must be the atlas's size. Tiles of size 0 are skipped.
+	// Depth testing must be off. Leaves the viewport on the last tile.
+	void filterEvsm(
+		EvsmBlurShader const& shader,
+		GLuint const depthTexture,
+		std::span<be::gl::ShadowTile const> const tiles,
+		EvsmTarget& scratch,
+		EvsmTarget& moments,
+		EvsmSettings const& settings
+	);
+
+	/*
+	//	GLSL for the fragment shaders that sample the moments, pasted in ahead of their main:
+	//		float evsmVisibility(sampler2D moments, vec3 lightCoords, float lod)
+	//	where lightCoords is in [0,1] on every axis. Its uniforms are set with uniformEvsm.
+	*/
+	extern char const* const evsmSampleGlsl;
+
+	struct EvsmUniformLocations
+	{
+		GLuint exponents{};
+		GLuint lightBleedReduction{};
+		GLuint varianceBias{};
+	};
+	EvsmUniformLocations getEvsmUniformLocations(GLuint program);
+	void uniformEvsm(EvsmUniformLocations const& locations, EvsmSettings const& settings);
+}
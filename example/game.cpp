@@ -4,54 +4,83 @@
 
 namespace example
 {
+	BE_ERROR_SITE(audioErrors, "example audio");
+
+
+
 	Game::Game()
 	{
-		screenSize.x = glutGet(GLUT_SCREEN_WIDTH);
-		screenSize.y = glutGet(GLUT_SCREEN_HEIGHT);
+		BE_PROFILE_SCOPE("example::Game::Game");
+
+		if (be::Application::isHeadless())
+		{
+			screenSize.x = be::Application::getWindowWidth();
+			screenSize.y = be::Application::getWindowHeight();
+		}
+		else
+		{
+			screenSize.x = glutGet(GLUT_SCREEN_WIDTH);
+			screenSize.y = glutGet(GLUT_SCREEN_HEIGHT);
+		}
 
 
-		skyboxCubemap = be::basic_assets::textures::loadSkyboxCubemap(assets::basicAssetsFolder);
+		skyboxCubemap = resources.add(be::basic_assets::textures::loadSkyboxCubemap(assets::basicAssetsFolder));
 		skyboxMesh = be::pink::makeSkyboxMesh();
 
 
-		quadMesh = be::basic_assets::meshes::makeQuadMesh();
-		cubeMesh = be::basic_assets::meshes::makeCubeMesh();
+		quadMesh = resources.add(be::basic_assets::meshes::makeQuadMesh());
+		cubeMesh = resources.add(be::basic_assets::meshes::makeCubeMesh());
+
 
+		meshPool = be::gl::MeshPool({ .drawIdAttribute = be::gl::basicDrawIdAttribute });
+		quadRange = be::basic_assets::meshes::addQuadMesh(meshPool);
 
-		groundTexture = example::loadGroundTexture();
-		flagTexture = be::basic_assets::textures::loadFlagTexture(assets::basicAssetsFolder);
 
+		textureStreamer.emplace(be::texture_stream::TextureStreamer::CreateInfo{});
+		groundTexture = example::loadGroundTexture(*textureStreamer);
+		flagTexture = resources.add(be::basic_assets::textures::loadFlagTexture(assets::basicAssetsFolder));
 
-		picketFenceModel = example::loadPicketFenceModel();
+
+		picketFenceModel = example::loadPicketFenceModel(&meshPool);
 
 
 		textGlyphMesh = be::pink::text_label::makeTextGlyphMesh();
 		FT_UInt const fontSize = 24;
 		arialFont = be::basic_assets::fonts::loadArialFont(assets::basicAssetsFolder, fontSize, 0);
 		lineHeight = static_cast<float>(fontSize) * 1.5f;
-		tabWidth = static_cast<float>(4 * arialFont.at(' ').advance);
+		tabWidth = static_cast<float>(4 * arialFont.glyphs.at(' ').advance);
 
 
-		audio = be::mem::fmod::System_Create_init(
-			30,
-			FMOD_INIT_NORMAL | FMOD_INIT_3D_RIGHTHANDED,
-			nullptr
-		);
+		audio = be::mem::fmod::System_Create();
+		if (be::Application::isHeadless())
+		{
+			// CI machines have no audio device.
+			be::mem::fmod::require_ok(audio->setOutput(FMOD_OUTPUTTYPE_NOSOUND), "[example] FMOD::System::setOutput failed");
+		}
+		be::mem::fmod::require_ok(
+			audio->init(30, FMOD_INIT_NORMAL | FMOD_INIT_3D_RIGHTHANDED, nullptr),
+			"[example] FMOD::System::init failed");
 
 		shadowScene.emplace(typename ShadowScene::CreateInfo{
-			.audio = *audio
+			.audio = *audio,
+			.shadowMapSize = 1024,
+			.extraLightCount = 2,
+			.pointLight = true,
+			.clusteredLightCount = 64,
+			.occluderCount = 4,
 			});
 
-		this->onWindowSizeChanged(glutGet(GLUT_WINDOW_WIDTH), glutGet(GLUT_WINDOW_HEIGHT));
-		this->update();
+		this->onWindowSizeChanged(be::Application::getWindowWidth(), be::Application::getWindowHeight());
+		this->update(0.0f);
 	}
 
-	void Game::Update()
+	void Game::Update(float deltaTime)
 	{
 		try
 		{
 #if 1
 			shadowScene->update({
+				.deltaTime = deltaTime,
 				.input = input,
 				.mousePositionInWindow = mousePositionInWindow,
 				.previousMousePositionInWindow = previousMousePositionInWindow,
@@ -99,7 +128,10 @@ namespace example
 				});
 #endif 1
 
-			be::mem::fmod::require_ok(audio->update(), "[example] FMOD::System::update failed");
+			if (FMOD_OK != audio->update())
+			{
+				audioErrors.report("FMOD::System::update failed");
+			}
 
 		}
 		catch (...) { be::Application::logException(); }
@@ -112,7 +144,7 @@ namespace example
 		{
 			glm::ivec2 const v = glm::ivec2(screenSize.x / 2, screenSize.y / 2);
 			previousMousePositionInWindow = v;
-			glutWarpPointer(v.x, v.y);
+			if (!be::Application::isHeadless()) { glutWarpPointer(v.x, v.y); }
 		}
 		else
 		{
@@ -122,10 +154,14 @@ namespace example
 		be::input::afterUpdate(this->input);
 	}
 
-	void Game::Render()
+	void Game::Render(float interpolation)
 	{
 #if 1
+		textureStreamer->request(groundTexture, shadowScene->calcGroundTextureTexels(windowSize));
+		textureStreamer->update();
+
 		shadowScene->render({
+			.interpolation = interpolation,
 			//.input = input,
 			//.mousePositionInWindow = mousePositionInWindow,
 			//.previousMousePositionInWindow = previousMousePositionInWindow,
@@ -136,24 +172,31 @@ namespace example
 
 			//.isFullScreen = isFullScreen,
 
+			.resources = resources,
+
 			.skyboxShader = skyboxShader,
 			.skyboxMesh = skyboxMesh,
-			.skyboxCubemap = skyboxCubemap.get(),
+			.skyboxCubemap = skyboxCubemap,
 
 			.shadowShader = shadowShader,
+			.evsmBlurShader = evsmBlurShader,
+			.pointShadowShader = pointShadowShader,
 
 			.lightGizmoShader = lightGizmoShader,
 
 			.quadMesh = quadMesh,
 			.cubeMesh = cubeMesh,
 
+			.meshPool = meshPool,
+			.quadRange = quadRange,
+
 			.depthMapQuadShader = depthMapQuadShader,
 
 			.groundShader = groundShader,
-			.groundTexture = groundTexture.get(),
+			.groundTexture = textureStreamer->texture(groundTexture),
 
 			.unlitShader = unlitShader,
-			.flagTexture = flagTexture.get(),
+			.flagTexture = flagTexture,
 
 			.picketFenceShader = picketFenceShader,
 			.picketFenceModel = picketFenceModel,
@@ -169,16 +212,18 @@ namespace example
 			.windowSize = windowSize,
 			.windowAspect = windowAspect,
 
+			.resources = resources,
+
 			.quadMesh = quadMesh,
 			.unlitShader = unlitShader,
-			.flagTexture = flagTexture.get(),
+			.flagTexture = flagTexture,
 
 			.skyboxShader = skyboxShader,
 			.skyboxMesh = skyboxMesh,
-			.skyboxCubemap = skyboxCubemap.get(),
+			.skyboxCubemap = skyboxCubemap,
 
 			.waterShader = waterShader,
-			.waterTexture = flagTexture.get(),
+			.waterTexture = flagTexture,
 			});
 #endif 1
 	}
@@ -192,40 +237,59 @@ namespace example
 	void Game::OnKeyGoingDown(unsigned char key)
 	{
 		be::input::informGoingDown(input.keyboardKeys, key);
-		printf_s("Key %c is going down!\n", key);
+		be::Application::logf(be::LogLevel::Debug, "Key %c is going down!", key);
 	}
 
 	void Game::OnKeyGoingUp(unsigned char key)
 	{
 		be::input::informGoingUp(input.keyboardKeys, key);
-		printf_s("Key %c is going up!\n", key);
+		be::Application::logf(be::LogLevel::Debug, "Key %c is going up!", key);
 	}
 
 	void Game::OnSpecialGoingDown(int keycode)
 	{
-		be::input::informGoingDown(input.specialKeys, keycode);
-
-		if (be::InputState::GoingDown == input.specialKeys[keycode])
+		if (be::InputState::GoingDown == be::input::informGoingDown(input.specialKeys, keycode))
 		{
 			if (keycode == GLUT_KEY_F11)
 			{
 				isFullScreen = !isFullScreen;
-				if (isFullScreen) {
-					glutFullScreen();
-					glutSetCursor(GLUT_CURSOR_NONE);
+				// a headless replay still toggles the flag, but has no window to change.
+				if (!be::Application::isHeadless())
+				{
+					if (isFullScreen) {
+						glutFullScreen();
+						glutSetCursor(GLUT_CURSOR_NONE);
+					}
+					else {
+						int const w = 1920 / 2;
+						int const h = 1080 / 2;
+						glutPositionWindow((screenSize.x - w) / 2, (screenSize.y - h) / 2);
+						glutReshapeWindow(w, h);
+						glutLeaveFullScreen();
+						glutSetCursor(GLUT_CURSOR_LEFT_ARROW);
+					}
 				}
-				else {
-					int const w = 1920 / 2;
-					int const h = 1080 / 2;
-					glutPositionWindow((screenSize.x - w) / 2, (screenSize.y - h) / 2);
-					glutReshapeWindow(w, h);
-					glutLeaveFullScreen();
-					glutSetCursor(GLUT_CURSOR_LEFT_ARROW);
+			}
+			else if (keycode == GLUT_KEY_F5)
+			{
+				// the scenes hold handles, so swapping what they refer to is all a reload takes.
+				try
+				{
+					resources.replace(skyboxCubemap, be::basic_assets::textures::loadSkyboxCubemap(assets::basicAssetsFolder));
+					resources.replace(flagTexture, be::basic_assets::textures::loadFlagTexture(assets::basicAssetsFolder));
+					be::Application::log(be::LogLevel::Info, "Reloaded the skybox and flag textures");
 				}
+				catch (...) { be::Application::logException(); }
+			}
+			else if (keycode == GLUT_KEY_F9)
+			{
+				be::profile::writeChromeTraceFile("trace.json", 120);
+				be::Application::log(be::LogLevel::Info, "Wrote the last 120 frames to trace.json");
 			}
 			else if (keycode == GLUT_KEY_F4)
 			{
-				if ((glutGetModifiers() & GLUT_ACTIVE_ALT) != 0)
+				// modifiers are only known inside a live GLUT callback.
+				if (!be::Application::isReplayingInput() && (glutGetModifiers() & GLUT_ACTIVE_ALT) != 0)
 				{
 					be::Application::exit();
 				}
@@ -250,12 +314,12 @@ namespace example
 
 	void Game::OnMouseWheelPositive(int wheel)
 	{
-		printf_s("wheel + #%d\n", wheel);
+		be::Application::logf(be::LogLevel::Debug, "wheel + #%d", wheel);
 	}
 
 	void Game::OnMouseWheelNegative(int wheel)
 	{
-		printf_s("wheel - #%d\n", wheel);
+		be::Application::logf(be::LogLevel::Debug, "wheel - #%d", wheel);
 	}
 
 	//void Game::OnMouseMoveWhileAnyDown()
@@ -270,12 +334,12 @@ namespace example
 
 	void Game::OnMouseEnteredWindow()
 	{
-		printf_s("Entered\n");
+		be::Application::log(be::LogLevel::Debug, "Entered");
 	}
 
 	void Game::OnMouseLeftWindow()
 	{
-		printf_s("Left\n");
+		be::Application::log(be::LogLevel::Debug, "Left");
 	}
 
 	void Game::OnWindowPositionChanged(int x, int y)
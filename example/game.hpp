@@ -2,8 +2,13 @@
 CONTROLS
 ALT+F4		exits the game
 F11			toggles fullscreen
+F9			writes a profiler trace of the last 120 frames to trace.json
+F5			reloads the skybox and flag textures from disk
 W/A/S/D		move the light source
 RMB+Drag	orbit the camera
+Z			toggles the depth prepass
+H			toggles the clustered light heat map, coloured by how many lights each pixel loops over
+O			toggles occlusion culling behind the nearest picket fences
 */
 
 #pragma once
@@ -32,24 +37,32 @@ namespace example
 
 		// RESOURCES
 
+		std::optional<be::texture_stream::TextureStreamer> textureStreamer; // declared before the textures it streams
+		be::gl::ResourceRegistry resources; // owns what the handles below refer to
+
 		be::pink::SkyboxShader skyboxShader;
 		be::pink::SkyboxMesh skyboxMesh;
-		be::mem::gl::Texture skyboxCubemap;
+		be::gl::TextureHandle skyboxCubemap;
 
 		ShadowShader shadowShader;
+		EvsmBlurShader evsmBlurShader;
+		PointShadowShader pointShadowShader;
 
 		LightGizmoShader lightGizmoShader;
 
-		be::gl::BasicMesh quadMesh;
-		be::gl::BasicMesh cubeMesh;
+		be::gl::MeshHandle quadMesh;
+		be::gl::MeshHandle cubeMesh;
+
+		be::gl::MeshPool meshPool; // declared before the models that live in it
+		be::gl::MeshRange quadRange;
 
 		DepthMapQuadShader depthMapQuadShader;
 
 		GroundShader groundShader;
-		be::mem::gl::Texture groundTexture;
+		be::texture_stream::TextureHandle groundTexture;
 
 		be::pink::UnlitShader unlitShader;
-		be::mem::gl::Texture flagTexture;
+		be::gl::TextureHandle flagTexture;
 
 		PicketFenceShader picketFenceShader;
 		be::pink::model::Model picketFenceModel;
@@ -83,8 +96,8 @@ namespace example
 
 	private:
 		// INTERFACE IMPLEMENTATION
-		void Update() final;
-		void Render() final;
+		void Update(float deltaTime) final;
+		void Render(float interpolation) final;
 		void OnMousePositionInWindowChanged(int x, int y) final;
 		void OnKeyGoingDown(unsigned char key) final;
 		void OnKeyGoingUp(unsigned char key) final;
@@ -16,15 +16,15 @@ out V2F {
 	vec3 FragPos;
 	vec3 Normal;
 	vec2 TexCoords;
-	vec4 FragPosLightSpace;
 } v2f;
 
 uniform mat4 mvp;
 uniform mat4 model;
 uniform mat3 fixNormals;
-uniform mat4 lightMvp;
 uniform vec2 uvScale = vec2(1.0f);
 
+invariant gl_Position; // matches ShadowShader's depth prepass
+
 void main()
 {
 	vec4 p = vec4(inPosition, 1.0f);
@@ -32,10 +32,9 @@ void main()
 	v2f.FragPos = vec3(model * p);
 	v2f.Normal = fixNormals * inNormal;
 	v2f.TexCoords = inTexCoords * uvScale;
-	v2f.FragPosLightSpace = lightMvp * p;
 }
 )__";
-		char const* const fragmentShader = R"__(
+		std::string const fragmentShader = R"__(
 #version 330 core
 
 out vec4 outColor;
@@ -44,20 +43,87 @@ in V2F {
 	vec3 FragPos;
 	vec3 Normal;
 	vec2 TexCoords;
-	vec4 FragPosLightSpace;
 } v2f;
 
 uniform sampler2D diffuseTexture;
-uniform sampler2D shadowMap;
-uniform vec3 lightDir;
+uniform sampler2D shadowMap; // an atlas with one tile per light
+uniform sampler2D shadowMoments; // the same atlas filtered, see evsm.hpp
+uniform bool filteredShadows;
+uniform samplerBuffer shadowLights; // per light: light space matrix, tile rect, direction, colour
+uniform int shadowLightBase;
+uniform int shadowLightStride; // texels per light, be::gl::ShadowAtlas::texelsPerLight
+uniform int shadowLightCount;
 uniform vec3 viewPos;
 uniform float maxShadowDistance;
+uniform bool pointLightEnabled;
+uniform vec3 pointLightPosition;
+uniform vec3 pointLightColor;
+uniform float pointLightRange;
+uniform samplerCube pointShadowMap; // distance to the light / range, see point_shadow.hpp
+uniform bool clusteredLights;
+uniform bool clusterHeat;
+)__" + std::string(evsmSampleGlsl) + std::string(be::gl::lightClustersGlsl) + R"__(
+// black through blue, green and red to white as the count climbs towards 32.
+vec3 calcHeat(int count)
+{
+	float t = clamp(float(count) / 32.0f, 0.0f, 1.0f) * 4.0f;
+	return clamp(vec3(t - 2.0f, 1.0f - abs(t - 2.0f), 1.0f - abs(t - 1.0f)), 0.0f, 1.0f) + max(t - 3.0f, 0.0f);
+}
+
+float calcIllumination(mat4 lightSpaceMatrix, vec4 tileRect)
+{
+	// CALCULATE SHADOW
+	// perform perspective divide
+	vec4 fragPosLightSpace = lightSpaceMatrix * vec4(v2f.FragPos, 1.0f);
+	vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+
+	// transform to [0,1] range
+	projCoords = projCoords * 0.5f + 0.5f;
+
+	// get depth of current fragment from light's perspective
+	float currentDepth = projCoords.z;
+
+	// the filtered fetch blends the two mip levels around its footprint, so it reads the coarser one's texels.
+	// the branch is uniform, so the derivatives are defined.
+	float tileTexels = max(1.0f, tileRect.z * float(textureSize(shadowMap, 0).x));
+	float lod = 0.0f;
+	if (filteredShadows)
+	{
+		vec2 texels = projCoords.xy * tileTexels;
+		lod = ceil(max(0.0f, log2(max(length(dFdx(texels)), length(dFdy(texels))))));
+	}
+
+	// into the light's tile, kept half a texel of that level inside it so no lookup reaches the neighbouring tile.
+	float inset = min(0.5f, 0.5f * exp2(lod) / tileTexels);
+	vec2 atlasCoords = tileRect.xy + clamp(projCoords.xy, inset, 1.0f - inset) * tileRect.zw;
+
+	// one fetch either way.
+	float visibility;
+	if (filteredShadows)
+	{
+		visibility = evsmVisibility(shadowMoments, vec3(atlasCoords, projCoords.z), lod);
+	}
+	else
+	{
+		// get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
+		float closestDepth = texture(shadowMap, atlasCoords).r;
+
+		// check whether current frag pos is in shadow
+		float bias = 0.001f;
+		visibility = currentDepth - bias > closestDepth ? 0.0f : 1.0f;
+	}
+
+	// a light that got no tile casts no shadow.
+	return (tileRect.z <= 0.0f || projCoords.x < 0.0f || projCoords.x > 1.0f || projCoords.y < 0.0f || projCoords.y > 1.0f)
+		? 1.0f
+		: (currentDepth < maxShadowDistance ? visibility : 1.0f);
+}
 
 void main()
 {
 	vec3 color = texture(diffuseTexture, v2f.TexCoords).rgb;
 	vec3 normal = normalize(v2f.Normal);
-	vec3 lightColor = vec3(1.0f);
+	vec3 viewDir = normalize(viewPos - v2f.FragPos);
 
 
 	// ambient
@@ -65,72 +131,104 @@ void main()
 	vec3 ambient = 0.05f * color;
 
 
-	// diffuse
-	float diff = max(dot(lightDir, normal), 0.0f);
-	vec3 diffuse = diff * lightColor;
-
-
-	// specular
-	vec3 viewDir = normalize(viewPos - v2f.FragPos);
-	vec3 halfwayDir = normalize(lightDir + viewDir);
-	float spec = pow(max(dot(normal, halfwayDir), 0.0f), 64.0f);
-	vec3 specular = spec * lightColor;
-
-
+	// the albedo is lit by the brightest unshadowed light, and the highlights by all of them.
+	float albedoStr = ambientStr;
+	vec3 highlights = vec3(0.0f);
+	for (int light = 0; light < shadowLightCount; ++light)
+	{
+		int i = shadowLightBase + light * shadowLightStride;
+		mat4 lightSpaceMatrix = mat4(texelFetch(shadowLights, i), texelFetch(shadowLights, i + 1), texelFetch(shadowLights, i + 2), texelFetch(shadowLights, i + 3));
+		vec4 tileRect = texelFetch(shadowLights, i + 4);
+		vec3 lightDir = texelFetch(shadowLights, i + 5).xyz;
+		vec3 lightColor = texelFetch(shadowLights, i + 6).rgb;
+
+		// diffuse
+		float diff = max(dot(lightDir, normal), 0.0f);
+		vec3 diffuse = diff * lightColor;
+
+		// specular
+		vec3 halfwayDir = normalize(lightDir + viewDir);
+		float spec = pow(max(dot(normal, halfwayDir), 0.0f), 64.0f);
+		vec3 specular = spec * lightColor;
+
+		float illumination = calcIllumination(lightSpaceMatrix, tileRect);
+		albedoStr = max(albedoStr, illumination * max(lightColor.r, max(lightColor.g, lightColor.b)));
+		highlights += illumination * (diffuse + specular);
+	}
 
-	// CALCULATE SHADOW
-	// perform perspective divide
-	vec3 projCoords = v2f.FragPosLightSpace.xyz / v2f.FragPosLightSpace.w;
+	if (pointLightEnabled)
+	{
+		vec3 toLight = pointLightPosition - v2f.FragPos;
+		float distance = length(toLight);
+		vec3 lightDir = toLight / distance;
+		float attenuation = clamp(1.0f - distance / pointLightRange, 0.0f, 1.0f);
+		attenuation *= attenuation;
 
-	// transform to [0,1] range
-	projCoords = projCoords * 0.5f + 0.5f;
+		float diff = max(dot(lightDir, normal), 0.0f);
+		vec3 halfwayDir = normalize(lightDir + viewDir);
+		float spec = pow(max(dot(normal, halfwayDir), 0.0f), 64.0f);
 
-	// get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-	float closestDepth = texture(shadowMap, projCoords.xy).r;
+		float closestDistance = texture(pointShadowMap, -toLight).r * pointLightRange;
+		float bias = 0.05f;
+		float visibility = distance - bias > closestDistance ? 0.0f : 1.0f;
 
-	// get depth of current fragment from light's perspective
-	float currentDepth = projCoords.z;
+		highlights += visibility * attenuation * pointLightColor * (diff + spec);
+	}
 
-	// check whether current frag pos is in shadow
-	float bias = 0.001f;
-	float illumination = (projCoords.x < 0.0f || projCoords.x > 1.0f || projCoords.y < 0.0f || projCoords.y > 1.0f)
-		? 1.0f
-		: ((currentDepth < maxShadowDistance && currentDepth - bias > closestDepth)
-		? 0.0f : 1.0f);
+	if (clusteredLights)
+	{
+		if (clusterHeat)
+		{
+			outColor = vec4(calcHeat(countClusterLights(v2f.FragPos)), 1.0f);
+			return;
+		}
+		highlights += calcClusteredLighting(v2f.FragPos, normal, viewDir);
+	}
 
-	vec3 lighting = max(ambientStr, illumination) * color + illumination * (diffuse + specular);
+	vec3 lighting = albedoStr * color + highlights;
 	outColor = vec4(lighting, 1.0f);
 }
 )__";
-		m_shader = be::gl::makeBasicShaderProgram(vertexShader, fragmentShader, "ground.cpp");
+		m_shader = be::gl::makeBasicShaderProgram(vertexShader, fragmentShader.c_str(), "ground.cpp");
 		GLuint const program = m_shader.program.get();
 		m_uniformLocations.diffuseTexture = glGetUniformLocation(program, "diffuseTexture");
-		m_uniformLocations.lightDir = glGetUniformLocation(program, "lightDir");
-		m_uniformLocations.lightMvp = glGetUniformLocation(program, "lightMvp");
 		m_uniformLocations.mvp = glGetUniformLocation(program, "mvp");
 		m_uniformLocations.model = glGetUniformLocation(program, "model");
 		m_uniformLocations.shadowMap = glGetUniformLocation(program, "shadowMap");
+		m_uniformLocations.shadowLights = glGetUniformLocation(program, "shadowLights");
+		m_uniformLocations.shadowLightBase = glGetUniformLocation(program, "shadowLightBase");
+		m_uniformLocations.shadowLightStride = glGetUniformLocation(program, "shadowLightStride");
+		m_uniformLocations.shadowLightCount = glGetUniformLocation(program, "shadowLightCount");
 		m_uniformLocations.viewPos = glGetUniformLocation(program, "viewPos");
 		m_uniformLocations.uvScale = glGetUniformLocation(program, "uvScale");
 		m_uniformLocations.maxShadowDistance = glGetUniformLocation(program, "maxShadowDistance");
+		m_uniformLocations.shadowMoments = glGetUniformLocation(program, "shadowMoments");
+		m_uniformLocations.filteredShadows = glGetUniformLocation(program, "filteredShadows");
+		m_uniformLocations.evsm = getEvsmUniformLocations(program);
+		m_uniformLocations.pointLightEnabled = glGetUniformLocation(program, "pointLightEnabled");
+		m_uniformLocations.pointLightPosition = glGetUniformLocation(program, "pointLightPosition");
+		m_uniformLocations.pointLightColor = glGetUniformLocation(program, "pointLightColor");
+		m_uniformLocations.pointLightRange = glGetUniformLocation(program, "pointLightRange");
+		m_uniformLocations.pointShadowMap = glGetUniformLocation(program, "pointShadowMap");
+		m_uniformLocations.clusteredLights = glGetUniformLocation(program, "clusteredLights");
+		m_uniformLocations.clusterHeat = glGetUniformLocation(program, "clusterHeat");
+		m_uniformLocations.clusters = be::gl::getLightClusterUniformLocations(program);
 
 		BE_USE_PROGRAM_SCOPE(program);
 		glUniform1i(m_uniformLocations.diffuseTexture, 0);
+		// a unit of its own until renderGround sets one, so the cube sampler never shares a unit with a 2D one.
+		glUniform1i(m_uniformLocations.pointShadowMap, 15);
+		glUniform1i(m_uniformLocations.clusters.lights, clusterLightsTextureUnit);
+		glUniform1i(m_uniformLocations.clusters.data, clusterDataTextureUnit);
 	}
 
 
 
-	be::mem::gl::Texture loadGroundTexture()
+	be::texture_stream::TextureHandle loadGroundTexture(be::texture_stream::TextureStreamer& streamer)
 	{
-		auto texture = be::soil::load_OGL_texture(
-			"resources/textures/seamless_green_grass_rough_DIFFUSE.jpg",
-			SOIL_LOAD_RGBA, 0, SOIL_FLAG_MIPMAPS
-		);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		return texture;
+		return streamer.load("resources/textures/seamless_green_grass_rough_DIFFUSE.jpg", {
+			.wrap = GL_REPEAT,
+			});
 	}
 
 
@@ -140,28 +238,60 @@ void main()
 		be::gl::BasicMesh const& mesh,
 		GLuint const tex,
 		be::pink::Camera const& camera,
-		glm::vec3 const& lightDir,
-		glm::mat4 const& lightSpaceMatrix,
 		GLint const shadowMapSlotIndex,
+		GLint const shadowLightsSlotIndex,
+		GLint const shadowLightBase,
+		GLint const shadowLightStride,
+		GLint const shadowLightCount,
 		glm::mat4 const& modelMatrix,
 		glm::vec2 const& uvScale,
-		GLfloat const maxShadowDistance
+		GLfloat const maxShadowDistance,
+		GLint const shadowMomentsSlotIndex,
+		EvsmSettings const& evsm,
+		PointLight const& pointLight,
+		GLint const pointShadowSlotIndex,
+		be::gl::LightClusters const* const clusters,
+		bool const showClusterHeat
 	)
 	{
 		BE_USE_PROGRAM_SCOPE(shader.program());
 
 		auto const& loc = shader.uniformLocations();
 		be::gl::uniformMat3(loc.fixNormals, be::pink::calcFixNormalsMatrix(modelMatrix));
-		be::gl::uniformVec3(loc.lightDir, glm::normalize(lightDir));
-		be::gl::uniformMat4(loc.lightMvp, lightSpaceMatrix * modelMatrix);
 		be::gl::uniformMat4(loc.model, modelMatrix);
 		be::gl::uniformMat4(loc.mvp, camera.vp * modelMatrix);
 		glUniform1i(loc.shadowMap, shadowMapSlotIndex);
+		glUniform1i(loc.shadowLights, shadowLightsSlotIndex);
+		glUniform1i(loc.shadowLightBase, shadowLightBase);
+		glUniform1i(loc.shadowLightStride, shadowLightStride);
+		glUniform1i(loc.shadowLightCount, shadowLightCount);
 		be::gl::uniformVec2(loc.uvScale, uvScale);
 		be::gl::uniformVec3(loc.viewPos, camera.position);
 		glUniform1f(loc.maxShadowDistance, maxShadowDistance);
+		glUniform1i(loc.filteredShadows, shadowMomentsSlotIndex >= 0);
+		if (shadowMomentsSlotIndex >= 0)
+		{
+			glUniform1i(loc.shadowMoments, shadowMomentsSlotIndex);
+			uniformEvsm(loc.evsm, evsm);
+		}
+		glUniform1i(loc.pointLightEnabled, pointShadowSlotIndex >= 0);
+		if (pointShadowSlotIndex >= 0)
+		{
+			glUniform1i(loc.pointShadowMap, pointShadowSlotIndex);
+			be::gl::uniformVec3(loc.pointLightPosition, pointLight.position);
+			be::gl::uniformVec3(loc.pointLightColor, pointLight.color);
+			glUniform1f(loc.pointLightRange, pointLight.range);
+		}
+		glUniform1i(loc.clusteredLights, clusters != nullptr);
+		glUniform1i(loc.clusterHeat, showClusterHeat);
+		if (clusters)
+		{
+			be::gl::uniformLightClusters(loc.clusters, *clusters, GroundShader::clusterLightsTextureUnit, GroundShader::clusterDataTextureUnit);
+		}
 
 		BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, tex, GL_TEXTURE0);
+		BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_BUFFER, clusters ? clusters->lightTexture() : 0, GL_TEXTURE0 + GroundShader::clusterLightsTextureUnit);
+		BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_BUFFER, clusters ? clusters->dataTexture() : 0, GL_TEXTURE0 + GroundShader::clusterDataTextureUnit);
 
 		be::gl::drawBasicMesh(mesh);
 	}
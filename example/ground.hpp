@@ -3,6 +3,9 @@
 
 #include <be/be.hpp>
 
+#include "evsm.hpp"
+#include "point_shadow.hpp"
+
 namespace example
 {
 	class GroundShader
@@ -13,33 +16,62 @@ namespace example
 			GLuint mvp;
 			GLuint model;
 			GLuint fixNormals;
-			GLuint lightMvp;
 			GLuint shadowMap;
-			GLuint lightDir;
+			GLuint shadowLights;
+			GLuint shadowLightBase;
+			GLuint shadowLightStride;
+			GLuint shadowLightCount;
 			GLuint viewPos;
 			GLuint diffuseTexture;
 			GLuint uvScale;
 			GLuint maxShadowDistance;
+			GLuint shadowMoments;
+			GLuint filteredShadows;
+			EvsmUniformLocations evsm;
+			GLuint pointLightEnabled;
+			GLuint pointLightPosition;
+			GLuint pointLightColor;
+			GLuint pointLightRange;
+			GLuint pointShadowMap;
+			GLuint clusteredLights;
+			GLuint clusterHeat;
+			be::gl::LightClusterUniformLocations clusters;
 		} m_uniformLocations{};
 
 	public:
+		// each light in the be::gl::ShadowAtlas table carries, after its matrix and tile,
+		// the direction it shines in (xyz) and its colour (rgb).
+		static constexpr int extraTexelsPerLight = 2;
+		// where renderGround binds the be::gl::LightClusters textures.
+		static constexpr GLint clusterLightsTextureUnit = 13;
+		static constexpr GLint clusterDataTextureUnit = 14;
+
 		GroundShader();
 		GLuint program() const { return m_shader.program.get(); }
 		UniformLocations const& uniformLocations() const { return m_uniformLocations; }
 	};
 
-	be::mem::gl::Texture loadGroundTexture();
+	// Streamed, so it shows a placeholder colour until the streamer has uploaded its first levels.
+	be::texture_stream::TextureHandle loadGroundTexture(be::texture_stream::TextureStreamer& streamer);
 
 	void renderGround(
 		GroundShader const& shader,
 		be::gl::BasicMesh const& mesh,
 		GLuint const tex,
 		be::pink::Camera const& camera,
-		glm::vec3 const& lightDir,
-		glm::mat4 const& lightSpaceMatrix,
-		GLint const shadowMapSlotIndex,
+		GLint const shadowMapSlotIndex, // the be::gl::ShadowAtlas depth texture
+		GLint const shadowLightsSlotIndex, // the atlas's light table, bound to GL_TEXTURE_BUFFER
+		GLint const shadowLightBase,
+		GLint const shadowLightStride, // the atlas's texelsPerLight
+		GLint const shadowLightCount,
 		glm::mat4 const& modelMatrix,
 		glm::vec2 const& uvScale,
-		GLfloat const maxShadowDistance
+		GLfloat const maxShadowDistance,
+		GLint const shadowMomentsSlotIndex, // -1 for the hard comparison against the depth map
+		EvsmSettings const& evsm,
+		PointLight const& pointLight,
+		GLint const pointShadowSlotIndex, // its PointShadowMap cube map, or -1 for no point light
+		be::gl::LightClusters const* const clusters, // assigned for |camera| this frame, or nullptr for none
+		bool const showClusterHeat // shades by how many lights each pixel loops over instead
 	);
 }
@@ -1,18 +1,68 @@
 
 //#include <vld.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 #include <be/application.hpp>
+#include <be/async_logger.hpp>
 
 #include "game.hpp"
 
 int main(int argc, char** argv)
 {
 	using namespace example;
-	be::DefaultLogger logger;
+
+	// example --log example.log
+	be::AsyncLogger::CreateInfo loggerInfo;
+#ifdef _DEBUG
+	loggerInfo.minLevel = be::LogLevel::Debug;
+#endif
+	loggerInfo.sinks.push_back(std::make_shared<be::ConsoleLogSink>());
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (0 == std::strcmp(argv[i], "--log"))
+		{
+			try { loggerInfo.sinks.push_back(std::make_shared<be::FileLogSink>(argv[++i])); }
+			catch (std::exception const& e) { std::cerr << e.what() << '\n'; return 1; }
+		}
+	}
+	be::AsyncLogger logger{ loggerInfo };
+
 	be::ApplicationRunInfo info = {};
 	info.logger = &logger;
 	info.argc = &argc;
 	info.argv = argv;
 	info.createGame = [] { return std::make_unique<Game>(); };
 	info.windowTitle = "be example";
+	info.enableProfiler = true;
+	info.maxFrameRate = 144.0;
+
+	// example --headless-frames 600
+	// example --headless-seconds 10
+	// example --record input.bin
+	// example --replay input.bin
+	// example --replay input.bin --headless-frames 0
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (0 == std::strcmp(argv[i], "--headless-frames"))
+		{
+			info.headless = true;
+			info.headlessFrameCount = std::atoi(argv[++i]);
+		}
+		else if (0 == std::strcmp(argv[i], "--headless-seconds"))
+		{
+			info.headless = true;
+			info.headlessSeconds = std::atof(argv[++i]);
+		}
+		else if (0 == std::strcmp(argv[i], "--record"))
+		{
+			info.recordInputPath = argv[++i];
+		}
+		else if (0 == std::strcmp(argv[i], "--replay"))
+		{
+			info.replayInputPath = argv[++i];
+		}
+	}
+
 	be::Application::run(info);
 }
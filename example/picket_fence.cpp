@@ -1,4 +1,7 @@
 
+#include <algorithm>
+#include <be/mem/frame_arena.hpp>
+
 #include "assets.hpp"
 #include "picket_fence.hpp"
 
@@ -12,27 +15,31 @@ namespace example
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexCoords;
+layout(location = 3) in uint inDrawId;
 
 out V2F {
 	vec3 FragPos;
 	vec3 Normal;
 	vec2 TexCoords;
-	vec4 FragPosLightSpace;
 } v2f;
 
-uniform mat4 mvp;
-uniform mat4 model;
-uniform mat3 fixNormals;
-uniform mat4 lightSpaceMatrix;
+uniform samplerBuffer perDraw; // per draw: mvp, model, fixNormals (3 columns)
+uniform int perDrawBase;
+
+invariant gl_Position; // matches ShadowShader's depth prepass
 
 void main()
 {
+	int i = perDrawBase + int(inDrawId) * 11;
+	mat4 mvp = mat4(texelFetch(perDraw, i), texelFetch(perDraw, i + 1), texelFetch(perDraw, i + 2), texelFetch(perDraw, i + 3));
+	mat4 model = mat4(texelFetch(perDraw, i + 4), texelFetch(perDraw, i + 5), texelFetch(perDraw, i + 6), texelFetch(perDraw, i + 7));
+	mat3 fixNormals = mat3(texelFetch(perDraw, i + 8).xyz, texelFetch(perDraw, i + 9).xyz, texelFetch(perDraw, i + 10).xyz);
+
 	vec4 p = vec4(inPosition, 1.0f);
 	gl_Position = mvp * p;
 	v2f.FragPos = vec3(model * p);
 	v2f.Normal = normalize(fixNormals * inNormal);
 	v2f.TexCoords = inTexCoords;
-	v2f.FragPosLightSpace = lightSpaceMatrix * vec4(v2f.FragPos, 1.0f);
 }
 )__";
 		char const* const fragmentShader = R"__(
@@ -44,22 +51,32 @@ in V2F {
 	vec3 FragPos;
 	vec3 Normal;
 	vec2 TexCoords;
-	vec4 FragPosLightSpace;
 } v2f;
 
 uniform sampler2D diffuseTextures[4];
-uniform sampler2D shadowMap;
-uniform vec3 lightPos;
+uniform sampler2D shadowMap; // an atlas with one tile per light
+uniform samplerBuffer shadowLights; // per light: light space matrix, tile rect, direction, colour
+uniform int shadowLightBase;
+uniform int shadowLightStride; // texels per light, be::gl::ShadowAtlas::texelsPerLight
+uniform int shadowLightCount;
 uniform vec3 viewPos;
 
-float ShadowCalculation(vec4 fragPosLightSpace)
+float ShadowCalculation(mat4 lightSpaceMatrix, vec4 shadowTile)
 {
 	// perform perspective divide
+	vec4 fragPosLightSpace = lightSpaceMatrix * vec4(v2f.FragPos, 1.0f);
 	vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
 	// transform to [0,1] range
 	projCoords = projCoords * 0.5 + 0.5;
+	// a light that got no tile casts no shadow.
+	if (shadowTile.z <= 0.0f)
+	{
+		return 0.0f;
+	}
+	// into the light's tile, kept half a texel inside it so no lookup reaches the neighbouring tile.
+	float inset = 0.5f / max(1.0f, shadowTile.z * float(textureSize(shadowMap, 0).x));
 	// get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-	float closestDepth = texture(shadowMap, projCoords.xy).r;
+	float closestDepth = texture(shadowMap, shadowTile.xy + clamp(projCoords.xy, inset, 1.0f - inset) * shadowTile.zw).r;
 	// get depth of current fragment from light's perspective
 	float currentDepth = projCoords.z;
 	// check whether current frag pos is in shadow
@@ -72,26 +89,35 @@ void main()
 {
 	vec3 color = texture(diffuseTextures[0], v2f.TexCoords).rgb;
 	vec3 normal = v2f.Normal;
-	vec3 lightColor = vec3(1.0f);
+	vec3 viewDir = normalize(viewPos - v2f.FragPos);
 
 	// ambient
 	vec3 ambient = 0.15 * color;
 
-	// diffuse
-	vec3 lightDir = normalize(lightPos - v2f.FragPos);
-	float diff = max(dot(lightDir, normal), 0.0);
-	vec3 diffuse = diff * lightColor;
-
-	// specular
-	vec3 viewDir = normalize(viewPos - v2f.FragPos);
-	float spec = 0.0;
-	vec3 halfwayDir = normalize(lightDir + viewDir);
-	spec = pow(max(dot(normal, halfwayDir), 0.0f), 64.0f);
-	vec3 specular = spec * lightColor;
-
-	// calculate shadow
-	float shadow = ShadowCalculation(v2f.FragPosLightSpace);
-	vec3 lighting = (ambient + (1.0f - shadow) * (diffuse + specular)) * color;
+	// every light of the table the ground reads, so both are lit alike.
+	vec3 lit = vec3(0.0f);
+	for (int light = 0; light < shadowLightCount; ++light)
+	{
+		int i = shadowLightBase + light * shadowLightStride;
+		mat4 lightSpaceMatrix = mat4(texelFetch(shadowLights, i), texelFetch(shadowLights, i + 1), texelFetch(shadowLights, i + 2), texelFetch(shadowLights, i + 3));
+		vec4 shadowTile = texelFetch(shadowLights, i + 4);
+		vec3 lightDir = texelFetch(shadowLights, i + 5).xyz;
+		vec3 lightColor = texelFetch(shadowLights, i + 6).rgb;
+
+		// diffuse
+		float diff = max(dot(lightDir, normal), 0.0);
+		vec3 diffuse = diff * lightColor;
+
+		// specular
+		vec3 halfwayDir = normalize(lightDir + viewDir);
+		float spec = pow(max(dot(normal, halfwayDir), 0.0f), 64.0f);
+		vec3 specular = spec * lightColor;
+
+		// calculate shadow
+		float shadow = ShadowCalculation(lightSpaceMatrix, shadowTile);
+		lit += (1.0f - shadow) * (diffuse + specular);
+	}
+	vec3 lighting = (ambient + lit) * color;
 
 	outColor = vec4(lighting, 1.0f);
 
@@ -101,12 +127,14 @@ void main()
 )__";
 		m_shader = be::gl::makeBasicShaderProgram(vertexShader, fragmentShader, "picket_fence.cpp");
 
-		m_uniformLocations.mvp = glGetUniformLocation(program(), "mvp");
-		m_uniformLocations.model = glGetUniformLocation(program(), "model");
-		m_uniformLocations.fixNormals = glGetUniformLocation(program(), "fixNormals");
-		m_uniformLocations.lightSpaceMatrix = glGetUniformLocation(program(), "lightSpaceMatrix");
+		m_uniformLocations.perDraw = glGetUniformLocation(program(), "perDraw");
+		m_uniformLocations.perDrawBase = glGetUniformLocation(program(), "perDrawBase");
+		m_uniformLocations.shadowMap = glGetUniformLocation(program(), "shadowMap");
+		m_uniformLocations.shadowLights = glGetUniformLocation(program(), "shadowLights");
+		m_uniformLocations.shadowLightBase = glGetUniformLocation(program(), "shadowLightBase");
+		m_uniformLocations.shadowLightStride = glGetUniformLocation(program(), "shadowLightStride");
+		m_uniformLocations.shadowLightCount = glGetUniformLocation(program(), "shadowLightCount");
 		m_uniformLocations.viewPos = glGetUniformLocation(program(), "viewPos");
-		m_uniformLocations.lightPos = glGetUniformLocation(program(), "lightPos");
 
 		for (size_t i = 0; i < m_uniformLocations.diffuseTextures.size(); ++i)
 		{
@@ -117,74 +145,138 @@ void main()
 		}
 	}
 
-	be::pink::model::Model loadPicketFenceModel()
+	be::pink::model::Model loadPicketFenceModel(be::gl::MeshPool* const pool)
 	{
-		return be::pink::model::loadModel((assets::projectAssetsFolder / "models/Fence.dae").string());
+		return be::pink::model::loadModel((assets::projectAssetsFolder / "models/Fence.dae").string(), pool);
 	}
 
-	void renderPicketFence(
+	PicketFenceCommand makePicketFenceCommand(
+		be::pink::model::MeshInstance const& instance,
+		glm::mat4 const& cameraVp
+	)
+	{
+		return PicketFenceCommand{
+			.mesh = instance.mesh,
+			.mvp = cameraVp * instance.modelMatrix,
+			.model = instance.modelMatrix,
+			.fixNormals = glm::transpose(glm::inverse(glm::mat3(instance.modelMatrix))),
+		};
+	}
+
+	void submitPicketFence(
 		PicketFenceShader const& shader,
+		be::gl::MeshPool const& pool,
+		be::gl::MultiDrawBatch& batch,
 		be::pink::model::Model const& model,
-		be::pink::Camera const& camera,
-		glm::vec3 const& lightPos,
-		glm::mat4 const& lightSpaceMatrix,
-		GLuint const shadowMapTextureIndex,
-		glm::mat4 const& parentModelMatrix
+		glm::vec3 const& viewPos,
+		GLint const shadowMapSlotIndex,
+		GLint const shadowLightsSlotIndex,
+		GLint const shadowLightBase,
+		GLint const shadowLightStride,
+		GLint const shadowLightCount,
+		std::span<PicketFenceCommand const> const commands
 	)
 	{
-		BE_USE_PROGRAM_SCOPE(shader.program());
+		if (commands.empty()) { return; }
 
-		be::gl::uniformMat4(shader.uniformLocations().lightSpaceMatrix, lightSpaceMatrix);
+		BE_USE_PROGRAM_SCOPE(shader.program());
+		BE_BIND_MESH_POOL_SCOPE(pool);
+
+		auto const& loc = shader.uniformLocations();
+		be::gl::uniformVec3(loc.viewPos, viewPos);
+		glUniform1i(loc.shadowMap, shadowMapSlotIndex);
+		glUniform1i(loc.shadowLights, shadowLightsSlotIndex);
+		glUniform1i(loc.shadowLightBase, shadowLightBase);
+		glUniform1i(loc.shadowLightStride, shadowLightStride);
+		glUniform1i(loc.shadowLightCount, shadowLightCount);
+
+		// textures are bound per material, so each material is one multi-draw.
+		be::mem::FrameVector<std::uint32_t> materials{ &be::mem::getFrameArena() };
+		for (auto const& command : commands)
+		{
+			auto const material = command.mesh->material;
+			if (std::find(materials.begin(), materials.end(), material) == materials.end())
+			{
+				materials.push_back(material);
+			}
+		}
 
-		be::gl::uniformVec3(shader.uniformLocations().lightPos, lightPos);
-		be::gl::uniformVec3(shader.uniformLocations().viewPos, camera.position);
-		glUniform1i(shader.uniformLocations().shadowMap, shadowMapTextureIndex);
+		auto const submitBatch = [&]()
+		{
+			batch.submit(pool, PicketFenceShader::perDrawTextureUnit,
+				shader.uniformLocations().perDraw, shader.uniformLocations().perDrawBase);
+		};
 
-		be::pink::model::DrawNodeCallback const drawNode = [&](be::pink::model::Node const& node, glm::mat4 const& modelMatrix)
+		for (auto const materialIndex : materials)
 		{
-			auto const mvp = camera.vp * modelMatrix;
-			be::gl::uniformMat4(shader.uniformLocations().mvp, mvp);
+			auto const& material = model.materials[materialIndex];
 
-			be::gl::uniformMat4(shader.uniformLocations().model, modelMatrix);
+			size_t boundTextures = 0;
+			CRESS_MOO_DEFER_BEGIN(_);
+			for (size_t i = 0; i < boundTextures; ++i)
+			{
+				glActiveTexture(GL_TEXTURE0 + i);
+				be::gl::bindTexture(GL_TEXTURE_2D, 0);
+			}
+			CRESS_MOO_DEFER_END(_);
 
-			auto const fixNormals = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
-			be::gl::uniformMat3(shader.uniformLocations().fixNormals, fixNormals);
+			if (auto const it = material.textureMap.find(aiTextureType_DIFFUSE);
+				it != material.textureMap.end())
+			{
+				auto const& textures = it->second;
+				auto const N = std::min<size_t>(textures.size(), shader.uniformLocations().diffuseTextures.size());
+				for (size_t i = 0; i < N; ++i)
+				{
+					glActiveTexture(GL_TEXTURE0 + i);
+					be::gl::bindTexture(GL_TEXTURE_2D, textures[i].get());
+					glUniform1i(shader.uniformLocations().diffuseTextures[i], i);
+					boundTextures = i + 1;
+				}
+			}
 
-			for (auto const& w : node.meshes)
+			batch.clear();
+			for (auto const& command : commands)
 			{
-				if (auto const mesh = w.lock())
+				if (command.mesh->pool != &pool || command.mesh->material != materialIndex) { continue; }
+
+				if (batch.size() == static_cast<std::size_t>(batch.maxDraws())) { submitBatch(); }
+
+				glm::vec4* const texels = batch.add(command.mesh->range);
+				for (int column = 0; column < 4; ++column)
+				{
+					texels[column] = command.mvp[column];
+					texels[4 + column] = command.model[column];
+				}
+				for (int column = 0; column < 3; ++column)
 				{
-					if (auto const material = mesh->material.lock())
-					{
-						std::vector<std::function<void()>> deferred;
-						CRESS_MOO_DEFER_BEGIN(_);
-						for (auto const& f : deferred) { f(); }
-						CRESS_MOO_DEFER_END(_);
-
-						if (auto const it = material->textureMap.find(aiTextureType_DIFFUSE);
-							it != material->textureMap.end())
-						{
-							auto const& textures = it->second;
-							auto const N = std::min<size_t>(textures.size(), shader.uniformLocations().diffuseTextures.size());
-							for (size_t i = 0; i < N; ++i)
-							{
-								glActiveTexture(GL_TEXTURE0 + i);
-								glBindTexture(GL_TEXTURE_2D, textures[i].get());
-								glUniform1i(shader.uniformLocations().diffuseTextures[i], i);
-
-								deferred.push_back([&shader, i]()noexcept {
-									glActiveTexture(GL_TEXTURE0 + i);
-									glBindTexture(GL_TEXTURE_2D, 0);
-									});
-							}
-						}
-
-						be::gl::drawBasicMesh(mesh->data);
-					}
+					texels[8 + column] = glm::vec4(command.fixNormals[column], 0.0f);
 				}
 			}
-		};
+			submitBatch();
+		}
+	}
+
+	void renderPicketFence(
+		PicketFenceShader const& shader,
+		be::gl::MeshPool const& pool,
+		be::gl::MultiDrawBatch& batch,
+		be::pink::model::Model const& model,
+		be::pink::Camera const& camera,
+		GLint const shadowMapSlotIndex,
+		GLint const shadowLightsSlotIndex,
+		GLint const shadowLightBase,
+		GLint const shadowLightStride,
+		GLint const shadowLightCount,
+		glm::mat4 const& parentModelMatrix
+	)
+	{
+		be::mem::FrameVector<PicketFenceCommand> commands{ &be::mem::getFrameArena() };
+		be::pink::model::forEachMeshInstance(model, parentModelMatrix, [&](be::pink::model::MeshInstance const& instance)
+		{
+			commands.push_back(makePicketFenceCommand(instance, camera.vp));
+		});
 
-		be::pink::model::renderModel(model, drawNode, parentModelMatrix);
+		submitPicketFence(shader, pool, batch, model, camera.position,
+			shadowMapSlotIndex, shadowLightsSlotIndex, shadowLightBase, shadowLightStride, shadowLightCount, commands);
 	}
 }
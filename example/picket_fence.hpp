@@ -2,6 +2,7 @@
 #pragma once
 
 #include <functional>
+#include <span>
 #include <be/be.hpp>
 
 namespace example
@@ -11,31 +12,71 @@ namespace example
 	private:
 		be::gl::ShaderProgram m_shader{};
 		struct UniformLocations {
-			GLuint mvp;
-			GLuint model;
-			GLuint fixNormals;
-			GLuint lightSpaceMatrix;
+			GLuint perDraw;
+			GLuint perDrawBase;
 			GLuint shadowMap;
-			GLuint lightPos;
+			GLuint shadowLights;
+			GLuint shadowLightBase;
+			GLuint shadowLightStride;
+			GLuint shadowLightCount;
 			GLuint viewPos;
 			std::array<GLuint, 4> diffuseTextures;
 		} m_uniformLocations{};
 
 	public:
+		// each draw reads mvp, model and fixNormals from a be::gl::MultiDrawBatch.
+		static constexpr GLsizei texelsPerDraw = 4 + 4 + 3;
+		static constexpr GLuint perDrawTextureUnit = 8; // clear of the diffuse and shadow map units
+
 		PicketFenceShader();
 		GLuint program() const { return m_shader.program.get(); }
 		UniformLocations const& uniformLocations() const { return m_uniformLocations; }
 	};
 	
-	be::pink::model::Model loadPicketFenceModel();
+	be::pink::model::Model loadPicketFenceModel(be::gl::MeshPool* pool = nullptr);
+
+	struct PicketFenceCommand
+	{
+		be::pink::model::Mesh const* mesh;
+		glm::mat4 mvp;
+		glm::mat4 model;
+		glm::mat3 fixNormals;
+	};
+
+	// Touches no GL state, so it may run on a worker thread.
+	PicketFenceCommand makePicketFenceCommand(
+		be::pink::model::MeshInstance const& instance,
+		glm::mat4 const& cameraVp
+	);
+
+	// Sets the per-pass uniforms once, then replays the commands as one multi-draw per material.
+	// The meshes must belong to |model| and live in |pool|. |batch| needs PicketFenceShader::texelsPerDraw texels per draw.
+	// Every light of a be::gl::ShadowAtlas is shadowed, read from its light table as the ground reads it.
+	void submitPicketFence(
+		PicketFenceShader const& shader,
+		be::gl::MeshPool const& pool,
+		be::gl::MultiDrawBatch& batch,
+		be::pink::model::Model const& model,
+		glm::vec3 const& viewPos,
+		GLint const shadowMapSlotIndex, // the be::gl::ShadowAtlas depth texture
+		GLint const shadowLightsSlotIndex, // the atlas's light table, bound to GL_TEXTURE_BUFFER
+		GLint const shadowLightBase,
+		GLint const shadowLightStride, // the atlas's texelsPerLight
+		GLint const shadowLightCount,
+		std::span<PicketFenceCommand const> const commands
+	);
 
 	void renderPicketFence(
 		PicketFenceShader const& shader,
+		be::gl::MeshPool const& pool,
+		be::gl::MultiDrawBatch& batch,
 		be::pink::model::Model const& model,
 		be::pink::Camera const& camera,
-		glm::vec3 const& lightPos,
-		glm::mat4 const& lightSpaceMatrix,
-		GLuint const shadowMapTextureIndex, // e.g. 1 if shadowmap is bound to GL_TEXTURE1
+		GLint const shadowMapSlotIndex,
+		GLint const shadowLightsSlotIndex,
+		GLint const shadowLightBase,
+		GLint const shadowLightStride,
+		GLint const shadowLightCount,
 		glm::mat4 const& parentModelMatrix
 	);
 }
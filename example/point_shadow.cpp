@@ -0,0 +1,194 @@
+
+#include <glm/gtx/transform.hpp>
+
+#include "point_shadow.hpp"
+
+namespace example
+{
+	PointShadowShader::PointShadowShader()
+	{
+		char const* const vertexShader = R"__(
+#version 330 core
+layout (location = 0) in vec3 inPosition;
+layout (location = 3) in uint inDrawId;
+uniform samplerBuffer perDraw; // per draw: model, face mask
+uniform int perDrawBase;
+flat out int faceMask;
+void main()
+{
+	int i = perDrawBase + int(inDrawId) * 5;
+	mat4 model = mat4(texelFetch(perDraw, i), texelFetch(perDraw, i + 1), texelFetch(perDraw, i + 2), texelFetch(perDraw, i + 3));
+	faceMask = int(texelFetch(perDraw, i + 4).x);
+	gl_Position = model * vec4(inPosition, 1.0f); // world space, projected per face below
+}
+)__";
+		char const* const geometryShader = R"__(
+#version 330 core
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 18) out;
+flat in int faceMask[];
+uniform mat4 faceViewProjections[6];
+out vec3 worldPosition;
+void main()
+{
+	for (int face = 0; face < 6; ++face)
+	{
+		if ((faceMask[0] & (1 << face)) == 0) { continue; }
+		for (int v = 0; v < 3; ++v)
+		{
+			gl_Layer = face;
+			worldPosition = gl_in[v].gl_Position.xyz;
+			gl_Position = faceViewProjections[face] * gl_in[v].gl_Position;
+			EmitVertex();
+		}
+		EndPrimitive();
+	}
+}
+)__";
+		char const* const fragmentShader = R"__(
+#version 330 core
+in vec3 worldPosition;
+uniform vec3 lightPosition;
+uniform float range;
+void main()
+{
+	gl_FragDepth = length(worldPosition - lightPosition) / range;
+}
+)__";
+		std::vector<be::mem::gl::Shader> shaders;
+		shaders.reserve(3);
+		shaders.push_back(be::gl::makeShader(GL_VERTEX_SHADER, vertexShader, "point_shadow.cpp: vertex shader"));
+		shaders.push_back(be::gl::makeShader(GL_GEOMETRY_SHADER, geometryShader, "point_shadow.cpp: geometry shader"));
+		shaders.push_back(be::gl::makeShader(GL_FRAGMENT_SHADER, fragmentShader, "point_shadow.cpp: fragment shader"));
+		m_shader = be::gl::makeShaderProgram(std::move(shaders), "point_shadow.cpp: shader linker");
+
+		GLuint const program = m_shader.program.get();
+		m_uniformLocations.perDraw = glGetUniformLocation(program, "perDraw");
+		m_uniformLocations.perDrawBase = glGetUniformLocation(program, "perDrawBase");
+		m_uniformLocations.faceViewProjections = glGetUniformLocation(program, "faceViewProjections");
+		m_uniformLocations.lightPosition = glGetUniformLocation(program, "lightPosition");
+		m_uniformLocations.range = glGetUniformLocation(program, "range");
+	}
+
+	PointShadowMap makePointShadowMap(int const size, char const* const label)
+	{
+		PointShadowMap map;
+		map.size = size;
+		map.frameBuffer = be::mem::gl::makeFrameBuffer(be::gpu_memory::Category::RenderTarget, label);
+		map.cubemap = be::mem::gl::makeTexture(be::gpu_memory::Category::RenderTarget, label);
+
+		{
+			BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_CUBE_MAP, map.cubemap.get(), GL_TEXTURE0);
+			for (GLenum face = 0; face < 6; ++face)
+			{
+				be::gl::texImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT,
+					size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+			}
+			// tracked as one texture, six faces deep.
+			be::gpu_memory::setTextureLevel(map.cubemap.get(), 0, size, size * 6, GL_DEPTH_COMPONENT);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		}
+
+		BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, map.frameBuffer.get());
+		// every face at once, so gl_Layer picks the face.
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, map.cubemap.get(), 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+
+		GLenum const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			throw std::runtime_error("[example] framebuffer exception: "
+				+ std::to_string(static_cast<int>(status)));
+		}
+		return map;
+	}
+
+	std::array<glm::mat4, 6> calcPointShadowViewProjections(PointLight const& light)
+	{
+		// the cube map convention: each face looks down its axis with these ups.
+		static std::array<std::array<glm::vec3, 2>, 6> const faces = { {
+			{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) },
+			{ glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) },
+			{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) },
+			{ glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },
+			{ glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f) },
+			{ glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f) },
+		} };
+
+		glm::mat4 const projection = glm::perspective<float>(glm::radians(90.0f), 1.0f, 0.05f, light.range);
+		std::array<glm::mat4, 6> viewProjections;
+		for (std::size_t face = 0; face < faces.size(); ++face)
+		{
+			viewProjections[face] = projection * glm::lookAt(light.position, light.position + faces[face][0], faces[face][1]);
+		}
+		return viewProjections;
+	}
+
+	std::array<be::pink::Frustum, 6> calcPointShadowFrusta(std::array<glm::mat4, 6> const& viewProjections)
+	{
+		std::array<be::pink::Frustum, 6> frusta;
+		for (std::size_t face = 0; face < frusta.size(); ++face)
+		{
+			frusta[face] = be::pink::calcFrustum(viewProjections[face]);
+		}
+		return frusta;
+	}
+
+	std::uint32_t calcPointShadowFaceMask(std::array<be::pink::Frustum, 6> const& frusta, be::pink::Aabb const& worldBounds) noexcept
+	{
+		std::uint32_t mask = 0;
+		for (std::size_t face = 0; face < frusta.size(); ++face)
+		{
+			if (be::pink::isVisible(frusta[face], worldBounds))
+			{
+				mask |= 1u << face;
+			}
+		}
+		return mask;
+	}
+
+	void submitPointShadow(
+		PointShadowShader const& shader,
+		be::gl::MeshPool const& pool,
+		be::gl::MultiDrawBatch& batch,
+		PointShadowMap const& map,
+		PointLight const& light,
+		std::array<glm::mat4, 6> const& viewProjections,
+		std::vector<PointShadowCommand> const& commands
+	)
+	{
+		BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, map.frameBuffer.get());
+		glViewport(0, 0, map.size, map.size);
+		glClear(GL_DEPTH_BUFFER_BIT);
+
+		if (commands.empty()) { return; }
+
+		BE_USE_PROGRAM_SCOPE(shader.program());
+		BE_BIND_MESH_POOL_SCOPE(pool);
+
+		auto const& loc = shader.uniformLocations();
+		glUniformMatrix4fv(loc.faceViewProjections, static_cast<GLsizei>(viewProjections.size()), GL_FALSE, &viewProjections[0][0][0]);
+		be::gl::uniformVec3(loc.lightPosition, light.position);
+		glUniform1f(loc.range, light.range);
+
+		batch.clear();
+		for (auto const& command : commands)
+		{
+			if (batch.size() == static_cast<std::size_t>(batch.maxDraws()))
+			{
+				batch.submit(pool, 0, loc.perDraw, loc.perDrawBase);
+			}
+			glm::vec4* const texels = batch.add(command.range);
+			for (int column = 0; column < 4; ++column)
+			{
+				texels[column] = command.model[column];
+			}
+			texels[4] = glm::vec4(static_cast<float>(command.faceMask), 0.0f, 0.0f, 0.0f);
+		}
+		batch.submit(pool, 0, loc.perDraw, loc.perDrawBase);
+	}
+}
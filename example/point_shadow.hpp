@@ -0,0 +1,83 @@
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <be/be.hpp>
+
+namespace example
+{
+	/*
+	//	Omnidirectional shadows for a point light in one pass: every caster is submitted once,
+	//	and a geometry shader copies each triangle to the cube faces in the caster's face mask,
+	//	choosing the face with gl_Layer. The masks are found on the CPU by culling each caster
+	//	against the six face frusta, so a caster is only rasterised on the faces it touches.
+	//
+	//	The cube map stores the distance to the light divided by the range, not window depth,
+	//	so a lookup compares it with length(fragment - light) / range along the same direction.
+	*/
+	struct PointLight
+	{
+		glm::vec3 position{};
+		glm::vec3 color = glm::vec3(1.0f);
+		float range = 10.0f; // the light fades to nothing here, which is also the shadow's far plane
+	};
+
+	class PointShadowShader
+	{
+	private:
+		be::gl::ShaderProgram m_shader{};
+		struct UniformLocations {
+			GLuint perDraw;
+			GLuint perDrawBase;
+			GLuint faceViewProjections;
+			GLuint lightPosition;
+			GLuint range;
+		} m_uniformLocations{};
+
+	public:
+		// each draw reads its model matrix and face mask from a be::gl::MultiDrawBatch.
+		static constexpr GLsizei texelsPerDraw = 4 + 1;
+
+		PointShadowShader();
+		GLuint program() const { return m_shader.program.get(); }
+		UniformLocations const& uniformLocations() const { return m_uniformLocations; }
+	};
+
+	// A depth cube map attached as a layered depth target.
+	struct PointShadowMap
+	{
+		be::mem::gl::FrameBuffer frameBuffer;
+		be::mem::gl::Texture cubemap;
+		int size{};
+	};
+
+	PointShadowMap makePointShadowMap(int size, char const* label);
+
+	// In GL_TEXTURE_CUBE_MAP_POSITIVE_X + face order.
+	std::array<glm::mat4, 6> calcPointShadowViewProjections(PointLight const& light);
+	std::array<be::pink::Frustum, 6> calcPointShadowFrusta(std::array<glm::mat4, 6> const& viewProjections);
+
+	// Bit |face| is set if |worldBounds| may reach that face. 0 casts no shadow.
+	std::uint32_t calcPointShadowFaceMask(std::array<be::pink::Frustum, 6> const& frusta, be::pink::Aabb const& worldBounds) noexcept;
+
+	struct PointShadowCommand
+	{
+		be::gl::MeshRange range; // in the pool given to submitPointShadow
+		glm::mat4 model;
+		std::uint32_t faceMask;
+	};
+
+	// Clears |map| and renders the commands into it as one multi-draw. Leaves the viewport at the map's size.
+	// |batch| needs PointShadowShader::texelsPerDraw texels per draw.
+	void submitPointShadow(
+		PointShadowShader const& shader,
+		be::gl::MeshPool const& pool,
+		be::gl::MultiDrawBatch& batch,
+		PointShadowMap const& map,
+		PointLight const& light,
+		std::array<glm::mat4, 6> const& viewProjections,
+		std::vector<PointShadowCommand> const& commands
+	);
+}
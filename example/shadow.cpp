@@ -9,6 +9,8 @@ namespace example
 #version 330 core
 layout (location = 0) in vec3 inPosition;
 uniform mat4 mvp;
+// the same on every program that draws with the same mvp, so a depth prepass matches exactly.
+invariant gl_Position;
 void main()
 {
 	gl_Position = mvp * vec4(inPosition, 1.0f);
@@ -21,6 +23,25 @@ void main(){}
 		m_shader = be::gl::makeBasicShaderProgram(vertexShader, fragmentShader, "shadow.cpp");
 		GLuint const program = m_shader.program.get();
 		m_uniformLoc_mvp = glGetUniformLocation(program, "mvp");
+
+		char const* const indirectVertexShader = R"__(
+#version 330 core
+layout (location = 0) in vec3 inPosition;
+layout (location = 3) in uint inDrawId;
+uniform samplerBuffer perDraw;
+uniform int perDrawBase;
+invariant gl_Position;
+void main()
+{
+	int i = perDrawBase + int(inDrawId) * 4;
+	mat4 mvp = mat4(texelFetch(perDraw, i), texelFetch(perDraw, i + 1), texelFetch(perDraw, i + 2), texelFetch(perDraw, i + 3));
+	gl_Position = mvp * vec4(inPosition, 1.0f);
+}
+)__";
+		m_indirectShader = be::gl::makeBasicShaderProgram(indirectVertexShader, fragmentShader, "shadow.cpp indirect");
+		GLuint const indirectProgram = m_indirectShader.program.get();
+		m_uniformLoc_perDraw = glGetUniformLocation(indirectProgram, "perDraw");
+		m_uniformLoc_perDrawBase = glGetUniformLocation(indirectProgram, "perDrawBase");
 	}
 
 
@@ -35,6 +56,34 @@ void main(){}
 		be::gl::drawBasicMesh(mesh);
 	}
 
+	void submitDepth(
+		ShadowShader const& shader,
+		be::gl::MeshPool const& pool,
+		be::gl::MultiDrawBatch& batch,
+		std::vector<DepthCommand> const& commands
+	)
+	{
+		if (commands.empty()) { return; }
+
+		BE_USE_PROGRAM_SCOPE(shader.indirectProgram());
+		BE_BIND_MESH_POOL_SCOPE(pool);
+
+		batch.clear();
+		for (auto const& command : commands)
+		{
+			if (batch.size() == static_cast<std::size_t>(batch.maxDraws()))
+			{
+				batch.submit(pool, 0, shader.uniformLoc_perDraw(), shader.uniformLoc_perDrawBase());
+			}
+			glm::vec4* const texels = batch.add(command.range);
+			for (int column = 0; column < 4; ++column)
+			{
+				texels[column] = command.mvp[column];
+			}
+		}
+		batch.submit(pool, 0, shader.uniformLoc_perDraw(), shader.uniformLoc_perDrawBase());
+	}
+
 	void drawModelDepth(
 		ShadowShader const& shader,
 		be::pink::model::Model const& model,
@@ -42,17 +91,14 @@ void main(){}
 		glm::mat4 const& parentModelMatrix
 	)
 	{
-		be::pink::model::DrawNodeCallback const drawNode = [&](be::pink::model::Node const& node, glm::mat4 const& modelMatrix)
+		auto const drawNode = [&](be::pink::model::Node const& node, glm::mat4 const& modelMatrix)
 		{
 			auto const mvp = lightSpaceMatrix * modelMatrix;
 			be::gl::uniformMat4(shader.uniformLoc_mvp(), mvp);
 
-			for (auto const& w : node.meshes)
+			for (auto const index : node.meshes)
 			{
-				if (auto const mesh = w.lock())
-				{
-					be::gl::drawBasicMesh(mesh->data);
-				}
+				be::pink::model::drawMesh(model.meshes[index]);
 			}
 		};
 
@@ -11,11 +11,22 @@ namespace example
 		be::gl::ShaderProgram m_shader{};
 		GLuint m_uniformLoc_mvp{};
 
+		// reads each draw's mvp from a be::gl::MultiDrawBatch with depthTexelsPerDraw texels per draw.
+		be::gl::ShaderProgram m_indirectShader{};
+		GLuint m_uniformLoc_perDraw{};
+		GLuint m_uniformLoc_perDrawBase{};
+
 	public:
+		static constexpr GLsizei depthTexelsPerDraw = 4;
+
 		ShadowShader();
 
 		GLuint program() const { return m_shader.program.get(); }
 		GLuint uniformLoc_mvp() const { return m_uniformLoc_mvp; }
+
+		GLuint indirectProgram() const { return m_indirectShader.program.get(); }
+		GLuint uniformLoc_perDraw() const { return m_uniformLoc_perDraw; }
+		GLuint uniformLoc_perDrawBase() const { return m_uniformLoc_perDrawBase; }
 	};
 
 	void drawDepth(
@@ -24,6 +35,22 @@ namespace example
 		glm::mat4 const& lightSpaceMvp
 	);
 
+	// Position-only, so the same list type serves the light's shadow map and the camera's depth prepass.
+	struct DepthCommand
+	{
+		be::gl::MeshRange range; // in the pool given to submitDepth
+		glm::mat4 mvp;
+	};
+
+	// Replays commands built off the GL thread as one multi-draw with the shader's indirect program.
+	// |batch| needs ShadowShader::depthTexelsPerDraw texels per draw.
+	void submitDepth(
+		ShadowShader const& shader,
+		be::gl::MeshPool const& pool,
+		be::gl::MultiDrawBatch& batch,
+		std::vector<DepthCommand> const& commands
+	);
+
 	void drawModelDepth(
 		ShadowShader const& shader,
 		be::pink::model::Model const& model,
@@ -4,52 +4,142 @@
 
 namespace example
 {
+	BE_ERROR_SITE(commandErrors, "shadow scene commands");
+	BE_ERROR_SITE(missingCharacterErrors, "text label missing characters");
+
+	// The clip-space z of the model's origin. It grows with the distance from the camera
+	// under both projections, so it orders draws front to back without a division.
+	static float calcClipDepth(glm::mat4 const& mvp) noexcept
+	{
+		return mvp[3][2];
+	}
+
+
+
 	ShadowScene::ShadowScene(CreateInfo const& info)
 	{
+		if (info.quadCount < 0
+			|| info.fenceCount < 0
+			|| info.labelCount < 0
+			|| info.shadowMapSize < 64
+			|| (info.shadowMapSize & (info.shadowMapSize - 1)) != 0
+			|| info.extraLightCount < 0
+			|| info.extraLightCount > 15
+			|| info.pointShadowMapSize <= 0
+			|| info.clusteredLightCount < 0
+			|| info.clusteredLightCount > 1024
+			|| info.occluderCount < 0
+			|| info.evsm.blurRadius < 0
+			|| info.evsm.blurRadius > EvsmBlurShader::maxBlurRadius)
+		{
+			throw std::runtime_error("[example] shadow scene exception: invalid create info");
+		}
+
+		camera.position = info.cameraPosition;
 		camera.ortho = false;
 		camera.fovY = glm::radians(30.0f);
 		camera.aspect = 1920.0f / 1080.0f;
 
-
+		depthPrepass = info.depthPrepass;
+
+		depthBatch = be::gl::MultiDrawBatch({ .texelsPerDraw = ShadowShader::depthTexelsPerDraw });
+		prepassBatch = be::gl::MultiDrawBatch({ .texelsPerDraw = ShadowShader::depthTexelsPerDraw });
+		picketFenceBatch = be::gl::MultiDrawBatch({ .texelsPerDraw = PicketFenceShader::texelsPerDraw });
+		pointShadowBatch = be::gl::MultiDrawBatch({ .texelsPerDraw = PointShadowShader::texelsPerDraw });
+
+		int const minTileSize = 64;
+		shadowAtlas = be::gl::ShadowAtlas({
+			.size = info.shadowMapSize,
+			.minTileSize = minTileSize,
+			// a lone light may take the whole atlas; with company, at most a quarter of it, so the rest always fit.
+			.maxTileSize = info.extraLightCount > 0 ? info.shadowMapSize / 2 : info.shadowMapSize,
+			.maxLights = 1 + info.extraLightCount,
+			.extraTexelsPerLight = GroundShader::extraTexelsPerLight,
+			.label = "shadow atlas",
+			});
+		shadowTexelsWanted.reserve(1 + info.extraLightCount);
+		lightFrusta.reserve(1 + info.extraLightCount);
+
+		filteredShadows = info.filteredShadows;
+		evsm = info.evsm;
+		if (filteredShadows)
 		{
-			depthMapFrameBuffer = be::mem::gl::makeFrameBuffer();
-			depthMapHeight = 1024;
-			depthMapWidth = depthMapHeight;
-			depthMapTexture = be::mem::gl::makeTexture();
-
-			BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, depthMapTexture.get(), GL_TEXTURE0);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
-				depthMapWidth, depthMapHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-			BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, depthMapFrameBuffer.get());
-			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMapTexture.get(), 0);
-			glDrawBuffer(GL_NONE);
-			glReadBuffer(GL_NONE);
-
-			GLenum const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-			if (status != GL_FRAMEBUFFER_COMPLETE) {
-				throw std::runtime_error("[example] framebuffer exception: "
-					+ std::to_string(static_cast<int>(status)));
-			}
+			// mipmaps stop where the smallest tile is 4 texels across; the ground keeps its lookups half a texel
+			// of the level it samples inside the tile, so a tile's edge never filters in its neighbour.
+			int momentLevels = 1;
+			for (int size = minTileSize; size > 4; size /= 2) { ++momentLevels; }
+			evsmScratch = makeEvsmTarget(info.shadowMapSize, 1, "shadow moments blur");
+			evsmMoments = makeEvsmTarget(info.shadowMapSize, momentLevels, "shadow moments");
 		}
 
 
 		//lightPos = be::quatFromEulerDeg({ 90, 0, 0 }) * glm::vec3(0.0f, 1.0f, 0.0f) * 10.0f;
 		light.target = glm::vec3(0.0f, 0.0f, 0.0f);
 		light.position = glm::vec3(0.0f, 6.0f, 20.0f);
+		lightPosition = light.position;
+		previousLightPosition = light.position;
 		light.up = glm::vec3(0.0f, 1.0f, 0.0f);
 		light.ortho = true;
 		light.extentY = 8.0f;
-		light.aspect = static_cast<float>(depthMapWidth) / static_cast<float>(depthMapHeight);
+		light.aspect = 1.0f; // tiles are square
 		light.nearClip = 0.1f;
 		light.farClip = 100.0f;
 		//light.nearClip = 0.9f;
 		//light.farClip = 3.0f;
 
+		extraLights.reserve(info.extraLightCount);
+		for (int i = 0; i < info.extraLightCount; ++i)
+		{
+			// spread evenly around the scene, starting opposite the moving light.
+			float const angle = glm::radians(180.0f) + glm::radians(360.0f) * static_cast<float>(i) / static_cast<float>(info.extraLightCount);
+			ExtraLight extra;
+			extra.camera = light;
+			extra.camera.position = glm::vec3(std::sin(angle) * 20.0f, 8.0f, std::cos(angle) * 20.0f);
+			extra.color = i % 2 == 0 ? glm::vec3(0.35f, 0.25f, 0.15f) : glm::vec3(0.15f, 0.2f, 0.35f);
+			be::pink::recalc(extra.camera);
+			extraLights.push_back(extra);
+		}
+
+		hasPointLight = info.pointLight;
+		if (hasPointLight)
+		{
+			pointLight.position = glm::vec3(2.0f, 1.5f, 2.0f);
+			pointLight.color = glm::vec3(1.0f, 0.6f, 0.3f);
+			pointLight.range = 12.0f;
+			pointShadowMap = makePointShadowMap(info.pointShadowMapSize, "point shadow map");
+			pointShadowViewProjections = calcPointShadowViewProjections(pointLight);
+			pointShadowFrusta = calcPointShadowFrusta(pointShadowViewProjections);
+		}
+
+		occluderCount = info.occluderCount;
+		occlusionCulling = occluderCount > 0;
+		if (occlusionCulling)
+		{
+			occlusion = be::pink::OcclusionBuffer(be::pink::OcclusionBuffer::CreateInfo{});
+			occluderCandidates.reserve(info.fenceCount);
+		}
+
+		if (info.clusteredLightCount > 0)
+		{
+			lightClusters = be::gl::LightClusters({ .maxLights = info.clusteredLightCount });
+			clusteredLights.reserve(info.clusteredLightCount);
+			for (int i = 0; i < info.clusteredLightCount; ++i)
+			{
+				// a sunflower spiral over the ground, about 4 square units each, so the density holds as the count grows.
+				float const radius = 1.2f * std::sqrt(static_cast<float>(i) + 0.5f);
+				float const angle = 2.39996323f * static_cast<float>(i);
+				float const hue = std::fmod(static_cast<float>(i) * 0.618034f, 1.0f) * 6.0f;
+				be::gl::ClusteredLight clustered;
+				clustered.position = glm::vec3(std::sin(angle) * radius, -0.6f, std::cos(angle) * radius - 4.0f);
+				clustered.range = 2.5f;
+				clustered.color = 0.6f * glm::clamp(glm::vec3(
+					std::abs(hue - 3.0f) - 1.0f,
+					2.0f - std::abs(hue - 2.0f),
+					2.0f - std::abs(hue - 4.0f)), 0.0f, 1.0f);
+				clusteredLights.push_back(clustered);
+			}
+		}
+
 
 		groundTransform.base.rotation = glm::quat(glm::radians(glm::vec3(-90.0f, 0, 0)));
 		groundTransform.base.translation = glm::vec3(0, -1.0f, 0);
@@ -58,21 +148,75 @@ namespace example
 		groundUVScale = glm::vec2(1.0f * 5.0f);
 
 
-		flag1.base.translation = groundTransform.base.translation;
-		flag1.base.scale = 1.0f;
+		// procedural content is laid out on a grid behind the origin, facing the camera.
+		auto const gridPosition = [](int index, int count, float spacing) {
+			int const columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count)))));
+			int const column = index % columns;
+			int const row = index / columns;
+			return glm::vec3(
+				(static_cast<float>(column) - 0.5f * static_cast<float>(columns - 1)) * spacing,
+				0.0f,
+				-static_cast<float>(row + 1) * spacing);
+		};
 
-		flag2.base.translation = glm::vec3(-10, 2, 0);
-		flag2.base.rotation = be::pink::quatFromEulerDeg({ 0, 90, 0 });
-		flag2.quadSize = glm::vec2(1.0f, 5.0f);
 
+		flags.reserve(info.quadCount);
+		for (int i = 0; i < info.quadCount; ++i)
+		{
+			Flag flag;
+			if (i == 0)
+			{
+				flag.transform.base.translation = groundTransform.base.translation;
+				flag.transform.base.scale = 1.0f;
+				flag.color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+			}
+			else if (i == 1)
+			{
+				flag.transform.base.translation = glm::vec3(-10, 2, 0);
+				flag.transform.base.rotation = be::pink::quatFromEulerDeg({ 0, 90, 0 });
+				flag.transform.quadSize = glm::vec2(1.0f, 5.0f);
+				flag.color = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+			}
+			else
+			{
+				int const n = i - 2;
+				flag.transform.base.translation = gridPosition(n, info.quadCount - 2, 2.0f);
+				flag.transform.base.rotation = be::pink::quatFromEulerDeg({ 0, static_cast<float>((n * 37) % 360), 0 });
+				flag.color = glm::vec4(
+					0.5f + 0.5f * static_cast<float>(n % 3 == 0),
+					0.5f + 0.5f * static_cast<float>(n % 3 == 1),
+					0.5f + 0.5f * static_cast<float>(n % 3 == 2),
+					1.0f);
+			}
+			flags.push_back(flag);
+		}
 
-		picketFenceTransform.translation = groundTransform.base.translation;
-		//picketFenceTransform.rotation = be::quatFromEulerDeg({ 90, 0, 0 });
 
+		picketFenceTransforms.reserve(info.fenceCount);
+		for (int i = 0; i < info.fenceCount; ++i)
+		{
+			be::pink::BasicTransform transform;
+			transform.translation = groundTransform.base.translation;
+			//transform.rotation = be::quatFromEulerDeg({ 90, 0, 0 });
+			if (i > 0)
+			{
+				transform.translation += gridPosition(i - 1, info.fenceCount - 1, 6.0f);
+			}
+			picketFenceTransforms.push_back(transform);
+		}
 
-		labelText = "Alt+F4\nF11\nRMB+Drag\n\tWASD/Arrows\nP\nG";
-		labelScale = glm::vec2(1.0f);
-		labelColor = glm::vec4(glm::vec3(0.85f), 1.0f);
+
+		labels.reserve(info.labelCount);
+		for (int i = 0; i < info.labelCount; ++i)
+		{
+			Label label;
+			label.text = i == 0
+				? "Alt+F4\nF11\nRMB+Drag\n\tWASD/Arrows\nP\nG\nM\nZ\nH\nO"
+				: "Label " + std::to_string(i) + "\n\tbe_bench";
+			label.scale = glm::vec2(1.0f);
+			label.color = glm::vec4(glm::vec3(0.85f), 1.0f);
+			labels.push_back(std::move(label));
+		}
 
 
 		popSound = be::mem::fmod::createSound(info.audio.get(),
@@ -84,7 +228,12 @@ namespace example
 
 	void ShadowScene::update(UpdateInfo const& info)
 	{
+		BE_PROFILE_SCOPE("ShadowScene::update");
+
 		auto const& windowSize = info.windowSize.get();
+		float const deltaTime = info.deltaTime.get();
+
+		previousLightPosition = lightPosition;
 
 
 		// update camera
@@ -128,7 +277,7 @@ namespace example
 			};
 			if (isGoingDown_CaseInsensitive('a'))
 			{
-				printf_s("Key 'a' is going down!\n");
+				be::Application::log(be::LogLevel::Debug, "Key 'a' is going down!");
 			}
 
 			if (isGoingDown_CaseInsensitive('p'))
@@ -138,6 +287,26 @@ namespace example
 					nullptr, false, nullptr
 				), "[example] FMOD::System::playSound() failed");
 			}
+
+			if (isGoingDown_CaseInsensitive('m'))
+			{
+				showMemoryOverlay = !showMemoryOverlay;
+			}
+
+			if (isGoingDown_CaseInsensitive('z'))
+			{
+				depthPrepass = !depthPrepass;
+			}
+
+			if (isGoingDown_CaseInsensitive('h'))
+			{
+				showClusterHeat = !showClusterHeat;
+			}
+
+			if (isGoingDown_CaseInsensitive('o') && occluderCount > 0)
+			{
+				occlusionCulling = !occlusionCulling;
+			}
 		}
 
 
@@ -152,6 +321,7 @@ namespace example
 				return isDown(lowercase)
 					|| isDown(std::toupper(lowercase));
 			};
+			float const lightSpeed = 3.0f; // units per second
 			auto const isArrowDown = [&](int k) {
 				return be::input::isDownAtAll(
 					be::input::getElseConsiderUp(
@@ -161,25 +331,25 @@ namespace example
 
 			if (isDown_CaseInsensitive('a') || isArrowDown(GLUT_KEY_LEFT))
 			{
-				light.position.x -= 0.05f;
+				lightPosition.x -= lightSpeed * deltaTime;
 			}
 			if (isDown_CaseInsensitive('d') || isArrowDown(GLUT_KEY_RIGHT))
 			{
-				light.position.x += 0.05f;
+				lightPosition.x += lightSpeed * deltaTime;
 			}
 			if (isDown_CaseInsensitive('s') || isArrowDown(GLUT_KEY_DOWN))
 			{
-				light.position.y -= 0.05f;
+				lightPosition.y -= lightSpeed * deltaTime;
 			}
 			if (isDown_CaseInsensitive('w') || isArrowDown(GLUT_KEY_UP))
 			{
-				light.position.y += 0.05f;
+				lightPosition.y += lightSpeed * deltaTime;
 			}
 			//light.target = light.position + glm::vec3(0.0f, 0.0f, -1.0f);
 
-			if (isDown_CaseInsensitive('g'))
+			if (isDown_CaseInsensitive('g') && !be::Application::isHeadless())
 			{
-				printf_s("moving window!\n");
+				be::Application::log(be::LogLevel::Debug, "moving window!");
 				glutPositionWindow(30, 30);
 			}
 		}
@@ -201,6 +371,7 @@ namespace example
 
 
 		{
+			float const depthMapQuadSpeed = 0.6f; // units per second
 			auto const isDown = [&](int k) {
 				return be::input::isDownAtAll(
 					be::input::getElseConsiderUp(
@@ -209,19 +380,19 @@ namespace example
 			};
 			if (isDown(GLUT_KEY_LEFT))
 			{
-				depthMapQuadTransform.base.translation.x -= 0.01f;
+				depthMapQuadTransform.base.translation.x -= depthMapQuadSpeed * deltaTime;
 			}
 			if (isDown(GLUT_KEY_RIGHT))
 			{
-				depthMapQuadTransform.base.translation.x += 0.01f;
+				depthMapQuadTransform.base.translation.x += depthMapQuadSpeed * deltaTime;
 			}
 			if (isDown(GLUT_KEY_DOWN))
 			{
-				depthMapQuadTransform.base.translation.y -= 0.01f;
+				depthMapQuadTransform.base.translation.y -= depthMapQuadSpeed * deltaTime;
 			}
 			if (isDown(GLUT_KEY_UP))
 			{
-				depthMapQuadTransform.base.translation.y += 0.01f;
+				depthMapQuadTransform.base.translation.y += depthMapQuadSpeed * deltaTime;
 			}
 		}
 
@@ -238,52 +409,436 @@ namespace example
 		}
 
 
+		if (!labels.empty())
 		{
+			auto const& labelText = labels[0].text;
 			auto const num_lines = std::count(labelText.begin(), labelText.end(), '\n');
 			glm::vec2 const labelPosBL = glm::vec2(
 				10.0f,
 				15.0f + info.lineHeight.get() * static_cast<float>(num_lines)
 			);
-			labelTransform.translation = glm::vec3(
+			labels[0].transform.translation = glm::vec3(
 				-0.5f * windowSize.x + labelPosBL.x,
 				-0.5f * windowSize.y + labelPosBL.y,
 				0.0f
 			);
 		}
+
+		if (showMemoryOverlay)
+		{
+			constexpr double mb = 1.0 / (1024.0 * 1024.0);
+			auto const totals = be::gpu_memory::getTotals();
+			auto const capacity = memoryOverlayText.size();
+			auto length = static_cast<std::size_t>(std::max(0, std::snprintf(memoryOverlayText.data(), capacity,
+				"GPU memory %.1f MB, peak %.1f MB\n%llu objects, +%.1f -%.1f MB this frame",
+				totals.bytes * mb, totals.peakBytes * mb,
+				static_cast<unsigned long long>(totals.objects),
+				totals.frameAllocatedBytes * mb, totals.frameReleasedBytes * mb)));
+			for (std::size_t c = 0; c < be::gpu_memory::categoryCount && length < capacity; ++c)
+			{
+				auto const& category = totals.categories[c];
+				length += static_cast<std::size_t>(std::max(0, std::snprintf(memoryOverlayText.data() + length, capacity - length,
+					"\n\t%s %.1f MB (%llu)",
+					be::gpu_memory::toString(static_cast<be::gpu_memory::Category>(c)),
+					category.bytes * mb,
+					static_cast<unsigned long long>(category.objects))));
+			}
+			if (!clusteredLights.empty() && length < capacity)
+			{
+				auto const& stats = lightClusters.stats();
+				length += static_cast<std::size_t>(std::max(0, std::snprintf(memoryOverlayText.data() + length, capacity - length,
+					"\n%u/%zu lights clustered in %.2f ms, up to %u per cluster",
+					stats.visibleLights, clusteredLights.size(), stats.assignMs, stats.maxLightsPerCluster)));
+			}
+			if (occlusionPrepared && length < capacity)
+			{
+				auto const& stats = occlusion.stats();
+				length += static_cast<std::size_t>(std::max(0, std::snprintf(memoryOverlayText.data() + length, capacity - length,
+					"\n%u occluder triangles in %.2f ms hid %zu objects",
+					stats.occluderTriangles, stats.rasterMs, frameCommands.occluded)));
+			}
+			memoryOverlayLength = std::min(length, capacity - 1);
+
+			memoryOverlayTransform.translation = glm::vec3(
+				0.5f * windowSize.x - 320.0f,
+				0.5f * windowSize.y - info.lineHeight.get(),
+				0.0f
+			);
+		}
+
+		// the other labels fill the window in rows from the top left.
+		{
+			int const columns = 8;
+			float const cellWidth = static_cast<float>(windowSize.x) / static_cast<float>(columns);
+			float const cellHeight = info.lineHeight.get() * 2.5f;
+			for (std::size_t i = 1; i < labels.size(); ++i)
+			{
+				int const n = static_cast<int>(i - 1);
+				labels[i].transform.translation = glm::vec3(
+					-0.5f * windowSize.x + 10.0f + cellWidth * static_cast<float>(n % columns),
+					0.5f * windowSize.y - info.lineHeight.get() - cellHeight * static_cast<float>(n / columns),
+					0.0f
+				);
+			}
+		}
+	}
+
+	void ShadowScene::FrameCommands::clear() noexcept
+	{
+		for (auto& commands : lightDepth) { commands.clear(); }
+		cameraDepth.clear();
+		pointShadow.clear();
+		flags.clear();
+		picketFences.clear();
+		occluded = 0;
+	}
+
+	void ShadowScene::FrameCommands::append(FrameCommands const& other)
+	{
+		if (lightDepth.size() < other.lightDepth.size())
+		{
+			lightDepth.resize(other.lightDepth.size());
+		}
+		for (std::size_t i = 0; i < other.lightDepth.size(); ++i)
+		{
+			lightDepth[i].insert(lightDepth[i].end(), other.lightDepth[i].begin(), other.lightDepth[i].end());
+		}
+		cameraDepth.insert(cameraDepth.end(), other.cameraDepth.begin(), other.cameraDepth.end());
+		pointShadow.insert(pointShadow.end(), other.pointShadow.begin(), other.pointShadow.end());
+		flags.insert(flags.end(), other.flags.begin(), other.flags.end());
+		picketFences.insert(picketFences.end(), other.picketFences.begin(), other.picketFences.end());
+		occluded += other.occluded;
+	}
+
+	void ShadowScene::FrameCommands::reserve(std::size_t const lightCount, std::size_t const commands)
+	{
+		if (lightDepth.size() < lightCount)
+		{
+			lightDepth.resize(lightCount);
+		}
+		for (auto& list : lightDepth) { list.reserve(commands); }
+		cameraDepth.reserve(commands);
+		pointShadow.reserve(commands);
+		flags.reserve(commands);
+		picketFences.reserve(commands);
+	}
+
+	bool ShadowScene::prepareCommands(
+		be::gl::MeshPool const& meshPool,
+		be::gl::MeshRange const& quadRange,
+		be::pink::model::Model const& picketFenceModel
+	)
+	{
+		BE_PROFILE_SCOPE("ShadowScene::prepareCommands");
+
+		for (auto const& mesh : picketFenceModel.meshes)
+		{
+			if (mesh.pool != &meshPool)
+			{
+				return false;
+			}
+		}
+
+		// below this many objects per chunk, queueing a job costs more than it saves.
+		std::size_t const minObjectsPerChunk = 256;
+
+		// the lists are reserved for everything at once, so no later frame allocates whatever comes into view.
+		std::size_t meshesPerFence = 0;
+		std::size_t trianglesPerFence = 0;
+		be::pink::model::forEachMeshInstance(picketFenceModel, glm::mat4(1.0f), [&](be::pink::model::MeshInstance const& instance)
+		{
+			++meshesPerFence;
+			trianglesPerFence += instance.mesh->indices.size() / 3;
+		});
+
+		std::size_t const lightCount = shadowLightCount();
+		lightFrusta.clear();
+		for (std::size_t l = 0; l < lightCount; ++l)
+		{
+			lightFrusta.push_back(be::pink::calcFrustum(shadowLightCamera(l).vp));
+		}
+		auto const cameraFrustum = be::pink::calcFrustum(camera.vp);
+
+		// the nearest fences ahead of the camera hide what is behind them from every chunk.
+		occlusionPrepared = occlusionCulling && !picketFenceTransforms.empty();
+		if (occlusionPrepared)
+		{
+			glm::vec3 const forward = camera.target - camera.position;
+			occluderCandidates.clear();
+			for (std::size_t i = 0; i < picketFenceTransforms.size(); ++i)
+			{
+				glm::vec3 const offset = picketFenceTransforms[i].translation - camera.position;
+				if (glm::dot(offset, forward) > 0.0f)
+				{
+					occluderCandidates.emplace_back(glm::dot(offset, offset), i);
+				}
+			}
+			std::size_t const count = std::min(occluderCandidates.size(), static_cast<std::size_t>(occluderCount));
+			std::partial_sort(occluderCandidates.begin(), occluderCandidates.begin() + count, occluderCandidates.end());
+
+			occlusion.begin(camera.vp);
+			occlusion.reserve(static_cast<std::size_t>(occluderCount) * trianglesPerFence);
+			for (std::size_t c = 0; c < count; ++c)
+			{
+				frameCommands.instances.clear();
+				be::pink::model::flattenModel(picketFenceModel, be::pink::calcTrs(picketFenceTransforms[occluderCandidates[c].second]), frameCommands.instances);
+				for (auto const& instance : frameCommands.instances)
+				{
+					if (be::pink::isVisible(cameraFrustum, be::pink::transformAabb(instance.mesh->bounds, instance.modelMatrix)))
+					{
+						occlusion.addOccluder(instance.mesh->positions, instance.mesh->indices, instance.modelMatrix);
+					}
+				}
+			}
+			occlusion.rasterize();
+		}
+
+		std::size_t const objectCount = flags.size() + picketFenceTransforms.size();
+		std::size_t const maxChunks = static_cast<std::size_t>(be::jobs::getWorkerCount()) + 1;
+		std::size_t const chunkCount = std::clamp<std::size_t>(objectCount / minObjectsPerChunk, 1, maxChunks);
+		std::size_t const chunkSize = (objectCount + chunkCount - 1) / chunkCount;
+
+		if (chunkCommands.size() < chunkCount)
+		{
+			chunkCommands.resize(chunkCount);
+		}
+		std::size_t const commandsPerChunk = chunkSize * std::max<std::size_t>(1, meshesPerFence);
+
+		// objects [0, flags.size()) are flags, the rest are picket fences.
+		auto const prepareChunk = [&](std::size_t const chunk)
+		{
+			auto& out = chunkCommands[chunk];
+			out.clear();
+			out.reserve(lightCount, commandsPerChunk);
+			out.lightDepth.resize(lightCount);
+
+			// shadows are still cast by what the camera cannot see.
+			auto const isCameraVisible = [&](be::pink::Aabb const& bounds)
+			{
+				if (!be::pink::isVisible(cameraFrustum, bounds)) { return false; }
+				if (occlusionPrepared && !occlusion.isVisible(bounds))
+				{
+					++out.occluded;
+					return false;
+				}
+				return true;
+			};
+
+			std::size_t const begin = std::min(objectCount, chunk * chunkSize);
+			std::size_t const end = std::min(objectCount, begin + chunkSize);
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				if (i < flags.size())
+				{
+					auto const& flag = flags[i];
+					glm::mat4 const modelMatrix = be::pink::calcTrs(flag.transform);
+					auto const bounds = be::pink::transformAabb(be::basic_assets::meshes::quadMeshBounds, modelMatrix);
+					for (std::size_t l = 0; l < lightCount; ++l)
+					{
+						if (be::pink::isVisible(lightFrusta[l], bounds))
+						{
+							out.lightDepth[l].push_back(DepthCommand{ quadRange, shadowLightCamera(l).vp * modelMatrix });
+						}
+					}
+					if (hasPointLight)
+					{
+						if (auto const faceMask = calcPointShadowFaceMask(pointShadowFrusta, bounds))
+						{
+							out.pointShadow.push_back(PointShadowCommand{ quadRange, modelMatrix, faceMask });
+						}
+					}
+					if (isCameraVisible(bounds))
+					{
+						out.flags.push_back(FlagCommand{ camera.vp * modelMatrix, flag.color });
+						if (depthPrepass)
+						{
+							out.cameraDepth.push_back(DepthCommand{ quadRange, out.flags.back().mvp });
+						}
+					}
+				}
+				else
+				{
+					auto const& transform = picketFenceTransforms[i - flags.size()];
+					out.instances.clear();
+					be::pink::model::flattenModel(picketFenceModel, be::pink::calcTrs(transform), out.instances);
+					for (auto const& instance : out.instances)
+					{
+						auto const bounds = be::pink::transformAabb(instance.mesh->bounds, instance.modelMatrix);
+						for (std::size_t l = 0; l < lightCount; ++l)
+						{
+							if (be::pink::isVisible(lightFrusta[l], bounds))
+							{
+								out.lightDepth[l].push_back(DepthCommand{ instance.mesh->range, shadowLightCamera(l).vp * instance.modelMatrix });
+							}
+						}
+						if (hasPointLight)
+						{
+							if (auto const faceMask = calcPointShadowFaceMask(pointShadowFrusta, bounds))
+							{
+								out.pointShadow.push_back(PointShadowCommand{ instance.mesh->range, instance.modelMatrix, faceMask });
+							}
+						}
+						if (isCameraVisible(bounds))
+						{
+							out.picketFences.push_back(makePicketFenceCommand(instance, camera.vp));
+							if (depthPrepass)
+							{
+								// the same mvp as the colour pass, so the depths match exactly.
+								out.cameraDepth.push_back(DepthCommand{ instance.mesh->range, out.picketFences.back().mvp });
+							}
+						}
+					}
+				}
+			}
+		};
+
+		be::jobs::parallelFor(chunkCount, [&](std::size_t const begin, std::size_t const end)
+		{
+			for (std::size_t chunk = begin; chunk < end; ++chunk)
+			{
+				prepareChunk(chunk);
+			}
+		});
+
+		// merge in chunk order, so the submission order does not depend on thread timing.
+		frameCommands.clear();
+		// every flag and fence mesh, and the ground.
+		frameCommands.reserve(lightCount, flags.size() + picketFenceTransforms.size() * meshesPerFence + 1);
+		frameCommands.lightDepth.resize(lightCount);
+		for (std::size_t l = 0; l < lightCount; ++l)
+		{
+			frameCommands.lightDepth[l].push_back(DepthCommand{ quadRange, shadowLightCamera(l).vp * be::pink::calcTrs(groundTransform) });
+		}
+		if (hasPointLight)
+		{
+			glm::mat4 const groundMatrix = be::pink::calcTrs(groundTransform);
+			auto const groundBounds = be::pink::transformAabb(be::basic_assets::meshes::quadMeshBounds, groundMatrix);
+			if (auto const faceMask = calcPointShadowFaceMask(pointShadowFrusta, groundBounds))
+			{
+				frameCommands.pointShadow.push_back(PointShadowCommand{ quadRange, groundMatrix, faceMask });
+			}
+		}
+		for (std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			frameCommands.append(chunkCommands[chunk]);
+		}
+
+		auto const nearerFlag = [](FlagCommand const& a, FlagCommand const& b) { return calcClipDepth(a.mvp) < calcClipDepth(b.mvp); };
+		auto const nearerFence = [](PicketFenceCommand const& a, PicketFenceCommand const& b) { return calcClipDepth(a.mvp) < calcClipDepth(b.mvp); };
+		auto const nearerDepth = [](DepthCommand const& a, DepthCommand const& b) { return calcClipDepth(a.mvp) < calcClipDepth(b.mvp); };
+		std::sort(frameCommands.flags.begin(), frameCommands.flags.end(), nearerFlag);
+		std::sort(frameCommands.picketFences.begin(), frameCommands.picketFences.end(), nearerFence);
+		std::sort(frameCommands.cameraDepth.begin(), frameCommands.cameraDepth.end(), nearerDepth);
+		if (depthPrepass)
+		{
+			// the ground is under everything, so it goes last and is rejected wherever an object stands on it.
+			frameCommands.cameraDepth.push_back(DepthCommand{ quadRange, camera.vp * be::pink::calcTrs(groundTransform) });
+		}
+		return true;
 	}
 
 	void ShadowScene::render(RenderInfo const& info)
 	{
+		BE_PROFILE_SCOPE("ShadowScene::render");
+
 		auto const& windowSize = info.windowSize.get();
 		auto const& shadowShader = info.shadowShader.get();
-		auto const& quadMesh = info.quadMesh.get();
+		auto const& resources = info.resources.get();
+		auto const& quadMesh = resources.mesh(info.quadMesh);
 		auto const& picketFenceModel = info.picketFenceModel.get();
+		auto const& meshPool = info.meshPool.get();
 
 
+		light.position = glm::mix(previousLightPosition, lightPosition, info.interpolation.get());
+
 		be::pink::recalc(camera);
 		be::pink::recalc(light);
 
+		if (!prepareCommands(meshPool, info.quadRange.get(), picketFenceModel))
+		{
+			frameCommands.clear();
+			commandErrors.report("the picket fence model must be loaded into the scene's mesh pool");
+		}
+
 
-		// 1. first render to depth map
+		// 1. first render each light's depth into its tile of the atlas
 		try
 		{
-			BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, depthMapFrameBuffer.get());
-			glViewport(0, 0, depthMapWidth, depthMapHeight);
-			glClear(GL_DEPTH_BUFFER_BIT);
+			BE_PROFILE_SCOPE("ShadowScene::render depth pass");
+			BE_GL_STATS_PASS("shadow depth");
 
-			glEnable(GL_DEPTH_TEST);
-			glDepthFunc(GL_LESS);
-			CRESS_MOO_DEFER_EXPRESSION(glDisable(GL_DEPTH_TEST));
+			// a light gets about as many texels across as its frustum covers pixels at its target, scaled by its brightness.
+			shadowTexelsWanted.clear();
+			for (std::size_t l = 0; l < shadowLightCount(); ++l)
+			{
+				auto const& lightCamera = shadowLightCamera(l);
+				glm::vec3 const color = shadowLightColor(l);
+				float const distance = std::max(camera.nearClip, glm::distance(camera.position, lightCamera.target));
+				float const pixels = be::pink::calcPixelsPerUnit(camera, distance, static_cast<float>(windowSize.y)) * 2.0f * lightCamera.extentY;
+				shadowTexelsWanted.push_back(pixels * std::max(color.r, std::max(color.g, color.b)));
+			}
+			shadowAtlas.assign(shadowTexelsWanted);
 
-			BE_USE_PROGRAM_SCOPE(shadowShader.program());
+			shadowAtlas.beginDepthPass();
+			CRESS_MOO_DEFER_EXPRESSION(shadowAtlas.endDepthPass());
 
-			example::drawDepth(shadowShader, quadMesh, light.vp * be::pink::calcTrs(flag1));
-			example::drawDepth(shadowShader, quadMesh, light.vp * be::pink::calcTrs(flag2));
-			example::drawDepth(shadowShader, quadMesh, light.vp * be::pink::calcTrs(groundTransform));
-			example::drawModelDepth(shadowShader, picketFenceModel, light.vp, be::pink::calcTrs(picketFenceTransform));
+			for (std::size_t l = 0; l < frameCommands.lightDepth.size(); ++l)
+			{
+				auto const& tile = shadowAtlas.tile(l);
+				if (tile.size <= 0) { continue; }
+				shadowAtlas.setTileViewport(tile);
+				example::submitDepth(shadowShader, meshPool, depthBatch, frameCommands.lightDepth[l]);
+			}
 		}
 		catch (...) { be::Application::logException(); }
 
+		if (hasPointLight)
+		{
+			try
+			{
+				BE_PROFILE_SCOPE("ShadowScene::render point shadow pass");
+				BE_GL_STATS_PASS("shadow point");
+
+				glEnable(GL_DEPTH_TEST);
+				glDepthFunc(GL_LESS);
+				CRESS_MOO_DEFER_EXPRESSION(glDisable(GL_DEPTH_TEST));
+
+				example::submitPointShadow(info.pointShadowShader.get(), meshPool, pointShadowBatch,
+					pointShadowMap, pointLight, pointShadowViewProjections, frameCommands.pointShadow);
+			}
+			catch (...) { be::Application::logException(); }
+		}
+
+		if (filteredShadows)
+		{
+			try
+			{
+				BE_PROFILE_SCOPE("ShadowScene::render shadow filter pass");
+				BE_GL_STATS_PASS("shadow filter");
+
+				filterEvsm(info.evsmBlurShader.get(), shadowAtlas.texture(), shadowAtlas.tiles(), evsmScratch, evsmMoments, evsm);
+			}
+			catch (...) { be::Application::logException(); }
+		}
+
+
+		if (!clusteredLights.empty())
+		{
+			try
+			{
+				BE_PROFILE_SCOPE("ShadowScene::render light clusters");
+				lightClusters.assign({
+					.view = camera.view,
+					.fovY = camera.fovY,
+					.aspect = camera.aspect,
+					.nearClip = camera.nearClip,
+					.farClip = camera.farClip,
+					.viewportSize = windowSize,
+					}, clusteredLights);
+			}
+			catch (...) { be::Application::logException(); }
+		}
+
 
 		// 2. then render scene as normal with shadow mapping (using depth map)
 		{
@@ -295,62 +850,89 @@ namespace example
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
 
-			// SCENE
+			// DEPTH PREPASS
 
-			try
+			bool prepassDone = false;
+			if (depthPrepass)
 			{
-				glDisable(GL_DEPTH_TEST);
+				try
+				{
+					BE_PROFILE_SCOPE("ShadowScene::render depth prepass");
+					BE_GL_STATS_PASS("shadow prepass");
+
+					glEnable(GL_DEPTH_TEST);
+					glDepthFunc(GL_LESS);
+					glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+					CRESS_MOO_DEFER_EXPRESSION(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+					CRESS_MOO_DEFER_EXPRESSION(glDisable(GL_DEPTH_TEST));
+
+					example::submitDepth(shadowShader, meshPool, prepassBatch, frameCommands.cameraDepth);
+					prepassDone = true;
+				}
+				catch (...) { be::Application::logException(); }
+			}
 
-				be::pink::renderSkybox({
-					.shader = info.skyboxShader,
-					.mesh = info.skyboxMesh,
-					.cubemap = info.skyboxCubemap,
-					.cameraProjectionMatrix = camera.projection,
-					.cameraViewMatrix = camera.view,
-					.scale = 1.0f
-					});
 
+			// SCENE
 
+			try
+			{
+				BE_PROFILE_SCOPE("ShadowScene::render colour pass");
+				BE_GL_STATS_PASS("shadow colour");
 
-				BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, depthMapTexture.get(), GL_TEXTURE9);
+				shadowAtlas.clearLights();
+				for (std::size_t l = 0; l < shadowLightCount(); ++l)
+				{
+					auto const& lightCamera = shadowLightCamera(l);
+					glm::vec4* const texels = shadowAtlas.addLight(lightCamera.vp, l);
+					texels[0] = glm::vec4(glm::normalize(lightCamera.target - lightCamera.position), 0.0f);
+					texels[1] = glm::vec4(shadowLightColor(l), 0.0f);
+				}
+				shadowAtlas.uploadLights();
+				CRESS_MOO_DEFER_EXPRESSION(shadowAtlas.fenceLights());
+
+				BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, shadowAtlas.texture(), GL_TEXTURE9);
 				GLint const shadowMapSlotIndex = 9;
+				BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, evsmMoments.texture.get(), GL_TEXTURE10);
+				GLint const shadowMomentsSlotIndex = filteredShadows ? 10 : -1;
+				BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_BUFFER, shadowAtlas.lightTexture(), GL_TEXTURE11);
+				GLint const shadowLightsSlotIndex = 11;
+				BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_CUBE_MAP, pointShadowMap.cubemap.get(), GL_TEXTURE12);
+				GLint const pointShadowSlotIndex = hasPointLight ? 12 : -1;
 
 				glEnable(GL_DEPTH_TEST);
 				CRESS_MOO_DEFER_EXPRESSION(glDisable(GL_DEPTH_TEST));
-				glDepthFunc(GL_LESS);
+				CRESS_MOO_DEFER_EXPRESSION(glDepthMask(GL_TRUE));
+				CRESS_MOO_DEFER_EXPRESSION(glDepthFunc(GL_LESS));
 
-				{
-					auto const color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-					auto const mvp = camera.vp * be::pink::calcTrs(flag1);
-					be::pink::renderUnlit({
-						.shader = info.unlitShader.get(),
-						.mesh = quadMesh,
-						.tex = info.flagTexture.get(),
-						.color = color,
-						.mvp = mvp,
-						});
-				}
+				// after the prepass the depth buffer already holds the nearest surfaces,
+				// so only the fragment that wrote each one passes and there is nothing left to write.
+				glDepthFunc(prepassDone ? GL_EQUAL : GL_LESS);
+				glDepthMask(prepassDone ? GL_FALSE : GL_TRUE);
 
+				for (auto const& flag : frameCommands.flags)
 				{
-					auto const color = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
-					auto const mvp = camera.vp * be::pink::calcTrs(flag2);
 					be::pink::renderUnlit({
 						.shader = info.unlitShader.get(),
 						.mesh = quadMesh,
-						.tex = info.flagTexture.get(),
-						.color = color,
-						.mvp = mvp,
+						.tex = resources.texture(info.flagTexture),
+						.color = flag.color,
+						.mvp = flag.mvp,
 						});
 				}
 
-				example::renderPicketFence(
+				example::submitPicketFence(
 					info.picketFenceShader.get(),
-					picketFenceModel,
-					camera,
-					light.position,
-					light.vp,
+					meshPool,
+					picketFenceBatch,
+					info.picketFenceModel.get(),
+					camera.position,
 					shadowMapSlotIndex,
-					be::pink::calcTrs(picketFenceTransform)
+					shadowLightsSlotIndex,
+					shadowAtlas.lightBase(),
+					shadowAtlas.texelsPerLight(),
+					static_cast<GLint>(shadowAtlas.lightCount()),
+					frameCommands.picketFences
 				);
 
 				example::renderGround(
@@ -358,20 +940,56 @@ namespace example
 					quadMesh,
 					info.groundTexture.get(),
 					camera,
-					light.target - light.position,
-					light.vp,
 					shadowMapSlotIndex,
+					shadowLightsSlotIndex,
+					shadowAtlas.lightBase(),
+					shadowAtlas.texelsPerLight(),
+					static_cast<GLint>(shadowAtlas.lightCount()),
 					calcTrs(groundTransform),
 					groundUVScale,
-					light.farClip - 0.001f
+					light.farClip - 0.001f,
+					shadowMomentsSlotIndex,
+					evsm,
+					pointLight,
+					pointShadowSlotIndex,
+					clusteredLights.empty() ? nullptr : &lightClusters,
+					showClusterHeat
 				);
+				if (!clusteredLights.empty())
+				{
+					lightClusters.fence();
+				}
+
+				// not in the prepass.
+				glDepthFunc(GL_LESS);
+				glDepthMask(GL_TRUE);
 
 				example::renderLightGizmo(
 					info.lightGizmoShader.get(),
-					info.cubeMesh.get(),
+					resources.mesh(info.cubeMesh),
 					glm::vec3(1.0f, 1.0f, 0.0f),
 					camera.vp * be::pink::calcTrs(light.position, glm::quat(), 0.3f)
 				);
+				if (hasPointLight)
+				{
+					example::renderLightGizmo(
+						info.lightGizmoShader.get(),
+						resources.mesh(info.cubeMesh),
+						pointLight.color,
+						camera.vp * be::pink::calcTrs(pointLight.position, glm::quat(), 0.15f)
+					);
+				}
+
+				// last, so it only shades the pixels nothing else covered.
+				be::pink::renderSkybox({
+					.shader = info.skyboxShader,
+					.mesh = info.skyboxMesh,
+					.cubemap = resources.texture(info.skyboxCubemap),
+					.cameraProjectionMatrix = camera.projection,
+					.cameraViewMatrix = camera.view,
+					.scale = 1.0f,
+					.atFarPlane = true,
+					});
 			}
 			catch (...) { be::Application::logException(); }
 
@@ -380,14 +998,22 @@ namespace example
 
 			try
 			{
+				BE_PROFILE_SCOPE("ShadowScene::render hud pass");
+				BE_GL_STATS_PASS("shadow hud");
+
 				example::renderDepthMapQuad(
 					info.depthMapQuadShader.get(),
 					quadMesh,
 					hudCamera.vp * be::pink::calcTrs(depthMapQuadTransform),
-					depthMapTexture.get());
+					shadowAtlas.texture());
 
+				auto const drawLabel = [&](
+					std::string_view const text,
+					be::pink::BasicTransform const& transform,
+					glm::vec2 const& scale,
+					glm::vec4 const& color)
 				{
-					glm::mat4 const mvp = hudCamera.vp * be::pink::calcTrs(labelTransform);
+					glm::mat4 const mvp = hudCamera.vp * be::pink::calcTrs(transform);
 
 					glm::mat4 const mvpDropshadow = mvp * glm::translate(glm::vec3(-1.0f, -1.0f, 0.0f));
 					glm::vec4 const colorDropshadow = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
@@ -400,17 +1026,39 @@ namespace example
 						.tabWidth = info.tabWidth,
 						.mvp = mvpDropshadow,
 						.color = colorDropshadow,
-						.scale = labelScale,
-						.text = labelText,
+						.scale = scale,
+						.text = text,
 					};
-					be::pink::text_label::renderTextLabel(in);
+					if (be::pink::text_label::RenderTextLabelStatus::Ok != be::pink::text_label::renderTextLabel(in))
+					{
+						missingCharacterErrors.report(text);
+					}
 
 					in.mvp = mvp;
-					in.color = labelColor;
-					be::pink::text_label::renderTextLabel(in);
+					in.color = color;
+					static_cast<void>(be::pink::text_label::renderTextLabel(in)); // same text, so already reported
+				};
+
+				for (auto const& label : labels)
+				{
+					drawLabel(label.text, label.transform, label.scale, label.color);
+				}
+
+				if (showMemoryOverlay)
+				{
+					drawLabel(std::string_view(memoryOverlayText.data(), memoryOverlayLength),
+						memoryOverlayTransform, glm::vec2(1.0f), glm::vec4(0.85f, 0.95f, 0.85f, 1.0f));
 				}
 			}
 			catch (...) { be::Application::logException(); }
 		}
 	}
+
+	float ShadowScene::calcGroundTextureTexels(glm::ivec2 const& windowSize) const
+	{
+		// the ground is horizontal, so the camera's height above it is the distance to its nearest point.
+		float const distance = glm::abs(camera.position.y - groundTransform.base.translation.y);
+		float const worldUnitsPerRepeat = groundTransform.base.scale * groundTransform.quadSize.x / groundUVScale.x;
+		return be::pink::calcPixelsPerUnit(camera, distance, static_cast<float>(windowSize.y)) * worldUnitsPerRepeat;
+	}
 }
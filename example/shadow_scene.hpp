@@ -6,6 +6,8 @@
 #include "picket_fence.hpp"
 #include "ground.hpp"
 #include "shadow.hpp"
+#include "evsm.hpp"
+#include "point_shadow.hpp"
 #include "depth_map_quad.hpp"
 #include "light_gizmo.hpp"
 
@@ -17,11 +19,53 @@ namespace example
 		be::pink::Camera camera;
 		glm::vec3 cameraEulerAngles;
 
-		be::mem::gl::FrameBuffer depthMapFrameBuffer;
-		int depthMapWidth{}, depthMapHeight{};
-		be::mem::gl::Texture depthMapTexture;
+		// one depth texture for every shadowed light, each given a tile as big as it looks on screen.
+		be::gl::ShadowAtlas shadowAtlas;
+		std::vector<float> shadowTexelsWanted; // scratch, by shadowed light
+
+		// the atlas filtered into blurred moments, tile by tile, sampled by the ground instead of the depth.
+		bool filteredShadows = true;
+		EvsmSettings evsm;
+		EvsmTarget evsmScratch;
+		EvsmTarget evsmMoments;
 
 		be::pink::Camera light;
+		glm::vec3 lightPosition;
+		glm::vec3 previousLightPosition;
+
+		// fixed lights around the scene, dimmer and tinted, shadowed from the same atlas as |light|.
+		struct ExtraLight
+		{
+			be::pink::Camera camera;
+			glm::vec3 color;
+		};
+		std::vector<ExtraLight> extraLights;
+		std::vector<be::pink::Frustum> lightFrusta; // scratch, by shadowed light
+
+		// a fixed point light with omnidirectional shadows, rendered in one pass. see point_shadow.hpp
+		bool hasPointLight = false;
+		PointLight pointLight;
+		PointShadowMap pointShadowMap;
+		std::array<glm::mat4, 6> pointShadowViewProjections{};
+		std::array<be::pink::Frustum, 6> pointShadowFrusta{};
+
+		// many small unshadowed lights near the ground, binned into froxels each frame. see be/light_clusters.hpp
+		std::vector<be::gl::ClusteredLight> clusteredLights;
+		be::gl::LightClusters lightClusters;
+		bool showClusterHeat = false; // the ground shows how many lights each pixel loops over. toggled with H
+
+		// the nearest fences in front of the camera are rasterised on the CPU each frame, and flags and fences
+		// they hide are left out of the camera's draw lists. see be/pink/occlusion.hpp. Toggled with O.
+		be::pink::OcclusionBuffer occlusion;
+		int occluderCount = 0;
+		bool occlusionCulling = false;
+		bool occlusionPrepared = false; // by the latest prepareCommands
+		std::vector<std::pair<float, std::size_t>> occluderCandidates; // scratch: distance, fence
+
+		// |light| is shadowed light 0, followed by the extra lights.
+		std::size_t shadowLightCount() const noexcept { return 1 + extraLights.size(); }
+		be::pink::Camera const& shadowLightCamera(std::size_t const i) const { return i == 0 ? light : extraLights.at(i - 1).camera; }
+		glm::vec3 shadowLightColor(std::size_t const i) const { return i == 0 ? glm::vec3(1.0f) : extraLights.at(i - 1).color; }
 
 		be::pink::Camera hudCamera;
 
@@ -30,29 +74,107 @@ namespace example
 		be::pink::QuadTransform groundTransform;
 		glm::vec2 groundUVScale = glm::vec2(1.0f);
 
-		be::pink::QuadTransform flag1;
-		be::pink::QuadTransform flag2;
+		struct Flag
+		{
+			be::pink::QuadTransform transform;
+			glm::vec4 color;
+		};
+		std::vector<Flag> flags;
+
+		std::vector<be::pink::BasicTransform> picketFenceTransforms;
+
+		struct Label
+		{
+			std::string text;
+			be::pink::BasicTransform transform;
+			glm::vec2 scale;
+			glm::vec4 color;
+		};
+		std::vector<Label> labels;
 
-		be::pink::BasicTransform picketFenceTransform;
+		// be::gpu_memory totals, toggled with M. Formatted in place so that showing it does not allocate.
+		bool showMemoryOverlay = false;
+		std::array<char, 512> memoryOverlayText{};
+		std::size_t memoryOverlayLength{};
+		be::pink::BasicTransform memoryOverlayTransform;
 
-		std::string labelText;
-		be::pink::BasicTransform labelTransform;
-		glm::vec2 labelScale;
-		glm::vec4 labelColor;
+		// Lays down the camera's depth with the position-only shadow program first, so the colour pass
+		// tests GL_EQUAL and shades each pixel once. Toggled with Z.
+		bool depthPrepass = false;
 
 		be::mem::fmod::Sound popSound;
 
+		// Draw lists with fully resolved matrices, built by prepareCommands and replayed by render.
+		// Kept between frames so their capacity is reused.
+		struct FlagCommand
+		{
+			glm::mat4 mvp;
+			glm::vec4 color;
+		};
+		struct FrameCommands
+		{
+			std::vector<std::vector<DepthCommand>> lightDepth; // by shadowed light
+			std::vector<DepthCommand> cameraDepth; // only filled for the depth prepass
+			std::vector<PointShadowCommand> pointShadow;
+			std::vector<FlagCommand> flags;
+			std::vector<PicketFenceCommand> picketFences;
+			std::size_t occluded{}; // flags and fence meshes in the camera's frustum left out as hidden
+			std::vector<be::pink::model::MeshInstance> instances; // scratch
+
+			void clear() noexcept;
+			void append(FrameCommands const& other);
+			// room for |commands| in each list, so later frames do not allocate whatever is in view.
+			void reserve(std::size_t lightCount, std::size_t commands);
+		};
+		FrameCommands frameCommands;
+		std::vector<FrameCommands> chunkCommands;
+
+		// per-draw data for the depth, depth prepass and picket fence multi-draws.
+		be::gl::MultiDrawBatch depthBatch;
+		be::gl::MultiDrawBatch prepassBatch;
+		be::gl::MultiDrawBatch picketFenceBatch;
+		be::gl::MultiDrawBatch pointShadowBatch;
+
+		// Culls the flags and fences against each light's and the camera's frusta and builds the draw lists,
+		// sorting the camera's front to back so early depth testing rejects what is hidden.
+		// Large scenes are split into chunks prepared by be::jobs. No GL calls are made.
+		// The depth list draws from |meshPool| only, so the fence model must live in it; returns false if not.
+		bool prepareCommands(
+			be::gl::MeshPool const& meshPool,
+			be::gl::MeshRange const& quadRange,
+			be::pink::model::Model const& picketFenceModel
+		);
+
 	public:
 		ShadowScene() = delete;
 
 		struct CreateInfo
 		{
 			be::need_ref<FMOD::System> audio;
+
+			// Scene content. The defaults are the example scene; be_bench scales them up.
+			int quadCount = 2; // require >= 0
+			int fenceCount = 1; // require >= 0
+			int labelCount = 1; // require >= 0
+			// the shadow atlas's width and height. require a power of two >= 64.
+			// filtering hides the aliasing a hard lookup needs 1024 or more for.
+			int shadowMapSize = 512;
+			int extraLightCount = 0; // fixed shadowed lights besides the moving one. require 0 to 15
+			bool pointLight = false;
+			int pointShadowMapSize = 256; // each cube face's width and height. require > 0
+			int clusteredLightCount = 0; // require 0 to 1024
+			int occluderCount = 0; // nearest fences rasterised as occluders each frame; 0 turns occlusion culling off. require >= 0
+			bool filteredShadows = true; // false compares against the depth map directly, for hard shadows
+			EvsmSettings evsm{};
+			bool depthPrepass = false;
+			glm::vec3 cameraPosition = glm::vec3(0.0f, 0.0f, 10.0f);
 		};
 		ShadowScene(CreateInfo const& info);
 
 		struct UpdateInfo
 		{
+			be::need<float> deltaTime;
+
 			be::need_ref<be::Input const> input;
 			be::need_ref<glm::ivec2 const> mousePositionInWindow;
 			be::need_ref<glm::ivec2 const> previousMousePositionInWindow;
@@ -70,18 +192,28 @@ namespace example
 
 		struct RenderInfo
 		{
+			be::need<float> interpolation;
+
 			be::need_ref<glm::ivec2 const> windowSize;
 
+			// the handles below are resolved here every frame, so their resources can be swapped.
+			be::need_ref<be::gl::ResourceRegistry const> resources;
+
 			be::need_ref<be::pink::SkyboxShader const> skyboxShader;
 			be::need_ref<be::pink::SkyboxMesh const> skyboxMesh;
-			be::need<GLuint> skyboxCubemap;
+			be::need<be::gl::TextureHandle> skyboxCubemap;
 
 			be::need_ref<ShadowShader const> shadowShader;
+			be::need_ref<EvsmBlurShader const> evsmBlurShader;
+			be::need_ref<PointShadowShader const> pointShadowShader;
 
 			be::need_ref<LightGizmoShader const> lightGizmoShader;
 
-			be::need_ref<be::gl::BasicMesh const> quadMesh;
-			be::need_ref<be::gl::BasicMesh const> cubeMesh;
+			be::need<be::gl::MeshHandle> quadMesh;
+			be::need<be::gl::MeshHandle> cubeMesh;
+
+			be::need_ref<be::gl::MeshPool const> meshPool;
+			be::need<be::gl::MeshRange> quadRange; // in meshPool
 
 			be::need_ref<DepthMapQuadShader const> depthMapQuadShader;
 
@@ -89,10 +221,10 @@ namespace example
 			be::need<GLuint> groundTexture;
 
 			be::need_ref<be::pink::UnlitShader const> unlitShader;
-			be::need<GLuint> flagTexture;
+			be::need<be::gl::TextureHandle> flagTexture;
 
 			be::need_ref<PicketFenceShader const> picketFenceShader;
-			be::need_ref<be::pink::model::Model const> picketFenceModel;
+			be::need_ref<be::pink::model::Model const> picketFenceModel; // loaded into meshPool
 
 			be::need_ref<be::pink::text_label::TextLabelShader const> textLabelShader;
 			be::need_ref<be::pink::text_label::TextGlyphMesh /* mutable */> textGlyphMesh;
@@ -102,5 +234,15 @@ namespace example
 			be::need<float> tabWidth;
 		};
 		void render(RenderInfo const& info);
+
+		// The texels across the ground texture that the nearest visible ground needs, for be::texture_stream.
+		float calcGroundTextureTexels(glm::ivec2 const& windowSize) const;
+
+		// Measured by the latest render. All zero without clustered lights.
+		be::gl::LightClusterStats const& lightClusterStats() const noexcept { return lightClusters.stats(); }
+
+		// Measured by the latest render. All zero while occlusion culling is off.
+		be::pink::OcclusionStats occlusionStats() const noexcept { return occlusionPrepared ? occlusion.stats() : be::pink::OcclusionStats{}; }
+		std::size_t occludedObjects() const noexcept { return frameCommands.occluded; }
 	};
 }
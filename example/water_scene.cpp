@@ -3,13 +3,14 @@
 
 namespace example
 {
-	be::mem::gl::Texture attachColorTextureToFrameBuffer(glm::ivec2 const& size)
+	be::mem::gl::Texture attachColorTextureToFrameBuffer(glm::ivec2 const& size, char const* const label)
 	{
-		auto texture = be::mem::gl::makeTexture();
+		auto texture = be::mem::gl::makeTexture(be::gpu_memory::Category::RenderTarget, label);
 
 		BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, texture.get(), GL_TEXTURE0);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB,
+		be::gl::texImage2D(GL_TEXTURE_2D, 0, GL_RGB,
 			size.x, size.y, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+		be::gpu_memory::setTextureLevel(texture.get(), 0, size.x, size.y, GL_RGB);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -22,13 +23,14 @@ namespace example
 		return texture;
 	}
 
-	be::mem::gl::Texture attachDepthTextureToFrameBuffer(glm::ivec2 const& size)
+	be::mem::gl::Texture attachDepthTextureToFrameBuffer(glm::ivec2 const& size, char const* const label)
 	{
-		auto texture = be::mem::gl::makeTexture();
+		auto texture = be::mem::gl::makeTexture(be::gpu_memory::Category::RenderTarget, label);
 
 		BE_BIND_TEXTURE_SCOPE(GL_TEXTURE_2D, texture.get(), GL_TEXTURE0);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32,
+		be::gl::texImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32,
 			size.x, size.y, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+		be::gpu_memory::setTextureLevel(texture.get(), 0, size.x, size.y, GL_DEPTH_COMPONENT32);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -41,8 +43,30 @@ namespace example
 		return texture;
 	}
 
+	// The water's plane is its quad's, facing up.
+	static glm::vec4 calcWaterPlane(be::pink::QuadTransform const& water) noexcept
+	{
+		return glm::vec4(0.0f, 1.0f, 0.0f, -water.base.translation.y);
+	}
+
+	static glm::ivec2 calcTargetSize(glm::ivec2 const& windowSize, float const scale) noexcept
+	{
+		return glm::max(glm::ivec2(1), glm::ivec2(glm::vec2(windowSize) * scale + 0.5f));
+	}
+
 	WaterScene::WaterScene()
+		: WaterScene(CreateInfo{})
+	{}
+
+	WaterScene::WaterScene(CreateInfo const& info)
 	{
+		if (!(info.targetScale > 0.0f) || info.refreshInterval < 0)
+		{
+			throw std::runtime_error("[example] water scene exception: invalid create info");
+		}
+		targetScale = info.targetScale;
+		refreshInterval = info.refreshInterval;
+
 		camera.position = glm::vec3(0, 2, 10);
 
 		waterQuadTransform.base.scale = 10;
@@ -52,12 +76,25 @@ namespace example
 		backgroundQuads.push_back({ .base = { .translation = { 0, 1, -2 }, .rotation = {} } });
 		backgroundQuads.push_back({ .base = { .translation = { -1, 0, -1 }, .rotation = {} } });
 
+		frameCommands.main.reserve(backgroundQuads.size());
+		frameCommands.refraction.reserve(backgroundQuads.size());
+		frameCommands.reflection.reserve(backgroundQuads.size());
+	}
+
+	void WaterScene::resizeTargets(glm::ivec2 const& windowSize)
+	{
+		glm::ivec2 const size = calcTargetSize(windowSize, targetScale);
+		if (refRactionFrameBuffer.get() != 0 && size == refRactionSize) { return; }
+
+		refreshed = false;
+
 		{
-			refRactionSize = glm::ivec2(1024, 1024);
-			refRactionFrameBuffer = be::mem::gl::makeFrameBuffer();
+			refRactionSize = size;
+			refRactionColorAttachment = be::mem::nullFraii;
+			refRactionFrameBuffer = be::mem::gl::makeFrameBuffer(be::gpu_memory::Category::RenderTarget, "water refraction");
 			BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, refRactionFrameBuffer.get());
-			refRactionColorAttachment = attachColorTextureToFrameBuffer(refRactionSize);
-			//refRactionDepthAttachment = attachDepthTextureToFrameBuffer(refRactionSize);
+			refRactionColorAttachment = attachColorTextureToFrameBuffer(refRactionSize, "water refraction");
+			//refRactionDepthAttachment = attachDepthTextureToFrameBuffer(refRactionSize, "water refraction");
 
 			GLenum const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 			if (status != GL_FRAMEBUFFER_COMPLETE) {
@@ -67,11 +104,13 @@ namespace example
 		}
 
 		{
-			refLectionSize = glm::ivec2(1024, 1024);
-			refLectionFrameBuffer = be::mem::gl::makeFrameBuffer();
+			refLectionSize = size;
+			refLectionColorAttachment = be::mem::nullFraii;
+			refLectionDepthAttachment = be::mem::nullFraii;
+			refLectionFrameBuffer = be::mem::gl::makeFrameBuffer(be::gpu_memory::Category::RenderTarget, "water reflection");
 			BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, refLectionFrameBuffer.get());
-			refLectionColorAttachment = attachColorTextureToFrameBuffer(refLectionSize);
-			refLectionDepthAttachment = attachDepthTextureToFrameBuffer(refLectionSize);
+			refLectionColorAttachment = attachColorTextureToFrameBuffer(refLectionSize, "water reflection");
+			refLectionDepthAttachment = attachDepthTextureToFrameBuffer(refLectionSize, "water reflection");
 
 			GLenum const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 			if (status != GL_FRAMEBUFFER_COMPLETE) {
@@ -79,9 +118,6 @@ namespace example
 					+ std::to_string(static_cast<int>(status)));
 			}
 		}
-
-
-		guiQuadTransform.quadSize = glm::vec2(refRactionSize);
 	}
 
 	void WaterScene::update(UpdateInfo const& info)
@@ -97,17 +133,56 @@ namespace example
 		}
 
 		{
+			// the targets keep the window's aspect, so the previews do too.
+			guiQuadTransform.quadSize = glm::vec2(windowSize);
 			guiQuadTransform.base.scale = 0.3f * windowSize.y / guiQuadTransform.quadSize.y;
 			guiQuadTransform.base.translation.x = -0.5f * windowSize.x + 0.5f * guiQuadTransform.quadSize.x * guiQuadTransform.base.scale;
 			guiQuadTransform.base.translation.y = -0.5f * windowSize.y + 0.5f * guiQuadTransform.quadSize.y * guiQuadTransform.base.scale;
+
+			guiReflectionQuadTransform = guiQuadTransform;
+			guiReflectionQuadTransform.base.translation.x += guiQuadTransform.quadSize.x * guiQuadTransform.base.scale;
 		}
 	}
 
-	void WaterScene::renderPass(RenderInfo const& info)
+	void WaterScene::prepareCommands(bool const refresh)
 	{
-		camera.aspect = info.windowAspect.get();
-		be::pink::recalc(camera);
+		frameCommands.main.clear();
+		frameCommands.refraction.clear();
+		frameCommands.reflection.clear();
+
+		float const waterHeight = waterQuadTransform.base.translation.y;
+		auto const cameraFrustum = be::pink::calcFrustum(camera.vp);
+		auto const reflectionFrustum = be::pink::calcFrustum(reflectionCamera.vp);
+
+		for (auto const& quadTransform : backgroundQuads)
+		{
+			glm::mat4 const model = be::pink::calcTrs(quadTransform);
+			auto const bounds = be::pink::transformAabb(be::basic_assets::meshes::quadMeshBounds, model);
+
+			// the main pass and the refraction look through the same camera, so they share its test.
+			if (be::pink::isVisible(cameraFrustum, bounds))
+			{
+				QuadCommand const command{ model, camera.vp * model };
+				frameCommands.main.push_back(command);
+				if (refresh && bounds.min.y < waterHeight)
+				{
+					frameCommands.refraction.push_back(command);
+				}
+			}
+			if (refresh && bounds.max.y > waterHeight && be::pink::isVisible(reflectionFrustum, bounds))
+			{
+				frameCommands.reflection.push_back(QuadCommand{ model, reflectionCamera.vp * model });
+			}
+		}
+	}
 
+	void WaterScene::renderPass(
+		RenderInfo const& info,
+		be::pink::Camera const& passCamera,
+		std::vector<QuadCommand> const& commands,
+		glm::vec4 const* const clipPlane
+	)
+	{
 		glClearColor(0.1f, 0.1f, 0.3f, 1.0f);
 		glStencilMask(~static_cast<GLuint>(0U));
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -117,9 +192,9 @@ namespace example
 		be::pink::renderSkybox({
 			.shader = info.skyboxShader,
 			.mesh = info.skyboxMesh,
-			.cubemap = info.skyboxCubemap,
-			.cameraProjectionMatrix = camera.projection,
-			.cameraViewMatrix = camera.view,
+			.cubemap = info.resources.get().texture(info.skyboxCubemap),
+			.cameraProjectionMatrix = passCamera.projection,
+			.cameraViewMatrix = passCamera.view,
 			.scale = 1.0f,
 			});
 
@@ -127,18 +202,24 @@ namespace example
 		CRESS_MOO_DEFER_EXPRESSION(glDisable(GL_DEPTH_TEST));
 		glDepthFunc(GL_LESS);
 
-		for (auto const& quadTransform : backgroundQuads)
+		// only around programs that write gl_ClipDistance; the skybox does not.
+		if (clipPlane)
+		{
+			glEnable(GL_CLIP_DISTANCE0);
+		}
+		CRESS_MOO_DEFER_EXPRESSION(glDisable(GL_CLIP_DISTANCE0));
+
+		for (auto const& command : commands)
 		{
-			glm::mat4 const model = be::pink::calcTrs(quadTransform);
-			glm::mat4 const mvp = camera.vp * model;
-			//glm::mat3 const fixNormals = be::calcFixNormalsMatrix(model);
 			glm::vec4 const color = glm::vec4(1.0f);
 			be::pink::renderUnlit({
 				.shader = info.unlitShader.get(),
-				.mesh = info.quadMesh.get(),
-				.tex = info.flagTexture.get(),
+				.mesh = info.resources.get().mesh(info.quadMesh),
+				.tex = info.resources.get().texture(info.flagTexture),
 				.color = color,
-				.mvp = mvp,
+				.mvp = command.mvp,
+				.clipPlane = clipPlane,
+				.model = &command.model,
 				});
 		}
 	}
@@ -146,30 +227,61 @@ namespace example
 	void WaterScene::render(RenderInfo const& info)
 	{
 		auto const& windowSize = info.windowSize.get();
-		auto const& quadMesh = info.quadMesh.get();
+		auto const& resources = info.resources.get();
+		auto const& quadMesh = resources.mesh(info.quadMesh);
 
-		glEnable(GL_CLIP_DISTANCE0);
-		CRESS_MOO_DEFER_EXPRESSION(glDisable(GL_CLIP_DISTANCE0));
+		resizeTargets(windowSize);
 
-		{
-			BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, refRactionFrameBuffer.get());
-			glViewport(0, 0, refRactionSize.x, refRactionSize.y);
+		camera.aspect = info.windowAspect.get();
+		be::pink::recalc(camera);
 
-			renderPass(info);
-		}
+		// mirrored in the water plane, looking up at what the water reflects.
+		glm::vec4 const waterPlane = calcWaterPlane(waterQuadTransform);
+		float const waterHeight = -waterPlane.w;
+		reflectionCamera = camera;
+		reflectionCamera.position.y = 2.0f * waterHeight - camera.position.y;
+		reflectionCamera.target.y = 2.0f * waterHeight - camera.target.y;
+		be::pink::recalc(reflectionCamera);
 
+		++framesSinceRefresh;
+		bool const refresh = !refreshed
+			|| (refreshInterval > 0 && framesSinceRefresh >= refreshInterval)
+			|| camera.vp != refreshedCameraVp;
+
+		prepareCommands(refresh);
+
+		if (refresh)
 		{
-			BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, refLectionFrameBuffer.get());
-			glViewport(0, 0, refLectionSize.x, refLectionSize.y);
+			refreshed = true;
+			framesSinceRefresh = 0;
+			refreshedCameraVp = camera.vp;
+
+			{
+				BE_GL_STATS_PASS("water refraction");
+				BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, refRactionFrameBuffer.get());
+				glViewport(0, 0, refRactionSize.x, refRactionSize.y);
+
+				// keeps what is below the water.
+				glm::vec4 const belowWater = -waterPlane;
+				renderPass(info, camera, frameCommands.refraction, &belowWater);
+			}
 
-			renderPass(info);
+			{
+				BE_GL_STATS_PASS("water reflection");
+				BE_BIND_FRAMEBUFFER_SCOPE(GL_FRAMEBUFFER, refLectionFrameBuffer.get());
+				glViewport(0, 0, refLectionSize.x, refLectionSize.y);
+
+				// keeps what is above the water.
+				renderPass(info, reflectionCamera, frameCommands.reflection, &waterPlane);
+			}
 		}
 
 		{
+			BE_GL_STATS_PASS("water main");
 			// (note: framebuffer 0 implicitly bound)
 			glViewport(0, 0, windowSize.x, windowSize.y);
 
-			renderPass(info);
+			renderPass(info, camera, frameCommands.main, nullptr);
 
 			// WATER PASS
 			{
@@ -183,24 +295,32 @@ namespace example
 					glm::mat3 const fixNormals = be::pink::calcFixNormalsMatrix(model);
 					example::renderWater({
 						.shader = info.waterShader,
-						.mesh = info.quadMesh,
+						.mesh = quadMesh,
 						.mvp = mvp,
 						.fixNormals = fixNormals,
-						.diffuseTexture = info.waterTexture
+						.diffuseTexture = resources.texture(info.waterTexture)
 						});
 				}
 			}
 
 			// GUI PASS
 			{
-				glm::mat4 const mvp = guiCamera.vp * be::pink::calcTrs(guiQuadTransform);
 				glm::vec4 const color = glm::vec4(1.0f);
+				glm::mat4 const refractionMvp = guiCamera.vp * be::pink::calcTrs(guiQuadTransform);
 				be::pink::renderUnlit({
 					.shader = info.unlitShader.get(),
 					.mesh = quadMesh,
 					.tex = refRactionColorAttachment.get(),
 					.color = color,
-					.mvp = mvp,
+					.mvp = refractionMvp,
+					});
+				glm::mat4 const reflectionMvp = guiCamera.vp * be::pink::calcTrs(guiReflectionQuadTransform);
+				be::pink::renderUnlit({
+					.shader = info.unlitShader.get(),
+					.mesh = quadMesh,
+					.tex = refLectionColorAttachment.get(),
+					.color = color,
+					.mvp = reflectionMvp,
 					});
 			}
 		}
@@ -7,18 +7,32 @@
 
 namespace example
 {
-	be::mem::gl::Texture attachColorTextureToFrameBuffer(glm::ivec2 const& size);
-	be::mem::gl::Texture attachDepthTextureToFrameBuffer(glm::ivec2 const& size);
-
+	be::mem::gl::Texture attachColorTextureToFrameBuffer(glm::ivec2 const& size, char const* label);
+	be::mem::gl::Texture attachDepthTextureToFrameBuffer(glm::ivec2 const& size, char const* label);
+
+	/*
+	//	The reflection and refraction are rendered into targets a fraction of the window's size.
+	//	The reflection uses the camera mirrored in the water plane. Each pass clips its geometry
+	//	to its side of the plane with gl_ClipDistance. Both are refreshed every few frames,
+	//	or at once when the camera moves or the window resizes, and are reused in between.
+	//	The quads are culled once per frame into one draw list per pass.
+	*/
 	class WaterScene
 	{
 	private:
 		be::pink::Camera camera;
+		be::pink::Camera reflectionCamera; // |camera| mirrored in the water plane
 
 		std::vector<be::pink::QuadTransform> backgroundQuads;
 
 		be::pink::QuadTransform waterQuadTransform;
 
+		float targetScale{};
+		int refreshInterval{};
+		int framesSinceRefresh{};
+		bool refreshed = false; // false until the first refresh and after the targets are remade
+		glm::mat4 refreshedCameraVp = glm::mat4(); // |camera| as of the latest refresh
+
 		be::mem::gl::FrameBuffer refRactionFrameBuffer;
 		glm::ivec2 refRactionSize;
 		be::mem::gl::Texture refRactionColorAttachment;
@@ -30,10 +44,35 @@ namespace example
 		be::mem::gl::Texture refLectionDepthAttachment;
 
 		be::pink::Camera guiCamera;
-		be::pink::QuadTransform guiQuadTransform;
+		be::pink::QuadTransform guiQuadTransform; // shows the refraction
+		be::pink::QuadTransform guiReflectionQuadTransform;
+
+		// Resolved matrices, built once per frame by prepareCommands and shared by the passes.
+		struct QuadCommand
+		{
+			glm::mat4 model;
+			glm::mat4 mvp;
+		};
+		struct FrameCommands
+		{
+			std::vector<QuadCommand> main;
+			std::vector<QuadCommand> refraction; // at least partly below the water
+			std::vector<QuadCommand> reflection; // at least partly above it, seen by |reflectionCamera|
+		};
+		FrameCommands frameCommands;
 
 	public:
+		struct CreateInfo
+		{
+			// the reflection and refraction targets' size as a fraction of the window's. require > 0
+			float targetScale = 0.5f;
+			// frames between refreshes of the reflection and refraction. 0 refreshes them only when
+			// the camera moves or the window resizes. require >= 0
+			int refreshInterval = 1;
+		};
+
 		WaterScene();
+		explicit WaterScene(CreateInfo const& info);
 
 		struct UpdateInfo
 		{
@@ -47,20 +86,36 @@ namespace example
 			be::need_ref<glm::ivec2 const> windowSize;
 			be::need<float> windowAspect;
 
-			be::need_ref<be::gl::BasicMesh const> quadMesh;
+			// the handles below are resolved here every frame, so their resources can be swapped.
+			be::need_ref<be::gl::ResourceRegistry const> resources;
+
+			be::need<be::gl::MeshHandle> quadMesh;
 			be::need_ref<be::pink::UnlitShader const> unlitShader;
-			be::need<GLuint> flagTexture;
+			be::need<be::gl::TextureHandle> flagTexture;
 
 			be::need_ref<be::pink::SkyboxShader const> skyboxShader;
 			be::need_ref<be::pink::SkyboxMesh const> skyboxMesh;
-			be::need<GLuint> skyboxCubemap;
+			be::need<be::gl::TextureHandle> skyboxCubemap;
 
 			be::need_ref<WaterShader const> waterShader;
-			be::need<GLuint> waterTexture;
+			be::need<be::gl::TextureHandle> waterTexture;
 		};
 		void render(RenderInfo const& info);
 
 	private:
-		void renderPass(RenderInfo const& info);
+		// Remakes the targets at |targetScale| of the window if that changed.
+		void resizeTargets(glm::ivec2 const& windowSize);
+
+		// Culls the quads against the cameras. The refraction and reflection lists are only filled if |refresh|.
+		void prepareCommands(bool refresh);
+
+		// Clears, draws the skybox seen from |passCamera| and replays |commands|,
+		// clipped to the side of |clipPlane| the pass looks at, if given.
+		void renderPass(
+			RenderInfo const& info,
+			be::pink::Camera const& passCamera,
+			std::vector<QuadCommand> const& commands,
+			glm::vec4 const* clipPlane
+		);
 	};
 }